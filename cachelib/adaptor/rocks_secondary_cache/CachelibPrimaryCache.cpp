@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/adaptor/rocks_secondary_cache/CachelibPrimaryCache.h"
+
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace facebook::rocks_secondary_cache {
+
+namespace {
+using rocksdb::Cache;
+
+// Form of the entry stored in the item, see RocksCachelibPrimaryCache.
+enum class EntryKind : uint8_t {
+  kSerialized = 0,
+  kObject = 1,
+};
+
+// Header at the start of every item. For serialized entries it is followed
+// by @size bytes written by the helper's saveto_cb. For object entries the
+// rest of the item is unused and only accounts for @size bytes of charge.
+struct EntryHeader {
+  EntryKind kind;
+  Cache::ObjectPtr obj;
+  const Cache::CacheItemHelper* helper;
+  uint64_t size;
+};
+
+// item memory is not guaranteed to be aligned for the header's pointers
+EntryHeader readHeader(const FbCacheItem& item) {
+  EntryHeader hdr;
+  std::memcpy(&hdr, item.getMemory(), sizeof(hdr));
+  return hdr;
+}
+
+void writeHeader(FbCacheItem& item, const EntryHeader& hdr) {
+  std::memcpy(item.getMemory(), &hdr, sizeof(hdr));
+}
+
+const char* payload(const FbCacheItem& item) {
+  return static_cast<const char*>(item.getMemory()) + sizeof(EntryHeader);
+}
+
+// Object entries only use their item to account for the charge. Give the
+// whole pages of the unused payload back to the OS. They are faulted back in
+// as zero pages when the memory is reused for another item. This only
+// releases memory that is not backed by a shared memory segment.
+void releasePayloadPages(const FbCacheItem& item) {
+  static const uintptr_t kPageSize = sysconf(_SC_PAGESIZE);
+  const auto begin =
+      (reinterpret_cast<uintptr_t>(payload(item)) + kPageSize - 1) &
+      ~(kPageSize - 1);
+  const auto end =
+      (reinterpret_cast<uintptr_t>(item.getMemory()) + item.getSize()) &
+      ~(kPageSize - 1);
+  if (begin < end &&
+      madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED) !=
+          0) {
+    XLOG_EVERY_N(WARN, 1000) << folly::sformat(
+        "Unable to release the payload of {}: {}", item.toString(),
+        folly::errnoStr(errno));
+  }
+}
+
+struct PoolSizes {
+  size_t high;
+  size_t low;
+  size_t bottom;
+};
+
+PoolSizes computePoolSizes(size_t capacity,
+                           double highPriPoolRatio,
+                           double bottomPriPoolRatio) {
+  PoolSizes sizes;
+  sizes.high = static_cast<size_t>(capacity * highPriPoolRatio);
+  sizes.bottom = static_cast<size_t>(capacity * bottomPriPoolRatio);
+  sizes.low = capacity - sizes.high - sizes.bottom;
+  return sizes;
+}
+} // namespace
+
+struct RocksCachelibPrimaryCache::PrimaryHandle : public Cache::Handle {
+  // item of the entry. Keeps an object entry alive while the handle exists,
+  // and identifies the shared object of a serialized entry. Empty for
+  // standalone handles.
+  FbCacheReadHandle item;
+  ObjectPtr obj{nullptr};
+  const CacheItemHelper* helper{nullptr};
+  size_t charge{0};
+  // true if the object must be deleted with the handle
+  bool ownsObj{false};
+  // true if the object is pinned in sharedObjects_
+  bool sharedObj{false};
+  std::atomic<uint32_t> refs{1};
+};
+
+RocksCachelibPrimaryCache::RocksCachelibPrimaryCache(
+    std::unique_ptr<FbCache>&& cache,
+    std::unique_ptr<cachelib::CacheAdmin>&& admin,
+    const RocksCachelibOptions& opts)
+    : cache_(std::move(cache)),
+      admin_(std::move(admin)),
+      highPriPoolRatio_(opts.highPriPoolRatio),
+      bottomPriPoolRatio_(opts.bottomPriPoolRatio),
+      capacity_(cache_->getCacheMemoryStats().ramCacheSize) {
+  const auto sizes =
+      computePoolSizes(capacity_, highPriPoolRatio_, bottomPriPoolRatio_);
+  lowPool_ = cache_->addPool("low", sizes.low);
+  highPool_ = sizes.high > 0 ? cache_->addPool("high", sizes.high) : lowPool_;
+  bottomPool_ =
+      sizes.bottom > 0 ? cache_->addPool("bottom", sizes.bottom) : lowPool_;
+}
+
+RocksCachelibPrimaryCache::~RocksCachelibPrimaryCache() {
+  // the admin references the cache
+  admin_.reset();
+  cache_.reset();
+}
+
+cachelib::PoolId RocksCachelibPrimaryCache::poolFor(Priority priority) const {
+  switch (priority) {
+  case Priority::HIGH:
+    return highPool_;
+  case Priority::BOTTOM:
+    return bottomPool_;
+  default:
+    return lowPool_;
+  }
+}
+
+RocksCachelibPrimaryCache::PrimaryHandle*
+RocksCachelibPrimaryCache::makeStandalone(ObjectPtr obj,
+                                          const CacheItemHelper* helper,
+                                          size_t charge) {
+  auto* h = new PrimaryHandle();
+  h->obj = obj;
+  h->helper = helper;
+  h->charge = charge;
+  h->ownsObj = true;
+  pinnedUsage_.fetch_add(charge, std::memory_order_relaxed);
+  return h;
+}
+
+void RocksCachelibPrimaryCache::releaseHandle(PrimaryHandle* h) {
+  pinnedUsage_.fetch_sub(h->charge, std::memory_order_relaxed);
+  if (h->sharedObj) {
+    unpinObject(*h->item);
+  } else if (h->ownsObj && h->helper && h->helper->del_cb) {
+    h->helper->del_cb(h->obj, memory_allocator());
+  }
+  delete h;
+}
+
+RocksCachelibPrimaryCache::SharedObjectShard&
+RocksCachelibPrimaryCache::shardFor(const FbCacheItem& item) {
+  return sharedObjects_[folly::hash::twang_mix64(
+                            reinterpret_cast<uintptr_t>(&item)) %
+                        sharedObjects_.size()];
+}
+
+std::optional<RocksCachelibPrimaryCache::SharedObject>
+RocksCachelibPrimaryCache::pinExistingObject(const FbCacheItem& item) {
+  auto& shard = shardFor(item);
+  std::lock_guard<std::mutex> l(shard.mutex);
+  auto it = shard.objects.find(&item);
+  if (it == shard.objects.end()) {
+    return std::nullopt;
+  }
+  it->second.pins++;
+  return it->second;
+}
+
+RocksCachelibPrimaryCache::SharedObject RocksCachelibPrimaryCache::pinObject(
+    const FbCacheItem& item, const SharedObject& obj) {
+  auto& shard = shardFor(item);
+  SharedObject pinned;
+  {
+    std::lock_guard<std::mutex> l(shard.mutex);
+    auto [it, inserted] = shard.objects.try_emplace(&item, obj);
+    if (!inserted) {
+      it->second.pins++;
+    }
+    pinned = it->second;
+  }
+  if (pinned.obj != obj.obj && obj.helper->del_cb) {
+    // another lookup created the object first
+    obj.helper->del_cb(obj.obj, memory_allocator());
+  }
+  return pinned;
+}
+
+void RocksCachelibPrimaryCache::unpinObject(const FbCacheItem& item) {
+  auto& shard = shardFor(item);
+  SharedObject unpinned;
+  {
+    std::lock_guard<std::mutex> l(shard.mutex);
+    auto it = shard.objects.find(&item);
+    XDCHECK(it != shard.objects.end());
+    if (--it->second.pins > 0) {
+      return;
+    }
+    unpinned = it->second;
+    shard.objects.erase(it);
+  }
+  if (unpinned.helper->del_cb) {
+    unpinned.helper->del_cb(unpinned.obj, memory_allocator());
+  }
+}
+
+rocksdb::Status RocksCachelibPrimaryCache::Insert(
+    const rocksdb::Slice& key,
+    ObjectPtr obj,
+    const CacheItemHelper* helper,
+    size_t charge,
+    Handle** handle,
+    Priority priority
+#if ROCKSDB_MAJOR > 8 || (ROCKSDB_MAJOR == 8 && ROCKSDB_MINOR > 9)
+    ,
+    const rocksdb::Slice& /* compressed */,
+    rocksdb::CompressionType /* type */
+#endif
+) {
+  // the cache takes ownership of obj in every case, so it must be deleted
+  // on any path that does not hand it to an item or a handle.
+  auto deleteObj = [&]() {
+    if (helper->del_cb) {
+      helper->del_cb(obj, memory_allocator());
+    }
+  };
+
+  const bool serialize = helper->size_cb && helper->saveto_cb;
+  const size_t size = serialize ? helper->size_cb(obj) : charge;
+  FbCacheKey k(key.data(), key.size());
+
+  rocksdb::Status s;
+  bool inserted = false;
+  FbCache::WriteHandle wh;
+  if (FbCacheItem::getRequiredSize(k, sizeof(EntryHeader) + size) <=
+      FB_CACHE_MAX_ITEM_SIZE) {
+    try {
+      wh = cache_->allocate(poolFor(priority), k, sizeof(EntryHeader) + size);
+      if (wh) {
+        EntryHeader hdr{serialize ? EntryKind::kSerialized : EntryKind::kObject,
+                        serialize ? nullptr : obj, helper, size};
+        writeHeader(*wh, hdr);
+        if (serialize) {
+          s = helper->saveto_cb(
+              obj, /*offset=*/0, size,
+              static_cast<char*>(wh->getMemory()) + sizeof(EntryHeader));
+        } else if (!cache_->isOnShm()) {
+          releasePayloadPages(*wh);
+        }
+        if (s.ok()) {
+          cache_->insertOrReplace(wh);
+          inserted = true;
+        }
+      }
+    } catch (const std::exception& ex) {
+      s = rocksdb::Status::Aborted(folly::sformat(
+          "Cachelib insertOrReplace exception, error:{}", ex.what()));
+    }
+  }
+
+  if (!s.ok()) {
+    deleteObj();
+    return s;
+  }
+
+  if (!inserted) {
+    if (strictCapacityLimit_.load(std::memory_order_relaxed) ||
+        handle == nullptr) {
+      deleteObj();
+      return handle == nullptr ? rocksdb::Status::OK()
+                               : rocksdb::Status::MemoryLimit();
+    }
+    // like the rocksdb caches, hand out an uncharged handle when the entry
+    // does not fit.
+    *handle = makeStandalone(obj, helper, charge);
+    return rocksdb::Status::OK();
+  }
+
+  if (handle == nullptr) {
+    if (serialize) {
+      deleteObj();
+    }
+    return rocksdb::Status::OK();
+  }
+
+  auto* h = new PrimaryHandle();
+  h->obj = obj;
+  h->helper = helper;
+  h->charge = charge;
+  if (serialize) {
+    // the caller gets back the object it inserted instead of a re-created
+    // copy. Lookups share it while the handle is alive.
+    pinObject(*wh, SharedObject{obj, helper, charge});
+    h->sharedObj = true;
+  }
+  h->item = std::move(wh);
+  pinnedUsage_.fetch_add(charge, std::memory_order_relaxed);
+  *handle = h;
+  return rocksdb::Status::OK();
+}
+
+Cache::Handle* RocksCachelibPrimaryCache::CreateStandalone(
+    const rocksdb::Slice& /* key */,
+    ObjectPtr obj,
+    const CacheItemHelper* helper,
+    size_t charge,
+    bool allow_uncharged) {
+  if (strictCapacityLimit_.load(std::memory_order_relaxed) &&
+      !allow_uncharged && GetUsage() + charge > GetCapacity()) {
+    if (helper->del_cb) {
+      helper->del_cb(obj, memory_allocator());
+    }
+    return nullptr;
+  }
+  return makeStandalone(obj, helper, charge);
+}
+
+Cache::Handle* RocksCachelibPrimaryCache::Lookup(
+    const rocksdb::Slice& key,
+    const CacheItemHelper* helper,
+    CreateContext* create_context,
+    Priority /* priority */,
+    rocksdb::Statistics* /* stats */) {
+  auto item = cache_->find(FbCacheKey(key.data(), key.size()));
+  if (!item) {
+    return nullptr;
+  }
+
+  const auto hdr = readHeader(*item);
+  auto* h = new PrimaryHandle();
+  if (hdr.kind == EntryKind::kObject) {
+    h->obj = hdr.obj;
+    h->helper = hdr.helper;
+    h->charge = hdr.size;
+    h->item = std::move(item);
+  } else {
+    // only create the object if no other handle to the item has one
+    auto shared = pinExistingObject(*item);
+    if (!shared) {
+      if (helper == nullptr || helper->create_cb == nullptr) {
+        delete h;
+        return nullptr;
+      }
+      SharedObject created{nullptr, helper};
+      rocksdb::Status s = helper->create_cb(
+          rocksdb::Slice(payload(*item), hdr.size),
+          rocksdb::CompressionType::kNoCompression,
+          rocksdb::CacheTier::kVolatileTier, create_context,
+          memory_allocator(), &created.obj, &created.charge);
+      if (!s.ok()) {
+        delete h;
+        return nullptr;
+      }
+      shared = pinObject(*item, created);
+    }
+    h->obj = shared->obj;
+    h->helper = shared->helper;
+    h->charge = shared->charge;
+    h->item = std::move(item);
+    h->sharedObj = true;
+  }
+  pinnedUsage_.fetch_add(h->charge, std::memory_order_relaxed);
+  return h;
+}
+
+bool RocksCachelibPrimaryCache::Ref(Handle* handle) {
+  static_cast<PrimaryHandle*>(handle)->refs.fetch_add(
+      1, std::memory_order_relaxed);
+  return true;
+}
+
+bool RocksCachelibPrimaryCache::Release(Handle* handle,
+                                        bool erase_if_last_ref) {
+  auto* h = static_cast<PrimaryHandle*>(handle);
+  if (h->refs.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+    return false;
+  }
+
+  // other handles of the same entry keep the item referenced. Removing by
+  // handle only erases the entry if the key still maps to this item.
+  const bool erased = erase_if_last_ref && h->item &&
+                      h->item->getRefCount() == 1 &&
+                      cache_->remove(h->item) == FbCache::RemoveRes::kSuccess;
+  releaseHandle(h);
+  return erased;
+}
+
+Cache::ObjectPtr RocksCachelibPrimaryCache::Value(Handle* handle) {
+  return static_cast<PrimaryHandle*>(handle)->obj;
+}
+
+void RocksCachelibPrimaryCache::Erase(const rocksdb::Slice& key) {
+  cache_->remove(FbCacheKey(key.data(), key.size()));
+}
+
+uint64_t RocksCachelibPrimaryCache::NewId() {
+  return lastId_.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void RocksCachelibPrimaryCache::SetCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> l(capacityMutex_);
+  capacity =
+      std::min<size_t>(capacity, cache_->getCacheMemoryStats().ramCacheSize);
+  const auto sizes =
+      computePoolSizes(capacity, highPriPoolRatio_, bottomPriPoolRatio_);
+
+  std::vector<std::pair<cachelib::PoolId, size_t>> targets;
+  targets.emplace_back(lowPool_, sizes.low);
+  if (highPool_ != lowPool_) {
+    targets.emplace_back(highPool_, sizes.high);
+  } else {
+    targets.front().second += sizes.high;
+  }
+  if (bottomPool_ != lowPool_) {
+    targets.emplace_back(bottomPool_, sizes.bottom);
+  } else {
+    targets.front().second += sizes.bottom;
+  }
+
+  // shrink first, so the pools that grow can take the released memory
+  for (const auto& [pid, target] : targets) {
+    const auto current = cache_->getPool(pid).getPoolSize();
+    if (current > target) {
+      cache_->shrinkPool(pid, current - target);
+    }
+  }
+  for (const auto& [pid, target] : targets) {
+    const auto current = cache_->getPool(pid).getPoolSize();
+    if (current < target && !cache_->growPool(pid, target - current)) {
+      XLOG(WARN) << folly::sformat(
+          "Unable to grow pool {} by {} bytes to the new capacity", pid,
+          target - current);
+    }
+  }
+  capacity_.store(capacity, std::memory_order_relaxed);
+}
+
+void RocksCachelibPrimaryCache::SetStrictCapacityLimit(
+    bool strict_capacity_limit) {
+  strictCapacityLimit_.store(strict_capacity_limit, std::memory_order_relaxed);
+}
+
+bool RocksCachelibPrimaryCache::HasStrictCapacityLimit() const {
+  return strictCapacityLimit_.load(std::memory_order_relaxed);
+}
+
+size_t RocksCachelibPrimaryCache::GetCapacity() const {
+  return capacity_.load(std::memory_order_relaxed);
+}
+
+size_t RocksCachelibPrimaryCache::GetUsage() const {
+  size_t usage = cache_->getPool(lowPool_).getCurrentUsedSize();
+  if (highPool_ != lowPool_) {
+    usage += cache_->getPool(highPool_).getCurrentUsedSize();
+  }
+  if (bottomPool_ != lowPool_) {
+    usage += cache_->getPool(bottomPool_).getCurrentUsedSize();
+  }
+  return usage;
+}
+
+size_t RocksCachelibPrimaryCache::GetUsage(Handle* handle) const {
+  return GetCharge(handle);
+}
+
+size_t RocksCachelibPrimaryCache::GetPinnedUsage() const {
+  return pinnedUsage_.load(std::memory_order_relaxed);
+}
+
+size_t RocksCachelibPrimaryCache::GetCharge(Handle* handle) const {
+  return static_cast<PrimaryHandle*>(handle)->charge;
+}
+
+const Cache::CacheItemHelper* RocksCachelibPrimaryCache::GetCacheItemHelper(
+    Handle* handle) const {
+  return static_cast<PrimaryHandle*>(handle)->helper;
+}
+
+void RocksCachelibPrimaryCache::ApplyToAllEntries(
+    const std::function<void(const rocksdb::Slice& key,
+                             ObjectPtr obj,
+                             size_t charge,
+                             const CacheItemHelper* helper)>& callback,
+    const ApplyToAllEntriesOptions& /* opts */) {
+  for (auto it = cache_->begin(); it != cache_->end(); ++it) {
+    const auto key = it->getKey();
+    const auto hdr = readHeader(*it);
+    callback(rocksdb::Slice(key.data(), key.size()),
+             hdr.kind == EntryKind::kObject ? hdr.obj : nullptr, hdr.size,
+             hdr.helper);
+  }
+}
+
+void RocksCachelibPrimaryCache::EraseUnRefEntries() {
+  std::vector<std::string> keys;
+  for (auto it = cache_->begin(); it != cache_->end(); ++it) {
+    // the iterator holds one reference
+    if (it->getRefCount() <= 1) {
+      keys.push_back(it->getKey().str());
+    }
+  }
+  for (const auto& key : keys) {
+    cache_->remove(FbCacheKey(key));
+  }
+}
+
+std::string RocksCachelibPrimaryCache::GetPrintableOptions() const {
+  return folly::sformat(
+      "    capacity : {}\n    high_pri_pool_ratio: {:.3f}\n"
+      "    bottom_pri_pool_ratio: {:.3f}\n    strict_capacity_limit : {}\n",
+      GetCapacity(), highPriPoolRatio_, bottomPriPoolRatio_,
+      HasStrictCapacityLimit());
+}
+
+std::shared_ptr<rocksdb::Cache> NewRocksCachelibPrimaryCache(
+    const RocksCachelibOptions& opts) {
+  if (opts.highPriPoolRatio < 0 || opts.bottomPriPoolRatio < 0 ||
+      opts.highPriPoolRatio + opts.bottomPriPoolRatio >= 1.0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid priority pool ratios. high: {}, bottom: {}. Both must be "
+        "non-negative and sum up to less than 1",
+        opts.highPriPoolRatio, opts.bottomPriPoolRatio));
+  }
+
+  FbCacheConfig config;
+  config.setCacheSize(opts.volatileSize)
+      .setCacheName(opts.cacheName)
+      .setAccessConfig(
+          {opts.bktPower /* bucket power */, opts.lockPower /* lock power */})
+      // SetCapacity() resizes the pools, the resizer releases their slabs
+      .enablePoolResizing(std::make_shared<cachelib::RebalanceStrategy>(),
+                          std::chrono::seconds(1),
+                          1 /* slabsToReleasePerIteration */)
+      .setItemDestructor([](const FbCache::DestructorData& data) {
+        // object entries only live in DRAM. Serialized entries hold no
+        // object, whichever tier they are dropped from.
+        if (data.context != cachelib::DestructorContext::kEvictedFromRAM &&
+            data.context != cachelib::DestructorContext::kRemovedFromRAM) {
+          return;
+        }
+        const auto hdr = readHeader(data.item);
+        if (hdr.kind == EntryKind::kObject && hdr.helper &&
+            hdr.helper->del_cb) {
+          hdr.helper->del_cb(hdr.obj, nullptr);
+        }
+      });
+
+  if (!opts.fileName.empty() && opts.size > 0) {
+    NvmCacheConfig nvmConfig = MakeNvmCacheConfig(opts);
+    // a pointer to an object is meaningless once the item leaves DRAM
+    nvmConfig.encodeCb = [](FbCache::NvmCacheT::EncodeDecodeContext ctx) {
+      return readHeader(ctx.item).kind == EntryKind::kSerialized;
+    };
+    nvmConfig.decodeCb = [](FbCache::NvmCacheT::EncodeDecodeContext) {};
+    config.enableNvmCache(nvmConfig);
+  }
+  config.validate(); // will throw if bad config
+
+  auto cache = std::make_unique<FbCache>(config);
+  std::unique_ptr<cachelib::CacheAdmin> admin;
+  if (opts.fb303Stats) {
+    cachelib::CacheAdmin::Config adminConfig;
+    adminConfig.oncall = opts.oncallName;
+    admin = std::make_unique<cachelib::CacheAdmin>(*cache, adminConfig);
+  }
+
+  return std::make_shared<RocksCachelibPrimaryCache>(std::move(cache),
+                                                     std::move(admin), opts);
+}
+
+} // namespace facebook::rocks_secondary_cache
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <folly/container/F14Map.h>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+#include "cachelib/adaptor/rocks_secondary_cache/CachelibWrapper.h"
+#include "rocksdb/advanced_cache.h"
+
+namespace facebook {
+namespace rocks_secondary_cache {
+// The RocksCachelibPrimaryCache is a concrete implementation of
+// rocksdb::Cache that keeps the entries in a cachelib LruAllocator. It can be
+// allocated using NewRocksCachelibPrimaryCache() and passed as the
+// block_cache in rocksdb::BlockBasedTableOptions. With a cache file
+// configured, blocks evicted from DRAM go to the navy engine of the same
+// cache, so a single cachelib instance and memory budget serves both tiers
+// and blocks are not cached twice.
+//
+// Entries are stored in one of two forms, depending on their helper:
+// 1. Entries whose helper can serialize them (size_cb and saveto_cb) are
+//    stored serialized. The inserted object is released once saved, unless
+//    the caller asked for a handle. A lookup re-creates the object with the
+//    helper's create_cb. All handles to the same item share one object,
+//    which is deleted once the last of them is released. These entries can
+//    be written to and read back from the cache file.
+// 2. Other entries (e.g. cache reservations and parsed objects without a
+//    serialized form) are stored as an object pointer in an item of their
+//    charge, so the memory budget still accounts for them. Only the header
+//    of these items is used, and the pages of the rest are given back to the
+//    OS so the charge is not resident twice. The object is deleted when the
+//    item is evicted or removed from DRAM, and they are never written to the
+//    cache file.
+//
+// rocksdb priorities map to cachelib pools sized by highPriPoolRatio and
+// bottomPriPoolRatio. Each pool evicts independently, so unlike the rocksdb
+// LRUCache a priority does not borrow the unused memory of another one.
+class RocksCachelibPrimaryCache : public rocksdb::Cache {
+ public:
+  using Cache::Release;
+
+  RocksCachelibPrimaryCache(std::unique_ptr<FbCache>&& cache,
+                            std::unique_ptr<cachelib::CacheAdmin>&& admin,
+                            const RocksCachelibOptions& opts);
+  ~RocksCachelibPrimaryCache() override;
+
+  const char* Name() const override { return "RocksCachelibPrimaryCache"; }
+
+  rocksdb::Status Insert(const rocksdb::Slice& key,
+                         ObjectPtr obj,
+                         const CacheItemHelper* helper,
+                         size_t charge,
+                         Handle** handle = nullptr,
+                         Priority priority = Priority::LOW
+#if ROCKSDB_MAJOR > 8 || (ROCKSDB_MAJOR == 8 && ROCKSDB_MINOR > 9)
+                         ,
+                         const rocksdb::Slice& compressed = rocksdb::Slice(),
+                         rocksdb::CompressionType type =
+                             rocksdb::CompressionType::kNoCompression
+#endif
+                         ) override;
+
+  Handle* CreateStandalone(const rocksdb::Slice& key,
+                           ObjectPtr obj,
+                           const CacheItemHelper* helper,
+                           size_t charge,
+                           bool allow_uncharged) override;
+
+  // Serialized entries are only found when @helper and @create_context are
+  // given, since the object has to be re-created from the cached bytes,
+  // unless another handle to the same item is still alive.
+  Handle* Lookup(const rocksdb::Slice& key,
+                 const CacheItemHelper* helper = nullptr,
+                 CreateContext* create_context = nullptr,
+                 Priority priority = Priority::LOW,
+                 rocksdb::Statistics* stats = nullptr) override;
+
+  bool Ref(Handle* handle) override;
+
+  bool Release(Handle* handle, bool erase_if_last_ref = false) override;
+
+  ObjectPtr Value(Handle* handle) override;
+
+  void Erase(const rocksdb::Slice& key) override;
+
+  uint64_t NewId() override;
+
+  // Resizes the pools in proportion to their ratios. The pool resizer
+  // releases the slabs of shrunk pools in the background, so usage can stay
+  // above the new capacity for a while. Capacity beyond the DRAM size of the
+  // cache is ignored.
+  void SetCapacity(size_t capacity) override;
+
+  void SetStrictCapacityLimit(bool strict_capacity_limit) override;
+
+  bool HasStrictCapacityLimit() const override;
+
+  size_t GetCapacity() const override;
+
+  size_t GetUsage() const override;
+
+  size_t GetUsage(Handle* handle) const override;
+
+  size_t GetPinnedUsage() const override;
+
+  size_t GetCharge(Handle* handle) const override;
+
+  const CacheItemHelper* GetCacheItemHelper(Handle* handle) const override;
+
+  // Serialized entries are reported with a null object and the size of their
+  // serialized form as the charge.
+  void ApplyToAllEntries(
+      const std::function<void(const rocksdb::Slice& key,
+                               ObjectPtr obj,
+                               size_t charge,
+                               const CacheItemHelper* helper)>& callback,
+      const ApplyToAllEntriesOptions& opts) override;
+
+  void EraseUnRefEntries() override;
+
+  std::string GetPrintableOptions() const override;
+
+  FbCache& getCache() { return *cache_; }
+
+ private:
+  struct PrimaryHandle;
+
+  // pool backing the given rocksdb priority
+  cachelib::PoolId poolFor(Priority priority) const;
+
+  // Creates a handle that is not backed by a cache item. It owns @obj.
+  PrimaryHandle* makeStandalone(ObjectPtr obj,
+                                const CacheItemHelper* helper,
+                                size_t charge);
+
+  void releaseHandle(PrimaryHandle* h);
+
+  // Object of a serialized entry, shared by the handles to its item.
+  struct SharedObject {
+    ObjectPtr obj{nullptr};
+    const CacheItemHelper* helper{nullptr};
+    size_t charge{0};
+    // number of handles using the object
+    size_t pins{1};
+  };
+
+  struct SharedObjectShard {
+    std::mutex mutex;
+    folly::F14FastMap<const FbCacheItem*, SharedObject> objects;
+  };
+
+  SharedObjectShard& shardFor(const FbCacheItem& item);
+
+  // Pins the object shared by the handles to @item, if there is one.
+  std::optional<SharedObject> pinExistingObject(const FbCacheItem& item);
+
+  // Pins the object shared by the handles to @item. If there is none yet,
+  // @obj becomes the shared object with a single pin. Otherwise @obj is
+  // deleted.
+  //
+  // @return the shared object
+  SharedObject pinObject(const FbCacheItem& item, const SharedObject& obj);
+
+  // Drops a pin taken by pinObject(). The object is deleted with the last
+  // pin.
+  void unpinObject(const FbCacheItem& item);
+
+  std::unique_ptr<FbCache> cache_;
+  std::unique_ptr<cachelib::CacheAdmin> admin_;
+
+  // pools for LOW, HIGH and BOTTOM priority. HIGH and BOTTOM are the same as
+  // LOW when their ratio is 0.
+  cachelib::PoolId lowPool_;
+  cachelib::PoolId highPool_;
+  cachelib::PoolId bottomPool_;
+  const double highPriPoolRatio_;
+  const double bottomPriPoolRatio_;
+
+  // serializes SetCapacity() calls
+  std::mutex capacityMutex_;
+  std::atomic<size_t> capacity_;
+  std::atomic<bool> strictCapacityLimit_{false};
+  std::atomic<size_t> pinnedUsage_{0};
+  std::atomic<uint64_t> lastId_{0};
+
+  // objects of serialized entries that are referenced by handles, keyed by
+  // their item. The handles keep the items alive.
+  std::array<SharedObjectShard, 64> sharedObjects_;
+};
+
+// Allocate a new primary block cache backed by cachelib. NVM is enabled when
+// opts.fileName and opts.size are set.
+extern std::shared_ptr<rocksdb::Cache> NewRocksCachelibPrimaryCache(
+    const RocksCachelibOptions& opts);
+} // namespace rocks_secondary_cache
+} // namespace facebook
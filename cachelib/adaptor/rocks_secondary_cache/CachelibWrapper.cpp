@@ -23,7 +23,6 @@
 
 namespace facebook::rocks_secondary_cache {
 
-#define FB_CACHE_MAX_ITEM_SIZE 4 << 20
 using ApiWrapper = cachelib::FbInternalRuntimeUpdateWrapper<FbCache>;
 
 namespace {
@@ -249,13 +248,7 @@ bool RocksCachelibWrapper::UpdateMaxWriteRateForDynamicRandom(
   return ret;
 }
 
-// Global cache object and a default cache pool
-std::unique_ptr<rocksdb::SecondaryCache> NewRocksCachelibWrapper(
-    const RocksCachelibOptions& opts) {
-  std::unique_ptr<FbCache> cache;
-  std::unique_ptr<cachelib::CacheAdmin> admin;
-  cachelib::PoolId defaultPool;
-  FbCacheConfig config;
+NvmCacheConfig MakeNvmCacheConfig(const RocksCachelibOptions& opts) {
   NvmCacheConfig nvmConfig;
 
   nvmConfig.navyConfig.setBlockSize(opts.blockSize);
@@ -271,6 +264,17 @@ std::unique_ptr<rocksdb::SecondaryCache> NewRocksCachelibWrapper(
         .setMaxWriteRate(opts.maxWriteRate)
         .setAdmWriteRate(opts.admissionWriteRate);
   }
+  return nvmConfig;
+}
+
+// Global cache object and a default cache pool
+std::unique_ptr<rocksdb::SecondaryCache> NewRocksCachelibWrapper(
+    const RocksCachelibOptions& opts) {
+  std::unique_ptr<FbCache> cache;
+  std::unique_ptr<cachelib::CacheAdmin> admin;
+  cachelib::PoolId defaultPool;
+  FbCacheConfig config;
+  NvmCacheConfig nvmConfig = MakeNvmCacheConfig(opts);
 
   config.setCacheSize(opts.volatileSize)
       .setCacheName(opts.cacheName)
@@ -29,7 +29,8 @@ struct RocksCachelibOptions {
   // A name for the use case
   std::string cacheName;
 
-  // Path to the cache file
+  // Path to the cache file. For the primary cache, NVM is only enabled when
+  // this is set.
   std::string fileName;
 
   // Maximum size of the cache file
@@ -72,6 +73,12 @@ struct RocksCachelibOptions {
 
   // An oncall name for FB303 stats
   std::string oncallName;
+
+  // Primary cache only. Fractions of volatileSize given to the cachelib pools
+  // that back rocksdb's HIGH and BOTTOM priority entries. LOW priority gets
+  // the rest. A priority with a ratio of 0 shares the LOW priority pool.
+  double highPriPoolRatio = 0.2;
+  double bottomPriPoolRatio = 0.0;
 };
 
 using FbCache =
@@ -82,6 +89,9 @@ using FbCacheKey = typename FbCache::Key;
 using FbCacheReadHandle = typename FbCache::ReadHandle;
 using FbCacheItem = typename FbCache::Item;
 
+// Largest item, including the key, stored in the cache.
+#define FB_CACHE_MAX_ITEM_SIZE (4 << 20)
+
 // The RocksCachelibWrapper is a concrete implementation of
 // rocksdb::SecondaryCache. It can be allocated using
 // NewRocksCachelibWrapper() and the resulting pointer
@@ -160,5 +170,8 @@ class RocksCachelibWrapper : public rocksdb::SecondaryCache {
 // Allocate a new Cache instance with a rocksdb::TieredCache wrapper around it
 extern std::unique_ptr<rocksdb::SecondaryCache> NewRocksCachelibWrapper(
     const RocksCachelibOptions& opts);
+
+// Navy configuration for the file, size and admission policy in opts
+NvmCacheConfig MakeNvmCacheConfig(const RocksCachelibOptions& opts);
 } // namespace rocks_secondary_cache
 } // namespace facebook
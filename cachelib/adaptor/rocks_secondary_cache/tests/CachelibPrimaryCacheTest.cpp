@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cachelib/adaptor/rocks_secondary_cache/CachelibPrimaryCache.h>
+#include <common/files/FileUtil.h>
+#include <folly/Random.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace facebook::rocks_secondary_cache {
+using namespace rocksdb;
+
+class CachelibPrimaryCacheTest : public ::testing::Test,
+                                 public Cache::CreateContext {
+ public:
+  class TestItem {
+   public:
+    TestItem(const char* buf, size_t size) : buf_(buf, size) { numLive_++; }
+    ~TestItem() { numLive_--; }
+
+    const char* Buf() const { return buf_.data(); }
+    size_t Size() const { return buf_.size(); }
+    const std::string& Str() const { return buf_; }
+
+   private:
+    std::string buf_;
+  };
+
+  void SetUp() override {
+    numLive_ = 0;
+    path_ = files::FileUtil::recreateRandomTempDir("CachelibPrimaryCacheTest");
+  }
+
+  // Cache with a high priority pool and a cache file, unless @withNvm is
+  // false.
+  void MakeCache(bool withNvm) {
+    RocksCachelibOptions opts;
+    opts.volatileSize = kVolatileSize;
+    opts.cacheName = "CachelibPrimaryCacheTest";
+    if (withNvm) {
+      opts.fileName = path_ + "/cachelib_primary_cache_test_file";
+      opts.size = 64 << 20;
+    } else {
+      opts.size = 0;
+    }
+    opts.highPriPoolRatio = 0.25;
+    cache_ = NewRocksCachelibPrimaryCache(opts);
+  }
+
+ protected:
+  static const uint64_t kVolatileSize = 16 << 20;
+  static std::atomic<int> numLive_;
+
+  static size_t SizeCallback(Cache::ObjectPtr obj) {
+    return static_cast<TestItem*>(obj)->Size();
+  }
+
+  static Status SaveToCallback(Cache::ObjectPtr obj,
+                               size_t offset,
+                               size_t size,
+                               char* out) {
+    TestItem* item = static_cast<TestItem*>(obj);
+    EXPECT_EQ(size, item->Size());
+    EXPECT_EQ(offset, 0);
+    memcpy(out, item->Buf(), size);
+    return Status::OK();
+  }
+
+  static void DeletionCallback(Cache::ObjectPtr obj, MemoryAllocator*) {
+    delete static_cast<TestItem*>(obj);
+  }
+
+  static Status CreateCallback(const Slice& data,
+                               rocksdb::CompressionType /*type*/,
+                               rocksdb::CacheTier /*source*/,
+                               Cache::CreateContext* /*context*/,
+                               MemoryAllocator* /*allocator*/,
+                               Cache::ObjectPtr* out_obj,
+                               size_t* out_charge) {
+    *out_obj = new TestItem(data.data(), data.size());
+    *out_charge = data.size();
+    return Status::OK();
+  }
+
+  // helper without a serialized form, stored as an object pointer
+  static Cache::CacheItemHelper helper_object_;
+
+  static Cache::CacheItemHelper helper_;
+
+  std::string RandomString(int len) {
+    std::string ret;
+    ret.resize(len);
+    for (int i = 0; i < len; i++) {
+      ret[i] = static_cast<char>(' ' +
+                                 folly::Random::secureRand64(95)); // ' ' .. '~'
+    }
+    return ret;
+  }
+
+  Cache* cache() { return cache_.get(); }
+
+  Cache::Handle* CacheLookup(const Slice& key) {
+    return cache()->Lookup(key, &CachelibPrimaryCacheTest::helper_,
+                           /*create_context=*/this);
+  }
+
+  Status InsertItem(const std::string& key,
+                    const std::string& value,
+                    const Cache::CacheItemHelper* helper,
+                    Cache::Handle** handle = nullptr,
+                    Cache::Priority priority = Cache::Priority::LOW) {
+    return cache()->Insert(key, new TestItem(value.data(), value.size()),
+                           helper, value.size(), handle, priority);
+  }
+
+ private:
+  std::shared_ptr<Cache> cache_;
+  std::string path_;
+};
+
+std::atomic<int> CachelibPrimaryCacheTest::numLive_{0};
+
+Cache::CacheItemHelper CachelibPrimaryCacheTest::helper_object_(
+    CacheEntryRole::kMisc, CachelibPrimaryCacheTest::DeletionCallback);
+
+Cache::CacheItemHelper CachelibPrimaryCacheTest::helper_(
+    CacheEntryRole::kMisc,
+    CachelibPrimaryCacheTest::DeletionCallback,
+    CachelibPrimaryCacheTest::SizeCallback,
+    CachelibPrimaryCacheTest::SaveToCallback,
+    CachelibPrimaryCacheTest::CreateCallback,
+    &CachelibPrimaryCacheTest::helper_object_);
+
+TEST_F(CachelibPrimaryCacheTest, SerializedEntries) {
+  MakeCache(true /* withNvm */);
+  std::string str1 = RandomString(1020);
+  ASSERT_EQ(InsertItem("k1", str1, &CachelibPrimaryCacheTest::helper_),
+            Status::OK());
+  // the inserted object is released once it is saved
+  ASSERT_EQ(numLive_, 0);
+
+  auto* handle = CacheLookup("k1");
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Str(), str1);
+  ASSERT_EQ(cache()->GetCharge(handle), str1.size());
+  ASSERT_EQ(cache()->GetCacheItemHelper(handle),
+            &CachelibPrimaryCacheTest::helper_);
+  ASSERT_EQ(cache()->GetPinnedUsage(), str1.size());
+  ASSERT_TRUE(cache()->Ref(handle));
+  ASSERT_FALSE(cache()->Release(handle));
+  ASSERT_EQ(numLive_, 1);
+  ASSERT_FALSE(cache()->Release(handle));
+  ASSERT_EQ(numLive_, 0);
+  ASSERT_EQ(cache()->GetPinnedUsage(), 0);
+
+  // without a create callback the entry can not be re-created
+  ASSERT_EQ(cache()->Lookup("k1"), nullptr);
+
+  cache()->Erase("k1");
+  ASSERT_EQ(CacheLookup("k1"), nullptr);
+}
+
+TEST_F(CachelibPrimaryCacheTest, LookupsShareObject) {
+  MakeCache(false /* withNvm */);
+  std::string str1 = RandomString(1020);
+  ASSERT_EQ(InsertItem("k1", str1, &CachelibPrimaryCacheTest::helper_),
+            Status::OK());
+
+  // the object is created once and shared by the handles to the entry
+  auto* handle1 = CacheLookup("k1");
+  auto* handle2 = CacheLookup("k1");
+  ASSERT_NE(handle1, nullptr);
+  ASSERT_NE(handle2, nullptr);
+  ASSERT_EQ(cache()->Value(handle1), cache()->Value(handle2));
+  ASSERT_EQ(numLive_, 1);
+  auto* handle3 = cache()->Lookup("k1");
+  ASSERT_NE(handle3, nullptr);
+  ASSERT_EQ(cache()->Value(handle1), cache()->Value(handle3));
+
+  // releasing the last handle to a replaced entry does not erase the new one
+  std::string str2 = RandomString(1020);
+  ASSERT_EQ(InsertItem("k1", str2, &CachelibPrimaryCacheTest::helper_),
+            Status::OK());
+  ASSERT_FALSE(cache()->Release(handle3, true /* erase_if_last_ref */));
+  ASSERT_FALSE(cache()->Release(handle2, true /* erase_if_last_ref */));
+  ASSERT_EQ(numLive_, 1);
+  ASSERT_FALSE(cache()->Release(handle1, true /* erase_if_last_ref */));
+  ASSERT_EQ(numLive_, 0);
+
+  auto* handle = CacheLookup("k1");
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Str(), str2);
+  cache()->Release(handle);
+  ASSERT_EQ(numLive_, 0);
+}
+
+TEST_F(CachelibPrimaryCacheTest, InsertWithHandle) {
+  MakeCache(false /* withNvm */);
+  std::string str1 = RandomString(1020);
+  Cache::Handle* handle = nullptr;
+  ASSERT_EQ(InsertItem("k1", str1, &CachelibPrimaryCacheTest::helper_, &handle),
+            Status::OK());
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Str(), str1);
+  ASSERT_EQ(numLive_, 1);
+
+  // erasing on the last release removes the entry from the cache
+  ASSERT_TRUE(cache()->Release(handle, true /* erase_if_last_ref */));
+  ASSERT_EQ(numLive_, 0);
+  ASSERT_EQ(CacheLookup("k1"), nullptr);
+}
+
+TEST_F(CachelibPrimaryCacheTest, ObjectEntries) {
+  MakeCache(true /* withNvm */);
+  std::string str1 = RandomString(1020);
+  ASSERT_EQ(InsertItem("k1", str1, &CachelibPrimaryCacheTest::helper_object_),
+            Status::OK());
+  // the cache keeps the object alive
+  ASSERT_EQ(numLive_, 1);
+
+  auto* handle = cache()->Lookup("k1");
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Str(), str1);
+  ASSERT_EQ(cache()->GetCharge(handle), str1.size());
+
+  // the object outlives the erase while a handle references it
+  cache()->Erase("k1");
+  ASSERT_EQ(numLive_, 1);
+  ASSERT_EQ(cache()->Lookup("k1"), nullptr);
+  cache()->Release(handle);
+  ASSERT_EQ(numLive_, 0);
+
+  // replacing an entry deletes the old object
+  ASSERT_EQ(InsertItem("k2", str1, &CachelibPrimaryCacheTest::helper_object_),
+            Status::OK());
+  ASSERT_EQ(InsertItem("k2", str1, &CachelibPrimaryCacheTest::helper_object_),
+            Status::OK());
+  ASSERT_EQ(numLive_, 1);
+  cache()->EraseUnRefEntries();
+  ASSERT_EQ(numLive_, 0);
+}
+
+TEST_F(CachelibPrimaryCacheTest, ObjectEntriesEvicted) {
+  MakeCache(true /* withNvm */);
+  // fill the cache several times over. Object entries are deleted on
+  // eviction instead of going to the cache file.
+  const int numEntries = 4 * kVolatileSize / 4096;
+  for (int i = 0; i < numEntries; ++i) {
+    ASSERT_EQ(InsertItem("k" + std::to_string(i), RandomString(4000),
+                         &CachelibPrimaryCacheTest::helper_object_),
+              Status::OK());
+  }
+  ASSERT_LT(numLive_, numEntries / 2);
+  ASSERT_LE(cache()->GetUsage(), cache()->GetCapacity());
+  ASSERT_EQ(cache()->Lookup("k0"), nullptr);
+}
+
+TEST_F(CachelibPrimaryCacheTest, SerializedEntriesFromNvm) {
+  MakeCache(true /* withNvm */);
+  const int numEntries = 2 * kVolatileSize / 1024;
+  std::vector<std::string> values;
+  for (int i = 0; i < numEntries; ++i) {
+    values.push_back(RandomString(1000));
+    ASSERT_EQ(InsertItem("k" + std::to_string(i), values.back(),
+                         &CachelibPrimaryCacheTest::helper_),
+              Status::OK());
+  }
+  // the oldest entries were evicted from DRAM to the cache file
+  int hits = 0;
+  for (int i = 0; i < 100; ++i) {
+    auto* handle = CacheLookup("k" + std::to_string(i));
+    if (handle != nullptr) {
+      ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Str(),
+                values[i]);
+      cache()->Release(handle);
+      hits++;
+    }
+  }
+  ASSERT_GT(hits, 0);
+}
+
+TEST_F(CachelibPrimaryCacheTest, PriorityPools) {
+  MakeCache(false /* withNvm */);
+  const size_t capacity = cache()->GetCapacity();
+  ASSERT_GT(capacity, 0);
+
+  std::string str1 = RandomString(1020);
+  ASSERT_EQ(InsertItem("high", str1, &CachelibPrimaryCacheTest::helper_,
+                       nullptr, Cache::Priority::HIGH),
+            Status::OK());
+  // low priority entries do not evict the high priority ones
+  const int numEntries = 2 * kVolatileSize / 1024;
+  for (int i = 0; i < numEntries; ++i) {
+    ASSERT_EQ(InsertItem("k" + std::to_string(i), RandomString(1000),
+                         &CachelibPrimaryCacheTest::helper_),
+              Status::OK());
+  }
+  auto* handle = CacheLookup("high");
+  ASSERT_NE(handle, nullptr);
+  cache()->Release(handle);
+
+  cache()->SetCapacity(capacity / 2);
+  ASSERT_EQ(cache()->GetCapacity(), capacity / 2);
+  // capacity is bounded by the DRAM size of the cache
+  cache()->SetCapacity(2 * capacity);
+  ASSERT_EQ(cache()->GetCapacity(), capacity);
+}
+
+TEST_F(CachelibPrimaryCacheTest, TooLarge) {
+  MakeCache(false /* withNvm */);
+  std::string big = RandomString(8 << 20);
+  Cache::Handle* handle = nullptr;
+  // an entry that does not fit is handed back as a standalone handle
+  ASSERT_EQ(InsertItem("big", big, &CachelibPrimaryCacheTest::helper_, &handle),
+            Status::OK());
+  ASSERT_NE(handle, nullptr);
+  ASSERT_EQ(static_cast<TestItem*>(cache()->Value(handle))->Size(),
+            big.size());
+  cache()->Release(handle);
+  ASSERT_EQ(numLive_, 0);
+  ASSERT_EQ(CacheLookup("big"), nullptr);
+
+  cache()->SetStrictCapacityLimit(true);
+  ASSERT_TRUE(cache()->HasStrictCapacityLimit());
+  ASSERT_EQ(InsertItem("big", big, &CachelibPrimaryCacheTest::helper_, &handle),
+            Status::MemoryLimit());
+  ASSERT_EQ(numLive_, 0);
+}
+} // namespace facebook::rocks_secondary_cache
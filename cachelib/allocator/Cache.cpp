@@ -225,6 +225,16 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
   counters_.updateCount(statPrefix + "mem.system_free",
                         memStats.memAvailableSize);
   counters_.updateCount(statPrefix + "mem.process_rss", memStats.memRssSize);
+  counters_.updateCount(statPrefix + "mem.prefaulted",
+                        memStats.memPrefaultedSize);
+  counters_.updateCount(statPrefix + "mem.prefault_time_ms",
+                        memStats.memPrefaultDurationMs);
+  counters_.updateCount(statPrefix + "mem.metadata.regular",
+                        memStats.metadataMemory.regularBytes);
+  counters_.updateCount(statPrefix + "mem.metadata.transparent_huge_pages",
+                        memStats.metadataMemory.transparentHugePageBytes);
+  counters_.updateCount(statPrefix + "mem.metadata.hugetlb",
+                        memStats.metadataMemory.hugeTlbBytes);
   counters_.updateCount(statPrefix + "mem.size", memStats.ramCacheSize);
   counters_.updateCount(statPrefix + "mem.size.configured",
                         memStats.configuredRamCacheSize);
@@ -314,6 +324,12 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
                         stats.numRefcountOverflow);
   counters_.updateDelta(statPrefix + "cache.destructors.exceptions",
                         stats.numDestructorExceptions);
+  counters_.updateDelta(statPrefix + "cache.cas_conflicts",
+                        stats.numCasConflicts);
+  counters_.updateDelta(statPrefix + "cache.resizes.in_place",
+                        stats.numInPlaceResizes);
+  counters_.updateDelta(statPrefix + "cache.resizes.copied",
+                        stats.numCopyResizes);
   counters_.updateDelta(statPrefix + "cache.aborted_slab_releases",
                         stats.numAbortedSlabReleases);
 
@@ -50,6 +50,7 @@
 #include "cachelib/allocator/CacheTraits.h"
 #include "cachelib/allocator/CacheVersion.h"
 #include "cachelib/allocator/ChainedAllocs.h"
+#include "cachelib/allocator/GhostList.h"
 #include "cachelib/allocator/ICompactCache.h"
 #include "cachelib/allocator/KAllocation.h"
 #include "cachelib/allocator/MemoryMonitor.h"
@@ -260,6 +261,34 @@ class CacheAllocator : public CacheBase {
     bool fromNvm_ = false;
   };
 
+  // Version token for optimistic read-modify-write. It captures the item a
+  // key mapped to when it was looked up through find(key, version) and is
+  // consumed by insertIfVersion(). The token keeps a reference to the item so
+  // that its memory cannot be recycled for another item while the token is
+  // alive, which makes the identity comparison free of ABA problems. Release
+  // the token as soon as the update is done or abandoned, as it pins the
+  // item like any other handle.
+  //
+  // An empty token means the key did not exist at lookup time.
+  class ItemVersion {
+   public:
+    ItemVersion() = default;
+    ItemVersion(ItemVersion&&) = default;
+    ItemVersion& operator=(ItemVersion&&) = default;
+
+    // true if the key existed when the token was taken.
+    explicit operator bool() const noexcept { return handle_ != nullptr; }
+
+    void reset() { handle_.reset(); }
+
+   private:
+    explicit ItemVersion(ReadHandle handle) : handle_{std::move(handle)} {}
+
+    ReadHandle handle_;
+
+    friend CacheAllocator<CacheTrait>;
+  };
+
   // holds information about removal, used in RemoveCb
   struct RemoveCbData {
     // remove or eviction
@@ -537,6 +566,72 @@ class CacheAllocator : public CacheBase {
   //                  key does not exist.
   ReadHandle find(Key key);
 
+  // look up an item by its key across the nvm cache as well if enabled and
+  // return a version token for it to be used with insertIfVersion(). Like
+  // findToWrite(), this blocks until an item being read from flash has been
+  // loaded into DRAM.
+  //
+  // @param key       the key for lookup
+  // @param version   set to the version of the item, or to an empty token if
+  //                  the key does not exist.
+  //
+  // @return          the read handle for the item or a handle to nullptr if the
+  //                  key does not exist.
+  ReadHandle find(Key key, ItemVersion& version);
+
+  // Optimistic compare-and-swap. Makes the allocated handle accessible in
+  // place of the item described by the version token, only if that item is
+  // still the one mapped to the key. If the token is empty, the handle is
+  // inserted only if the key is still absent. The check and the swap happen
+  // under the access container's bucket lock, so concurrent writers using
+  // insertIfVersion(), insertOrReplace() or remove() on the same key are
+  // detected and exactly one of them wins.
+  //
+  // Only replacements of the item are detected. Callers mutating an item in
+  // place through findToWrite() need to keep their own synchronization.
+  //
+  // If this call fails, the allocation will be freed back when the handle
+  // gets out of scope in the caller. The token can be reset afterwards.
+  //
+  // @param  handle   the handle for the allocation.
+  // @param  version  the version obtained from find(key, version)
+  //
+  // @throw std::invalid_argument if the handle is already accessible or if
+  //        the version belongs to a different key.
+  // @return true if the handle was inserted, false if the key changed since
+  //         the version was taken.
+  bool insertIfVersion(const WriteHandle& handle, const ItemVersion& version);
+
+  enum class ResizeRes : uint8_t {
+    kSuccess,
+    kAllocFailed,
+    kNotAccessible,
+  };
+  // Resizes the item's value to newSize bytes, keeping the first
+  // min(getSize(), newSize) bytes of the value. If the new size maps to the
+  // item's current allocation class (see getUsableSize()), the item is
+  // resized in place without copying. Otherwise a new item is allocated in
+  // the same pool with the same TTL and the value is copied over. Under the
+  // item's chained item lock, the new item replaces the old one in the
+  // access container and then takes over any chained items.
+  //
+  // Like mutations through findToWrite(), resizing in place is not
+  // synchronized with concurrent readers of the item.
+  //
+  // @param  handle   the handle for the item to resize. It can be accessible
+  //                  or not yet inserted.
+  // @param  newSize  the new size of the value
+  //
+  // @throw std::invalid_argument if the handle is for a chained item or the
+  //        size is invalid.
+  // @return kSuccess and a handle to the resized item, which is the same
+  //         item if it was resized in place.
+  //         kAllocFailed if a bigger item could not be allocated.
+  //         kNotAccessible if the item was replaced or removed concurrently.
+  //         The old item and its chain are left untouched.
+  std::pair<ResizeRes, WriteHandle> resize(const WriteHandle& handle,
+                                           uint32_t newSize);
+
   // Warning: this API is synchronous today with HybridCache. This means as
   //          opposed to find(), we will block on an item being read from
   //          flash until it is loaded into DRAM-cache. In find(), if an item
@@ -629,6 +724,34 @@ class CacheAllocator : public CacheBase {
 
   AccessIterator end() { return accessContainer_->end(); }
 
+  using AccessCursor = typename AccessContainer::BucketCursor;
+  // Partitioned iteration for walking the cache from a pool of threads.
+  // Splits the access container into @numPartitions cursors over disjoint
+  // bucket ranges that can be walked concurrently. Each cursor yields
+  // batches of handles through AccessCursor::nextBatch, so only a batch of
+  // items is held unevictable at a time. Same visiting guarantees as
+  // begin(). Cursors must be destroyed before shutting down the cache.
+  //
+  // @throw std::invalid_argument if numPartitions is 0
+  std::vector<AccessCursor> getAccessCursors(size_t numPartitions) const {
+    return accessContainer_->partition(numPartitions);
+  }
+
+  using NvmItemVisitor = typename NvmCacheT::ItemVisitor;
+  // Walk the items in nvmcache that belong to partition @partition out of
+  // @numPartitions. This reads the whole flash device over all partitions and
+  // is meant for background analytics. Items present in both DRAM and
+  // nvmcache are visited by both walks. No-op if nvmcache is not enabled.
+  //
+  // @throw std::invalid_argument if the partition is invalid
+  void forEachNvmItem(uint32_t partition,
+                      uint32_t numPartitions,
+                      const NvmItemVisitor& visitor) {
+    if (isNvmCacheEnabled()) {
+      nvmCache_->forEachItem(partition, numPartitions, visitor);
+    }
+  }
+
   enum class RemoveRes : uint8_t {
     kSuccess,
     kNotFoundInRam,
@@ -1421,6 +1544,10 @@ class CacheAllocator : public CacheBase {
 
   void createMMContainers(const PoolId pid, MMConfig config);
 
+  // create the ghost lists for the allocation classes of the pool, sized to
+  // config_.ghostListSlabs slabs of each class.
+  void createGhostLists(PoolId pid);
+
   // acquire the MMContainer corresponding to the the Item's class and pool.
   //
   // @return pointer to the MMContainer.
@@ -1669,6 +1796,16 @@ class CacheAllocator : public CacheBase {
   // Only replaces an item if it is accessible
   bool replaceIfAccessible(Item& oldItem, Item& newItem);
 
+  // Changes the size of a regular item if the new size maps to the item's
+  // current allocation class.
+  //
+  // @param item      the item to resize
+  // @param newSize   the new size of the value
+  //
+  // @return true if the item was resized, false if it needs a different
+  //         allocation class.
+  bool resizeInPlace(Item& item, uint32_t newSize);
+
   // Inserts the allocated handle into the AccessContainer, making it
   // accessible for everyone. This needs to be the handle that the caller
   // allocated through _allocate_. If this call fails, the allocation will be
@@ -1895,7 +2032,7 @@ class CacheAllocator : public CacheBase {
 
   static typename MemoryAllocator::Config getAllocatorConfig(
       const Config& config) {
-    return MemoryAllocator::Config{
+    typename MemoryAllocator::Config allocatorConfig{
         config.defaultAllocSizes.empty()
             ? util::generateAllocSizes(
                   config.allocationClassSizeFactor,
@@ -1905,6 +2042,9 @@ class CacheAllocator : public CacheBase {
             : config.defaultAllocSizes,
         config.enableZeroedSlabAllocs, config.disableFullCoredump,
         config.lockMemory};
+    allocatorConfig.prefaultThreads = config.prefaultThreads;
+    allocatorConfig.prefaultNumaNodes = config.prefaultNumaNodes;
+    return allocatorConfig;
   }
 
   // starts one of the cache workers passing the current instance and the args
@@ -2008,8 +2148,60 @@ class CacheAllocator : public CacheBase {
   // @return true   if successfully recorded in MMContainer
   bool recordAccessInMMContainer(Item& item, AccessMode mode);
 
+  // Records @item leaving the cache for @reason in the item lifetime stats if
+  // they are enabled and this removal is sampled.
+  //
+  // @param admittedToNvm   for evictions, whether the item was written to
+  //                        the nvm cache
+  void recordItemRemoval(const Item& item,
+                         ItemRemovalReason reason,
+                         bool admittedToNvm = false);
+
+  // Remember the key of @item, which is being evicted, in the ghost list of
+  // its allocation class if ghost lists are enabled.
+  void recordInGhostList(const Item& item);
+
   WriteHandle findChainedItem(const Item& parent) const;
 
+  // Make @head the head of its parent's chain in the chain lookup.
+  //
+  // @return handle to the previous head, empty if there was none
+  WriteHandle setChainHead(ChainedItem& head);
+
+  // Remove the chain that @head leads from the chain lookup.
+  //
+  // @return false if @head was not the head of a chain
+  bool removeChainHead(ChainedItem& head);
+
+  // Bytes reserved at the end of every regular item's allocation to keep
+  // the head of its chain, see Config::configureChainedItemsInParent.
+  uint32_t chainHeadSlotSize() const noexcept {
+    return config_.isChainHeadInParent() ? sizeof(CompressedPtr::PtrType)
+                                         : 0;
+  }
+
+  // The slot lives in the last bytes of the allocation, so it does not move
+  // when the item is resized in place.
+  CompressedPtr::PtrType* getChainHeadSlot(const Item& parent) const {
+    XDCHECK(config_.isChainHeadInParent());
+    const auto allocSize =
+        allocator_->getAllocInfo(static_cast<const void*>(&parent)).allocSize;
+    return reinterpret_cast<CompressedPtr::PtrType*>(
+        reinterpret_cast<uintptr_t>(&parent) + allocSize -
+        sizeof(CompressedPtr::PtrType));
+  }
+
+  // Readers may not hold the chained item lock (e.g.
+  // viewAsChainedAllocsRange), so the slot is accessed atomically.
+  CompressedPtr loadChainHead(const Item& parent) const {
+    return CompressedPtr{static_cast<CompressedPtr::SerializedPtrType>(
+        __atomic_load_n(getChainHeadSlot(parent), __ATOMIC_ACQUIRE))};
+  }
+
+  void storeChainHead(const Item& parent, CompressedPtr head) {
+    __atomic_store_n(getChainHeadSlot(parent), head.getRaw(), __ATOMIC_RELEASE);
+  }
+
   // Get the thread local version of the Stats
   detail::Stats& stats() const noexcept { return stats_; }
 
@@ -2028,6 +2220,13 @@ class CacheAllocator : public CacheBase {
                      : false;
   }
 
+  // returns the lifecycle traces of recent slow nvm requests, one per line.
+  // Empty if nvm request tracing (NavyConfig::setRequestTracing) is not
+  // enabled.
+  std::string dumpNvmSlowRequests() const {
+    return nvmCache_ ? nvmCache_->dumpSlowRequests() : std::string{};
+  }
+
   // returns the background mover stats
   BackgroundMoverStats getBackgroundMoverStats(MoverDir direction) const {
     auto stats = BackgroundMoverStats{};
@@ -2270,6 +2469,17 @@ class CacheAllocator : public CacheBase {
   mutable util::FastStats<int64_t> handleCount_{};
 
   mutable detail::Stats stats_{};
+
+  // sampled item lifetime stats. nullptr unless enabled in the config.
+  std::unique_ptr<detail::ItemLifetimeTracker> lifetimeTracker_;
+
+  // fingerprints of the recently evicted keys of every allocation class.
+  // nullptr unless enabled in the config.
+  using GhostLists =
+      std::array<std::array<std::unique_ptr<GhostList>,
+                            MemoryAllocator::kMaxClasses>,
+                 MemoryPoolManager::kMaxPools>;
+  std::unique_ptr<GhostLists> ghostLists_;
   // allocator's items reaper to evict expired items in bg checking
   std::unique_ptr<Reaper<CacheT>> reaper_;
 
@@ -2667,13 +2877,19 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
   SCOPE_FAIL { stats_.invalidAllocs.inc(); };
 
   // number of bytes required for this item
-  const auto requiredSize = Item::getRequiredSize(key, size);
+  const auto requiredSize =
+      Item::getRequiredSize(key, size) + chainHeadSlotSize();
 
   // the allocation class in our memory allocator.
   const auto cid = allocator_->getAllocationClassId(pid, requiredSize);
 
   (*stats_.allocAttempts)[pid][cid].inc();
 
+  if (ghostLists_ && !fromBgThread) {
+    // the key was evicted from this class recently and is coming back
+    (*ghostLists_)[pid][cid]->remove(HashedKey{key}.keyHash());
+  }
+
   void* memory = allocator_->allocate(pid, requiredSize);
 
   if (backgroundEvictor_.size() && !fromBgThread &&
@@ -2700,6 +2916,9 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
 
     handle = acquire(new (memory) Item(key, size, creationTime, expiryTime));
     if (handle) {
+      if (config_.isChainHeadInParent()) {
+        storeChainHead(*handle, CompressedPtr{});
+      }
       handle.markNascent();
       (*stats_.fragmentationSize)[pid][cid].add(
           util::getFragmentation(*this, *handle));
@@ -2794,7 +3013,7 @@ void CacheAllocator<CacheTrait>::addChainedItem(WriteHandle& parent,
   auto l = chainedItemLocks_.lockExclusive(parent->getKey());
 
   // Insert into secondary lookup table for chained allocation
-  auto oldHead = chainedItemAccessContainer_->insertOrReplace(*child);
+  auto oldHead = setChainHead(child->asChainedItem());
   if (oldHead) {
     child->asChainedItem().appendChain(oldHead->asChainedItem(), compressor_);
   }
@@ -2844,10 +3063,9 @@ CacheAllocator<CacheTrait>::popChainedItem(WriteHandle& parent) {
 
     head = findChainedItem(*parent);
     if (head->asChainedItem().getNext(compressor_) != nullptr) {
-      chainedItemAccessContainer_->insertOrReplace(
-          *head->asChainedItem().getNext(compressor_));
+      setChainHead(*head->asChainedItem().getNext(compressor_));
     } else {
-      chainedItemAccessContainer_->remove(*head);
+      removeChainHead(head->asChainedItem());
       parent->unmarkHasChainedItem();
       stats_.numChainedParentItems.dec();
     }
@@ -2901,7 +3119,7 @@ void CacheAllocator<CacheTrait>::transferChainLocked(Item& parent,
   XDCHECK(headHandle);
 
   // remove from the access container since we are changing the key
-  chainedItemAccessContainer_->remove(*headHandle);
+  removeChainHead(headHandle->asChainedItem());
 
   // change the key of the chain to have them belong to the new parent.
   ChainedItem* curr = &headHandle->asChainedItem();
@@ -2915,7 +3133,7 @@ void CacheAllocator<CacheTrait>::transferChainLocked(Item& parent,
   }
 
   newParent.markHasChainedItem();
-  auto oldHead = chainedItemAccessContainer_->insertOrReplace(*headHandle);
+  auto oldHead = setChainHead(headHandle->asChainedItem());
   if (oldHead) {
     throw std::logic_error(
         folly::sformat("Did not expect to find an existing chain for {}",
@@ -3012,7 +3230,7 @@ void CacheAllocator<CacheTrait>::replaceInChainLocked(Item& oldItem,
   // if old item is the head, replace the head in the chain and insert into
   // the access container and append its chain.
   if (head.get() == &oldItem) {
-    chainedItemAccessContainer_->insertOrReplace(*newItemHdl);
+    setChainHead(newItemHdl->asChainedItem());
   } else {
     // oldItem is in the middle of the chain, find its previous and fix the
     // links
@@ -3185,7 +3403,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
           it.getKey()));
     }
 
-    if (!chainedItemAccessContainer_->remove(*head)) {
+    if (!removeChainHead(*head)) {
       throw exception::ChainedItemInvalid(folly::sformat(
           "Chained item associated with {} cannot be removed from hash table "
           "This should not happen here.",
@@ -3341,6 +3559,7 @@ void CacheAllocator<CacheTrait>::insertInMMContainer(Item& item) {
     throw std::runtime_error(folly::sformat(
         "Invalid state. Node {} was already in the container.", &item));
   }
+  allocator_->recordAccess(&item, item.getLastAccessTime());
 }
 
 /**
@@ -3435,6 +3654,7 @@ CacheAllocator<CacheTrait>::insertOrReplace(const WriteHandle& handle) {
   // Remove from LRU as well if we do have a handle of old item
   if (replaced) {
     removeFromMMContainer(*replaced);
+    recordItemRemoval(*replaced, ItemRemovalReason::kReplaced);
   }
 
   if (UNLIKELY(nvmCache_ != nullptr)) {
@@ -3459,6 +3679,185 @@ CacheAllocator<CacheTrait>::insertOrReplace(const WriteHandle& handle) {
   return replaced;
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::insertIfVersion(const WriteHandle& handle,
+                                                 const ItemVersion& version) {
+  XDCHECK(handle);
+  if (handle->isAccessible()) {
+    throw std::invalid_argument("Handle is already accessible");
+  }
+  if (!version) {
+    return insert(handle);
+  }
+
+  auto& oldItem = *(version.handle_.getInternal());
+  auto& newItem = *(handle.getInternal());
+  if (oldItem.getKey() != newItem.getKey()) {
+    throw std::invalid_argument(folly::sformat(
+        "Version is for key {}, but the handle has key {}",
+        oldItem.getKey(), newItem.getKey()));
+  }
+
+  HashedKey hk{newItem.getKey()};
+
+  insertInMMContainer(newItem);
+  bool replaced = false;
+  try {
+    auto lock = nvmCache_ ? nvmCache_->getItemDestructorLock(hk)
+                          : std::unique_lock<TimedMutex>();
+
+    // the token holds a reference on the old item, so it is still the item
+    // mapped to the key as long as it is accessible. This is checked under
+    // the bucket lock, atomically with the swap.
+    replaced = accessContainer_->replaceIfAccessible(oldItem, newItem);
+
+    if (replaced && oldItem.isNvmClean() && !oldItem.isNvmEvicted()) {
+      // see insertOrReplace() for why the old copy in nvm is marked removed.
+      nvmCache_->markNvmItemRemovedLocked(hk);
+    }
+  } catch (const std::exception&) {
+    removeFromMMContainer(newItem);
+    if (auto eventTracker = getEventTracker()) {
+      eventTracker->record(AllocatorApiEvent::INSERT_OR_REPLACE,
+                           handle->getKey(),
+                           AllocatorApiResult::FAILED,
+                           handle->getSize(),
+                           handle->getConfiguredTTL().count());
+    }
+    throw;
+  }
+
+  if (!replaced) {
+    removeFromMMContainer(newItem);
+    stats().numCasConflicts.inc();
+    if (auto eventTracker = getEventTracker()) {
+      eventTracker->record(AllocatorApiEvent::INSERT_OR_REPLACE,
+                           handle->getKey(),
+                           AllocatorApiResult::FAILED,
+                           handle->getSize(),
+                           handle->getConfiguredTTL().count());
+    }
+    return false;
+  }
+
+  removeFromMMContainer(oldItem);
+  recordItemRemoval(oldItem, ItemRemovalReason::kReplaced);
+
+  if (UNLIKELY(nvmCache_ != nullptr) && oldItem.isNvmClean()) {
+    nvmCache_->remove(hk, nvmCache_->createDeleteTombStone(hk));
+  }
+
+  handle.unmarkNascent();
+
+  if (auto eventTracker = getEventTracker()) {
+    eventTracker->record(AllocatorApiEvent::INSERT_OR_REPLACE, handle->getKey(),
+                         AllocatorApiResult::REPLACED, handle->getSize(),
+                         handle->getConfiguredTTL().count());
+  }
+
+  return true;
+}
+
+template <typename CacheTrait>
+std::pair<typename CacheAllocator<CacheTrait>::ResizeRes,
+          typename CacheAllocator<CacheTrait>::WriteHandle>
+CacheAllocator<CacheTrait>::resize(const WriteHandle& handle,
+                                   uint32_t newSize) {
+  XDCHECK(handle);
+  if (handle->isChainedItem()) {
+    throw std::invalid_argument(folly::sformat(
+        "Chained items can not be resized {}", handle->toString()));
+  }
+
+  auto& oldItem = *(handle.getInternal());
+  if (resizeInPlace(oldItem, newSize)) {
+    stats().numInPlaceResizes.inc();
+    // the copy in nvm no longer matches the value.
+    invalidateNvm(oldItem);
+    return {ResizeRes::kSuccess, handle.clone()};
+  }
+
+  const auto pid = allocator_->getAllocInfo(oldItem.getMemory()).poolId;
+  auto newHandle = allocateInternal(pid, oldItem.getKey(), newSize,
+                                    oldItem.getCreationTime(),
+                                    oldItem.getExpiryTime());
+  if (!newHandle) {
+    return {ResizeRes::kAllocFailed, WriteHandle{}};
+  }
+  std::memcpy(newHandle->getMemory(), oldItem.getMemory(),
+              std::min(oldItem.getSize(), newSize));
+
+  if (handle.isNascent()) {
+    // not inserted yet, the caller inserts the new item instead.
+    if (oldItem.hasChainedItem()) {
+      auto l = chainedItemLocks_.lockExclusive(oldItem.getKey());
+      transferChainLocked(oldItem, *newHandle);
+    }
+    stats().numCopyResizes.inc();
+    return {ResizeRes::kSuccess, std::move(newHandle)};
+  }
+
+  HashedKey hk{oldItem.getKey()};
+  bool nvmClean = false;
+  { // scope for nvm destructor and chained item locks
+    // The old item is not accessible after the swap, so whether its nvm copy
+    // must be invalidated is decided under the destructor lock before it, as
+    // in insertOrReplace(). The destructor lock is taken first, as in
+    // removeImpl().
+    auto nvmLock = nvmCache_ ? nvmCache_->getItemDestructorLock(hk)
+                             : std::unique_lock<TimedMutex>();
+    // Swap the items first and only then move the chain, so that losing the
+    // race against a concurrent replace or remove leaves the chain with the
+    // old item. Holding the lock keeps chain readers from seeing the new
+    // item without its chain.
+    auto l = chainedItemLocks_.lockExclusive(oldItem.getKey());
+    nvmClean = oldItem.isNvmClean();
+    if (!replaceIfAccessible(oldItem, *newHandle)) {
+      return {ResizeRes::kNotAccessible, WriteHandle{}};
+    }
+    if (nvmClean && !oldItem.isNvmEvicted()) {
+      nvmCache_->markNvmItemRemovedLocked(hk);
+    }
+    if (oldItem.hasChainedItem()) {
+      transferChainLocked(oldItem, *newHandle);
+    }
+  }
+  newHandle.unmarkNascent();
+  recordItemRemoval(oldItem, ItemRemovalReason::kReplaced);
+  if (UNLIKELY(nvmCache_ != nullptr) && nvmClean) {
+    nvmCache_->remove(hk, nvmCache_->createDeleteTombStone(hk));
+  }
+  stats().numCopyResizes.inc();
+
+  if (auto eventTracker = getEventTracker()) {
+    eventTracker->record(AllocatorApiEvent::INSERT_OR_REPLACE,
+                         newHandle->getKey(), AllocatorApiResult::REPLACED,
+                         newHandle->getSize(),
+                         newHandle->getConfiguredTTL().count());
+  }
+  return {ResizeRes::kSuccess, std::move(newHandle)};
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::resizeInPlace(Item& item, uint32_t newSize) {
+  XDCHECK(!item.isChainedItem());
+  const auto allocInfo = allocator_->getAllocInfo(item.getMemory());
+  const auto requiredSize =
+      Item::getRequiredSize(item.getKey(), newSize) + chainHeadSlotSize();
+  if (requiredSize == 0 ||
+      allocator_->getAllocationClassId(allocInfo.poolId, requiredSize) !=
+          allocInfo.classId) {
+    return false;
+  }
+
+  auto& fragmentation =
+      (*stats_.fragmentationSize)[allocInfo.poolId][allocInfo.classId];
+  fragmentation.sub(util::getFragmentation(*this, item));
+  item.changeSize(newSize);
+  fragmentation.add(util::getFragmentation(*this, item));
+  return true;
+}
+
 /* Next two methods are used to asynchronously move Item between Slabs.
  *
  * The thread, which moves Item, allocates new Item in the tier we are moving to
@@ -3713,9 +4112,13 @@ CacheAllocator<CacheTrait>::getNextCandidate(PoolId pid,
 
   unlinkItemForEviction(*candidate);
 
-  if (token.isValid() && shouldWriteToNvmCacheExclusive(*candidate)) {
+  const bool admittedToNvm =
+      token.isValid() && shouldWriteToNvmCacheExclusive(*candidate);
+  if (admittedToNvm) {
     nvmCache_->put(*candidate, std::move(token));
   }
+  recordItemRemoval(*candidate, ItemRemovalReason::kEvicted, admittedToNvm);
+  recordInGhostList(*candidate);
   return {candidate, toRecycle};
 }
 
@@ -3986,6 +4389,7 @@ CacheAllocator<CacheTrait>::removeImpl(HashedKey hk,
   // allocator.
   if (success) {
     stats_.numCacheRemoveRamHits.inc();
+    recordItemRemoval(item, ItemRemovalReason::kRemoved);
     return RemoveRes::kSuccess;
   }
   return RemoveRes::kNotFoundInRam;
@@ -4187,6 +4591,20 @@ CacheAllocator<CacheTrait>::find(typename Item::Key key) {
   return findImpl(key, AccessMode::kRead);
 }
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::ReadHandle
+CacheAllocator<CacheTrait>::find(typename Item::Key key,
+                                 ItemVersion& version) {
+  auto handle = findImpl(key, AccessMode::kRead);
+  // comparing against nullptr waits for items being read from flash.
+  if (handle == nullptr) {
+    version = ItemVersion{};
+    return handle;
+  }
+  version = ItemVersion{handle.clone()};
+  return handle;
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::markUseful(const ReadHandle& handle,
                                             AccessMode mode) {
@@ -4220,8 +4638,55 @@ bool CacheAllocator<CacheTrait>::recordAccessInMMContainer(Item& item,
     ring_->trackItem(reinterpret_cast<uintptr_t>(&item), item.getSize());
   }
 
+  if (lifetimeTracker_) {
+    item.incHitCount();
+  }
+
   auto& mmContainer = getMMContainer(allocInfo.poolId, allocInfo.classId);
-  return mmContainer.recordAccess(item, mode);
+  if (!mmContainer.recordAccess(item, mode)) {
+    return false;
+  }
+  // only when the container updated the item's access time, which keeps
+  // this off most hits
+  allocator_->recordAccess(&item, item.getLastAccessTime());
+  return true;
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::recordItemRemoval(const Item& item,
+                                                   ItemRemovalReason reason,
+                                                   bool admittedToNvm) {
+  if (!lifetimeTracker_ || !lifetimeTracker_->shouldSample()) {
+    return;
+  }
+
+  auto outcome = NvmAdmissionOutcome::kNoNvm;
+  if (admittedToNvm) {
+    outcome = NvmAdmissionOutcome::kAdmitted;
+  } else if (isNvmCacheEnabled()) {
+    outcome = item.isNvmClean() && !item.isNvmEvicted()
+                  ? NvmAdmissionOutcome::kAlreadyInNvm
+                  : NvmAdmissionOutcome::kRejected;
+  }
+
+  const auto allocInfo =
+      allocator_->getAllocInfo(static_cast<const void*>(&item));
+  const auto now = util::getCurrentTimeSec();
+  const auto creationTime = item.getCreationTime();
+  lifetimeTracker_->record(allocInfo.poolId, allocInfo.classId, reason,
+                           now > creationTime ? now - creationTime : 0,
+                           item.getHitCount(), outcome);
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::recordInGhostList(const Item& item) {
+  if (!ghostLists_) {
+    return;
+  }
+  const auto allocInfo =
+      allocator_->getAllocInfo(static_cast<const void*>(&item));
+  (*ghostLists_)[allocInfo.poolId][allocInfo.classId]->insert(
+      HashedKey{item.getKey()}.keyHash());
 }
 
 template <typename CacheTrait>
@@ -4230,7 +4695,8 @@ uint32_t CacheAllocator<CacheTrait>::getUsableSize(const Item& item) const {
       allocator_->getAllocInfo(static_cast<const void*>(&item)).allocSize;
   return item.isChainedItem()
              ? allocSize - ChainedItem::getRequiredSize(0)
-             : allocSize - Item::getRequiredSize(item.getKey(), 0);
+             : allocSize - Item::getRequiredSize(item.getKey(), 0) -
+                   chainHeadSlotSize();
 }
 
 template <typename CacheTrait>
@@ -4476,6 +4942,9 @@ PoolId CacheAllocator<CacheTrait>::addPool(
   std::unique_lock w(poolsResizeAndRebalanceLock_);
   auto pid = allocator_->addPool(name, size, allocSizes, ensureProvisionable);
   createMMContainers(pid, std::move(config));
+  if (ghostLists_) {
+    createGhostLists(pid);
+  }
   setRebalanceStrategy(pid, std::move(rebalanceStrategy));
   setResizeStrategy(pid, std::move(resizeStrategy));
 
@@ -4559,6 +5028,17 @@ void CacheAllocator<CacheTrait>::createMMContainers(const PoolId pid,
   }
 }
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::createGhostLists(PoolId pid) {
+  auto& pool = allocator_->getPool(pid);
+  for (unsigned int cid = 0; cid < pool.getNumClassId(); ++cid) {
+    const auto allocsPerSlab =
+        pool.getAllocationClass(static_cast<ClassId>(cid)).getAllocsPerSlab();
+    (*ghostLists_)[pid][cid] =
+        std::make_unique<GhostList>(allocsPerSlab * config_.ghostListSlabs);
+  }
+}
+
 template <typename CacheTrait>
 PoolId CacheAllocator<CacheTrait>::getPoolId(
     folly::StringPiece name) const noexcept {
@@ -4676,6 +5156,12 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
             mmContainers_[poolId][cid]->getStats()}
 
           });
+      if (lifetimeTracker_) {
+        cacheStats[cid].lifetimeStat = lifetimeTracker_->getStat(poolId, cid);
+      }
+      if (ghostLists_) {
+        cacheStats[cid].ghostHits = (*ghostLists_)[poolId][cid]->getHits();
+      }
       totalHits += classHits;
     }
   }
@@ -4998,9 +5484,13 @@ void CacheAllocator<CacheTrait>::evictForSlabRelease(Item& item) {
   // no other reader can be added to the waiters list
   wakeUpWaiters(evicted->getKey(), {});
 
-  if (token.isValid() && shouldWriteToNvmCacheExclusive(*evicted)) {
+  const bool admittedToNvm =
+      token.isValid() && shouldWriteToNvmCacheExclusive(*evicted);
+  if (admittedToNvm) {
     nvmCache_->put(*evicted, std::move(token));
   }
+  recordItemRemoval(*evicted, ItemRemovalReason::kSlabRelease, admittedToNvm);
+  recordInGhostList(*evicted);
 
   const auto allocInfo =
       allocator_->getAllocInfo(static_cast<const void*>(&item));
@@ -5030,6 +5520,7 @@ bool CacheAllocator<CacheTrait>::removeIfExpired(const ReadHandle& handle) {
       accessContainer_->removeIf(*(handle.getInternal()), itemExpiryPredicate);
   if (removedHandle) {
     removeFromMMContainer(*(handle.getInternal()));
+    recordItemRemoval(*removedHandle, ItemRemovalReason::kExpired);
     return true;
   }
 
@@ -5246,6 +5737,7 @@ folly::IOBufQueue CacheAllocator<CacheTrait>::saveStateToIOBuf() {
   *metadata_.numChainedParentItems() = stats_.numChainedParentItems.get();
   *metadata_.numChainedChildItems() = stats_.numChainedChildItems.get();
   *metadata_.numAbortedSlabReleases() = stats_.numAbortedSlabReleases.get();
+  *metadata_.chainHeadInParent() = config_.isChainHeadInParent();
 
   auto serializeMMContainers = [](MMContainers& mmContainers) {
     MMSerializationTypeContainer state;
@@ -5440,6 +5932,14 @@ CacheAllocator<CacheTrait>::deserializeCacheAllocatorMetadata(
     throw std::invalid_argument(folly::sformat("Expected {}, got {} for MMType",
                                                *meta.mmType(), MMType::kId));
   }
+
+  // the item layout differs, so the items can not be reused
+  if (*meta.chainHeadInParent() != config_.isChainHeadInParent()) {
+    throw std::invalid_argument(
+        folly::sformat("Expected {}, got {} for chainHeadInParent",
+                       *meta.chainHeadInParent(),
+                       config_.isChainHeadInParent()));
+  }
   return meta;
 }
 
@@ -5467,6 +5967,17 @@ void CacheAllocator<CacheTrait>::adjustHandleCountForThread_private(
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::initStats() {
   stats_.init();
+  if (config_.itemLifetimeStatsSampleRate > 0) {
+    lifetimeTracker_ = std::make_unique<detail::ItemLifetimeTracker>(
+        config_.itemLifetimeStatsSampleRate);
+  }
+  if (config_.ghostListSlabs > 0) {
+    ghostLists_ = std::make_unique<GhostLists>();
+    // pools restored from a previous instance
+    for (const auto pid : filterCompactCachePools(allocator_->getPoolIds())) {
+      createGhostLists(pid);
+    }
+  }
 
   // deserialize the fragmentation size of each thread.
   for (const auto& pid : *metadata_.fragmentationSize()) {
@@ -5503,11 +6014,41 @@ void CacheAllocator<CacheTrait>::forEachChainedItem(
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::WriteHandle
 CacheAllocator<CacheTrait>::findChainedItem(const Item& parent) const {
+  if (config_.isChainHeadInParent()) {
+    auto* head = compressor_.unCompress(loadChainHead(parent));
+    return head ? const_cast<CacheAllocator*>(this)->acquire(head)
+                : WriteHandle{};
+  }
   const auto cPtr = compressor_.compress(&parent);
   return chainedItemAccessContainer_->find(
       Key{reinterpret_cast<const char*>(&cPtr), ChainedItem::kKeySize});
 }
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::setChainHead(ChainedItem& head) {
+  if (!config_.isChainHeadInParent()) {
+    return chainedItemAccessContainer_->insertOrReplace(head);
+  }
+  const auto& parent = head.getParentItem(compressor_);
+  auto oldHead = findChainedItem(parent);
+  storeChainHead(parent, compressor_.compress(&head));
+  return oldHead;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::removeChainHead(ChainedItem& head) {
+  if (!config_.isChainHeadInParent()) {
+    return chainedItemAccessContainer_->remove(head);
+  }
+  const auto& parent = head.getParentItem(compressor_);
+  if (!(loadChainHead(parent) == compressor_.compress(&head))) {
+    return false;
+  }
+  storeChainHead(parent, CompressedPtr{});
+  return true;
+}
+
 template <typename CacheTrait>
 template <typename Handle, typename Iter>
 CacheChainedAllocs<CacheAllocator<CacheTrait>, Handle, Iter>
@@ -5582,7 +6123,10 @@ CacheMemoryStats CacheAllocator<CacheTrait>::getCacheMemoryStats() const {
                           allocator_->getUnreservedMemorySize(),
                           nvmCache_ ? nvmCache_->getSize() : 0,
                           util::getMemAvailable(),
-                          util::getRSSBytes()};
+                          util::getRSSBytes(),
+                          allocator_->getPrefaultedMemorySize(),
+                          allocator_->getPrefaultDurationMs(),
+                          util::getMetadataMemoryStats()};
 }
 
 template <typename CacheTrait>
@@ -162,9 +162,34 @@ class CacheAllocatorConfig {
   CacheAllocatorConfig& configureChainedItems(size_t numEntries,
                                               uint32_t lockPower = 10);
 
+  // Keep the pointer to the head of an item's chain in the item itself
+  // instead of a separate hash table. This saves a hash table lookup on
+  // every chain access and the memory of the chained item access container,
+  // at the cost of sizeof(CompressedPtr) bytes in every regular item. Must
+  // be the same across warm roll.
+  //
+  // @param lockPower  this controls the number of locks (2^lockPower) for
+  //                   synchronizing operations on chained items.
+  CacheAllocatorConfig& configureChainedItemsInParent(uint32_t lockPower = 10);
+
+  bool isChainHeadInParent() const noexcept { return chainHeadInParent; }
+
   // enable tracking tail hits
   CacheAllocatorConfig& enableTailHitsTracking();
 
+  // Collect sampled histograms of the time in cache, hits, removal reason and
+  // NVM admission outcome of the items of every allocation class, exported
+  // as CacheStat::lifetimeStat in the pool stats. One in @sampleRate
+  // removals is recorded on each thread.
+  CacheAllocatorConfig& enableItemLifetimeStats(uint32_t sampleRate = 100);
+
+  // Remember the fingerprints of the keys recently evicted from every
+  // allocation class, as many as @numSlabs slabs of the class hold. Keys
+  // allocated again while still remembered are counted as CacheStat::ghostHits,
+  // the hits the class would have got with @numSlabs more slabs. Costs 4 bytes
+  // per remembered key.
+  CacheAllocatorConfig& enableGhostLists(uint32_t numSlabs = 1);
+
   // Turn on full core dump which includes all the cache memory.
   // This is not recommended for production as it can significantly slow down
   // the coredumping process.
@@ -192,6 +217,16 @@ class CacheAllocatorConfig {
   // If memory monitor is enabled, this is not usually needed.
   CacheAllocatorConfig& setMemoryLocking(bool enable);
 
+  // Page in the cache memory from @numThreads threads in parallel instead of
+  // a single throttled thread. Each thread pages in one contiguous range of
+  // slabs and runs on one of @numaNodes (round robin), so first touch places
+  // the range on that node; empty leaves the threads unpinned. Implies
+  // setMemoryLocking(true). Only applies when creating a new cache.
+  //
+  // @throw std::invalid_argument if numThreads is 0
+  CacheAllocatorConfig& enableParallelMemoryPrefault(
+      unsigned int numThreads, std::vector<unsigned int> numaNodes = {});
+
   // This allows cache to be persisted across restarts. One example use case is
   // to preserve the cache when releasing a new version of your service. Refer
   // to our user guide for how to set up cache persistence.
@@ -518,6 +553,14 @@ class CacheAllocatorConfig {
   // whether to allow tracking tail hits in MM2Q
   bool trackTailHits{false};
 
+  // if non-zero, one in these many removed items is recorded in the item
+  // lifetime stats
+  uint32_t itemLifetimeStatsSampleRate{0};
+
+  // if non-zero, every allocation class keeps a ghost list of evicted keys
+  // worth these many slabs
+  uint32_t ghostListSlabs{0};
+
   // Memory monitoring config
   MemoryMonitor::Config memMonitorConfig;
 
@@ -568,6 +611,10 @@ class CacheAllocatorConfig {
   // add/pop and between moving during slab rebalancing
   uint32_t chainedItemsLockPower{10};
 
+  // whether the head of the chain is kept in the parent item rather than in
+  // the chained item access container
+  bool chainHeadInParent{false};
+
   // Configuration for the main access container which manages the lookup
   // for all normal items
   AccessConfig accessConfig{};
@@ -621,6 +668,11 @@ class CacheAllocatorConfig {
   // This option has no effect when attaching to existing cache.
   bool lockMemory{false};
 
+  // number of threads paging in the memory when lockMemory is set, and the
+  // NUMA nodes they run on. 0 pages in from a single throttled thread.
+  unsigned int prefaultThreads{0};
+  std::vector<unsigned int> prefaultNumaNodes;
+
   // These configs configure how MemoryAllocator will be generating
   // allocation class sizes for each pool by default
   double allocationClassSizeFactor{1.25};
@@ -845,12 +897,44 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureChainedItems(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureChainedItemsInParent(
+    uint32_t lockPower) {
+  // the chained item access container is unused, keep it minimal
+  chainedItemAccessConfig = AccessConfig{0 /* bucketsPower */,
+                                         0 /* locksPower */};
+  chainedItemsLockPower = lockPower;
+  chainHeadInParent = true;
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableTailHitsTracking() {
   trackTailHits = true;
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableItemLifetimeStats(
+    uint32_t sampleRate) {
+  if (sampleRate == 0) {
+    throw std::invalid_argument(
+        "item lifetime stats sample rate must be greater than 0");
+  }
+  itemLifetimeStatsSampleRate = sampleRate;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableGhostLists(
+    uint32_t numSlabs) {
+  if (numSlabs == 0) {
+    throw std::invalid_argument("ghost list slabs must be greater than 0");
+  }
+  ghostListSlabs = numSlabs;
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setFullCoredump(bool enable) {
   disableFullCoredump = !enable;
@@ -884,6 +968,19 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setMemoryLocking(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableParallelMemoryPrefault(
+    unsigned int numThreads, std::vector<unsigned int> numaNodes) {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "number of memory prefault threads must be greater than 0");
+  }
+  lockMemory = true;
+  prefaultThreads = numThreads;
+  prefaultNumaNodes = std::move(numaNodes);
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableCachePersistence(
     std::string cacheDirectory, void* baseAddr) {
@@ -1181,6 +1278,9 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["slabReleaseStuckThreshold"] =
       util::toString(slabReleaseStuckThreshold);
   configMap["trackTailHits"] = std::to_string(trackTailHits);
+  configMap["itemLifetimeStatsSampleRate"] =
+      std::to_string(itemLifetimeStatsSampleRate);
+  configMap["ghostListSlabs"] = std::to_string(ghostListSlabs);
   // Stringify enum
   switch (memMonitorConfig.mode) {
   case MemoryMonitor::FreeMemory:
@@ -1213,12 +1313,14 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
       std::to_string(thresholdForConvertingToIOBuf);
   configMap["movingTries"] = std::to_string(movingTries);
   configMap["chainedItemsLockPower"] = std::to_string(chainedItemsLockPower);
+  configMap["chainHeadInParent"] = chainHeadInParent ? "true" : "false";
   configMap["removeCb"] = removeCb ? "set" : "empty";
   configMap["nvmAP"] = nvmCacheAP ? "custom" : "empty";
   configMap["nvmAPRejectFirst"] = rejectFirstAPNumEntries ? "set" : "empty";
   configMap["moveCb"] = moveCb ? "set" : "empty";
   configMap["enableZeroedSlabAllocs"] = std::to_string(enableZeroedSlabAllocs);
   configMap["lockMemory"] = std::to_string(lockMemory);
+  configMap["prefaultThreads"] = std::to_string(prefaultThreads);
   configMap["allocationClassSizeFactor"] =
       std::to_string(allocationClassSizeFactor);
   configMap["maxAllocationClassSize"] = std::to_string(maxAllocationClassSize);
@@ -238,6 +238,14 @@ class CACHELIB_PACKED_ATTR CacheItem {
   void unmarkNvmEvicted() noexcept;
   bool isNvmEvicted() const noexcept;
 
+  /**
+   * Saturating count of the hits on this item, up to
+   * RefcountWithFlags::kMaxHitCount. Only maintained when item lifetime stats
+   * are enabled.
+   */
+  void incHitCount() noexcept;
+  uint8_t getHitCount() const noexcept;
+
   /**
    * Function to set the timestamp for when to expire an item
    *
@@ -289,6 +297,13 @@ class CACHELIB_PACKED_ATTR CacheItem {
   //        size does not match with the current key
   void changeKey(Key key);
 
+  // changes the size of the item's value in place. This is only supported for
+  // regular items, and the new size must fit the item's existing allocation.
+  //
+  // @throw std::invalid_argument if item is a chained item or the size is
+  //        too big
+  void changeSize(uint32_t size);
+
   void* getMemoryInternal() const noexcept;
 
   /**
@@ -732,6 +747,16 @@ void CacheItem<CacheTrait>::changeKey(Key key) {
   XDCHECK_EQ(key, getKey());
 }
 
+template <typename CacheTrait>
+void CacheItem<CacheTrait>::changeSize(uint32_t size) {
+  if (isChainedItem()) {
+    throw std::invalid_argument("Chained items can not be resized");
+  }
+
+  alloc_.changeSize(size);
+  XDCHECK_EQ(size, getSize());
+}
+
 template <typename CacheTrait>
 RefcountWithFlags::Value CacheItem<CacheTrait>::getRefCount() const noexcept {
   return ref_.getAccessRef();
@@ -843,6 +868,16 @@ bool CacheItem<CacheTrait>::isNvmEvicted() const noexcept {
   return ref_.isNvmEvicted();
 }
 
+template <typename CacheTrait>
+void CacheItem<CacheTrait>::incHitCount() noexcept {
+  ref_.incHitCount();
+}
+
+template <typename CacheTrait>
+uint8_t CacheItem<CacheTrait>::getHitCount() const noexcept {
+  return ref_.getHitCount();
+}
+
 template <typename CacheTrait>
 void CacheItem<CacheTrait>::markIsChainedItem() noexcept {
   XDCHECK(!hasChainedItem());
@@ -16,6 +16,8 @@
 
 #include "cachelib/allocator/CacheStats.h"
 
+#include <cmath>
+
 #include "cachelib/allocator/CacheStatsInternal.h"
 
 namespace facebook::cachelib {
@@ -50,7 +52,7 @@ struct SizeVerify {};
 
 void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
 #ifndef SKIP_SIZE_VERIFY
-  SizeVerify<sizeof(Stats)> a = SizeVerify<16272>{};
+  SizeVerify<sizeof(Stats)> a = SizeVerify<16296>{};
   std::ignore = a;
 #endif
   ret.numCacheGets = numCacheGets.get();
@@ -61,6 +63,9 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numCacheEvictions = numCacheEvictions.get();
   ret.numRamDestructorCalls = numRamDestructorCalls.get();
   ret.numDestructorExceptions = numDestructorExceptions.get();
+  ret.numCasConflicts = numCasConflicts.get();
+  ret.numInPlaceResizes = numInPlaceResizes.get();
+  ret.numCopyResizes = numCopyResizes.get();
 
   ret.numNvmGets = numNvmGets.get();
   ret.numNvmGetMiss = numNvmGetMiss.get();
@@ -142,8 +147,126 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numHandleWaitBlocks = numHandleWaitBlocks.get();
 }
 
+ItemLifetimeTracker::ItemLifetimeTracker(uint32_t sampleRate)
+    : sampleRate_{sampleRate} {
+  if (sampleRate_ == 0) {
+    throw std::invalid_argument(
+        "item lifetime stats sample rate must be greater than 0");
+  }
+}
+
+ItemLifetimeTracker::~ItemLifetimeTracker() {
+  for (auto& pool : pools_) {
+    delete pool.load(std::memory_order_relaxed);
+  }
+}
+
+ItemLifetimeTracker::ClassCounters& ItemLifetimeTracker::getCounters(
+    PoolId pid, ClassId cid) {
+  auto* pool = pools_[pid].load(std::memory_order_acquire);
+  if (pool == nullptr) {
+    // first sampled removal from this pool. Racing threads allocate their own
+    // counters and all but one of them throw theirs away.
+    auto newPool = std::make_unique<PoolCounters>();
+    if (pools_[pid].compare_exchange_strong(pool, newPool.get(),
+                                            std::memory_order_acq_rel)) {
+      pool = newPool.release();
+    }
+  }
+  return (*pool)[cid];
+}
+
+void ItemLifetimeTracker::record(PoolId pid,
+                                 ClassId cid,
+                                 ItemRemovalReason reason,
+                                 uint32_t lifetimeSecs,
+                                 uint8_t hits,
+                                 NvmAdmissionOutcome outcome) {
+  auto& c = getCounters(pid, cid);
+  const auto r = static_cast<size_t>(reason);
+  c.lifetimeSecs[r][ItemLifetimeStat::getLifetimeBucket(lifetimeSecs)]
+      .fetch_add(1, std::memory_order_relaxed);
+  c.hits[r][std::min<size_t>(hits, ItemLifetimeStat::kNumHitBuckets - 1)]
+      .fetch_add(1, std::memory_order_relaxed);
+  if (reason == ItemRemovalReason::kEvicted ||
+      reason == ItemRemovalReason::kSlabRelease) {
+    c.nvmAdmission[static_cast<size_t>(outcome)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+}
+
+ItemLifetimeStat ItemLifetimeTracker::getStat(PoolId pid, ClassId cid) const {
+  ItemLifetimeStat ret;
+  const auto* pool = pools_[pid].load(std::memory_order_acquire);
+  if (pool == nullptr) {
+    return ret;
+  }
+  const auto& c = (*pool)[cid];
+  for (size_t r = 0; r < ItemLifetimeStat::kNumReasons; r++) {
+    for (size_t b = 0; b < ItemLifetimeStat::kNumLifetimeBuckets; b++) {
+      ret.lifetimeSecs[r][b] =
+          c.lifetimeSecs[r][b].load(std::memory_order_relaxed);
+    }
+    for (size_t h = 0; h < ItemLifetimeStat::kNumHitBuckets; h++) {
+      ret.hits[r][h] = c.hits[r][h].load(std::memory_order_relaxed);
+    }
+  }
+  for (size_t o = 0; o < ItemLifetimeStat::kNumOutcomes; o++) {
+    ret.nvmAdmission[o] = c.nvmAdmission[o].load(std::memory_order_relaxed);
+  }
+  return ret;
+}
+
 } // namespace detail
 
+uint64_t ItemLifetimeStat::numItems(ItemRemovalReason reason) const noexcept {
+  const auto& h = hits[static_cast<size_t>(reason)];
+  return std::accumulate(h.begin(), h.end(), uint64_t{0});
+}
+
+double ItemLifetimeStat::noHitRatio(ItemRemovalReason reason) const noexcept {
+  const auto n = numItems(reason);
+  return n == 0 ? 0.0
+                : static_cast<double>(hits[static_cast<size_t>(reason)][0]) /
+                      static_cast<double>(n);
+}
+
+uint64_t ItemLifetimeStat::lifetimePercentile(
+    ItemRemovalReason reason, double percentile) const noexcept {
+  const auto& buckets = lifetimeSecs[static_cast<size_t>(reason)];
+  const auto n = std::accumulate(buckets.begin(), buckets.end(), uint64_t{0});
+  if (n == 0) {
+    return 0;
+  }
+  const auto target = static_cast<uint64_t>(
+      std::ceil(std::clamp(percentile, 0.0, 1.0) * static_cast<double>(n)));
+  uint64_t seen = 0;
+  for (size_t b = 0; b < buckets.size(); b++) {
+    seen += buckets[b];
+    if (seen >= target && seen > 0) {
+      // upper bound of the bucket
+      return uint64_t{1} << b;
+    }
+  }
+  return uint64_t{1} << (buckets.size() - 1);
+}
+
+ItemLifetimeStat& ItemLifetimeStat::operator+=(
+    const ItemLifetimeStat& other) noexcept {
+  for (size_t r = 0; r < kNumReasons; r++) {
+    for (size_t b = 0; b < kNumLifetimeBuckets; b++) {
+      lifetimeSecs[r][b] += other.lifetimeSecs[r][b];
+    }
+    for (size_t h = 0; h < kNumHitBuckets; h++) {
+      hits[r][h] += other.hits[r][h];
+    }
+  }
+  for (size_t o = 0; o < kNumOutcomes; o++) {
+    nvmAdmission[o] += other.nvmAdmission[o];
+  }
+  return *this;
+}
+
 PoolStats& PoolStats::operator+=(const PoolStats& other) {
   auto verify = [](bool isCompatible) {
     if (!isCompatible) {
@@ -183,6 +306,8 @@ PoolStats& PoolStats::operator+=(const PoolStats& other) {
       d.numHits += s.numHits;
       d.chainedItemEvictions += s.chainedItemEvictions;
       d.regularItemEvictions += s.regularItemEvictions;
+      d.lifetimeStat += s.lifetimeStat;
+      d.ghostHits += s.ghostHits;
     }
 
     // aggregate container stats within CacheStat
@@ -19,6 +19,7 @@
 #include <folly/container/F14Map.h>
 
 #include <algorithm>
+#include <array>
 #include <numeric>
 
 #include "cachelib/allocator/Util.h"
@@ -26,6 +27,7 @@
 #include "cachelib/allocator/memory/MemoryAllocatorStats.h"
 #include "cachelib/allocator/memory/Slab.h"
 #include "cachelib/common/FastStats.h"
+#include "cachelib/common/HugePageAllocator.h"
 #include "cachelib/common/PercentileStats.h"
 #include "cachelib/common/Time.h"
 
@@ -97,6 +99,84 @@ struct MMContainerStat {
   uint64_t numTailAccesses;
 };
 
+// Why an item left the RAM cache, as recorded by the item lifetime stats.
+enum class ItemRemovalReason : uint8_t {
+  // evicted from the tail of its eviction queue to make room
+  kEvicted = 0,
+  // evicted to release its slab for rebalancing, resizing or advising
+  kSlabRelease,
+  // removed after it expired, by a lookup or by the reaper
+  kExpired,
+  // removed explicitly through remove()
+  kRemoved,
+  // replaced by a newer version through insertOrReplace()
+  kReplaced,
+  kNumReasons,
+};
+
+// What happened to an evicted item with respect to the NVM cache.
+enum class NvmAdmissionOutcome : uint8_t {
+  // no NVM cache is configured or it is disabled
+  kNoNvm = 0,
+  // the item was written to the NVM cache
+  kAdmitted,
+  // not written because an identical copy is already in the NVM cache
+  kAlreadyInNvm,
+  // not written because the admission policy rejected it, it had expired or
+  // it could not be written safely (e.g. a concurrent fill)
+  kRejected,
+  kNumOutcomes,
+};
+
+// Sampled histograms of how long the items of an allocation class stayed in
+// RAM, how often they were read and why they left. Only collected when
+// CacheAllocatorConfig::enableItemLifetimeStats() is set; all counts are of
+// sampled items.
+struct ItemLifetimeStat {
+  static constexpr size_t kNumReasons =
+      static_cast<size_t>(ItemRemovalReason::kNumReasons);
+  static constexpr size_t kNumOutcomes =
+      static_cast<size_t>(NvmAdmissionOutcome::kNumOutcomes);
+
+  // Time in cache is bucketed by powers of two. Bucket 0 counts items that
+  // stayed less than a second, bucket i items that stayed [2^(i-1), 2^i)
+  // seconds. The last bucket is open ended.
+  static constexpr size_t kNumLifetimeBuckets = 24;
+
+  // Hits are counted up to 3. The last bucket counts 3 or more hits.
+  static constexpr size_t kNumHitBuckets = 4;
+
+  // [reason][bucket] number of items by time in cache
+  std::array<std::array<uint64_t, kNumLifetimeBuckets>, kNumReasons>
+      lifetimeSecs{};
+
+  // [reason][hits] number of items by hits before they left
+  std::array<std::array<uint64_t, kNumHitBuckets>, kNumReasons> hits{};
+
+  // [outcome] number of evicted items (kEvicted and kSlabRelease) by what
+  // happened to them with respect to the NVM cache
+  std::array<uint64_t, kNumOutcomes> nvmAdmission{};
+
+  // bucket of lifetimeSecs for an item that stayed @secs in cache
+  static size_t getLifetimeBucket(uint32_t secs) noexcept {
+    const size_t bucket = secs == 0 ? 0 : 32 - __builtin_clz(secs);
+    return std::min(bucket, kNumLifetimeBuckets - 1);
+  }
+
+  // number of items that left the cache for @reason
+  uint64_t numItems(ItemRemovalReason reason) const noexcept;
+
+  // fraction of the items that left for @reason without being read once
+  double noHitRatio(ItemRemovalReason reason) const noexcept;
+
+  // approximate time in cache in seconds of the given percentile (0 to 1)
+  // of the items that left for @reason, at the resolution of the buckets.
+  uint64_t lifetimePercentile(ItemRemovalReason reason,
+                              double percentile) const noexcept;
+
+  ItemLifetimeStat& operator+=(const ItemLifetimeStat& other) noexcept;
+};
+
 // cache related stats for a given allocation class.
 struct CacheStat {
   // allocation size for this container.
@@ -126,6 +206,15 @@ struct CacheStat {
   // the stats from the mm container
   MMContainerStat containerStat;
 
+  // sampled time in cache, hits and removal reasons of the items. Empty
+  // unless item lifetime stats are enabled.
+  ItemLifetimeStat lifetimeStat{};
+
+  // number of allocations of keys recently evicted from this class, i.e. the
+  // hits it would have got with more slabs. Zero unless ghost lists are
+  // enabled.
+  uint64_t ghostHits{0};
+
   // number of elements in this MMContainer
   uint64_t numItems() const noexcept { return containerStat.size; }
 
@@ -476,6 +565,13 @@ struct GlobalCacheStats {
   // number of exception occurred inside item destructor
   uint64_t numDestructorExceptions{0};
 
+  // number of insertIfVersion calls that lost against a concurrent writer
+  uint64_t numCasConflicts{0};
+
+  // number of resize calls done in place and by copying into a new item
+  uint64_t numInPlaceResizes{0};
+  uint64_t numCopyResizes{0};
+
   // number of allocated and CHAINED items that are parents (i.e.,
   // consisting of at least one chained child)
   uint64_t numChainedChildItems{0};
@@ -592,6 +688,15 @@ struct CacheMemoryStats {
   // rss size of the process
   size_t memRssSize{0};
 
+  // cache memory paged in by memory locking so far, and the time it took to
+  // page in all of it (0 until done)
+  size_t memPrefaultedSize{0};
+  uint64_t memPrefaultDurationMs{0};
+
+  // bytes of large metadata arrays (hash table buckets, navy index and bloom
+  // filters, nvm cache shards) in the process by page backing
+  util::MetadataMemoryStats metadataMemory{};
+
   // returns the advised memory in the unit of slabs.
   size_t numAdvisedSlabs() const { return advisedSize / Slab::kSize; }
 
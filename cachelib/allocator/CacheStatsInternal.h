@@ -16,6 +16,7 @@
 
 #pragma once
 #include <array>
+#include <atomic>
 #include <numeric>
 
 #include "cachelib/allocator/Cache.h"
@@ -170,6 +171,14 @@ struct Stats {
   // number of exception occurred inside item destructor
   AtomicCounter numDestructorExceptions{0};
 
+  // number of insertIfVersion calls that lost against a concurrent writer
+  AtomicCounter numCasConflicts{0};
+
+  // number of resize calls that fit the item's allocation class and the ones
+  // that needed to copy the item into a new allocation
+  AtomicCounter numInPlaceResizes{0};
+  AtomicCounter numCopyResizes{0};
+
   // The number of slabs being released right now.
   // This must be zero when `saveState()` is called.
   AtomicCounter numActiveSlabReleases{0};
@@ -256,6 +265,60 @@ struct Stats {
   void populateGlobalCacheStats(GlobalCacheStats& ret) const;
 };
 
+// Collects ItemLifetimeStat for every allocation class without locks. Each
+// thread records one in sampleRate removals, and the counters of a pool are
+// only allocated once an item from it is sampled, so pools that are not in
+// use cost a pointer.
+class ItemLifetimeTracker {
+ public:
+  // @param sampleRate  record one in these many removals on each thread
+  // @throw std::invalid_argument if sampleRate is 0
+  explicit ItemLifetimeTracker(uint32_t sampleRate);
+  ~ItemLifetimeTracker();
+
+  ItemLifetimeTracker(const ItemLifetimeTracker&) = delete;
+  ItemLifetimeTracker& operator=(const ItemLifetimeTracker&) = delete;
+
+  // true if the caller should record the current removal
+  bool shouldSample() const noexcept {
+    static thread_local uint32_t tlCount{0};
+    return ++tlCount % sampleRate_ == 0;
+  }
+
+  // record an item of (pid, cid) that left the cache for @reason after
+  // @lifetimeSecs in it and @hits reads. @outcome is only recorded for
+  // evictions.
+  void record(PoolId pid,
+              ClassId cid,
+              ItemRemovalReason reason,
+              uint32_t lifetimeSecs,
+              uint8_t hits,
+              NvmAdmissionOutcome outcome);
+
+  ItemLifetimeStat getStat(PoolId pid, ClassId cid) const;
+
+ private:
+  template <size_t N>
+  using Counters = std::array<std::atomic<uint64_t>, N>;
+
+  struct ClassCounters {
+    std::array<Counters<ItemLifetimeStat::kNumLifetimeBuckets>,
+               ItemLifetimeStat::kNumReasons>
+        lifetimeSecs{};
+    std::array<Counters<ItemLifetimeStat::kNumHitBuckets>,
+               ItemLifetimeStat::kNumReasons>
+        hits{};
+    Counters<ItemLifetimeStat::kNumOutcomes> nvmAdmission{};
+  };
+  using PoolCounters = std::array<ClassCounters, MemoryAllocator::kMaxClasses>;
+
+  ClassCounters& getCounters(PoolId pid, ClassId cid);
+
+  const uint32_t sampleRate_;
+  std::array<std::atomic<PoolCounters*>, MemoryPoolManager::kMaxPools>
+      pools_{};
+};
+
 } // namespace detail
 } // namespace cachelib
 } // namespace facebook
@@ -22,10 +22,13 @@
 #include <map>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
 #include "cachelib/common/CompilerUtils.h"
+#include "cachelib/common/HugePageAllocator.h"
 #include "cachelib/common/Mutex.h"
 #include "cachelib/common/Throttler.h"
 #include "cachelib/shm/Shm.h"
@@ -68,9 +71,11 @@ class ChainedHashTable {
     // @param numBuckets    the number of buckets to be allocated, power of two
     // @param compressor    object used to compress/decompress node pointers
     // @param hasher        object used to hash the key for its bucket id
+    // @param hugePages     how the bucket array is backed
     Impl(size_t numBuckets,
          const PtrCompressor& compressor,
-         const Hasher& hasher);
+         const Hasher& hasher,
+         util::HugePagePolicy hugePages = util::HugePagePolicy::kNone);
 
     // allocate memory for hash table; the memory is managed by the user.
     //
@@ -88,7 +93,7 @@ class ChainedHashTable {
 
     // hash table memory is not released if managed by user.
     // i.e. Impl::isRestorable() == true
-    ~Impl();
+    ~Impl() = default;
 
     // prohibit copying
     Impl(const Impl&) = delete;
@@ -181,8 +186,11 @@ class ChainedHashTable {
     // materialized value of numBuckets_ - 1
     const size_t numBucketsMask_{0};
 
+    // buckets allocated by Impl when the memory is not managed by the user.
+    util::MetadataArray<CompressedPtr> ownedTable_;
+
     // actual buckets.
-    std::unique_ptr<CompressedPtr[]> hashTable_;
+    CompressedPtr* hashTable_{nullptr};
 
     // indicate whether or not the hash table uses user-managed memory and
     // is thus restorable from serialized state
@@ -313,6 +321,14 @@ class ChainedHashTable {
 
     PageSizeT getPageSize() const { return pageSize_; }
 
+    // Huge page policy for a hash table in local memory with this page size.
+    // Both huge page sizes map to 2MB hugetlbfs pages, falling back to
+    // transparent huge pages.
+    util::HugePagePolicy getHugePagePolicy() const {
+      return pageSize_ == PageSizeT::NORMAL ? util::HugePagePolicy::kNone
+                                            : util::HugePagePolicy::kHugeTlb;
+    }
+
    private:
     // 4 billion buckets should be good enough for everyone.
     static constexpr unsigned int kMaxBucketPower = 32;
@@ -365,7 +381,8 @@ class ChainedHashTable {
               HandleMaker hm = kDefaultHandleMaker)
         : config_(std::move(c)),
           handleMaker_(std::move(hm)),
-          ht_{config_.getNumBuckets(), compressor, config_.getHasher()},
+          ht_{config_.getNumBuckets(), compressor, config_.getHasher(),
+              config_.getHugePagePolicy()},
           locks_{config_.getLocksPower(), config_.getHasher()} {}
 
     // create hash table container with user-managed memory
@@ -617,6 +634,69 @@ class ChainedHashTable {
     Iterator begin() { return Iterator(*this); }
     Iterator end() { return Iterator(*this, Iterator::EndIter); }
 
+    // Cursor over a contiguous range of buckets. Cursors from partition()
+    // cover disjoint ranges and can be walked concurrently. Instead of
+    // holding a handle per position like Iterator, the cursor hands out
+    // handles in batches, and a bucket lock is only held while one bucket
+    // is copied. The same visiting guarantees as Iterator apply.
+    class BucketCursor {
+     public:
+      ~BucketCursor() {
+        if (container_) {
+          XDCHECK_GT(container_->numIterators_.load(), 0u);
+          --container_->numIterators_;
+        }
+      }
+      BucketCursor(const BucketCursor&) = delete;
+      BucketCursor& operator=(const BucketCursor&) = delete;
+
+      BucketCursor(BucketCursor&& other) noexcept
+          : container_{std::exchange(other.container_, nullptr)},
+            beginBucket_{other.beginBucket_},
+            currBucket_{other.currBucket_},
+            endBucket_{other.endBucket_} {}
+      BucketCursor& operator=(BucketCursor&& other) noexcept {
+        if (this != &other) {
+          this->~BucketCursor();
+          new (this) BucketCursor(std::move(other));
+        }
+        return *this;
+      }
+
+      // Fill @batch with handles to the items of the next buckets until it
+      // has at least @maxBatchSize handles or the range is exhausted. A
+      // bucket is never split across batches. @batch is cleared first.
+      //
+      // @return false once the range has been walked and @batch is empty
+      bool nextBatch(std::vector<Handle>& batch, size_t maxBatchSize);
+
+      // true if all the buckets of the range have been walked
+      bool done() const noexcept { return currBucket_ >= endBucket_; }
+
+      BucketId beginBucket() const noexcept { return beginBucket_; }
+      BucketId endBucket() const noexcept { return endBucket_; }
+
+     private:
+      using C = Container<T, HookPtr, LockT>;
+      friend C;
+      BucketCursor(const C& container, BucketId begin, BucketId end);
+
+      const C* container_;
+      BucketId beginBucket_{0};
+      BucketId currBucket_{0};
+      BucketId endBucket_{0};
+
+      // scratch space for the bucket being copied
+      std::vector<Handle> bucketElems_;
+    };
+
+    // Split the buckets into @numPartitions disjoint cursors of about the
+    // same number of buckets. Like iterators, cursors must be destroyed
+    // before the container state is saved.
+    //
+    // @throw std::invalid_argument if numPartitions is 0
+    std::vector<BucketCursor> partition(size_t numPartitions) const;
+
     // Stats describing the distribution of items (keys) in the hash table
     struct DistributionStats {
       uint64_t numKeys{0};
@@ -669,7 +749,8 @@ class ChainedHashTable {
     // locks protecting the hashtable buckets
     mutable LockT locks_;
 
-    std::atomic<unsigned int> numIterators_{0};
+    // number of live iterators and cursors
+    mutable std::atomic<unsigned int> numIterators_{0};
 
     // Cached stats for distribution
     // This is updated if the number of keys changes by more than 5%, or
@@ -704,7 +785,8 @@ const typename T::HandleMaker
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 ChainedHashTable::Impl<T, HookPtr>::Impl(size_t numBuckets,
                                          const PtrCompressor& compressor,
-                                         const Hasher& hasher)
+                                         const Hasher& hasher,
+                                         util::HugePagePolicy hugePages)
     : numBuckets_(numBuckets),
       numBucketsMask_(numBuckets - 1),
       compressor_(compressor),
@@ -715,9 +797,8 @@ ChainedHashTable::Impl<T, HookPtr>::Impl(size_t numBuckets,
   if (numBuckets & (numBuckets - 1)) {
     throw std::invalid_argument("Number of buckets must be a power of two");
   }
-  hashTable_ = std::make_unique<CompressedPtr[]>(numBuckets_);
-  CompressedPtr* memStart = hashTable_.get();
-  std::fill(memStart, memStart + numBuckets_, CompressedPtr{});
+  ownedTable_ = util::MetadataArray<CompressedPtr>(numBuckets_, hugePages);
+  hashTable_ = ownedTable_.data();
 }
 
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
@@ -744,13 +825,6 @@ ChainedHashTable::Impl<T, HookPtr>::Impl(size_t numBuckets,
   }
 }
 
-template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
-ChainedHashTable::Impl<T, HookPtr>::Impl::~Impl() {
-  if (restorable_) {
-    hashTable_.release();
-  }
-}
-
 template <typename T, typename ChainedHashTable::Hook<T> T::*HookPtr>
 typename ChainedHashTable::Impl<T, HookPtr>::BucketId
 ChainedHashTable::Impl<T, HookPtr>::getBucket(
@@ -1176,6 +1250,59 @@ void ChainedHashTable::Container<T, HookPtr, LockT>::getBucketElems(
   });
 }
 
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+std::vector<typename ChainedHashTable::Container<T, HookPtr, LockT>::
+                BucketCursor>
+ChainedHashTable::Container<T, HookPtr, LockT>::partition(
+    size_t numPartitions) const {
+  if (numPartitions == 0) {
+    throw std::invalid_argument("Number of partitions must be positive");
+  }
+  const uint64_t numBuckets = ht_.getNumBuckets();
+  // more partitions than buckets would only produce empty cursors
+  numPartitions = std::min<uint64_t>(numPartitions, numBuckets);
+
+  std::vector<BucketCursor> cursors;
+  cursors.reserve(numPartitions);
+  for (size_t i = 0; i < numPartitions; i++) {
+    cursors.push_back(BucketCursor(
+        *this,
+        static_cast<BucketId>(numBuckets * i / numPartitions),
+        static_cast<BucketId>(numBuckets * (i + 1) / numPartitions)));
+  }
+  return cursors;
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+ChainedHashTable::Container<T, HookPtr, LockT>::BucketCursor::BucketCursor(
+    const C& container, BucketId begin, BucketId end)
+    : container_(&container),
+      beginBucket_{begin},
+      currBucket_{begin},
+      endBucket_{end} {
+  ++container_->numIterators_;
+}
+
+template <typename T,
+          typename ChainedHashTable::Hook<T> T::*HookPtr,
+          typename LockT>
+bool ChainedHashTable::Container<T, HookPtr, LockT>::BucketCursor::nextBatch(
+    std::vector<Handle>& batch, size_t maxBatchSize) {
+  batch.clear();
+  while (currBucket_ < endBucket_ && batch.size() < maxBatchSize) {
+    container_->getBucketElems(currBucket_++, bucketElems_);
+    for (auto& handle : bucketElems_) {
+      batch.push_back(std::move(handle));
+    }
+  }
+  bucketElems_.clear();
+  return !batch.empty();
+}
+
 // Container's Iterator
 // with/without throtter to iterate
 template <typename T,
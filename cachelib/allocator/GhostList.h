@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/lang/Bits.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+// A bounded set of fingerprints of recently evicted keys of an allocation
+// class. A key that comes back while its fingerprint is still here would
+// have been a hit had the class kept that many more items, which makes the
+// hit count a direct estimate of the marginal value of more memory.
+//
+// The fingerprints live in 64 byte buckets that are each a FIFO, so the
+// list as a whole is an approximate FIFO of the last capacity() evictions.
+// All operations are lock free and may lose an update under contention,
+// which only costs accuracy.
+class GhostList {
+ public:
+  static constexpr size_t kSlotsPerBucket = 15;
+
+  // @param capacity  number of fingerprints to remember, rounded up to a
+  //                  power of two number of buckets
+  // @throw std::invalid_argument if capacity is 0
+  explicit GhostList(size_t capacity) {
+    if (capacity == 0) {
+      throw std::invalid_argument("ghost list capacity must be positive");
+    }
+    numBuckets_ = folly::nextPowTwo(
+        (capacity + kSlotsPerBucket - 1) / kSlotsPerBucket);
+    buckets_ = std::make_unique<Bucket[]>(numBuckets_);
+  }
+
+  GhostList(const GhostList&) = delete;
+  GhostList& operator=(const GhostList&) = delete;
+
+  // remember the key with @keyHash as evicted, displacing the oldest
+  // fingerprint of its bucket.
+  void insert(uint64_t keyHash) noexcept {
+    auto& bucket = getBucket(keyHash);
+    const auto slot =
+        bucket.next.fetch_add(1, std::memory_order_relaxed) % kSlotsPerBucket;
+    bucket.fingerprints[slot].store(getFingerprint(keyHash),
+                                    std::memory_order_relaxed);
+  }
+
+  // check whether the key with @keyHash was recently evicted. A key is only
+  // reported once per eviction: its fingerprint is dropped and a hit is
+  // counted.
+  //
+  // @return true if the key was in the list
+  bool remove(uint64_t keyHash) noexcept {
+    auto& bucket = getBucket(keyHash);
+    const auto fp = getFingerprint(keyHash);
+    for (auto& slot : bucket.fingerprints) {
+      auto curr = fp;
+      if (slot.load(std::memory_order_relaxed) == fp &&
+          slot.compare_exchange_strong(curr, 0, std::memory_order_relaxed)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // number of keys found by remove() so far
+  uint64_t getHits() const noexcept {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  size_t capacity() const noexcept { return numBuckets_ * kSlotsPerBucket; }
+
+  size_t getByteSize() const noexcept { return numBuckets_ * sizeof(Bucket); }
+
+ private:
+  struct alignas(64) Bucket {
+    // 0 marks an empty slot
+    std::array<std::atomic<uint32_t>, kSlotsPerBucket> fingerprints{};
+    // slot to overwrite next, modulo kSlotsPerBucket
+    std::atomic<uint32_t> next{0};
+  };
+  static_assert(sizeof(Bucket) == 64, "a bucket should be one cache line");
+
+  Bucket& getBucket(uint64_t keyHash) const noexcept {
+    return buckets_[keyHash & (numBuckets_ - 1)];
+  }
+
+  // the high bits, which are independent of the bucket for all practical
+  // sizes. Never 0.
+  static uint32_t getFingerprint(uint64_t keyHash) noexcept {
+    return static_cast<uint32_t>(keyHash >> 32) | 1;
+  }
+
+  size_t numBuckets_{0};
+  std::unique_ptr<Bucket[]> buckets_;
+  std::atomic<uint64_t> hits_{0};
+};
+} // namespace cachelib
+} // namespace facebook
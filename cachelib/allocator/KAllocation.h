@@ -105,6 +105,18 @@ class CACHELIB_PACKED_ATTR KAllocation {
     std::memcpy(&data_[0], key.start(), getKeySize());
   }
 
+  // updates the size of the value. The caller is responsible for making sure
+  // that the underlying allocation is big enough for the new size.
+  //
+  // @throw std::invalid_argument if the size is too big.
+  void changeSize(uint32_t valSize) {
+    if (valSize > kMaxValSize) {
+      throw std::invalid_argument(folly::sformat(
+          "value size exceeded maximum allowed. total size: {}", valSize));
+    }
+    size_ = (getKeySize() << kMaxValSizeBits) | valSize;
+  }
+
   // return a void* to the usable memory block. There are no alignment
   // guarantees.
   // TODO add support for alignment
@@ -142,7 +154,7 @@ class CACHELIB_PACKED_ATTR KAllocation {
  private:
   // Top 8 bits are for key size (up to 255 bytes)
   // Bottom 24 bits are for value size (up to 16777215 bytes)
-  const uint32_t size_;
+  uint32_t size_;
 
   // beginning of the byte array. First keylen bytes correspond to the key and
   // the next size - keylen_ bytes are usable.
@@ -30,7 +30,7 @@
 #include "cachelib/allocator/datastruct/MultiDList.h"
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
 #include "cachelib/common/CompilerUtils.h"
-#include "cachelib/common/CountMinSketch.h"
+#include "cachelib/common/BlockedCountMinSketch.h"
 #include "cachelib/common/Mutex.h"
 
 namespace facebook::cachelib {
@@ -46,8 +46,10 @@ namespace facebook::cachelib {
 // cache is evicted. This gives the frequency based admission into main
 // cache. Hits in each cache simply move the item to the head of each
 // LRU cache.
-// The frequency counts are maintained in CountMinSketch approximate
-// counters -
+// The frequency counts are maintained in BlockedCountMinSketch approximate
+// counters. They are 4-bit counters that saturate at 15, with all the
+// counters of a key in one cache line, which keeps the time spent updating
+// them under the lru lock short.
 
 // Counter Overhead:
 // The windowToCacheSizeRatio determines the size of counters. The default
@@ -592,9 +594,6 @@ class MMTinyLFU {
     // The error threshold for frequency calculation
     static constexpr size_t kErrorThreshold = 5;
 
-    // decay rate for frequency
-    static constexpr double kDecayFactor = 0.5;
-
     // protects all operations on the lru. We never really just read the state
     // of the LRU. Hence we dont really require a RW mutex at this point of
     // time.
@@ -628,7 +627,7 @@ class MMTinyLFU {
 
     // Approximate streaming frequency counters. The counts are halved every
     // time the maxWindowSize is hit.
-    facebook::cachelib::util::CountMinSketch accessFreq_{};
+    facebook::cachelib::util::BlockedCountMinSketch accessFreq_{};
 
     FRIEND_TEST(MMTinyLFUTest, SegmentStress);
     FRIEND_TEST(MMTinyLFUTest, TinyLFUBasic);
@@ -675,9 +674,12 @@ void MMTinyLFU::Container<T,
 
   numCounters = folly::nextPowTwo(numCounters);
 
-  // The CountMinSketch frequency counter
-  accessFreq_ =
-      facebook::cachelib::util::CountMinSketch(numCounters, kHashCount);
+  // The frequency counter, with as many counters per hash as a CountMinSketch
+  // of kHashCount rows would have.
+  static_assert(
+      kHashCount == facebook::cachelib::util::BlockedCountMinSketch::kDepth,
+      "the blocked sketch has a fixed number of hashes");
+  accessFreq_ = facebook::cachelib::util::BlockedCountMinSketch(numCounters);
 }
 
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
@@ -757,7 +759,7 @@ void MMTinyLFU::Container<T, HookPtr>::updateFrequenciesLocked(
   // cold) from staying in cache forever.
   if (windowSize_ == maxWindowSize_) {
     windowSize_ >>= 1;
-    accessFreq_.decayCountsBy(kDecayFactor);
+    accessFreq_.halveCounts();
   }
 }
 
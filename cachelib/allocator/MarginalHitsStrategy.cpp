@@ -52,15 +52,23 @@ RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverImpl(
     validReceiver[it] = acStats.at(it).getTotalFreeMemory() <
                         config.maxFreeMemSlabs * Slab::kSize;
   }
-  if (classStates_[pid].entities.empty()) {
-    // initialization
-    classStates_[pid].entities = classes;
-    for (auto cid : classes) {
-      classStates_[pid].smoothedRanks[cid] = 0;
+  auto initState = [&classes](MarginalHitsState<ClassId>& state) {
+    if (state.entities.empty()) {
+      state.entities = classes;
+      for (auto cid : classes) {
+        state.smoothedRanks[cid] = 0;
+      }
     }
-  }
+  };
+  initState(classStates_[pid]);
   classStates_[pid].updateRankings(scores, config.movingAverageParam);
-  return pickVictimAndReceiverFromRankings(pid, validVictim, validReceiver);
+  if (config.useGhostHits) {
+    initState(receiverStates_[pid]);
+    receiverStates_[pid].updateRankings(computeClassGhostHits(pid, poolStats),
+                                        config.movingAverageParam);
+  }
+  return pickVictimAndReceiverFromRankings(pid, validVictim, validReceiver,
+                                           config.useGhostHits);
 }
 
 ClassId MarginalHitsStrategy::pickVictimImpl(const CacheBase& cache,
@@ -82,12 +90,33 @@ MarginalHitsStrategy::computeClassMarginalHits(PoolId pid,
   return scores;
 }
 
+std::unordered_map<ClassId, double> MarginalHitsStrategy::computeClassGhostHits(
+    PoolId pid, const PoolStats& poolStats) {
+  const auto& poolState = getPoolState(pid);
+  std::unordered_map<ClassId, double> scores;
+  for (auto info : poolState) {
+    if (info.id != Slab::kInvalidClassId) {
+      scores[info.id] = info.getMarginalGhostHits(poolStats);
+    }
+  }
+  return scores;
+}
+
 RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverFromRankings(
     PoolId pid,
     const std::unordered_map<ClassId, bool>& validVictim,
-    const std::unordered_map<ClassId, bool>& validReceiver) {
+    const std::unordered_map<ClassId, bool>& validReceiver,
+    bool useGhostHits) {
   auto victimAndReceiver = classStates_[pid].pickVictimAndReceiverFromRankings(
       validVictim, validReceiver, Slab::kInvalidClassId);
+  auto& receiverState = useGhostHits ? receiverStates_[pid] : classStates_[pid];
+  if (useGhostHits) {
+    victimAndReceiver.second =
+        receiverState
+            .pickVictimAndReceiverFromRankings(validVictim, validReceiver,
+                                               Slab::kInvalidClassId)
+            .second;
+  }
   RebalanceContext ctx{victimAndReceiver.first, victimAndReceiver.second};
   if (ctx.victimClassId == Slab::kInvalidClassId ||
       ctx.receiverClassId == Slab::kInvalidClassId ||
@@ -99,7 +128,7 @@ RebalanceContext MarginalHitsStrategy::pickVictimAndReceiverFromRankings(
         "Rebalancing: receiver = {}, smoothed rank = {}, victim = {}, smoothed "
         "rank = {}",
         static_cast<int>(ctx.receiverClassId),
-        classStates_[pid].smoothedRanks[ctx.receiverClassId],
+        receiverState.smoothedRanks[ctx.receiverClassId],
         static_cast<int>(ctx.victimClassId),
         classStates_[pid].smoothedRanks[ctx.victimClassId]);
   return ctx;
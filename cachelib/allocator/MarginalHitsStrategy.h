@@ -39,6 +39,13 @@ class MarginalHitsStrategy : public RebalanceStrategy {
     // class
     unsigned int maxFreeMemSlabs{1};
 
+    // pick the receiver by the hits on the ghost lists of the classes instead
+    // of their tail hits. Tail hits estimate what a class loses with one slab
+    // less, which is the right signal for the victim, while ghost hits
+    // directly count what it would gain with one more. Needs ghost lists to
+    // be enabled in the cache config.
+    bool useGhostHits{false};
+
     Config() noexcept {}
     explicit Config(double param) noexcept : Config(param, 1, 1) {}
     Config(double param, unsigned int minSlab, unsigned int maxFree) noexcept
@@ -81,15 +88,25 @@ class MarginalHitsStrategy : public RebalanceStrategy {
   std::unordered_map<ClassId, double> computeClassMarginalHits(
       PoolId pid, const PoolStats& poolStats);
 
-  // pick victim and receiver according to smoothed rankings
+  // compute delta of ghost list hits for every class in this pool
+  std::unordered_map<ClassId, double> computeClassGhostHits(
+      PoolId pid, const PoolStats& poolStats);
+
+  // pick victim and receiver according to smoothed rankings. The receiver
+  // comes from receiverStates_ if @useGhostHits.
   RebalanceContext pickVictimAndReceiverFromRankings(
       PoolId pid,
       const std::unordered_map<ClassId, bool>& validVictim,
-      const std::unordered_map<ClassId, bool>& validReceiver);
+      const std::unordered_map<ClassId, bool>& validReceiver,
+      bool useGhostHits);
 
   // marginal hits states for classes in each pools
   std::unordered_map<PoolId, MarginalHitsState<ClassId>> classStates_;
 
+  // ghost hits states for classes in each pool, used to pick receivers when
+  // Config::useGhostHits is set
+  std::unordered_map<PoolId, MarginalHitsState<ClassId>> receiverStates_;
+
   // Config for this strategy, this can be updated anytime.
   // Do not access this directly, always use `getConfig()` to
   // obtain a copy first
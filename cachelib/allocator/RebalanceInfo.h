@@ -47,6 +47,9 @@ struct Info {
   // accumulative number of hits in the tail slab of this allocation class
   uint64_t accuTailHits{0};
 
+  // accumulative number of hits on the ghost list of this allocation class
+  uint64_t accuGhostHits{0};
+
   // TODO(sugak) this is changed to unblock the LLVM upgrade The fix is not
   // completely understood, but it's a safe change T16521551 - Info() noexcept
   // = default;
@@ -55,8 +58,14 @@ struct Info {
        unsigned long long slabs,
        unsigned long long evicts,
        uint64_t h,
-       uint64_t th) noexcept
-      : id(_id), nSlabs(slabs), evictions(evicts), hits(h), accuTailHits(th) {}
+       uint64_t th,
+       uint64_t gh) noexcept
+      : id(_id),
+        nSlabs(slabs),
+        evictions(evicts),
+        hits(h),
+        accuTailHits(th),
+        accuGhostHits(gh) {}
 
   // number of rounds we hold off for when we acquire a slab.
   static constexpr unsigned int kNumHoldOffRounds = 10;
@@ -144,6 +153,15 @@ struct Info {
            accuTailHits;
   }
 
+  // return the delta of hits on the ghost list of this allocation class, the
+  // hits it would have got with more slabs.
+  //
+  // @param poolStats  the current pool stats for this pool.
+  // @return the marginal hits of growing the class
+  uint64_t getMarginalGhostHits(const PoolStats& poolStats) const {
+    return poolStats.cacheStats.at(id).ghostHits - accuGhostHits;
+  }
+
   // returns true if the hold off is active for this alloc class.
   bool isOnHoldOff() const noexcept { return holdOffRemaining > 0; }
 
@@ -177,6 +195,9 @@ struct Info {
     // update tail hits
     accuTailHits = cacheStats.containerStat.numTailAccesses;
 
+    // update ghost hits
+    accuGhostHits = cacheStats.ghostHits;
+
     allocFailures = cacheStats.allocFailures;
   }
 };
@@ -116,6 +116,11 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
     // unevictable in the past.
     kUnevictable_NOOP,
 
+    // 2-bit saturating count of the hits on an item since it was allocated.
+    // Only maintained when item lifetime stats are enabled.
+    kHitCount0,
+    kHitCount1,
+
     // Unused. This is just to indciate the maximum number of flags
     kFlagMax,
   };
@@ -422,6 +427,28 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
   void unmarkNvmEvicted() noexcept { return unSetFlag<kNvmEvicted>(); }
   bool isNvmEvicted() const noexcept { return isFlagSet<kNvmEvicted>(); }
 
+  /**
+   * Saturating count of the hits on this item, up to kMaxHitCount. Once the
+   * count saturates, incHitCount() is a plain load.
+   */
+  static constexpr uint8_t kMaxHitCount = 3;
+  void incHitCount() noexcept {
+    constexpr Value kHitCountMask =
+        getFlag<kHitCount0>() | getFlag<kHitCount1>();
+    constexpr Value kOne = getFlag<kHitCount0>();
+    if ((getRaw() & kHitCountMask) == kHitCountMask) {
+      return;
+    }
+    auto predicate = [](const Value curValue) {
+      return (curValue & kHitCountMask) != kHitCountMask;
+    };
+    auto newValue = [](const Value curValue) { return curValue + kOne; };
+    atomicUpdateValue(predicate, newValue);
+  }
+  uint8_t getHitCount() const noexcept {
+    return static_cast<uint8_t>((getRaw() >> kHitCount0) & kMaxHitCount);
+  }
+
   // Whether or not an item is completely drained of access
   // Refcount is 0 and the item is not linked, accessible, nor exclusive
   bool isDrained() const noexcept { return getRefWithAccessAndAdmin() == 0; }
@@ -490,7 +517,7 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
   }
 
   template <Flags flagBit>
-  static Value getFlag() noexcept {
+  static constexpr Value getFlag() noexcept {
     static_assert(flagBit >= kNumAccessRefBits + kNumAdminRefBits,
                   "incorrect flag");
     static_assert(flagBit < NumBits<Value>::value, "incorrect flag");
@@ -22,6 +22,7 @@
 #include "cachelib/allocator/memory/SlabAllocator.h"
 #include "cachelib/common/Exceptions.h"
 #include "cachelib/common/Throttler.h"
+#include "cachelib/common/Time.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -31,6 +32,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <limits>
 #include <stdexcept>
 #include <thread>
 
@@ -41,6 +43,7 @@ using namespace facebook::cachelib;
 constexpr unsigned int AllocationClass::kFreeAllocsPruneLimit;
 constexpr unsigned int AllocationClass::kFreeAllocsPruneSleepMicroSecs;
 constexpr unsigned int AllocationClass::kForEachAllocPrefetchOffset;
+constexpr unsigned int AllocationClass::kSlabReleaseSamples;
 
 AllocationClass::AllocationClass(ClassId classId,
                                  PoolId poolId,
@@ -117,6 +120,24 @@ AllocationClass::AllocationClass(
   }
 
   checkState();
+  restoreSlabUsage();
+}
+
+void AllocationClass::restoreSlabUsage() const {
+  // the access times were not saved, so every slab starts out as recently
+  // accessed.
+  const auto now = util::getCurrentTimeSec();
+  for (const auto* slab : allocatedSlabs_) {
+    auto& usage = slabAlloc_.getSlabUsage(slab);
+    usage.activeAllocs.store(slab == currSlab_ ? currOffset_ / allocationSize_
+                                               : getAllocsPerSlab(),
+                             std::memory_order_relaxed);
+    usage.lastAccessTime.store(now, std::memory_order_relaxed);
+  }
+  for (const auto& freeAlloc : freedAllocations_) {
+    slabAlloc_.getSlabUsage(slabAlloc_.getSlabForMemory(&freeAlloc))
+        .activeAllocs.fetch_sub(1, std::memory_order_relaxed);
+  }
 }
 
 void AllocationClass::addSlabLocked(Slab* slab) {
@@ -169,25 +190,27 @@ void* AllocationClass::allocateLocked() {
 
   XDCHECK(canAllocate_);
 
-  // grab from the free list if possible.
+  void* ret = nullptr;
   if (!freedAllocations_.empty()) {
-    FreeAlloc* ret = freedAllocations_.getHead();
+    // grab from the free list if possible.
+    ret = freedAllocations_.getHead();
     XDCHECK(ret != nullptr);
     freedAllocations_.pop();
-    return reinterpret_cast<void*>(ret);
+  } else if (canAllocateFromCurrentSlabLocked()) {
+    // see if we have an active slab that is being used to carve the
+    // allocations.
+    ret = allocateFromCurrentSlabLocked();
+  } else {
+    XDCHECK(canAllocate_);
+    XDCHECK(!freeSlabs_.empty());
+    setupCurrentSlabLocked();
+    // grab a free slab and make it current.
+    ret = allocateFromCurrentSlabLocked();
   }
 
-  // see if we have an active slab that is being used to carve the
-  // allocations.
-  if (canAllocateFromCurrentSlabLocked()) {
-    return allocateFromCurrentSlabLocked();
-  }
-
-  XDCHECK(canAllocate_);
-  XDCHECK(!freeSlabs_.empty());
-  setupCurrentSlabLocked();
-  // grab a free slab and make it current.
-  return allocateFromCurrentSlabLocked();
+  slabAlloc_.getSlabUsage(slabAlloc_.getSlabForMemory(ret))
+      .activeAllocs.fetch_add(1, std::memory_order_relaxed);
+  return ret;
 }
 
 void AllocationClass::setupCurrentSlabLocked() {
@@ -197,17 +220,46 @@ void AllocationClass::setupCurrentSlabLocked() {
   currSlab_ = slab;
   currOffset_ = 0;
   allocatedSlabs_.push_back(slab);
+
+  auto& usage = slabAlloc_.getSlabUsage(slab);
+  usage.activeAllocs.store(0, std::memory_order_relaxed);
+  usage.lastAccessTime.store(util::getCurrentTimeSec(),
+                             std::memory_order_relaxed);
 }
 
 const Slab* AllocationClass::getSlabForReleaseLocked() const noexcept {
   if (!freeSlabs_.empty()) {
     return freeSlabs_.front();
-  } else if (!allocatedSlabs_.empty()) {
-    auto idx =
-        folly::Random::rand32(static_cast<uint32_t>(allocatedSlabs_.size()));
-    return allocatedSlabs_[idx];
+  } else if (allocatedSlabs_.empty()) {
+    return nullptr;
+  }
+
+  // compare all the slabs if there are few, otherwise a random sample
+  const auto numSlabs = static_cast<uint32_t>(allocatedSlabs_.size());
+  const bool sample = numSlabs > kSlabReleaseSamples;
+  const auto now = util::getCurrentTimeSec();
+  const Slab* victim = nullptr;
+  double minCost = std::numeric_limits<double>::max();
+  for (uint32_t i = 0; i < std::min(numSlabs, kSlabReleaseSamples); i++) {
+    const auto* slab =
+        allocatedSlabs_[sample ? folly::Random::rand32(numSlabs) : i];
+    const auto cost = getSlabReleaseCost(slab, now);
+    if (cost < minCost) {
+      minCost = cost;
+      victim = slab;
+    }
   }
-  return nullptr;
+  return victim;
+}
+
+double AllocationClass::getSlabReleaseCost(const Slab* slab,
+                                           uint32_t now) const noexcept {
+  const auto& usage = slabAlloc_.getSlabUsage(slab);
+  const auto activeAllocs = usage.activeAllocs.load(std::memory_order_relaxed);
+  const auto lastAccessTime =
+      usage.lastAccessTime.load(std::memory_order_relaxed);
+  const auto idleSecs = now > lastAccessTime ? now - lastAccessTime : 0;
+  return static_cast<double>(activeAllocs) / (1 + idleSecs);
 }
 
 SlabReleaseContext AllocationClass::startSlabRelease(
@@ -653,12 +705,16 @@ void AllocationClass::free(void* memory) {
             folly::sformat("Allocation {} is already marked as free", memory));
       }
       allocState[idx] = true;
+      slabAlloc_.getSlabUsage(slab).activeAllocs.fetch_sub(
+          1, std::memory_order_relaxed);
       return;
     }
 
     // TODO add checks here to ensure that we dont double free in debug mode.
     freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(memory));
     canAllocate_ = true;
+    slabAlloc_.getSlabUsage(slab).activeAllocs.fetch_sub(
+        1, std::memory_order_relaxed);
   });
 }
 
@@ -326,9 +326,19 @@ class AllocationClass {
   void* allocateFromCurrentSlabLocked() noexcept;
 
   // get a suitable slab for being released from either the set of free slabs
-  // or the allocated slabs.
+  // or the allocated slabs. Among the allocated slabs, the cheapest one of a
+  // random sample of kSlabReleaseSamples is picked.
   const Slab* getSlabForReleaseLocked() const noexcept;
 
+  // expected cost of releasing an allocated slab at @now. Every active
+  // allocation has to be moved or evicted, and evicting is cheaper the longer
+  // the slab has not been accessed.
+  double getSlabReleaseCost(const Slab* slab, uint32_t now) const noexcept;
+
+  // rebuilds the usage of the allocated slabs after being restored, since it
+  // is not persisted.
+  void restoreSlabUsage() const;
+
   // prune the freeAllocs_ to eliminate any  allocs belonging to this slab and
   // also return a list of active allocations. If there are any active
   // allocations, it maintains the freeState for the slab release.
@@ -489,6 +499,9 @@ class AllocationClass {
   // in a slab.
   static constexpr unsigned int kForEachAllocPrefetchOffset = 16;
 
+  // Number of allocated slabs to compare when picking a slab for release.
+  static constexpr unsigned int kSlabReleaseSamples = 32;
+
   // Allow access to private members by unit tests
   friend class facebook::cachelib::tests::AllocTestBase;
   FRIEND_TEST(AllocationClassTest, ReleaseSlabMultithread);
@@ -27,6 +27,15 @@ void checkConfig(const MemoryAllocator::Config& config) {
     throw std::invalid_argument("Too many allocation classes");
   }
 }
+
+SlabAllocator::Config getSlabAllocatorConfig(
+    const MemoryAllocator::Config& config) {
+  SlabAllocator::Config slabConfig{config.disableFullCoredump,
+                                   config.lockMemory};
+  slabConfig.prefaultThreads = config.prefaultThreads;
+  slabConfig.prefaultNumaNodes = config.prefaultNumaNodes;
+  return slabConfig;
+}
 } // namespace
 
 MemoryAllocator::MemoryAllocator(Config config,
@@ -35,7 +44,7 @@ MemoryAllocator::MemoryAllocator(Config config,
     : config_(std::move(config)),
       slabAllocator_(memoryStart,
                      memSize,
-                     {config_.disableFullCoredump, config_.lockMemory}),
+                     getSlabAllocatorConfig(config_)),
       memoryPoolManager_(slabAllocator_) {
   checkConfig(config_);
 }
@@ -43,7 +52,7 @@ MemoryAllocator::MemoryAllocator(Config config,
 MemoryAllocator::MemoryAllocator(Config config, size_t memSize)
     : config_(std::move(config)),
       slabAllocator_(memSize,
-                     {config_.disableFullCoredump, config_.lockMemory}),
+                     getSlabAllocatorConfig(config_)),
       memoryPoolManager_(slabAllocator_) {
   checkConfig(config_);
 }
@@ -61,7 +70,7 @@ MemoryAllocator::MemoryAllocator(
       slabAllocator_(*object.slabAllocator(),
                      memoryStart,
                      memSize,
-                     {config_.disableFullCoredump, config_.lockMemory}),
+                     getSlabAllocatorConfig(config_)),
       memoryPoolManager_(*object.memoryPoolManager(), slabAllocator_) {
   checkConfig(config_);
 }
@@ -109,6 +109,12 @@ class MemoryAllocator {
     // allocator is not shared, user needs to ensure there are appropriate
     // rlimits setup to lock the memory.
     bool lockMemory{false};
+
+    // Page in the memory from this many threads in parallel when lockMemory
+    // is set, each pinned to one of prefaultNumaNodes if not empty. See
+    // SlabAllocator::Config. Not persisted across saved state.
+    unsigned int prefaultThreads{0};
+    std::vector<unsigned int> prefaultNumaNodes;
   };
 
   // Creates a memory allocator out of the caller allocated memory region. The
@@ -411,6 +417,16 @@ class MemoryAllocator {
     return memoryPoolManager_.getAdvisedMemorySize();
   }
 
+  // return the memory paged in so far when memory locking is enabled
+  size_t getPrefaultedMemorySize() const noexcept {
+    return slabAllocator_.getPrefaultedSize();
+  }
+
+  // return the time it took to page in all of the memory, 0 if not done
+  uint64_t getPrefaultDurationMs() const noexcept {
+    return slabAllocator_.getPrefaultDurationMs();
+  }
+
   // return the list of pool ids for this allocator.
   std::set<PoolId> getPoolIds() const {
     return memoryPoolManager_.getPoolIds();
@@ -465,6 +481,13 @@ class MemoryAllocator {
     return AllocInfo{header->poolId, header->classId, header->allocSize};
   }
 
+  // record that the allocation at @memory was accessed at @time. Slab
+  // release prefers slabs whose allocations were not accessed recently.
+  FOLLY_ALWAYS_INLINE void recordAccess(const void* memory,
+                                        uint32_t time) const noexcept {
+    slabAllocator_.recordSlabAccess(memory, time);
+  }
+
   // fetch the allocation size for the pool id and class id.
   //
   // @param pid  the pool id
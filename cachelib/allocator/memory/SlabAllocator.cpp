@@ -20,10 +20,14 @@
 #include <folly/Random.h>
 #include <folly/logging/xlog.h>
 #include <folly/synchronization/SanitizeThread.h>
+#include <numa.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 
@@ -36,6 +40,10 @@
 #ifndef MADV_DONTDUMP
 #define MADV_DONTDUMP 0
 #endif
+/* MADV_POPULATE_WRITE was added in Linux 5.14 */
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 0
+#endif
 
 using namespace facebook::cachelib;
 
@@ -53,6 +61,7 @@ constexpr unsigned int CompressedPtr::kNumAllocIdxBits;
 
 constexpr unsigned int SlabAllocator::kLockSleepMS;
 constexpr size_t SlabAllocator::kPagesPerStep;
+constexpr unsigned int SlabAllocator::kPrefaultLogIntervalMS;
 
 void SlabAllocator::checkState() const {
   if (memoryStart_ == nullptr || memorySize_ <= Slab::kSize) {
@@ -124,6 +133,8 @@ SlabAllocator::SlabAllocator(void* memoryStart,
       nextSlabAllocation_(slabMemoryStart_),
       ownsMemory_(ownsMemory) {
   checkState();
+  slabUsage_ =
+      std::make_unique<SlabUsage[]>(getSlabMemoryEnd() - slabMemoryStart_);
 
   static_assert(!(sizeof(Slab) & (sizeof(Slab) - 1)),
                 "slab size must be power of two");
@@ -133,7 +144,7 @@ SlabAllocator::SlabAllocator(void* memoryStart,
   }
 
   if (config.lockMemory) {
-    memoryLocker_ = std::thread{[this]() { lockMemoryAsync(); }};
+    startMemoryLocker(config);
   }
 
   XDCHECK_EQ(0u, reinterpret_cast<uintptr_t>(memoryStart_) % sizeof(Slab));
@@ -208,14 +219,26 @@ SlabAllocator::SlabAllocator(const serialization::SlabAllocatorObject& object,
   }
 
   if (config.lockMemory) {
-    memoryLocker_ = std::thread{[this]() { lockMemoryAsync(); }};
+    startMemoryLocker(config);
   }
 
   checkState();
+  slabUsage_ =
+      std::make_unique<SlabUsage[]>(getSlabMemoryEnd() - slabMemoryStart_);
+}
+
+void SlabAllocator::startMemoryLocker(const Config& config) {
+  if (config.prefaultThreads > 0) {
+    memoryLocker_ =
+        std::thread{[this, config]() { prefaultMemoryParallel(config); }};
+  } else {
+    memoryLocker_ = std::thread{[this]() { lockMemoryAsync(); }};
+  }
 }
 
 void SlabAllocator::lockMemoryAsync() noexcept {
   try {
+    const auto startTime = std::chrono::steady_clock::now();
     // memory start is always page aligned since it is aligned to slab size.
     auto* mem = reinterpret_cast<const uint8_t* const>(memoryStart_);
     XDCHECK(util::isPageAlignedAddr(mem));
@@ -245,6 +268,7 @@ void SlabAllocator::lockMemoryAsync() noexcept {
         // in opt mode.
         volatile const uint8_t val = *pageAddr;
         (void)val;
+        prefaultedSize_.fetch_add(pageSize, std::memory_order_relaxed);
       }
 
       ++pageOffset;
@@ -255,26 +279,142 @@ void SlabAllocator::lockMemoryAsync() noexcept {
       }
     }
 
-    // verify everything got paged in. If it doesn't, then we'll end up locking
-    // advised away pages, which means we'll start off with some unusable
-    // cache memory.
-    const auto numInCore = util::getNumResidentPages(memoryStart_, memorySize_);
-    if (numInCore != numPages - numAdvisedAwayPages) {
-      XLOGF(ERR,
-            "could not page in all memory. numPages = {}, numInCore = {}. "
-            "Trying to mlock.",
-            numPages - numAdvisedAwayPages, numInCore);
-      // try mlock to see if that helps.
-      const int rv = mlock(memoryStart_, memorySize_);
-      if (rv != 0) {
-        XLOGF(ERR, "could not mlock. errno = {}", errno);
+    mlockIfNotResident(numAdvisedAwayPages);
+    prefaultDurationMs_ =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count();
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Exception during locking memory {}", e.what());
+  }
+}
+
+void SlabAllocator::prefaultMemoryParallel(const Config& config) noexcept {
+  try {
+    const auto startTime = std::chrono::steady_clock::now();
+    // header slabs are paged in as well, they are never advised away.
+    const size_t numSlabs = memorySize_ / Slab::kSize;
+    const size_t numThreads =
+        std::min<size_t>(config.prefaultThreads, numSlabs);
+    const size_t slabsPerThread = (numSlabs + numThreads - 1) / numThreads;
+    const auto& numaNodes = config.prefaultNumaNodes;
+    const bool useNuma = !numaNodes.empty() && numa_available() >= 0;
+    if (!numaNodes.empty() && !useNuma) {
+      XLOG(WARN) << "NUMA is not available, not pinning prefault threads";
+    }
+
+    std::atomic<size_t> numAdvisedAwayPages{0};
+    std::atomic<size_t> numDone{0};
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numThreads; i++) {
+      const size_t begin = i * slabsPerThread;
+      const size_t end = std::min(numSlabs, begin + slabsPerThread);
+      if (begin >= end) {
+        break;
+      }
+      const int node =
+          useNuma ? static_cast<int>(numaNodes[i % numaNodes.size()]) : -1;
+      threads.emplace_back([this, begin, end, node, &numAdvisedAwayPages,
+                            &numDone]() {
+        if (node >= 0 && numa_run_on_node(node) != 0) {
+          XLOGF(WARN, "could not run prefault thread on NUMA node {}: {}",
+                node, std::strerror(errno));
+        }
+        numAdvisedAwayPages += prefaultSlabs(begin, end);
+        ++numDone;
+      });
+    }
+
+    XLOGF(INFO, "paging in {} bytes of cache memory with {} threads",
+          memorySize_, threads.size());
+    unsigned int sinceLogMs = 0;
+    while (numDone < threads.size()) {
+      /* sleep override */
+      std::this_thread::sleep_for(std::chrono::milliseconds(kLockSleepMS));
+      sinceLogMs += kLockSleepMS;
+      if (sinceLogMs >= kPrefaultLogIntervalMS) {
+        sinceLogMs = 0;
+        XLOGF(INFO, "paged in {} of {} bytes of cache memory",
+              getPrefaultedSize(), memorySize_);
       }
     }
+    for (auto& t : threads) {
+      t.join();
+    }
+    if (stopLocking_) {
+      return;
+    }
+
+    mlockIfNotResident(numAdvisedAwayPages);
+    prefaultDurationMs_ =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count();
+    XLOGF(INFO, "paged in {} bytes of cache memory in {} ms",
+          getPrefaultedSize(), prefaultDurationMs_.load());
   } catch (const std::exception& e) {
     XLOGF(ERR, "Exception during locking memory {}", e.what());
   }
 }
 
+size_t SlabAllocator::prefaultSlabs(size_t begin, size_t end) noexcept {
+  const size_t pageSize = util::getPageSize();
+  const size_t pagesPerSlab = Slab::kSize / pageSize;
+  size_t numAdvisedAwayPages = 0;
+  for (size_t i = begin; i < end && !stopLocking_; i++) {
+    auto* slabAddr =
+        reinterpret_cast<uint8_t*>(memoryStart_) + i * Slab::kSize;
+    // Avoid touching advised away slabs.
+    const auto header = getSlabHeader(slabAddr);
+    if (header && header->isAdvised()) {
+      numAdvisedAwayPages += pagesPerSlab;
+      continue;
+    }
+
+    // MADV_POPULATE_WRITE faults the pages in as if written to without
+    // changing their contents, which also works for memory that is not
+    // shared.
+    bool populated = false;
+    if (MADV_POPULATE_WRITE != 0 &&
+        usePopulateWrite_.load(std::memory_order_relaxed)) {
+      populated = madvise(slabAddr, Slab::kSize, MADV_POPULATE_WRITE) == 0;
+      if (!populated && errno == EINVAL) {
+        usePopulateWrite_ = false;
+      }
+    }
+    if (!populated) {
+      // Reading a page that is not shared maps the zero page, which neither
+      // allocates it nor places it on this thread's NUMA node. Write to every
+      // page instead, with an atomic no-op so that a concurrent write to the
+      // same byte by the cache is not lost.
+      for (size_t off = 0; off < Slab::kSize; off += pageSize) {
+        __atomic_fetch_or(slabAddr + off, 0, __ATOMIC_RELAXED);
+      }
+    }
+    prefaultedSize_.fetch_add(Slab::kSize, std::memory_order_relaxed);
+  }
+  return numAdvisedAwayPages;
+}
+
+void SlabAllocator::mlockIfNotResident(size_t numAdvisedAwayPages) noexcept {
+  // verify everything got paged in. If it doesn't, then we'll end up locking
+  // advised away pages, which means we'll start off with some unusable
+  // cache memory.
+  const size_t numPages = util::getNumPages(memorySize_);
+  const auto numInCore = util::getNumResidentPages(memoryStart_, memorySize_);
+  if (numInCore != numPages - numAdvisedAwayPages) {
+    XLOGF(ERR,
+          "could not page in all memory. numPages = {}, numInCore = {}. "
+          "Trying to mlock.",
+          numPages - numAdvisedAwayPages, numInCore);
+    // try mlock to see if that helps.
+    const int rv = mlock(memoryStart_, memorySize_);
+    if (rv != 0) {
+      XLOGF(ERR, "could not mlock. errno = {}", errno);
+    }
+  }
+}
+
 namespace {
 unsigned int numSlabs(size_t memorySize) noexcept {
   return static_cast<unsigned int>(memorySize / sizeof(Slab));
@@ -19,6 +19,7 @@
 #include <sys/mman.h>
 
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -60,6 +61,15 @@ class SlabAllocator {
     // lock the pages in memory, forcing to allocate them and retaining them in
     // memory even when untouched.
     bool lockMemory{false};
+
+    // number of threads paging in the memory when lockMemory is set. 0 pages
+    // it in from a single thread, throttled to spread out the page faults.
+    unsigned int prefaultThreads{0};
+
+    // NUMA nodes the prefault threads run on, assigned round robin. Each
+    // thread pages in one contiguous range of slabs, so first touch places
+    // the range on the thread's node. Empty leaves the threads unpinned.
+    std::vector<unsigned int> prefaultNumaNodes;
   };
 
   // initialize the slab allocator for the range of memory starting from
@@ -109,6 +119,17 @@ class SlabAllocator {
   // state. This is a precondition to calling saveState.
   bool isRestorable() const noexcept { return !ownsMemory_; }
 
+  // bytes of memory paged in so far when memory locking is enabled.
+  size_t getPrefaultedSize() const noexcept {
+    return prefaultedSize_.load(std::memory_order_relaxed);
+  }
+
+  // time it took to page in all of the memory. 0 while the memory is being
+  // paged in or if memory locking is not enabled.
+  uint64_t getPrefaultDurationMs() const noexcept {
+    return prefaultDurationMs_.load(std::memory_order_relaxed);
+  }
+
   using LockHolder = std::unique_lock<std::mutex>;
 
   // return true if any more slabs can be allocated from the slab allocator at
@@ -183,6 +204,38 @@ class SlabAllocator {
   // invalid
   SlabHeader* getSlabHeader(const Slab* const slab) const noexcept;
 
+  // How much a slab is used by its allocation class, to find slabs that are
+  // cheap to release. Kept outside of the slab headers, so it is not
+  // persisted and AllocationClass rebuilds it when it is restored.
+  struct SlabUsage {
+    // number of allocations of the slab that are handed out
+    std::atomic<uint32_t> activeAllocs{0};
+
+    // latest access time in seconds of an allocation in the slab, as
+    // reported through recordSlabAccess()
+    std::atomic<uint32_t> lastAccessTime{0};
+  };
+
+  // returns the usage of a valid slab
+  SlabUsage& getSlabUsage(const Slab* slab) const noexcept {
+    XDCHECK(isValidSlab(slab));
+    return slabUsage_[slab - slabMemoryStart_];
+  }
+
+  // record that the allocation at @memory was accessed at @time. The slab's
+  // time is only written when it moves forward, so that this is cheap enough
+  // to call on accesses.
+  FOLLY_ALWAYS_INLINE void recordSlabAccess(const void* memory,
+                                            uint32_t time) const noexcept {
+    const auto* slab = getSlabForMemory(memory);
+    if (LIKELY(isValidSlab(slab))) {
+      auto& lastAccessTime = slabUsage_[slab - slabMemoryStart_].lastAccessTime;
+      if (lastAccessTime.load(std::memory_order_relaxed) < time) {
+        lastAccessTime.store(time, std::memory_order_relaxed);
+      }
+    }
+  }
+
   // for saving the state of the slab allocator state and reattaching.
   //
   // precondition:  The object must have been instantiated with the
@@ -380,6 +433,26 @@ class SlabAllocator {
   // asynchronously.
   void lockMemoryAsync() noexcept;
 
+  // same as lockMemoryAsync, but pages in the memory from
+  // config.prefaultThreads threads, each owning a contiguous range of slabs.
+  // Uses MADV_POPULATE_WRITE when the kernel supports it and falls back to
+  // writing to every page, so that the pages are allocated on the thread's
+  // NUMA node even when the memory is not shared.
+  void prefaultMemoryParallel(const Config& config) noexcept;
+
+  // pages in the slab sized chunks of memory [begin, end), skipping slabs
+  // that are advised away.
+  //
+  // @return the number of pages skipped
+  size_t prefaultSlabs(size_t begin, size_t end) noexcept;
+
+  // checks that all the pages that are not advised away are resident and
+  // mlocks the memory if they are not.
+  void mlockIfNotResident(size_t numAdvisedAwayPages) noexcept;
+
+  // starts the memory locker thread for the config.
+  void startMemoryLocker(const Config& config);
+
   // shutsdown the memory locker if it is still running.
   void stopMemoryLocker();
 
@@ -412,6 +485,9 @@ class SlabAllocator {
   // the memory address up to which we have converted into slabs.
   Slab* nextSlabAllocation_{nullptr};
 
+  // usage of every slab, indexed by the slab's index.
+  std::unique_ptr<SlabUsage[]> slabUsage_;
+
   // boolean atomic that represents whether the allocator can allocate any
   // more slabs without holding any locks.
   std::atomic<bool> canAllocate_{true};
@@ -426,6 +502,16 @@ class SlabAllocator {
   // signals the locker thread to stop if we need to shutdown this instance.
   std::atomic<bool> stopLocking_{false};
 
+  // cleared once MADV_POPULATE_WRITE fails with EINVAL, i.e. the kernel does
+  // not support it.
+  std::atomic<bool> usePopulateWrite_{true};
+
+  // bytes paged in by the memory locker.
+  std::atomic<size_t> prefaultedSize_{0};
+
+  // time taken by the memory locker to page in all of the memory.
+  std::atomic<uint64_t> prefaultDurationMs_{0};
+
   // Used by tests to avoid having to created shared memory for madvise
   // to be successful.
   bool pretendMadvise_{false};
@@ -437,6 +523,9 @@ class SlabAllocator {
   // number of pages to touch in eash step.
   static constexpr size_t kPagesPerStep = 10000;
 
+  // how often the parallel prefault logs its progress.
+  static constexpr unsigned int kPrefaultLogIntervalMS = 10'000;
+
   static_assert((Slab::kSize & (Slab::kSize - 1)) == 0,
                 "Slab size is not power of two");
 
@@ -27,6 +27,7 @@
 #include "cachelib/allocator/memory/SlabAllocator.h"
 #include "cachelib/allocator/memory/tests/TestBase.h"
 #include "cachelib/common/Serialization.h"
+#include "cachelib/common/Time.h"
 
 using namespace facebook::cachelib::tests;
 using namespace facebook::cachelib;
@@ -631,6 +632,115 @@ TEST_F(AllocationClassTest, ReleaseSlabWithActiveAllocations) {
   ASSERT_EQ(secondSlabHeader->classId, Slab::kInvalidClassId);
 }
 
+TEST_F(AllocationClassTest, ReleaseCheapestSlab) {
+  // without a hint, slab release should pick the slab with the fewest and
+  // coldest active allocations.
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 2;
+  const ClassId cid = 3;
+  const auto allocSize = 1 << 10;
+  AllocationClass ac(cid, pid, allocSize, *slabAlloc);
+
+  // fill up four slabs
+  std::vector<Slab*> slabs;
+  std::vector<std::vector<void*>> allocations(4);
+  for (unsigned int i = 0; i < allocations.size(); i++) {
+    auto slab = slabAlloc->makeNewSlab(pid);
+    ASSERT_NE(slab, nullptr);
+    ac.addSlab(slab);
+    slabs.push_back(slab);
+    for (unsigned int j = 0; j < ac.getAllocsPerSlab(); j++) {
+      auto alloc = ac.allocate();
+      ASSERT_NE(alloc, nullptr);
+      ASSERT_TRUE(slabAlloc->isMemoryInSlab(alloc, slab));
+      allocations[i].push_back(alloc);
+    }
+    ASSERT_EQ(ac.getAllocsPerSlab(),
+              slabAlloc->getSlabUsage(slab).activeAllocs.load());
+  }
+
+  auto releaseSlab = [&](unsigned int expected) {
+    auto context = ac.startSlabRelease(SlabReleaseMode::kRebalance, nullptr);
+    ASSERT_EQ(slabs[expected], context.getSlab());
+    const auto activeAllocs = context.getActiveAllocations();
+    ASSERT_TRUE(std::is_permutation(activeAllocs.begin(), activeAllocs.end(),
+                                    allocations[expected].begin(),
+                                    allocations[expected].end()));
+    for (auto alloc : activeAllocs) {
+      ac.free(alloc);
+    }
+    ASSERT_EQ(0, slabAlloc->getSlabUsage(slabs[expected]).activeAllocs.load());
+    ac.completeSlabRelease(std::move(context));
+  };
+
+  // nearly empty slab
+  while (allocations[2].size() > 3) {
+    ac.free(allocations[2].back());
+    allocations[2].pop_back();
+  }
+  ASSERT_EQ(3, slabAlloc->getSlabUsage(slabs[2]).activeAllocs.load());
+  releaseSlab(2);
+
+  // full, but not accessed for an hour
+  const auto now = util::getCurrentTimeSec();
+  slabAlloc->getSlabUsage(slabs[0]).lastAccessTime.store(now - 3600);
+  slabAlloc->getSlabUsage(slabs[1]).lastAccessTime.store(now - 3600);
+  slabAlloc->recordSlabAccess(allocations[0][0], now);
+  EXPECT_EQ(now, slabAlloc->getSlabUsage(slabs[0]).lastAccessTime.load());
+  // access times do not go backwards
+  slabAlloc->recordSlabAccess(allocations[3][0], now - 7200);
+  EXPECT_GE(slabAlloc->getSlabUsage(slabs[3]).lastAccessTime.load(), now);
+  releaseSlab(1);
+}
+
+TEST_F(AllocationClassTest, SlabUsageRestored) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  AllocationClass ac(cid, pid, 1 << 10, *slabAlloc);
+
+  // one full slab with some frees and a partially carved current slab
+  auto fullSlab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(fullSlab);
+  std::vector<void*> allocations;
+  for (unsigned int i = 0; i < ac.getAllocsPerSlab(); i++) {
+    allocations.push_back(ac.allocate());
+  }
+  for (unsigned int i = 0; i < 10; i++) {
+    ac.free(allocations[i]);
+  }
+  auto currSlab = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(currSlab);
+  for (unsigned int i = 0; i < 20; i++) {
+    ASSERT_TRUE(slabAlloc->isMemoryInSlab(ac.allocate(), currSlab));
+  }
+  ASSERT_EQ(ac.getAllocsPerSlab() - 10,
+            slabAlloc->getSlabUsage(fullSlab).activeAllocs.load());
+  ASSERT_EQ(20, slabAlloc->getSlabUsage(currSlab).activeAllocs.load());
+
+  uint8_t buffer[SerializationBufferSize];
+  uint8_t* begin = buffer;
+  uint8_t* end = buffer + SerializationBufferSize;
+  Serializer serializer(begin, end);
+  serializer.serialize(ac.saveState());
+
+  // the usage is not persisted
+  for (auto slab : {fullSlab, currSlab}) {
+    slabAlloc->getSlabUsage(slab).activeAllocs.store(0);
+    slabAlloc->getSlabUsage(slab).lastAccessTime.store(0);
+  }
+
+  Deserializer deserializer(begin, end);
+  AllocationClass ac2(
+      deserializer.deserialize<serialization::AllocationClassObject>(),
+      pid,
+      *slabAlloc);
+  EXPECT_EQ(ac.getAllocsPerSlab() - 10,
+            slabAlloc->getSlabUsage(fullSlab).activeAllocs.load());
+  EXPECT_EQ(20, slabAlloc->getSlabUsage(currSlab).activeAllocs.load());
+  EXPECT_NE(0, slabAlloc->getSlabUsage(fullSlab).lastAccessTime.load());
+}
+
 // 1. Add two slabs to the AC
 // 2. Allocate until full for each slab
 // 3. Free 2 * kFreeAllocsPruneLimit from each slab
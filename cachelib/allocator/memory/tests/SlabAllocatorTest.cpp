@@ -533,6 +533,35 @@ TEST_F(SlabAllocatorTest, LockMemory) {
   }
 }
 
+TEST_F(SlabAllocatorTest, LockMemoryParallel) {
+  const size_t size = 20 * Slab::kSize;
+  size_t allocSize = size + sizeof(Slab);
+
+  void* memory = mmap(nullptr, allocSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(memory, MAP_FAILED);
+  SCOPE_EXIT { munmap(memory, allocSize); };
+
+  void* alignedMem = util::align(sizeof(Slab), size, memory, allocSize);
+  ASSERT_TRUE(util::isPageAlignedAddr(alignedMem));
+
+  auto config = getDefaultConfig();
+  config.lockMemory = true;
+  config.prefaultThreads = 4;
+  // node 0 always exists, the threads are left unpinned without NUMA
+  config.prefaultNumaNodes = {0};
+  SlabAllocator s(alignedMem, size, config);
+
+  for (int i = 0; i < 50 && s.getPrefaultDurationMs() == 0; i++) {
+    /* sleep override */
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(getSlabAllocatorLockSleepMs()));
+  }
+  ASSERT_EQ(size, s.getPrefaultedSize());
+  ASSERT_EQ(util::getNumResidentPages(alignedMem, size),
+            util::getNumPages(size));
+}
+
 // ensure that we can call save state and have the memory locker thread
 // be shut down appropriately.
 TEST_F(SlabAllocatorTest, LockMemorySaveState) {
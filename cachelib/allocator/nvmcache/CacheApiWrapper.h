@@ -84,6 +84,26 @@ class CacheAPIWrapperForNvm {
     return cache.allocateInternal(id, key, size, creationTime, expiryTime);
   }
 
+  // Change the size of an item allocated from nvmcache to the size the user
+  // requested, when it was allocated with a bigger size. The item must not be
+  // accessible and the caller must hold its only reference.
+  //
+  // @param cache   the cache instance using nvmcache
+  // @param item    the item to resize
+  // @param size    the new size, mapping to the item's allocation class
+  // @return true if the item was resized.
+  static bool resizeInPlace(C& cache, Item& item, uint32_t size) {
+    return cache.resizeInPlace(item, size);
+  }
+
+  // Bytes every regular item reserves beyond its required size to keep the
+  // head of its chain.
+  //
+  // @param cache   the cache instance using nvmcache
+  static uint32_t chainHeadSlotSize(const C& cache) {
+    return cache.chainHeadSlotSize();
+  }
+
   // Insert the allocated handle into the AccessContainer from nvmcache, making
   // it accessible for everyone. This needs to be the handle that the caller
   // allocated through _allocate_. If this call fails, the allocation will be
@@ -16,6 +16,7 @@
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -155,6 +156,83 @@ BigHashConfig& BigHashConfig::setSizePctAndMaxItemSize(
   return *this;
 }
 
+// device emulation settings
+DeviceEmulationConfig& DeviceEmulationConfig::setLatencySigma(double sigma) {
+  if (sigma < 0) {
+    throw std::invalid_argument(folly::sformat(
+        "latency sigma should be non-negative, but {} is set", sigma));
+  }
+  latencySigma_ = sigma;
+  return *this;
+}
+
+DeviceEmulationConfig& DeviceEmulationConfig::setNumQueues(uint32_t numQueues) {
+  if (numQueues == 0) {
+    throw std::invalid_argument("number of queues should be non-zero");
+  }
+  numQueues_ = numQueues;
+  return *this;
+}
+
+DeviceEmulationConfig& DeviceEmulationConfig::setOverProvisioningPct(
+    uint32_t overProvisioningPct) {
+  if (overProvisioningPct > 100) {
+    throw std::invalid_argument(folly::sformat(
+        "over-provisioning pct should be in the range of [0, 100], but {} is "
+        "set",
+        overProvisioningPct));
+  }
+  overProvisioningPct_ = overProvisioningPct;
+  return *this;
+}
+
+DeviceEmulationConfig& DeviceEmulationConfig::setWriteAmplification(
+    double writeAmplification) {
+  if (writeAmplification < 1) {
+    throw std::invalid_argument(folly::sformat(
+        "write amplification should be at least 1, but {} is set",
+        writeAmplification));
+  }
+  writeAmplification_ = writeAmplification;
+  return *this;
+}
+
+double DeviceEmulationConfig::getWriteAmplification() const {
+  if (writeAmplification_ >= 1) {
+    return writeAmplification_;
+  }
+  if (overProvisioningPct_ == 0) {
+    return 1.0;
+  }
+  const double op = overProvisioningPct_ / 100.0;
+  return std::max(1.0, (1 + op) / (2 * op));
+}
+
+std::map<std::string, std::string> DeviceEmulationConfig::serialize() const {
+  auto configMap = std::map<std::string, std::string>();
+  configMap["navyConfig::emulationReadLatencyUs"] =
+      folly::to<std::string>(readLatencyUs_);
+  configMap["navyConfig::emulationWriteLatencyUs"] =
+      folly::to<std::string>(writeLatencyUs_);
+  configMap["navyConfig::emulationLatencySigma"] =
+      folly::to<std::string>(latencySigma_);
+  configMap["navyConfig::emulationReadBandwidthMBps"] =
+      folly::to<std::string>(readBandwidthMBps_);
+  configMap["navyConfig::emulationWriteBandwidthMBps"] =
+      folly::to<std::string>(writeBandwidthMBps_);
+  configMap["navyConfig::emulationNumQueues"] =
+      folly::to<std::string>(numQueues_);
+  configMap["navyConfig::emulationQueueDepthLatencyFactor"] =
+      folly::to<std::string>(queueDepthLatencyFactor_);
+  configMap["navyConfig::emulationWriteAmplification"] =
+      folly::to<std::string>(getWriteAmplification());
+  configMap["navyConfig::emulationGcUnitSizeKB"] =
+      folly::to<std::string>(gcUnitSizeKB_);
+  configMap["navyConfig::emulationGcStallUs"] =
+      folly::to<std::string>(gcStallUs_);
+  return configMap;
+}
+
 // job scheduler settings
 
 void NavyConfig::setReaderAndWriterThreads(unsigned int readerThreads,
@@ -235,6 +313,10 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
       blockCache().getDataChecksum() ? "true" : "false";
   configMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       folly::join(",", blockCache().getSFifoSegmentRatio());
+  configMap["navyConfig::blockCacheDiscardBytesPerSec"] =
+      folly::to<std::string>(blockCache().getDiscardBytesPerSec());
+  configMap["navyConfig::blockCacheSizeBands"] =
+      folly::join(",", blockCache().getSizeBands());
 
   // BigHash settings
   configMap["navyConfig::bigHashSizePct"] =
@@ -245,6 +327,8 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
       folly::to<std::string>(bigHash().getBucketBfSize());
   configMap["navyConfig::bigHashSmallItemMaxSize"] =
       folly::to<std::string>(bigHash().getSmallItemMaxSize());
+  configMap["navyConfig::bigHashDirectorySize"] =
+      folly::to<std::string>(bigHash().getDirectorySize());
   return configMap;
 }
 
@@ -281,6 +365,10 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
   configMap["navyConfig::ioEngine"] = getIoEngineName(ioEngine_).str();
   configMap["navyConfig::QDepth"] = folly::to<std::string>(qDepth_);
   configMap["navyConfig::enableFDP"] = folly::to<std::string>(enableFDP_);
+  if (useDeviceEmulation_) {
+    auto m = deviceEmulationConfig_.serialize();
+    configMap.insert(m.begin(), m.end());
+  }
 
   // Job scheduler settings
   configMap["navyConfig::readerThreads"] =
@@ -292,12 +380,22 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
   configMap["navyConfig::maxNumReads"] = folly::to<std::string>(maxNumReads_);
   configMap["navyConfig::maxNumWrites"] = folly::to<std::string>(maxNumWrites_);
   configMap["navyConfig::stackSize"] = folly::to<std::string>(stackSize_);
+  if (requestTraceSampleRate_ > 0) {
+    configMap["navyConfig::requestTraceSampleRate"] =
+        folly::to<std::string>(requestTraceSampleRate_);
+    configMap["navyConfig::requestTraceSlowThresholdUs"] =
+        folly::to<std::string>(requestTraceSlowThresholdUs_);
+  }
 
   // Other settings
   configMap["navyConfig::maxConcurrentInserts"] =
       folly::to<std::string>(maxConcurrentInserts_);
   configMap["navyConfig::maxParcelMemoryMB"] =
       folly::to<std::string>(maxParcelMemoryMB_);
+  if (metadataHugePages_ != util::HugePagePolicy::kNone) {
+    configMap["navyConfig::metadataHugePages"] =
+        folly::to<std::string>(static_cast<int>(metadataHugePages_));
+  }
 
   if (enginesConfigs_.size() > 1) {
     for (size_t idx = 0; idx < enginesConfigs_.size(); idx++) {
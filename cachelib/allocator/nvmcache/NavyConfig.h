@@ -23,6 +23,7 @@
 
 #include "cachelib/allocator/nvmcache/BlockCacheReinsertionPolicy.h"
 #include "cachelib/common/Hash.h"
+#include "cachelib/common/HugePageAllocator.h"
 
 namespace facebook {
 namespace cachelib {
@@ -311,6 +312,40 @@ class BlockCacheConfig {
     return *this;
   }
 
+  // Keep extra metadata in the in-memory index so that some operations do
+  // not need to read the device. Each costs memory per item.
+  // @param keyFingerprint         resolve hash collisions of lookups and
+  //                               removes in memory
+  // @param expiryGranularitySecs  track expiry times rounded up to this many
+  //                               seconds. 0 disables it.
+  BlockCacheConfig& setIndexMetadata(bool keyFingerprint,
+                                     uint32_t expiryGranularitySecs) noexcept {
+    indexKeyFingerprint_ = keyFingerprint;
+    indexExpiryGranularitySecs_ = expiryGranularitySecs;
+    return *this;
+  }
+
+  // Discard (TRIM or hole punch) regions on the device once they are
+  // reclaimed, so the SSD doesn't relocate their dead data during its garbage
+  // collection. Discards are limited to @bytesPerSec. 0 (the default)
+  // disables discards.
+  BlockCacheConfig& setDiscardRate(uint64_t bytesPerSec) noexcept {
+    discardBytesPerSec_ = bytesPerSec;
+    return *this;
+  }
+
+  // Segregate items by size into bands. Each band writes to its own regions
+  // and has its own eviction policy, and regions move between bands based on
+  // their hit density and reinsertion rate. @sizeBands are the ascending
+  // upper bounds (bytes) of all but the last band, which takes the larger
+  // items. Empty (the default) keeps a single band. Each band keeps an open
+  // region per priority, so the in-mem buffers must outnumber the bands times
+  // the priorities.
+  BlockCacheConfig& setSizeBands(std::vector<uint32_t> sizeBands) noexcept {
+    sizeBands_ = std::move(sizeBands);
+    return *this;
+  }
+
   bool isLruEnabled() const { return lru_; }
 
   const std::vector<unsigned int>& getSFifoSegmentRatio() const {
@@ -335,6 +370,16 @@ class BlockCacheConfig {
 
   bool isPreciseRemove() const { return preciseRemove_; }
 
+  bool hasIndexKeyFingerprint() const { return indexKeyFingerprint_; }
+
+  uint32_t getIndexExpiryGranularitySecs() const {
+    return indexExpiryGranularitySecs_;
+  }
+
+  uint64_t getDiscardBytesPerSec() const { return discardBytesPerSec_; }
+
+  const std::vector<uint32_t>& getSizeBands() const { return sizeBands_; }
+
  private:
   // Whether Navy BlockCache will use region-based LRU eviction policy.
   bool lru_{true};
@@ -359,6 +404,14 @@ class BlockCacheConfig {
   // Whether to remove an item by checking the key (true) or only the hash value
   // (false).
   bool preciseRemove_{false};
+  // Whether the index keeps key fingerprints.
+  bool indexKeyFingerprint_{false};
+  // Granularity of the expiry times kept in the index. 0 to disable.
+  uint32_t indexExpiryGranularitySecs_{0};
+  // Max rate of discarding reclaimed regions. 0 to disable.
+  uint64_t discardBytesPerSec_{0};
+  // Upper bounds of the item size bands. Empty for a single band.
+  std::vector<uint32_t> sizeBands_;
 
   // Intended size of the block cache.
   // If 0, this block cache takes all the space left on the device.
@@ -402,6 +455,18 @@ class BigHashConfig {
     return *this;
   }
 
+  // Reserve the first @directorySize bytes of each bucket for a directory of
+  // key fingerprints. 0 (the default) disables the directory. If the size is
+  // a multiple of the device block size and buckets are at least four
+  // blocks, lookups read the directory and then only the blocks holding the
+  // matching entry, which pays off for large buckets but takes two serial
+  // IOs. Otherwise, e.g. with 4KB buckets, lookups still read the whole
+  // bucket in one IO and only use the directory to search it.
+  BigHashConfig& setDirectorySize(uint32_t directorySize) noexcept {
+    directorySize_ = directorySize;
+    return *this;
+  }
+
   bool isBloomFilterEnabled() const { return bucketBfSize_ > 0; }
 
   unsigned int getSizePct() const { return sizePct_; }
@@ -412,6 +477,8 @@ class BigHashConfig {
 
   uint64_t getSmallItemMaxSize() const { return smallItemMaxSize_; }
 
+  uint32_t getDirectorySize() const { return directorySize_; }
+
  private:
   // Percentage of how much of the device out of all is given to BigHash
   // engine in Navy, e.g. 50.
@@ -425,6 +492,8 @@ class BigHashConfig {
   uint64_t bucketBfSize_{8};
   // The maximum item size to put into Navy BigHash engine.
   uint64_t smallItemMaxSize_{};
+  // Bytes per bucket used for the key fingerprint directory. 0 disables it.
+  uint32_t directorySize_{0};
 };
 
 // Config for a pair of small,large engines.
@@ -462,6 +531,121 @@ inline const folly::StringPiece getIoEngineName(IoEngine e) {
   return "invalid";
 }
 
+/**
+ * DeviceEmulationConfig provides APIs for users to wrap the Navy device in an
+ * emulated SSD. The emulated device still stores data in the underlying
+ * device (usually memory), but delays each IO until the completion time given
+ * by a simple SSD model. This makes it possible to benchmark Navy against
+ * different SSD profiles on machines without the hardware.
+ *
+ * The model consists of:
+ * - per-IO base latency with a lognormal jitter
+ * - per-queue bandwidth, where IOs are spread over a number of queues
+ * - latency growth with the number of outstanding IOs
+ * - garbage collection stalls driven by the write amplification implied by
+ *   the over-provisioning ratio
+ */
+class DeviceEmulationConfig {
+ public:
+  // Set the median read and write latency of a single IO in microseconds.
+  DeviceEmulationConfig& setLatencyUs(uint32_t readLatencyUs,
+                                      uint32_t writeLatencyUs) noexcept {
+    readLatencyUs_ = readLatencyUs;
+    writeLatencyUs_ = writeLatencyUs;
+    return *this;
+  }
+
+  // Set the sigma of the lognormal jitter applied to the latency. 0 makes the
+  // latency deterministic.
+  // @throw std::invalid_argument if sigma is negative.
+  DeviceEmulationConfig& setLatencySigma(double sigma);
+
+  // Set read and write bandwidth in MB/s of each queue. 0 means unlimited.
+  DeviceEmulationConfig& setBandwidthMBps(
+      uint32_t readBandwidthMBps, uint32_t writeBandwidthMBps) noexcept {
+    readBandwidthMBps_ = readBandwidthMBps;
+    writeBandwidthMBps_ = writeBandwidthMBps;
+    return *this;
+  }
+
+  // Set the number of hardware queues IOs are spread across.
+  // @throw std::invalid_argument if numQueues is 0.
+  DeviceEmulationConfig& setNumQueues(uint32_t numQueues);
+
+  // Set how much the latency grows per outstanding IO on the device, as a
+  // fraction of the base latency.
+  DeviceEmulationConfig& setQueueDepthLatencyFactor(double factor) noexcept {
+    queueDepthLatencyFactor_ = factor;
+    return *this;
+  }
+
+  // Set the over-provisioning ratio in percent of the emulated SSD. The write
+  // amplification of the greedy GC under uniform random writes is
+  // approximated as (1 + op) / (2 * op). 0 disables GC emulation.
+  // @throw std::invalid_argument if the value is not in the range of [0, 100].
+  DeviceEmulationConfig& setOverProvisioningPct(uint32_t overProvisioningPct);
+
+  // Override the write amplification derived from over-provisioning.
+  // @throw std::invalid_argument if the value is less than 1.
+  DeviceEmulationConfig& setWriteAmplification(double writeAmplification);
+
+  // Set the GC model: every time gcUnitSizeKB of GC debt (bytes written times
+  // (WA - 1)) accumulates, the device stalls for gcStallUs.
+  DeviceEmulationConfig& setGcParams(uint32_t gcUnitSizeKB,
+                                     uint32_t gcStallUs) noexcept {
+    gcUnitSizeKB_ = gcUnitSizeKB;
+    gcStallUs_ = gcStallUs;
+    return *this;
+  }
+
+  uint32_t getReadLatencyUs() const { return readLatencyUs_; }
+
+  uint32_t getWriteLatencyUs() const { return writeLatencyUs_; }
+
+  double getLatencySigma() const { return latencySigma_; }
+
+  uint32_t getReadBandwidthMBps() const { return readBandwidthMBps_; }
+
+  uint32_t getWriteBandwidthMBps() const { return writeBandwidthMBps_; }
+
+  uint32_t getNumQueues() const { return numQueues_; }
+
+  double getQueueDepthLatencyFactor() const { return queueDepthLatencyFactor_; }
+
+  uint32_t getOverProvisioningPct() const { return overProvisioningPct_; }
+
+  uint32_t getGcUnitSizeKB() const { return gcUnitSizeKB_; }
+
+  uint32_t getGcStallUs() const { return gcStallUs_; }
+
+  // @return the configured write amplification, or the one derived from the
+  //         over-provisioning ratio. 1 means no GC.
+  double getWriteAmplification() const;
+
+  std::map<std::string, std::string> serialize() const;
+
+ private:
+  // Median latency of a single read and write IO in microseconds.
+  uint32_t readLatencyUs_{80};
+  uint32_t writeLatencyUs_{20};
+  // Sigma of the lognormal latency jitter.
+  double latencySigma_{0.0};
+  // Bandwidth of each queue in MB/s. 0 means unlimited.
+  uint32_t readBandwidthMBps_{0};
+  uint32_t writeBandwidthMBps_{0};
+  // Number of queues IOs are spread across.
+  uint32_t numQueues_{1};
+  // Fraction of the base latency added per outstanding IO.
+  double queueDepthLatencyFactor_{0.0};
+  // Over-provisioning ratio in percent. 0 disables GC emulation.
+  uint32_t overProvisioningPct_{0};
+  // Write amplification override. 0 means derived from over-provisioning.
+  double writeAmplification_{0.0};
+  // Size of the GC debt that triggers a stall, and the stall duration.
+  uint32_t gcUnitSizeKB_{1024};
+  uint32_t gcStallUs_{2000};
+};
+
 /**
  * NavyConfig provides APIs for users to set up Navy related settings for
  * NvmCache.
@@ -501,6 +685,14 @@ class NavyConfig {
   // Get a const RandomAPConfig to read values of its parameters.
   const RandomAPConfig& randomAdmPolicy() const { return randomAPConfig_; }
 
+  // Whether the device is wrapped by an emulated SSD.
+  bool usesDeviceEmulation() const { return useDeviceEmulation_; }
+
+  // Get a const DeviceEmulationConfig to read values of its parameters.
+  const DeviceEmulationConfig& deviceEmulation() const {
+    return deviceEmulationConfig_;
+  }
+
   // ============ Device settings =============
   uint64_t getBlockSize() const { return blockSize_; }
   bool getExclusiveOwner() const { return isExclusiveOwner_; }
@@ -533,10 +725,17 @@ class NavyConfig {
   unsigned int getMaxNumReads() const { return maxNumReads_; }
   unsigned int getMaxNumWrites() const { return maxNumWrites_; }
   unsigned int getStackSize() const { return stackSize_; }
+  uint32_t getRequestTraceSampleRate() const { return requestTraceSampleRate_; }
+  uint64_t getRequestTraceSlowThresholdUs() const {
+    return requestTraceSlowThresholdUs_;
+  }
   // ============ other settings =============
   uint32_t getMaxConcurrentInserts() const { return maxConcurrentInserts_; }
   uint64_t getMaxParcelMemoryMB() const { return maxParcelMemoryMB_; }
   bool getUseEstimatedWriteSize() const { return useEstimatedWriteSize_; }
+  util::HugePagePolicy getMetadataHugePages() const {
+    return metadataHugePages_;
+  }
 
   // Setters:
   // Enable "dynamic_random" admission policy.
@@ -587,6 +786,13 @@ class NavyConfig {
   // If qDepth is 0, existing qDepth_ will be used
   void enableAsyncIo(unsigned int qDepth, bool enableIoUring);
 
+  // Wrap the device in an emulated SSD with latency and bandwidth modelling.
+  // @return DeviceEmulationConfig (for configuration)
+  DeviceEmulationConfig& enableDeviceEmulation() noexcept {
+    useDeviceEmulation_ = true;
+    return deviceEmulationConfig_;
+  }
+
   // ============ BlockCache settings =============
   // Return BlockCacheConfig for configuration.
   BlockCacheConfig& blockCache() noexcept {
@@ -617,6 +823,16 @@ class NavyConfig {
   // @throw std::invalid_argument if the input value is 0.
   void setNavyReqOrderingShards(uint64_t navyReqOrderingShards);
 
+  // Enable lifecycle tracing of one in every sampleRate requests. Per stage
+  // latencies are exported through getCounters and traces slower than
+  // slowThresholdUs can be dumped with AbstractCache::dumpSlowRequests.
+  // Only supported with async IO (maxNumReads and maxNumWrites > 0).
+  void setRequestTracing(uint32_t sampleRate,
+                         uint64_t slowThresholdUs) noexcept {
+    requestTraceSampleRate_ = sampleRate;
+    requestTraceSlowThresholdUs_ = slowThresholdUs;
+  }
+
   // ============ Other settings =============
   void setMaxConcurrentInserts(uint32_t maxConcurrentInserts) noexcept {
     maxConcurrentInserts_ = maxConcurrentInserts;
@@ -627,6 +843,11 @@ class NavyConfig {
   void setUseEstimatedWriteSize(bool useEstimatedWriteSize) noexcept {
     useEstimatedWriteSize_ = useEstimatedWriteSize;
   }
+  // Back the large DRAM metadata arrays (the block cache index, the BigHash
+  // bloom filters and the NvmCache shard state) with huge pages.
+  void setMetadataHugePages(util::HugePagePolicy policy) noexcept {
+    metadataHugePages_ = policy;
+  }
 
   const std::vector<EnginesConfig>& enginesConfigs() const {
     return enginesConfigs_;
@@ -669,6 +890,10 @@ class NavyConfig {
   // 0 for Sync io engine and >1 for libaio and io_uring
   unsigned int qDepth_{0};
 
+  // Whether the device is wrapped by an emulated SSD.
+  bool useDeviceEmulation_{false};
+  DeviceEmulationConfig deviceEmulationConfig_{};
+
   // ============ Engines settings =============
   // Currently we support one pair of engines.
   std::vector<EnginesConfig> enginesConfigs_{1};
@@ -695,6 +920,11 @@ class NavyConfig {
   // Stack size of fibers when async-io is enabled. 0 for default
   unsigned int stackSize_{0};
 
+  // Trace one in every requestTraceSampleRate_ requests. 0 disables tracing.
+  uint32_t requestTraceSampleRate_{0};
+  // Traced requests slower than this are kept for dumping.
+  uint64_t requestTraceSlowThresholdUs_{0};
+
   // ============ Other settings =============
   // Maximum number of concurrent inserts we allow globally for Navy.
   // 0 means unlimited.
@@ -706,6 +936,8 @@ class NavyConfig {
   // Whether to use write size (instead of parcel size) for Navy admission
   // policy.
   bool useEstimatedWriteSize_{false};
+  // How the large DRAM metadata arrays are backed.
+  util::HugePagePolicy metadataHugePages_{util::HugePagePolicy::kNone};
   // Whether Navy support the NVMe FDP data placement(TP4146) directives or not.
   // Reference: https://nvmexpress.org/nvmeflexible-data-placement-fdp-blog/
   bool enableFDP_{false};
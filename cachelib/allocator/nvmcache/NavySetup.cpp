@@ -21,6 +21,7 @@
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/navy/Factory.h"
+#include "cachelib/navy/common/EmulatedDevice.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
 
 namespace facebook {
@@ -64,6 +65,7 @@ uint64_t getRegionSize(const navy::NavyConfig& config) {
 // @param bigHashEndOffset The offset where this bighash ends.
 // @param bigHashStartOffsetLimit The start offset of this bighash can not be
 // smaller than or equal to this limit.
+// @param hugePages how the bloom filters are backed
 // @param proto The proto of engine pair that this bighash will be set into.
 //
 // @return the starting offset of the setup bighash (inclusive)
@@ -72,6 +74,7 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
                       uint64_t bigHashReservedSize,
                       uint64_t bigHashEndOffset,
                       uint64_t bigHashStartOffsetLimit,
+                      util::HugePagePolicy hugePages,
                       cachelib::navy::EnginePairProto& proto) {
   auto bucketSize = bigHashConfig.getBucketSize();
   if (bucketSize != alignUp(bucketSize, ioAlignSize)) {
@@ -101,6 +104,11 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
     const uint32_t bitsPerHash =
         bigHashConfig.getBucketBfSize() * 8 / kNumHashes;
     bigHash->setBloomFilter(kNumHashes, bitsPerHash);
+    bigHash->setBloomFilterHugePages(hugePages);
+  }
+
+  if (bigHashConfig.getDirectorySize() > 0) {
+    bigHash->setDirectory(bigHashConfig.getDirectorySize());
   }
 
   proto.setBigHash(std::move(bigHash), bigHashConfig.getSmallItemMaxSize());
@@ -123,6 +131,7 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
 // @param useRaidFiles if set to true, the device will setup using raid.
 // @param itemDestructorEnabled
 // @param stackSize size of the stack used by the region_manager thread
+// @param hugePages how the index is backed
 // @param proto
 //
 // @return The end offset (exclusive) of the setup blockcache.
@@ -133,6 +142,7 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
                          bool usesRaidFiles,
                          bool itemDestructorEnabled,
                          uint32_t stackSize,
+                         util::HugePagePolicy hugePages,
                          cachelib::navy::EnginePairProto& proto) {
   auto regionSize = blockCacheConfig.getRegionSize();
   if (regionSize != alignUp(regionSize, ioAlignSize)) {
@@ -178,6 +188,12 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
   blockCache->setItemDestructorEnabled(itemDestructorEnabled);
   blockCache->setStackSize(stackSize);
   blockCache->setPreciseRemove(blockCacheConfig.isPreciseRemove());
+  blockCache->setIndexMetadata(
+      blockCacheConfig.hasIndexKeyFingerprint(),
+      blockCacheConfig.getIndexExpiryGranularitySecs());
+  blockCache->setDiscardRate(blockCacheConfig.getDiscardBytesPerSec());
+  blockCache->setIndexHugePages(hugePages);
+  blockCache->setSizeBands(blockCacheConfig.getSizeBands());
 
   proto.setBlockCache(std::move(blockCache));
   return blockCacheOffset + blockCacheSize;
@@ -252,7 +268,8 @@ void setupCacheProtos(const navy::NavyConfig& config,
           totalCacheSize * enginesConfig.bigHash().getSizePct() / 100ul;
       bigHashStartOffset = setupBigHash(
           enginesConfig.bigHash(), ioAlignSize, bigHashSize, bigHashEndOffset,
-          blockCacheStartOffset, *enginePairProto);
+          blockCacheStartOffset, config.getMetadataHugePages(),
+          *enginePairProto);
       blockCacheSize = blockCacheSize == 0
                            ? bigHashStartOffset - blockCacheStartOffset
                            : blockCacheSize;
@@ -270,7 +287,8 @@ void setupCacheProtos(const navy::NavyConfig& config,
       blockCacheEndOffset = setupBlockCache(
           enginesConfig.blockCache(), blockCacheSize, ioAlignSize,
           blockCacheStartOffset, config.usesRaidFiles(), itemDestructorEnabled,
-          config.getStackSize(), *enginePairProto);
+          config.getStackSize(), config.getMetadataHugePages(),
+          *enginePairProto);
     }
     if (blockCacheEndOffset > bigHashStartOffset) {
       throw std::invalid_argument(folly::sformat(
@@ -314,12 +332,15 @@ std::unique_ptr<cachelib::navy::JobScheduler> createJobScheduler(
         readerThreads, writerThreads, reqOrderShardsPower);
   }
 
-  return cachelib::navy::createNavyRequestScheduler(readerThreads,
-                                                    writerThreads,
-                                                    maxNumReads,
-                                                    maxNumWrites,
-                                                    stackSize,
-                                                    reqOrderShardsPower);
+  return cachelib::navy::createNavyRequestScheduler(
+      readerThreads,
+      writerThreads,
+      maxNumReads,
+      maxNumWrites,
+      stackSize,
+      reqOrderShardsPower,
+      config.getRequestTraceSampleRate(),
+      config.getRequestTraceSlowThresholdUs());
 }
 } // namespace
 
@@ -328,6 +349,7 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
     std::shared_ptr<navy::DeviceEncryptor> encryptor) {
   auto blockSize = config.getBlockSize();
   auto maxDeviceWriteSize = config.getDeviceMaxWriteSize();
+  std::unique_ptr<cachelib::navy::Device> device;
   if (config.usesRaidFiles() || config.usesSimpleFile()) {
     auto stripeSize = 0;
     auto fileSize = config.getFileSize();
@@ -340,7 +362,7 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
       fileSize = alignDown(fileSize, stripeSize);
     }
 
-    return cachelib::navy::createFileDevice(
+    device = cachelib::navy::createFileDevice(
         filePaths,
         fileSize,
         config.getTruncateFile(),
@@ -353,9 +375,15 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
         std::move(encryptor),
         config.getExclusiveOwner());
   } else {
-    return cachelib::navy::createMemoryDevice(config.getFileSize(),
-                                              std::move(encryptor), blockSize);
+    device = cachelib::navy::createMemoryDevice(
+        config.getFileSize(), std::move(encryptor), blockSize);
+  }
+
+  if (config.usesDeviceEmulation()) {
+    return cachelib::navy::createEmulatedDevice(std::move(device),
+                                                config.deviceEmulation());
   }
+  return device;
 }
 
 std::unique_ptr<navy::AbstractCache> createNavyCache(
@@ -364,7 +392,8 @@ std::unique_ptr<navy::AbstractCache> createNavyCache(
     navy::DestructorCallback destructorCb,
     bool truncate,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    bool itemDestructorEnabled) {
+    bool itemDestructorEnabled,
+    navy::ExpiryTimeGetter getExpiryTime) {
   auto device = createDevice(config, std::move(encryptor));
 
   auto proto = cachelib::navy::createCacheProto();
@@ -376,6 +405,7 @@ std::unique_ptr<navy::AbstractCache> createNavyCache(
   proto->setUseEstimatedWriteSize(config.getUseEstimatedWriteSize());
   setAdmissionPolicy(config, *proto);
   proto->setExpiredCheck(checkExpired);
+  proto->setExpiryTimeGetter(std::move(getExpiryTime));
   proto->setDestructorCallback(destructorCb);
 
   setupCacheProtos(config, *devicePtr, *proto, itemDestructorEnabled);
@@ -29,7 +29,8 @@ std::unique_ptr<facebook::cachelib::navy::AbstractCache> createNavyCache(
     facebook::cachelib::navy::DestructorCallback destructorCb,
     bool truncate,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    bool itemDestructorEnabled);
+    bool itemDestructorEnabled,
+    facebook::cachelib::navy::ExpiryTimeGetter getExpiryTime = {});
 
 // create a flash device for Navy engines to use
 // made public for testing purposes
@@ -39,6 +39,7 @@
 #include "cachelib/common/EventInterface.h"
 #include "cachelib/common/Exceptions.h"
 #include "cachelib/common/Hash.h"
+#include "cachelib/common/HugePageAllocator.h"
 #include "cachelib/common/Utils.h"
 #include "cachelib/navy/common/Device.h"
 #include "folly/Range.h"
@@ -63,6 +64,11 @@ class NvmCache {
   using DestructorData = typename C::DestructorData;
   using SampleItem = typename C::SampleItem;
 
+  // Visiting an item of nvmcache. @key and @item are only valid during the
+  // call.
+  using ItemVisitor =
+      std::function<void(folly::StringPiece key, const NvmItem& item)>;
+
   // Context passed in encodeCb or decodeCb. If the item has children,
   // they are passed in the form of a folly::Range.
   // Chained items must be iterated though @chainedItemRange.
@@ -196,6 +202,15 @@ class NvmCache {
 
   SampleItem getSampleItem();
 
+  // Walk partition @partition out of @numPartitions disjoint partitions of
+  // the navy cache and call @visitor with every item that is not expired.
+  // Partitions can be walked concurrently.
+  //
+  // @throw std::invalid_argument if the partition is invalid
+  void forEachItem(uint32_t partition,
+                   uint32_t numPartitions,
+                   const ItemVisitor& visitor);
+
   // safely shut down the cache. must be called after stopping all concurrent
   // access to cache. using nvmcache after this will result in no-op.
   // Returns true if shutdown was performed properly, false otherwise.
@@ -218,6 +233,11 @@ class NvmCache {
     return navyCache_->updateMaxRateForDynamicRandomAP(maxRate);
   }
 
+  // returns the lifecycle traces of recent slow navy requests, one per line
+  std::string dumpSlowRequests() const {
+    return navyCache_->dumpSlowRequests();
+  }
+
   // This lock is to protect concurrent NvmCache evictCB and CacheAllocator
   // remove/insertOrReplace/invalidateNvm.
   // This lock scope within the above functions is
@@ -230,8 +250,9 @@ class NvmCache {
   // influence to future item with same key.
   std::unique_lock<TimedMutex> getItemDestructorLock(HashedKey hk) const {
     using LockType = std::unique_lock<TimedMutex>;
-    return itemDestructor_ ? LockType{itemDestructorMutex_[getShardForKey(hk)]}
-                           : LockType{};
+    return itemDestructor_
+               ? LockType{shards_[getShardForKey(hk)].itemDestructorMutex}
+               : LockType{};
   }
 
   // For items with this key that are present in NVM, mark the DRAM to be the
@@ -404,14 +425,14 @@ class NvmCache {
     return getShardForKey(HashedKey{key});
   }
 
-  FillMap& getFillMapForShard(size_t shard) { return fills_[shard].fills_; }
+  FillMap& getFillMapForShard(size_t shard) { return shards_[shard].fills; }
 
   FillMap& getFillMap(HashedKey hk) {
     return getFillMapForShard(getShardForKey(hk));
   }
 
   std::unique_lock<TimedMutex> getFillLockForShard(size_t shard) {
-    return std::unique_lock<TimedMutex>(fillLock_[shard].fillLock_);
+    return std::unique_lock<TimedMutex>(shards_[shard].fillLock);
   }
 
   std::unique_lock<TimedMutex> getFillLock(HashedKey hk) {
@@ -438,38 +459,40 @@ class NvmCache {
   // a function to check if an item is expired
   const navy::ExpiredCheck checkExpired_;
 
-  // a map of all pending fills to prevent thundering herds
-  struct {
-    alignas(folly::hardware_destructive_interference_size) FillMap fills_;
-  } fills_[kShards];
-
-  // a map of fill locks for each shard
-  struct {
-    alignas(folly::hardware_destructive_interference_size) TimedMutex fillLock_;
-  } fillLock_[kShards];
-
-  // currently queued put operations to navy.
-  std::array<PutContexts, kShards> putContexts_;
-
-  // currently queued delete operations to navy.
-  std::array<DelContexts, kShards> delContexts_;
-
-  // co-ordination between in-flight evictions from cache that are not queued
-  // to navy and in-flight gets into nvmcache that are not yet queued.
-  std::array<InFlightPuts, kShards> inflightPuts_;
-  std::array<TombStones, kShards> tombstones_;
+  // Per shard state. The shards are kept in one array so that it is large
+  // enough to be backed by huge pages (see NavyConfig::setMetadataHugePages);
+  // every operation on a key touches several of these members.
+  struct Shard {
+    // a map of all pending fills to prevent thundering herds
+    alignas(folly::hardware_destructive_interference_size) FillMap fills;
+
+    // fill lock for the shard
+    alignas(folly::hardware_destructive_interference_size) TimedMutex fillLock;
+
+    // currently queued put operations to navy.
+    PutContexts putContexts;
+
+    // currently queued delete operations to navy.
+    DelContexts delContexts;
+
+    // co-ordination between in-flight evictions from cache that are not queued
+    // to navy and in-flight gets into nvmcache that are not yet queued.
+    InFlightPuts inflightPuts;
+    TombStones tombstones;
+
+    TimedMutex itemDestructorMutex;
+    // Used to track the keys of items present in NVM that should be excluded
+    // for executing Destructor upon eviction from NVM, if the item is not
+    // present in DRAM. The ownership of item destructor is already managed
+    // elsewhere for these keys. This data struct is updated prior to issueing
+    // NvmCache::remove to handle any racy eviction from NVM before the
+    // NvmCache::remove is finished.
+    folly::F14FastSet<std::string> itemRemoved;
+  };
+  util::MetadataArray<Shard> shards_;
 
   const ItemDestructor itemDestructor_;
 
-  mutable std::array<TimedMutex, kShards> itemDestructorMutex_{TimedMutex()};
-  // Used to track the keys of items present in NVM that should be excluded for
-  // executing Destructor upon eviction from NVM, if the item is not present in
-  // DRAM. The ownership of item destructor is already managed elsewhere for
-  // these keys. This data struct is updated prior to issueing NvmCache::remove
-  // to handle any racy eviction from NVM before the NvmCache::remove is
-  // finished.
-  std::array<folly::F14FastSet<std::string>, kShards> itemRemoved_;
-
   std::unique_ptr<cachelib::navy::AbstractCache> navyCache_;
 
   friend class tests::NvmCacheTest;
@@ -531,7 +554,7 @@ typename NvmCache<C>::DeleteTombStoneGuard NvmCache<C>::createDeleteTombStone(
     HashedKey hk) {
   // lower bits for shard and higher bits for key.
   const auto shard = hk.keyHash() % kShards;
-  auto guard = tombstones_[shard].add(hk.key());
+  auto guard = shards_[shard].tombstones.add(hk.key());
 
   // need to synchronize tombstone creations with fill lock to serialize
   // async fills with deletes
@@ -552,7 +575,7 @@ template <typename C>
 bool NvmCache<C>::hasTombStone(HashedKey hk) {
   // lower bits for shard and higher bits for key.
   const auto shard = hk.keyHash() % kShards;
-  return tombstones_[shard].isPresent(hk.key());
+  return shards_[shard].tombstones.isPresent(hk.key());
 }
 
 template <typename C>
@@ -566,7 +589,7 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
   auto shard = getShardForKey(hk);
   // invalidateToken any inflight puts for the same key since we are filling
   // from nvmcache.
-  inflightPuts_[shard].invalidateToken(hk.key());
+  shards_[shard].inflightPuts.invalidateToken(hk.key());
 
   stats().numNvmGets.inc();
 
@@ -608,7 +631,7 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
     // For concurrent put, if it is already enqueued, its put context already
     // exists. If it is not enqueued yet (in-flight) the above invalidateToken
     // will prevent the put from being enqueued.
-    if (it == fillMap.end() && !putContexts_[shard].hasContexts() &&
+    if (it == fillMap.end() && !shards_[shard].putContexts.hasContexts() &&
         !navyCache_->couldExist(hk)) {
       stats().numNvmGetMiss.inc();
       stats().numNvmGetMissFast.inc();
@@ -658,7 +681,7 @@ bool NvmCache<C>::couldExistFast(HashedKey hk) {
   auto shard = getShardForKey(hk);
   // invalidateToken any inflight puts for the same key since we are filling
   // from nvmcache.
-  inflightPuts_[shard].invalidateToken(hk.key());
+  shards_[shard].inflightPuts.invalidateToken(hk.key());
 
   auto lock = getFillLockForShard(shard);
   // do not use the Cache::find() since that will call back into us.
@@ -692,7 +715,7 @@ bool NvmCache<C>::couldExistFast(HashedKey hk) {
   // For concurrent put, if it is already enqueued, its put context already
   // exists. If it is not enqueued yet (in-flight) the above invalidateToken
   // will prevent the put from being enqueued.
-  if (it == fillMap.end() && !putContexts_[shard].hasContexts() &&
+  if (it == fillMap.end() && !shards_[shard].putContexts.hasContexts() &&
       !navyCache_->couldExist(hk)) {
     return false;
   }
@@ -892,6 +915,7 @@ NvmCache<C>::NvmCache(C& c,
         const auto& nvmItem = *reinterpret_cast<const NvmItem*>(v.data());
         return nvmItem.isExpired();
       }),
+      shards_(kShards, config_.navyConfig.getMetadataHugePages()),
       itemDestructor_(itemDestructor) {
   navyCache_ = createNavyCache(
       config_.navyConfig,
@@ -901,7 +925,10 @@ NvmCache<C>::NvmCache(C& c,
       },
       truncate,
       std::move(config.deviceEncryptor),
-      itemDestructor_ ? true : false);
+      itemDestructor_ ? true : false,
+      [](navy::BufferView v) -> uint32_t {
+        return reinterpret_cast<const NvmItem*>(v.data())->getExpiryTime();
+      });
 }
 
 template <typename C>
@@ -1000,7 +1027,7 @@ void NvmCache<C>::put(Item& item, PutToken token) {
   auto val = folly::ByteRange{iobuf.data(), iobuf.length()};
 
   auto shard = getShardForKey(hk);
-  auto& putContexts = putContexts_[shard];
+  auto& putContexts = shards_[shard].putContexts;
   auto& ctx = putContexts.createContext(item.getKey(), std::move(iobuf),
                                         std::move(tracker));
   // capture array reference for putContext. it is stable
@@ -1051,7 +1078,7 @@ void NvmCache<C>::put(Item& item, PutToken token) {
 template <typename C>
 typename NvmCache<C>::PutToken NvmCache<C>::createPutToken(
     folly::StringPiece key) {
-  return inflightPuts_[getShardForKey(key)].tryAcquireToken(key);
+  return shards_[getShardForKey(key)].inflightPuts.tryAcquireToken(key);
 }
 
 template <typename C>
@@ -1127,18 +1154,34 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::createItem(
   const auto pBlob = nvmItem.getBlob(0);
 
   stats().numNvmAllocAttempts.inc();
-  // use the original alloc size to allocate, but make sure that the usable
-  // size matches the pBlob's size
+  // allocate for the stored size so that the item lands in the allocation
+  // class it was flushed from, even if it was resized in place to a size that
+  // maps to a smaller class. The item's size is set back to the original
+  // alloc size below.
+  XDCHECK_LE(pBlob.origAllocSize, pBlob.data.size());
   auto it = CacheAPIWrapperForNvm<C>::allocateInternal(
-      cache_, nvmItem.poolId(), key, pBlob.origAllocSize,
+      cache_, nvmItem.poolId(), key, pBlob.data.size(),
       nvmItem.getCreationTime(), nvmItem.getExpiryTime());
   if (!it) {
     return nullptr;
   }
 
   XDCHECK_LE(pBlob.data.size(), getStorageSizeInNvm(*it));
-  XDCHECK_LE(pBlob.origAllocSize, pBlob.data.size());
   ::memcpy(it->getMemory(), pBlob.data.data(), pBlob.data.size());
+  if (pBlob.origAllocSize != pBlob.data.size()) {
+    // resizing in place is only safe while nobody else can read the item. It
+    // was just allocated and is not inserted yet, so this handle must be its
+    // only reference. The resize also fails if the pool's allocation classes
+    // changed since the item was flushed. Treat either case as a miss.
+    if (it->isAccessible() || it->getRefCount() != 1 ||
+        !CacheAPIWrapperForNvm<C>::resizeInPlace(cache_, *it,
+                                                 pBlob.origAllocSize)) {
+      XLOG_EVERY_N(ERR, 1000) << folly::sformat(
+          "Can not restore the size of item {} from nvm to {}",
+          it->toString(), pBlob.origAllocSize);
+      return nullptr;
+    }
+  }
   it->markNvmClean();
 
   // if we have more, then we need to allocate them as chained items and add
@@ -1261,7 +1304,7 @@ void NvmCache<C>::remove(HashedKey hk, DeleteTombStoneGuard tombstone) {
   //
   // invalidate any inflight put that is on flight since we are queueing up a
   // deletion.
-  inflightPuts_[shard].invalidateToken(hk.key());
+  shards_[shard].inflightPuts.invalidateToken(hk.key());
 
   // Skip scheduling async job to remove the key if the key couldn't exist,
   // if there are no put requests for the key shard.
@@ -1272,11 +1315,12 @@ void NvmCache<C>::remove(HashedKey hk, DeleteTombStoneGuard tombstone) {
   // (in-flight puts) before we check for couldExist.  Any put contexts
   // created after couldExist api returns does not matter, since the put
   // token is invalidated before all of this begins.
-  if (!putContexts_[shard].hasContexts() && !navyCache_->couldExist(hk)) {
+  if (!shards_[shard].putContexts.hasContexts() &&
+      !navyCache_->couldExist(hk)) {
     stats().numNvmSkippedDeletes.inc();
     return;
   }
-  auto& delContexts = delContexts_[shard];
+  auto& delContexts = shards_[shard].delContexts;
   auto& ctx = delContexts.createContext(hk.key(), std::move(tracker),
                                         std::move(tombstone));
 
@@ -1304,6 +1348,19 @@ void NvmCache<C>::remove(HashedKey hk, DeleteTombStoneGuard tombstone) {
                           delCleanup);
 }
 
+template <typename C>
+void NvmCache<C>::forEachItem(uint32_t partition,
+                              uint32_t numPartitions,
+                              const ItemVisitor& visitor) {
+  navyCache_->forEachItem(
+      partition, numPartitions, [&](HashedKey hk, navy::BufferView value) {
+        if (checkExpired_(value)) {
+          return;
+        }
+        visitor(hk.key(), *reinterpret_cast<const NvmItem*>(value.data()));
+      });
+}
+
 template <typename C>
 typename NvmCache<C>::SampleItem NvmCache<C>::getSampleItem() {
   navy::Buffer value;
@@ -1315,8 +1372,10 @@ typename NvmCache<C>::SampleItem NvmCache<C>::getSampleItem() {
   folly::StringPiece key(keyStr);
 
   const auto& nvmItem = *reinterpret_cast<const NvmItem*>(value.data());
+  // sized the way the allocator sizes the item when it is loaded
   const auto requiredSize =
-      Item::getRequiredSize(key, nvmItem.getBlob(0).origAllocSize);
+      Item::getRequiredSize(key, nvmItem.getBlob(0).origAllocSize) +
+      CacheAPIWrapperForNvm<C>::chainHeadSlotSize(cache_);
 
   const auto poolId = nvmItem.poolId();
   auto& pool = cache_.getPool(poolId);
@@ -1363,13 +1422,13 @@ util::StatsMap NvmCache<C>::getStatsMap() const {
 template <typename C>
 void NvmCache<C>::markNvmItemRemovedLocked(HashedKey hk) {
   if (itemDestructor_) {
-    itemRemoved_[getShardForKey(hk)].insert(hk.key());
+    shards_[getShardForKey(hk)].itemRemoved.insert(hk.key());
   }
 }
 
 template <typename C>
 bool NvmCache<C>::checkAndUnmarkItemRemovedLocked(HashedKey hk) {
-  auto& removedSet = itemRemoved_[getShardForKey(hk)];
+  auto& removedSet = shards_[getShardForKey(hk)].itemRemoved;
   auto it = removedSet.find(hk.key());
   if (it != removedSet.end()) {
     removedSet.erase(it);
@@ -1382,8 +1441,8 @@ template <typename C>
 uint64_t NvmCache<C>::getNvmItemRemovedSize() const {
   uint64_t size = 0;
   for (size_t i = 0; i < kShards; ++i) {
-    auto lock = std::unique_lock<TimedMutex>{itemDestructorMutex_[i]};
-    size += itemRemoved_[i].size();
+    auto lock = std::unique_lock<TimedMutex>{shards_[i].itemDestructorMutex};
+    size += shards_[i].itemRemoved.size();
   }
   return size;
 }
@@ -140,6 +140,7 @@ TEST(NavyConfigTest, DefaultVal) {
   EXPECT_EQ(blockCacheConfig.getCleanRegions(), 1);
   EXPECT_EQ(blockCacheConfig.getCleanRegionThreads(), 1);
   EXPECT_TRUE(blockCacheConfig.getSFifoSegmentRatio().empty());
+  EXPECT_TRUE(blockCacheConfig.getSizeBands().empty());
   EXPECT_EQ(blockCacheConfig.getDataChecksum(), true);
   EXPECT_EQ(blockCacheConfig.getNumInMemBuffers(), 2);
 
@@ -201,11 +202,14 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::blockCacheDataChecksum"] = "true";
   expectedConfigMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       "111,222,333";
+  expectedConfigMap["navyConfig::blockCacheDiscardBytesPerSec"] = "0";
+  expectedConfigMap["navyConfig::blockCacheSizeBands"] = "";
 
   expectedConfigMap["navyConfig::bigHashSizePct"] = "50";
   expectedConfigMap["navyConfig::bigHashBucketSize"] = "1024";
   expectedConfigMap["navyConfig::bigHashBucketBfSize"] = "4";
   expectedConfigMap["navyConfig::bigHashSmallItemMaxSize"] = "512";
+  expectedConfigMap["navyConfig::bigHashDirectorySize"] = "0";
 
   expectedConfigMap["navyConfig::maxConcurrentInserts"] = "50000";
   expectedConfigMap["navyConfig::maxParcelMemoryMB"] = "512";
@@ -412,6 +416,40 @@ TEST(NavyConfigTest, OtherSettings) {
   EXPECT_EQ(config.getMaxConcurrentInserts(), maxConcurrentInserts);
   EXPECT_EQ(config.getMaxParcelMemoryMB(), maxParcelMemoryMB);
 }
+
+TEST(NavyConfigTest, DeviceEmulation) {
+  NavyConfig config{};
+  EXPECT_FALSE(config.usesDeviceEmulation());
+  EXPECT_THROW(config.enableDeviceEmulation().setNumQueues(0),
+               std::invalid_argument);
+  EXPECT_THROW(config.enableDeviceEmulation().setLatencySigma(-1),
+               std::invalid_argument);
+  EXPECT_THROW(config.enableDeviceEmulation().setOverProvisioningPct(101),
+               std::invalid_argument);
+  EXPECT_THROW(config.enableDeviceEmulation().setWriteAmplification(0.5),
+               std::invalid_argument);
+
+  config = NavyConfig{};
+  config.enableDeviceEmulation()
+      .setLatencyUs(100, 30)
+      .setBandwidthMBps(3000, 1500)
+      .setNumQueues(4)
+      .setOverProvisioningPct(25);
+  EXPECT_TRUE(config.usesDeviceEmulation());
+  const auto& emulation = config.deviceEmulation();
+  EXPECT_EQ(emulation.getReadLatencyUs(), 100);
+  EXPECT_EQ(emulation.getWriteLatencyUs(), 30);
+  EXPECT_EQ(emulation.getReadBandwidthMBps(), 3000);
+  EXPECT_EQ(emulation.getWriteBandwidthMBps(), 1500);
+  EXPECT_EQ(emulation.getNumQueues(), 4);
+  // (1 + 0.25) / (2 * 0.25)
+  EXPECT_DOUBLE_EQ(emulation.getWriteAmplification(), 2.5);
+
+  config.enableDeviceEmulation().setWriteAmplification(1.5);
+  EXPECT_DOUBLE_EQ(config.deviceEmulation().getWriteAmplification(), 1.5);
+  EXPECT_EQ(config.serialize()["navyConfig::emulationWriteAmplification"],
+            "1.5");
+}
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
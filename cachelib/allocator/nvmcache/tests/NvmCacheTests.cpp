@@ -407,6 +407,41 @@ TEST_F(NvmCacheTest, InsertOrReplace) {
   }
 }
 
+TEST_F(NvmCacheTest, ResizeNvmClean) {
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  std::string key = "blah";
+
+  {
+    auto it = nvm.allocate(pid, key, 100);
+    ASSERT_NE(nullptr, it);
+    *(int*)it->getMemory() = 0xdeadbeef;
+    nvm.insertOrReplace(it);
+  }
+  ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key));
+  this->removeFromRamForTesting(key);
+  nvm.flushNvmCache();
+
+  // the item reloaded from nvm is clean, so evicting it would not write it
+  // back. Growing it past its allocation class replaces it with a copy.
+  {
+    auto it = this->fetch(key, false /* ramOnly */);
+    ASSERT_NE(nullptr, it);
+    ASSERT_TRUE(it->isNvmClean());
+    auto res = nvm.resize(it, 15 * 1024);
+    ASSERT_EQ(AllocatorT::ResizeRes::kSuccess, res.first);
+    ASSERT_NE(it.get(), res.second.get());
+    ASSERT_FALSE(res.second->isNvmClean());
+    *(int*)res.second->getMemory() = 0x5a5a5a5a;
+  }
+  nvm.flushNvmCache();
+
+  // dropping the resized item from ram must not bring back the old bytes.
+  this->removeFromRamForTesting(key);
+  ASSERT_FALSE(this->checkKeyExists(key, false /* ramOnly */));
+}
+
 TEST_F(NvmCacheTest, ConcurrentFills) {
   auto& nvm = this->cache();
   auto pid = this->poolId();
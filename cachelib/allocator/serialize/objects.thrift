@@ -34,6 +34,7 @@ struct CacheAllocatorMetadata {
   9: i64 numChainedChildItems;
   10: i64 ramFormatVersion = 0; // format version of ram cache
   11: i64 numAbortedSlabReleases = 0; // number of times slab release is aborted
+  12: bool chainHeadInParent = false; // chain head kept in the parent item
 }
 
 struct NvmCacheMetadata {
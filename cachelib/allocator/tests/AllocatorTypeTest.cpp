@@ -141,6 +141,8 @@ TYPED_TEST(BaseAllocatorTest, IterateAndRemoveWithIter) {
   this->testIterateAndRemoveWithIter();
 }
 
+TYPED_TEST(BaseAllocatorTest, AccessCursors) { this->testAccessCursors(); }
+
 TYPED_TEST(BaseAllocatorTest, IterateWithEvictions) {
   this->testIterateWithEvictions();
 }
@@ -255,6 +257,14 @@ TYPED_TEST(BaseAllocatorTest, PopChainedItemSimple) {
   this->testPopChainedItemSimple();
 }
 
+TYPED_TEST(BaseAllocatorTest, ChainHeadInParent) {
+  this->testChainHeadInParent();
+}
+
+TYPED_TEST(BaseAllocatorTest, ChainHeadInParentAttach) {
+  this->testChainHeadInParentAttach();
+}
+
 TYPED_TEST(BaseAllocatorTest, AddChainedItemSlabRelease) {
   this->testAddChainedItemSlabRelease();
 }
@@ -352,6 +362,12 @@ TYPED_TEST(BaseAllocatorTest, ReplaceIfAccessible) {
   this->testReplaceIfAccessible();
 }
 
+TYPED_TEST(BaseAllocatorTest, InsertIfVersion) {
+  this->testInsertIfVersion();
+}
+
+TYPED_TEST(BaseAllocatorTest, Resize) { this->testResize(); }
+
 TYPED_TEST(BaseAllocatorTest, ChainedItemIterator) {
   this->testChainedItemIterator();
 }
@@ -411,6 +427,10 @@ TYPED_TEST(BaseAllocatorTest, StatSnapshotTest) {
   this->testStatSnapshotTest();
 }
 
+TYPED_TEST(BaseAllocatorTest, ItemLifetimeStats) {
+  this->testItemLifetimeStats();
+}
+
 namespace { // the tests that cannot be done by TYPED_TEST.
 
 using LruAllocatorTest = BaseAllocatorTest<LruAllocator>;
@@ -2024,6 +2024,57 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     }
   }
 
+  void testAccessCursors() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().ramCacheSize;
+    auto poolId = alloc.addPool("foobar", numBytes);
+
+    const unsigned int nSizes = 2;
+    const unsigned int keyLen = 100;
+    const auto sizes = this->getValidAllocSizes(alloc, poolId, nSizes, keyLen);
+    this->fillUpPoolUntilEvictions(alloc, poolId, sizes, keyLen);
+
+    std::set<std::string> expectedKeys;
+    for (auto& item : alloc) {
+      expectedKeys.insert(item.getKey().str());
+    }
+    ASSERT_GT(expectedKeys.size(), 0);
+
+    ASSERT_THROW(alloc.getAccessCursors(0), std::invalid_argument);
+
+    const size_t numPartitions = 4;
+    auto cursors = alloc.getAccessCursors(numPartitions);
+    ASSERT_EQ(numPartitions, cursors.size());
+    std::vector<std::vector<std::string>> visited(numPartitions);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < numPartitions; i++) {
+      threads.emplace_back([&cursor = cursors[i], &keys = visited[i]]() {
+        std::vector<typename AllocatorT::WriteHandle> batch;
+        while (cursor.nextBatch(batch, 16)) {
+          for (const auto& handle : batch) {
+            keys.push_back(handle->getKey().str());
+          }
+        }
+        EXPECT_TRUE(cursor.done());
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    // every key is visited by exactly one cursor
+    std::set<std::string> visitedKeys;
+    size_t numVisited = 0;
+    for (const auto& keys : visited) {
+      visitedKeys.insert(keys.begin(), keys.end());
+      numVisited += keys.size();
+    }
+    ASSERT_EQ(expectedKeys.size(), numVisited);
+    ASSERT_EQ(expectedKeys, visitedKeys);
+  }
+
   void testIterateWithEvictions() {
     std::set<std::string> evictedKeys;
     auto removeCb =
@@ -4485,6 +4536,89 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     ASSERT_THROW(alloc.popChainedItem(itemHandle), std::invalid_argument);
   }
 
+  // Keep the chain head in the parent item instead of the chained item hash
+  // table and make sure add, pop and transfer still see the right chain.
+  void testChainHeadInParent() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    config.configureChainedItemsInParent();
+    ASSERT_TRUE(config.isChainHeadInParent());
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().ramCacheSize;
+    const auto pid = alloc.addPool("one", numBytes);
+
+    const auto size = 100;
+    auto itemHandle = util::allocateAccessible(alloc, pid, "hello", size);
+    ASSERT_NE(nullptr, itemHandle);
+    ASSERT_FALSE(itemHandle->hasChainedItem());
+
+    // the slot for the chain head takes away from the usable size
+    const auto allocSize =
+        alloc.allocator_->getAllocInfo(itemHandle->getMemory()).allocSize;
+    using Item = typename AllocatorT::Item;
+    ASSERT_EQ(allocSize - Item::getRequiredSize(itemHandle->getKey(), 0) -
+                  sizeof(CompressedPtr::PtrType),
+              alloc.getUsableSize(*itemHandle));
+
+    for (char c = '1'; c <= '3'; ++c) {
+      auto chainedItemHandle = alloc.allocateChainedItem(itemHandle, size);
+      ASSERT_NE(nullptr, chainedItemHandle);
+      reinterpret_cast<char*>(chainedItemHandle->getMemory())[0] = c;
+      alloc.addChainedItem(itemHandle, std::move(chainedItemHandle));
+    }
+
+    {
+      auto chainedAllocs = alloc.viewAsChainedAllocs(itemHandle);
+      ASSERT_EQ(3, chainedAllocs.computeChainLength());
+      char expected = '3';
+      for (const auto& c : chainedAllocs.getChain()) {
+        ASSERT_EQ(expected--, *reinterpret_cast<const char*>(c.getMemory()));
+      }
+    }
+
+    // move the chain over to a new parent and drop the old one
+    auto newParent = alloc.allocate(pid, "hello", size);
+    ASSERT_NE(nullptr, newParent);
+    alloc.transferChainAndReplace(itemHandle, newParent);
+    ASSERT_FALSE(itemHandle->hasChainedItem());
+    itemHandle.reset();
+
+    auto found = alloc.findToWrite("hello");
+    ASSERT_NE(nullptr, found);
+    ASSERT_TRUE(found->hasChainedItem());
+    ASSERT_EQ(3, alloc.viewAsChainedAllocs(found).computeChainLength());
+
+    for (char c = '3'; c >= '1'; --c) {
+      auto popped = alloc.popChainedItem(found);
+      ASSERT_EQ(c, *reinterpret_cast<const char*>(popped->getMemory()));
+    }
+    ASSERT_FALSE(found->hasChainedItem());
+    ASSERT_THROW(alloc.popChainedItem(found), std::invalid_argument);
+  }
+
+  // The chain head slot changes the item layout, so a warm roll with a
+  // different setting must not attach to the saved cache.
+  void testChainHeadInParentAttach() {
+    for (bool inParent : {true, false}) {
+      typename AllocatorT::Config config;
+      config.setCacheSize(10 * Slab::kSize);
+      config.enableCachePersistence(this->cacheDir_);
+      typename AllocatorT::Config otherConfig = config;
+      if (inParent) {
+        config.configureChainedItemsInParent();
+      } else {
+        otherConfig.configureChainedItemsInParent();
+      }
+
+      {
+        AllocatorT alloc(AllocatorT::SharedMemNew, config);
+        ASSERT_EQ(AllocatorT::ShutDownStatus::kSuccess, alloc.shutDown());
+      }
+      ASSERT_THROW(AllocatorT(AllocatorT::SharedMemAttach, otherConfig),
+                   std::invalid_argument);
+    }
+  }
+
   // This tests basically tests slab release when freeing chained items
   // will free the entire chains which they belong to as well.
   void testAddChainedItemSlabRelease() {
@@ -5561,6 +5695,192 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     }
   }
 
+  void testInsertIfVersion() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    AllocatorT alloc(config);
+    const auto poolId =
+        alloc.addPool("default", alloc.getCacheMemoryStats().ramCacheSize);
+
+    // absent key: an empty version only matches an absent key
+    {
+      typename AllocatorT::ItemVersion version;
+      ASSERT_EQ(nullptr, alloc.find("key", version));
+      ASSERT_FALSE(version);
+
+      auto first = alloc.allocate(poolId, "key", 100);
+      ASSERT_TRUE(alloc.insertIfVersion(first, version));
+      auto second = alloc.allocate(poolId, "key", 100);
+      ASSERT_FALSE(alloc.insertIfVersion(second, version));
+      ASSERT_EQ(first, alloc.find("key"));
+    }
+
+    // replace only if unchanged
+    {
+      typename AllocatorT::ItemVersion version;
+      auto old = alloc.find("key", version);
+      ASSERT_TRUE(version);
+
+      auto concurrent = alloc.allocate(poolId, "key", 100);
+      alloc.insertOrReplace(concurrent);
+
+      auto mine = alloc.allocate(poolId, "key", 100);
+      ASSERT_FALSE(alloc.insertIfVersion(mine, version));
+      ASSERT_FALSE(mine->isAccessible());
+      ASSERT_FALSE(mine->isInMMContainer());
+      ASSERT_EQ(concurrent, alloc.find("key"));
+
+      auto current = alloc.find("key", version);
+      ASSERT_TRUE(alloc.insertIfVersion(mine, version));
+      ASSERT_TRUE(mine->isAccessible());
+      ASSERT_TRUE(mine->isInMMContainer());
+      ASSERT_FALSE(concurrent->isAccessible());
+      ASSERT_FALSE(concurrent->isInMMContainer());
+      ASSERT_EQ(mine, alloc.find("key"));
+    }
+
+    // removed keys do not match their old version
+    {
+      typename AllocatorT::ItemVersion version;
+      alloc.find("key", version);
+      alloc.remove("key");
+      auto mine = alloc.allocate(poolId, "key", 100);
+      ASSERT_FALSE(alloc.insertIfVersion(mine, version));
+      ASSERT_EQ(nullptr, alloc.find("key"));
+    }
+
+    // version for a different key
+    {
+      util::allocateAccessible(alloc, poolId, "other", 100);
+      typename AllocatorT::ItemVersion version;
+      alloc.find("other", version);
+      auto mine = alloc.allocate(poolId, "key", 100);
+      ASSERT_THROW(alloc.insertIfVersion(mine, version), std::invalid_argument);
+    }
+    ASSERT_EQ(2, alloc.getGlobalCacheStats().numCasConflicts);
+
+    // concurrent increments without external locking never lose an update
+    {
+      auto counter = alloc.allocate(poolId, "counter", sizeof(uint64_t));
+      *counter->template getMemoryAs<uint64_t>() = 0;
+      alloc.insert(counter);
+
+      const unsigned int numThreads = 8;
+      const unsigned int numIncrements = 1000;
+      std::vector<std::thread> threads;
+      for (unsigned int i = 0; i < numThreads; i++) {
+        threads.emplace_back([&]() {
+          for (unsigned int j = 0; j < numIncrements; j++) {
+            while (true) {
+              typename AllocatorT::ItemVersion version;
+              auto cur = alloc.find("counter", version);
+              auto next = alloc.allocate(poolId, "counter", sizeof(uint64_t));
+              *next->template getMemoryAs<uint64_t>() =
+                  *cur->template getMemoryAs<uint64_t>() + 1;
+              if (alloc.insertIfVersion(next, version)) {
+                break;
+              }
+            }
+          }
+        });
+      }
+      for (auto& t : threads) {
+        t.join();
+      }
+      ASSERT_EQ(numThreads * numIncrements,
+                *alloc.find("counter")->template getMemoryAs<uint64_t>());
+    }
+  }
+
+  void testResize() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    config.configureChainedItems();
+    AllocatorT alloc(config);
+    const auto poolId =
+        alloc.addPool("default", alloc.getCacheMemoryStats().ramCacheSize);
+
+    auto fill = [](auto& handle, uint32_t size) {
+      for (uint32_t i = 0; i < size; i++) {
+        reinterpret_cast<uint8_t*>(handle->getMemory())[i] =
+            static_cast<uint8_t>(i);
+      }
+    };
+    auto check = [](const auto& handle, uint32_t size) {
+      for (uint32_t i = 0; i < size; i++) {
+        ASSERT_EQ(static_cast<uint8_t>(i),
+                  reinterpret_cast<const uint8_t*>(handle->getMemory())[i]);
+      }
+    };
+
+    // growing into the slack of the allocation class happens in place
+    auto handle = util::allocateAccessible(alloc, poolId, "key", 100);
+    fill(handle, 100);
+    const auto usable = alloc.getUsableSize(*handle);
+    ASSERT_GE(usable, 100);
+    using ResizeRes = typename AllocatorT::ResizeRes;
+    auto [res, resized] = alloc.resize(handle, usable);
+    ASSERT_EQ(ResizeRes::kSuccess, res);
+    ASSERT_EQ(handle, resized);
+    ASSERT_EQ(usable, resized->getSize());
+    ASSERT_EQ(usable, alloc.getUsableSize(*resized));
+    check(resized, 100);
+    ASSERT_EQ(1, alloc.getGlobalCacheStats().numInPlaceResizes);
+
+    // shrinking within the allocation class happens in place as well
+    std::tie(res, resized) = alloc.resize(handle, 100);
+    ASSERT_EQ(ResizeRes::kSuccess, res);
+    ASSERT_EQ(handle, resized);
+    ASSERT_EQ(100, alloc.find("key")->getSize());
+    ASSERT_EQ(2, alloc.getGlobalCacheStats().numInPlaceResizes);
+
+    // growing beyond the allocation class copies and replaces the item
+    auto child = alloc.allocateChainedItem(handle, 50);
+    alloc.addChainedItem(handle, std::move(child));
+    std::tie(res, resized) = alloc.resize(handle, 10000);
+    ASSERT_EQ(ResizeRes::kSuccess, res);
+    ASSERT_NE(handle, resized);
+    ASSERT_EQ(10000, resized->getSize());
+    check(resized, 100);
+    ASSERT_FALSE(handle->isAccessible());
+    ASSERT_FALSE(handle->hasChainedItem());
+    ASSERT_TRUE(resized->hasChainedItem());
+    ASSERT_EQ(resized, alloc.find("key"));
+    ASSERT_EQ(1, alloc.getGlobalCacheStats().numCopyResizes);
+
+    // the old item can not be resized anymore once it is replaced
+    auto [lost, lostHandle] = alloc.resize(handle, 20000);
+    ASSERT_EQ(ResizeRes::kNotAccessible, lost);
+    ASSERT_EQ(nullptr, lostHandle);
+    ASSERT_EQ(resized, alloc.find("key"));
+    ASSERT_TRUE(resized->hasChainedItem());
+    ASSERT_EQ(1, alloc.getGlobalCacheStats().numCopyResizes);
+
+    // losing the race against a remove leaves the chain with the old item
+    auto removed = util::allocateAccessible(alloc, poolId, "removed", 100);
+    alloc.addChainedItem(removed, alloc.allocateChainedItem(removed, 50));
+    ASSERT_EQ(AllocatorT::RemoveRes::kSuccess, alloc.remove("removed"));
+    std::tie(lost, lostHandle) = alloc.resize(removed, 10000);
+    ASSERT_EQ(ResizeRes::kNotAccessible, lost);
+    ASSERT_EQ(nullptr, lostHandle);
+    ASSERT_TRUE(removed->hasChainedItem());
+
+    // items that are not inserted yet are left to the caller to insert
+    auto nascent = alloc.allocate(poolId, "nascent", 100);
+    fill(nascent, 100);
+    auto [nascentRes, bigger] = alloc.resize(nascent, 10000);
+    ASSERT_EQ(ResizeRes::kSuccess, nascentRes);
+    ASSERT_NE(nascent, bigger);
+    ASSERT_FALSE(bigger->isAccessible());
+    check(bigger, 100);
+    ASSERT_EQ(nullptr, alloc.find("nascent"));
+    alloc.insert(bigger);
+    ASSERT_EQ(bigger, alloc.find("nascent"));
+
+    auto chainedItem = alloc.allocateChainedItem(bigger, 50);
+    ASSERT_THROW(alloc.resize(chainedItem, 60), std::invalid_argument);
+  }
+
   void testChainedItemIterator() {
     typename AllocatorT::Config config;
     using Iterator =
@@ -6296,6 +6616,92 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
         });
     EXPECT_EQ(intervalNameExists, 4);
   }
+
+  void testItemLifetimeStats() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(10 * Slab::kSize);
+    config.enableItemLifetimeStats(1 /* sampleRate */);
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().ramCacheSize;
+    const auto poolId = alloc.addPool("default", numBytes);
+    const unsigned int keyLen = 100;
+
+    auto getLifetimeStat = [&alloc, poolId]() {
+      ItemLifetimeStat stat;
+      for (const auto& kv : alloc.getPoolStats(poolId).cacheStats) {
+        stat += kv.second.lifetimeStat;
+      }
+      return stat;
+    };
+
+    // an item read twice and then removed
+    {
+      auto handle = util::allocateAccessible(alloc, poolId, "removed", 1000);
+      ASSERT_NE(nullptr, handle);
+      ASSERT_NE(nullptr, alloc.find("removed"));
+      ASSERT_NE(nullptr, alloc.find("removed"));
+      ASSERT_EQ(2, handle->getHitCount());
+    }
+    ASSERT_EQ(AllocatorT::RemoveRes::kSuccess, alloc.remove("removed"));
+
+    // an item replaced without being read
+    {
+      auto handle = util::allocateAccessible(alloc, poolId, "replaced", 1000);
+      ASSERT_NE(nullptr, handle);
+      auto newHandle = alloc.allocate(poolId, "replaced", 1000);
+      ASSERT_NE(nullptr, newHandle);
+      ASSERT_NE(nullptr, alloc.insertOrReplace(newHandle));
+    }
+
+    const auto kRemoved = static_cast<size_t>(ItemRemovalReason::kRemoved);
+    auto stat = getLifetimeStat();
+    EXPECT_EQ(1, stat.numItems(ItemRemovalReason::kRemoved));
+    EXPECT_EQ(1, stat.hits[kRemoved][2]);
+    EXPECT_EQ(0, stat.noHitRatio(ItemRemovalReason::kRemoved));
+    EXPECT_EQ(1, stat.numItems(ItemRemovalReason::kReplaced));
+    EXPECT_EQ(1, stat.noHitRatio(ItemRemovalReason::kReplaced));
+    // it stayed for about a second at most
+    EXPECT_EQ(1,
+              stat.lifetimeSecs[kRemoved][0] + stat.lifetimeSecs[kRemoved][1]);
+    EXPECT_EQ(0, stat.numItems(ItemRemovalReason::kEvicted));
+
+    // evictions are recorded with their nvm admission outcome
+    const auto sizes = this->getValidAllocSizes(alloc, poolId, 5, keyLen);
+    this->fillUpPoolUntilEvictions(alloc, poolId, sizes, keyLen);
+    for (unsigned int i = 0; i < 100; i++) {
+      util::allocateAccessible(alloc, poolId,
+                               this->getRandomNewKey(alloc, keyLen), sizes[0]);
+    }
+
+    stat = getLifetimeStat();
+    const auto numEvicted = stat.numItems(ItemRemovalReason::kEvicted);
+    EXPECT_EQ(alloc.getPoolStats(poolId).numEvictions(), numEvicted);
+    EXPECT_LT(0, numEvicted);
+    EXPECT_EQ(numEvicted,
+              stat.nvmAdmission[static_cast<size_t>(
+                  NvmAdmissionOutcome::kNoNvm)]);
+    EXPECT_EQ(1, stat.numItems(ItemRemovalReason::kRemoved));
+
+    // nothing is collected unless enabled
+    typename AllocatorT::Config disabledConfig;
+    disabledConfig.setCacheSize(10 * Slab::kSize);
+    AllocatorT disabled(disabledConfig);
+    const auto pid = disabled.addPool(
+        "default", disabled.getCacheMemoryStats().ramCacheSize);
+    {
+      auto handle = util::allocateAccessible(disabled, pid, "key", 1000);
+      ASSERT_NE(nullptr, disabled.find("key"));
+      ASSERT_EQ(0, handle->getHitCount());
+    }
+    ASSERT_EQ(AllocatorT::RemoveRes::kSuccess, disabled.remove("key"));
+    for (const auto& kv : disabled.getPoolStats(pid).cacheStats) {
+      EXPECT_EQ(0,
+                kv.second.lifetimeStat.numItems(ItemRemovalReason::kRemoved));
+    }
+
+    EXPECT_THROW(disabledConfig.enableItemLifetimeStats(0),
+                 std::invalid_argument);
+  }
 };
 } // namespace tests
 } // namespace cachelib
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "cachelib/allocator/GhostList.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+TEST(GhostListTest, Size) {
+  GhostList list{100};
+  // 7 buckets rounded up to 8
+  EXPECT_EQ(8 * GhostList::kSlotsPerBucket, list.capacity());
+  EXPECT_EQ(8 * 64, list.getByteSize());
+
+  GhostList small{1};
+  EXPECT_EQ(GhostList::kSlotsPerBucket, small.capacity());
+
+  EXPECT_THROW(GhostList{0}, std::invalid_argument);
+}
+
+TEST(GhostListTest, InsertAndRemove) {
+  GhostList list{1000};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  for (int i = 0; i < 100; i++) {
+    keys.push_back(rg());
+    list.insert(keys.back());
+  }
+
+  for (auto key : keys) {
+    EXPECT_TRUE(list.remove(key));
+    // counted once per eviction
+    EXPECT_FALSE(list.remove(key));
+  }
+  EXPECT_EQ(keys.size(), list.getHits());
+
+  uint64_t falsePositives = 0;
+  for (int i = 0; i < 10000; i++) {
+    falsePositives += list.remove(rg());
+  }
+  EXPECT_EQ(0, falsePositives);
+  EXPECT_EQ(keys.size(), list.getHits());
+}
+
+TEST(GhostListTest, Fifo) {
+  // a single bucket keeps the last kSlotsPerBucket keys
+  GhostList list{1};
+  const uint64_t n = 2 * GhostList::kSlotsPerBucket;
+  for (uint64_t i = 1; i <= n; i++) {
+    list.insert(i << 33);
+  }
+  for (uint64_t i = 1; i <= n; i++) {
+    EXPECT_EQ(i > n - GhostList::kSlotsPerBucket, list.remove(i << 33)) << i;
+  }
+}
+
+TEST(GhostListTest, Capacity) {
+  // across buckets the list approximately remembers the last capacity() keys
+  GhostList list{4096};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  for (size_t i = 0; i < 4 * list.capacity(); i++) {
+    keys.push_back(rg());
+    list.insert(keys.back());
+  }
+
+  uint64_t recent = 0;
+  uint64_t old = 0;
+  const size_t n = list.capacity() / 2;
+  for (size_t i = 0; i < n; i++) {
+    recent += list.remove(keys[keys.size() - 1 - i]);
+    old += list.remove(keys[i]);
+  }
+  EXPECT_GT(recent, n * 9 / 10);
+  EXPECT_EQ(0, old);
+}
+
+TEST(GhostListTest, Concurrent) {
+  GhostList list{1 << 16};
+  const int kThreads = 4;
+  const uint64_t kKeysPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&list, t] {
+      std::mt19937_64 rg{static_cast<uint64_t>(t)};
+      for (uint64_t i = 0; i < kKeysPerThread; i++) {
+        list.insert(rg());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  threads.clear();
+
+  std::atomic<uint64_t> found{0};
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&list, &found, t] {
+      std::mt19937_64 rg{static_cast<uint64_t>(t)};
+      for (uint64_t i = 0; i < kKeysPerThread; i++) {
+        found += list.remove(rg());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(found.load(), list.getHits());
+  // a few keys may have lost their slot to a racing insert
+  EXPECT_GT(found.load(), kThreads * kKeysPerThread * 9 / 10);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
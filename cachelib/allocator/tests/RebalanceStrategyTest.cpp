@@ -619,6 +619,102 @@ TEST_F(RebalanceStrategy2QTest, MarginalHitsSlabRebalance) {
   }
 }
 
+TEST_F(RebalanceStrategy2QTest, MarginalHitsGhostHitsRebalance) {
+  using MMConfig = Lru2QAllocator::MMConfig;
+  const auto smallItemSize = Slab::kSize / 3;
+  const auto largeItemSize = Slab::kSize * 2 / 3;
+  const auto smallAllocSize = Slab::kSize / 2;
+  const auto largeAllocSize = Slab::kSize;
+  Lru2QAllocator::Config config;
+  MarginalHitsStrategy::Config strategyConfig{};
+  strategyConfig.useGhostHits = true;
+  auto strategy = std::make_shared<MarginalHitsStrategy>(strategyConfig);
+
+  config.setCacheSize(20 * Slab::kSize);
+  config.enableTailHitsTracking();
+  config.enableGhostLists();
+  auto cache = std::make_unique<Lru2QAllocator>(config);
+  MMConfig mmConfig;
+  const std::set<uint32_t> allocSizes{static_cast<uint32_t>(smallAllocSize),
+                                      static_cast<uint32_t>(largeAllocSize)};
+  mmConfig.hotSizePercent = 0;
+  mmConfig.coldSizePercent = 100;
+  mmConfig.lruRefreshTime = 0;
+
+  auto pid = cache->addPool("Pool", cache->getCacheMemoryStats().ramCacheSize,
+                            allocSizes, mmConfig);
+  ASSERT_NE(Slab::kInvalidPoolId, pid);
+  ClassId cid0{Slab::kInvalidClassId}, cid1{Slab::kInvalidClassId};
+  for (auto&& it : cache->getPoolStats(pid).cacheStats) {
+    if (it.second.allocSize == smallAllocSize) {
+      cid0 = it.first;
+    }
+    if (it.second.allocSize == largeAllocSize) {
+      cid1 = it.first;
+    }
+  }
+  ASSERT_NE(Slab::kInvalidClassId, cid0);
+  ASSERT_NE(Slab::kInvalidClassId, cid1);
+
+  auto getClassStat = [&](ClassId cid) {
+    return cache->getPoolStats(pid).cacheStats.at(cid);
+  };
+
+  // populate until both classes evict
+  uint32_t num;
+  for (num = 0; !getClassStat(cid0).numEvictions() ||
+                !getClassStat(cid1).numEvictions();
+       num++) {
+    auto handle = util::allocateAccessible(
+        *cache, pid, "large-" + std::to_string(num), largeItemSize);
+    ASSERT_NE(nullptr, handle);
+    handle = util::allocateAccessible(
+        *cache, pid, "small-" + std::to_string(num), smallItemSize);
+    ASSERT_NE(nullptr, handle);
+  }
+  EXPECT_EQ(0, getClassStat(cid0).ghostHits);
+  EXPECT_EQ(0, getClassStat(cid1).ghostHits);
+
+  // initialize states
+  {
+    auto init = strategy->pickVictimAndReceiver(*cache, pid);
+    EXPECT_EQ(init.victimClassId, Slab::kInvalidClassId);
+    EXPECT_EQ(init.receiverClassId, Slab::kInvalidClassId);
+  }
+
+  // allocate the evicted keys of a class again, which hits its ghost list,
+  // and read the ones it still has, which hits its tail
+  auto reuseKeys = [&](const std::string& prefix, uint32_t itemSize) {
+    for (uint32_t i = 0; i < num; i++) {
+      const auto key = prefix + std::to_string(i);
+      if (cache->peek(key) == nullptr) {
+        EXPECT_NE(nullptr,
+                  util::allocateAccessible(*cache, pid, key, itemSize));
+      }
+    }
+    for (uint32_t i = 0; i < num; i++) {
+      cache->find(prefix + std::to_string(i));
+    }
+  };
+
+  reuseKeys("small-", smallItemSize);
+  EXPECT_GT(getClassStat(cid0).ghostHits, 0);
+  EXPECT_EQ(0, getClassStat(cid1).ghostHits);
+  {
+    auto ctx = strategy->pickVictimAndReceiver(*cache, pid);
+    EXPECT_EQ(cid0, ctx.receiverClassId);
+    EXPECT_EQ(cid1, ctx.victimClassId);
+  }
+
+  reuseKeys("large-", largeItemSize);
+  EXPECT_GT(getClassStat(cid1).ghostHits, 0);
+  {
+    auto ctx = strategy->pickVictimAndReceiver(*cache, pid);
+    EXPECT_EQ(cid1, ctx.receiverClassId);
+    EXPECT_EQ(cid0, ctx.victimClassId);
+  }
+}
+
 using RebalanceStrategyMaxAgeEvictionTest = RebalanceStrategyTest<LruAllocator>;
 
 TEST_F(RebalanceStrategyMaxAgeEvictionTest, HitsSlabRebalanceMaxAge) {
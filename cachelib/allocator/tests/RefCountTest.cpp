@@ -31,6 +31,7 @@ class RefCountTest : public AllocTestBase {
   static void testMultiThreaded();
   static void testBasic();
   static void testMarkForEvictionAndMoving();
+  static void testHitCount();
 };
 
 void RefCountTest::testMultiThreaded() {
@@ -228,6 +229,27 @@ void RefCountTest::testMarkForEvictionAndMoving() {
     ASSERT_FALSE(ref.markForEviction());
   }
 }
+
+void RefCountTest::testHitCount() {
+  RefcountWithFlags ref;
+  ref.markInMMContainer();
+  ref.incRef();
+  ref.markNvmClean();
+  ASSERT_EQ(0, ref.getHitCount());
+
+  for (uint8_t i = 1; i <= RefcountWithFlags::kMaxHitCount; i++) {
+    ref.incHitCount();
+    ASSERT_EQ(i, ref.getHitCount());
+  }
+
+  // saturates without touching the neighbouring bits
+  ref.incHitCount();
+  ASSERT_EQ(RefcountWithFlags::kMaxHitCount, ref.getHitCount());
+  ASSERT_TRUE(ref.isNvmClean());
+  ASSERT_FALSE(ref.isNvmEvicted());
+  ASSERT_TRUE(ref.isInMMContainer());
+  ASSERT_EQ(1, ref.getAccessRef());
+}
 } // namespace
 
 TEST_F(RefCountTest, MutliThreaded) { testMultiThreaded(); }
@@ -235,6 +257,7 @@ TEST_F(RefCountTest, Basic) { testBasic(); }
 TEST_F(RefCountTest, MarkForEvictionAndMoving) {
   testMarkForEvictionAndMoving();
 }
+TEST_F(RefCountTest, HitCount) { testHitCount(); }
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
@@ -645,13 +645,19 @@ Cache<Allocator>::Cache(const CacheConfig& config,
     }
     nvmConfig.navyConfig.setBlockSize(config_.navyBlockSize);
     nvmConfig.navyConfig.setEnableFDP(config_.deviceEnableFDP);
+    if (config_.navyMetadataHugePages) {
+      nvmConfig.navyConfig.setMetadataHugePages(
+          util::HugePagePolicy::kTransparent);
+    }
 
     // configure BlockCache
     auto& bcConfig = nvmConfig.navyConfig.blockCache()
                          .setDataChecksum(config_.navyDataChecksum)
                          .setCleanRegions(config_.navyCleanRegions,
                                           config_.navyCleanRegionThreads)
-                         .setRegionSize(config_.navyRegionSizeMB * MB);
+                         .setRegionSize(config_.navyRegionSizeMB * MB)
+                         .setDiscardRate(config_.navyDiscardRateMB * MB)
+                         .setSizeBands(config_.navySizeBands);
 
     // by default lru. if more than one fifo ratio is present, we use
     // segmented fifo. otherwise, simple fifo.
@@ -678,7 +684,8 @@ Cache<Allocator>::Cache(const CacheConfig& config,
           .setSizePctAndMaxItemSize(config_.navyBigHashSizePct,
                                     config_.navySmallItemMaxSize)
           .setBucketSize(config_.navyBigHashBucketSize)
-          .setBucketBfSize(config_.navyBloomFilterPerBucketSize);
+          .setBucketBfSize(config_.navyBloomFilterPerBucketSize)
+          .setDirectorySize(config_.navyBigHashDirectorySize);
     }
 
     nvmConfig.navyConfig.setMaxParcelMemoryMB(config_.navyParcelMemoryMB);
@@ -708,6 +715,15 @@ Cache<Allocator>::Cache(const CacheConfig& config,
 
     nvmConfig.navyConfig.setDeviceMaxWriteSize(config_.deviceMaxWriteSize);
 
+    nvmConfig.navyConfig.setRequestTracing(
+        util::narrow_cast<uint32_t>(config_.navyRequestTraceSampleRate),
+        config_.navyRequestTraceSlowThresholdUs);
+
+    if (config_.navyDeviceEmulation) {
+      nvmConfig.navyConfig.enableDeviceEmulation() =
+          *config_.navyDeviceEmulation;
+    }
+
     XLOG(INFO) << "Using the following nvm config"
                << folly::toPrettyJson(
                       folly::toDynamic(nvmConfig.navyConfig.serialize()));
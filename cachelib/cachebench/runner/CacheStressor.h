@@ -122,6 +122,9 @@ class CacheStressor : public Stressor {
     if (config_.checkConsistency) {
       cache_->enableConsistencyCheck(wg_->getAllKeys());
     }
+    if (config_.perfCounters) {
+      stressorPerfCounters_.resize(config_.numThreads);
+    }
     if (config_.opRatePerSec > 0) {
       // opRateBurstSize is default to opRatePerSec if not specified
       rateLimiter_ = std::make_unique<folly::BasicTokenBucket<>>(
@@ -144,14 +147,27 @@ class CacheStressor : public Stressor {
                                 config_.numThreads * config_.numOps / 1e6)
               << std::endl;
 
+    if (config_.perfCounters) {
+      // every thread that exists at this point other than us belongs to the
+      // cache (background workers, navy schedulers) or to the ticker.
+      auto counters = ThreadPerfCounters::forOtherThreads("cb_stressor_");
+      std::lock_guard<std::mutex> l(perfMutex_);
+      backgroundPerfCounters_ = std::move(counters);
+    }
+
     stressWorker_ = std::thread([this] {
       std::vector<std::thread> workers;
 
       for (uint64_t i = 0; i < config_.numThreads; ++i) {
         workers.push_back(
-            std::thread([this, throughputStats = &throughputStats_.at(i),
+            std::thread([this, i, throughputStats = &throughputStats_.at(i),
                          threadName = folly::sformat("cb_stressor_{}", i)]() {
               folly::setThreadName(threadName);
+              if (config_.perfCounters) {
+                auto counters = std::make_unique<ThreadPerfCounters>();
+                std::lock_guard<std::mutex> l(perfMutex_);
+                stressorPerfCounters_[i] = std::move(counters);
+              }
               stressByDiscreteDistribution(*throughputStats);
             }));
       }
@@ -205,6 +221,22 @@ class CacheStressor : public Stressor {
     return res;
   }
 
+  // obtain the perf counters summed over the stressor threads and the
+  // background threads. Counters of finished threads keep their final value.
+  PerfStats getPerfStats() const override {
+    PerfStats res{};
+    std::lock_guard<std::mutex> l(perfMutex_);
+    for (const auto& counters : stressorPerfCounters_) {
+      if (counters) {
+        res.stressor += counters->read();
+      }
+    }
+    for (const auto& counters : backgroundPerfCounters_) {
+      res.background += counters->read();
+    }
+    return res;
+  }
+
   void renderWorkloadGeneratorStats(uint64_t elapsedTimeNs,
                                     std::ostream& out) const override {
     wg_->renderStats(elapsedTimeNs, out);
@@ -215,6 +247,12 @@ class CacheStressor : public Stressor {
     wg_->renderStats(elapsedTimeNs, counters);
   }
 
+  size_t getCurrentPhase() const override { return wg_->getCurrentPhase(); }
+
+  std::string getPhaseName(size_t phase) const override {
+    return wg_->getPhaseName(phase);
+  }
+
   uint64_t getTestDurationNs() const override {
     std::lock_guard<std::mutex> l(timeMutex_);
     return std::chrono::nanoseconds{
@@ -555,6 +593,13 @@ class CacheStressor : public Stressor {
 
   std::vector<ThroughputStats> throughputStats_; // thread local stats
 
+  // perf counters per stressor thread, opened by the thread itself when it
+  // starts, and for the threads that existed when the stress run started.
+  // Only used when config_.perfCounters is set.
+  std::vector<std::unique_ptr<ThreadPerfCounters>> stressorPerfCounters_;
+  std::vector<std::unique_ptr<ThreadPerfCounters>> backgroundPerfCounters_;
+  mutable std::mutex perfMutex_;
+
   std::unique_ptr<GeneratorBase> wg_; // workload generator
 
   // locks when using chained item and moving.
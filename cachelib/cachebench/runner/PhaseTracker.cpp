@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/runner/PhaseTracker.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+PhaseTracker::PhaseTracker(const Stressor& s)
+    : stressor_(s), prevStats_(s.getCacheStats()) {}
+
+PhaseTracker::~PhaseTracker() {
+  try {
+    stop();
+  } catch (const std::exception&) {
+  }
+}
+
+void PhaseTracker::work() {
+  std::lock_guard<std::mutex> l(lock_);
+  const auto phase = stressor_.getCurrentPhase();
+  if (phase != currentPhase_) {
+    closePhase();
+    currentPhase_ = phase;
+  }
+}
+
+void PhaseTracker::closePhase() {
+  const auto nowNs = stressor_.getTestDurationNs();
+  auto throughput = stressor_.aggregateThroughputStats();
+  const auto currStats = stressor_.getCacheStats();
+
+  PhaseStats stats;
+  stats.phase = currentPhase_;
+  stats.name = stressor_.getPhaseName(currentPhase_);
+  stats.durationNs = nowNs - phaseStartNs_;
+  stats.throughput = throughput;
+  stats.throughput -= prevThroughput_;
+  std::tie(stats.overallHitRatio, stats.ramHitRatio, stats.nvmHitRatio) =
+      currStats.getHitRatios(prevStats_);
+  phases_.push_back(std::move(stats));
+
+  phaseStartNs_ = nowNs;
+  prevThroughput_ = throughput;
+  prevStats_ = currStats;
+}
+
+void PhaseTracker::render(std::ostream& out) {
+  std::lock_guard<std::mutex> l(lock_);
+  closePhase();
+
+  out << "== Phase Stats ==" << std::endl;
+  for (const auto& p : phases_) {
+    if (p.throughput.ops == 0) {
+      continue;
+    }
+    out << folly::sformat(
+               "Phase {} ({}) for {:.2f}s: Hit Ratio {:6.2f}% (RAM {:6.2f}%, "
+               "NVM {:6.2f}%)",
+               p.phase, p.name, p.durationNs / 1e9, p.overallHitRatio,
+               p.ramHitRatio, p.nvmHitRatio)
+        << std::endl;
+    p.throughput.render(p.durationNs, out);
+  }
+}
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
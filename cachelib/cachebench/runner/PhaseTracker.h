@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cachelib/cachebench/runner/Stressor.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+// independent worker that runs along side the stressor and splits the
+// throughput and cache stats of the run at workload phase boundaries, so that
+// each phase can be reported on its own.
+class PhaseTracker final : public cachelib::PeriodicWorker {
+ public:
+  // @param s   the stressor that is being tracked
+  explicit PhaseTracker(const Stressor& s);
+  ~PhaseTracker() override;
+
+  // close the phase that is currently running and print the stats of every
+  // phase seen so far.
+  void render(std::ostream& out);
+
+ private:
+  // stats of one run of a phase
+  struct PhaseStats {
+    size_t phase{0};
+    std::string name;
+    uint64_t durationNs{0};
+    ThroughputStats throughput;
+    double overallHitRatio{0};
+    double ramHitRatio{0};
+    double nvmHitRatio{0};
+  };
+
+  void work() override;
+
+  // snapshot the stats and account them to the current phase.
+  void closePhase();
+
+  const Stressor& stressor_; // stressor instance
+
+  std::mutex lock_;
+  size_t currentPhase_{0};
+  uint64_t phaseStartNs_{0};
+  ThroughputStats prevThroughput_;
+  Stats prevStats_;
+  std::vector<PhaseStats> phases_;
+};
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
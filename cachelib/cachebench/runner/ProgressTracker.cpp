@@ -59,12 +59,33 @@ void ProgressTracker::work() {
       ramHitRatio,
       nvmHitRatio);
 
+  // perf counters are normalized by the ops completed in this interval.
+  const auto currPerfStats = stressor_.getPerfStats();
+  std::string perfStr;
+  if (currPerfStats.enabled()) {
+    auto intervalPerfStats = currPerfStats;
+    intervalPerfStats -= prevPerfStats_;
+    const auto intervalOps = throughputStats.ops - prevOps_;
+    perfStr = folly::sformat(
+        "{} stressor   {}\n{} background {}",
+        buf,
+        intervalPerfStats.stressor.toString(intervalOps),
+        buf,
+        intervalPerfStats.background.toString(intervalOps));
+  }
+
   // log this always to stdout
   std::cout << thStr << std::endl;
+  if (!perfStr.empty()) {
+    std::cout << perfStr << std::endl;
+  }
 
   // additionally log into the stats file
   if (statsFile_.is_open()) {
     statsFile_ << thStr << std::endl;
+    if (!perfStr.empty()) {
+      statsFile_ << perfStr << std::endl;
+    }
     statsFile_ << "== Allocator Stats ==" << std::endl;
     currCacheStats.render(statsFile_);
 
@@ -80,6 +101,8 @@ void ProgressTracker::work() {
   }
 
   prevStats_ = currCacheStats;
+  prevPerfStats_ = currPerfStats;
+  prevOps_ = throughputStats.ops;
 }
 } // namespace cachebench
 } // namespace cachelib
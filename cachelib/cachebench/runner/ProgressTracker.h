@@ -41,6 +41,8 @@ class ProgressTracker final : public cachelib::PeriodicWorker {
   const Stressor& stressor_; // stressor instance
   std::ofstream statsFile_;  // optional output file stream
   Stats prevStats_; // previous snapshot of cache stats to perform deltas.
+  PerfStats prevPerfStats_; // previous snapshot of perf counters.
+  uint64_t prevOps_{0};     // ops completed at the previous snapshot.
 };
 } // namespace cachebench
 } // namespace cachelib
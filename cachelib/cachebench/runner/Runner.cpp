@@ -23,23 +23,33 @@ namespace cachelib {
 namespace cachebench {
 Runner::Runner(const CacheBenchConfig& config)
     : stressor_{Stressor::makeStressor(config.getCacheConfig(),
-                                       config.getStressorConfig())} {}
+                                       config.getStressorConfig())},
+      usesPhases_{config.getStressorConfig().usesPhases()} {}
 
 bool Runner::run(std::chrono::seconds progressInterval,
                  const std::string& progressStatsFile) {
   ProgressTracker tracker{*stressor_, progressStatsFile};
+  std::unique_ptr<PhaseTracker> phaseTracker;
+  if (usesPhases_) {
+    phaseTracker = std::make_unique<PhaseTracker>(*stressor_);
+  }
 
   stressor_->start();
 
   if (!tracker.start(progressInterval)) {
     throw std::runtime_error("Cannot start ProgressTracker.");
   }
+  if (phaseTracker &&
+      !phaseTracker->start(std::chrono::milliseconds{kPhaseCheckIntervalMs})) {
+    throw std::runtime_error("Cannot start PhaseTracker.");
+  }
 
   stressor_->finish();
 
   uint64_t durationNs = stressor_->getTestDurationNs();
   auto cacheStats = stressor_->getCacheStats();
   auto opsStats = stressor_->aggregateThroughputStats();
+  auto perfStats = stressor_->getPerfStats();
   tracker.stop();
 
   std::cout << "== Test Results ==\n== Allocator Stats ==" << std::endl;
@@ -51,6 +61,18 @@ bool Runner::run(std::chrono::seconds progressInterval,
   stressor_->renderWorkloadGeneratorStats(durationNs, std::cout);
   std::cout << std::endl;
 
+  if (perfStats.enabled()) {
+    std::cout << "== Hardware Counters per Op ==\n";
+    perfStats.render(opsStats.ops, std::cout);
+    std::cout << std::endl;
+  }
+
+  if (phaseTracker) {
+    phaseTracker->stop();
+    phaseTracker->render(std::cout);
+    std::cout << std::endl;
+  }
+
   stressor_.reset();
 
   bool passed = cacheStats.renderIsTestPassed(std::cout);
@@ -78,6 +100,11 @@ bool Runner::run(folly::UserCounters& counters) {
 
     stressor_->renderWorkloadGeneratorStats(durationNs, counters);
 
+    auto perfStats = stressor_->getPerfStats();
+    if (perfStats.enabled()) {
+      perfStats.render(opsStats.ops, counters);
+    }
+
     counters["nvm_disable"] = cacheStats.isNvmCacheDisabled ? 100 : 0;
     counters["inconsistency_count"] = cacheStats.inconsistencyCount * 100;
 
@@ -20,6 +20,7 @@
 
 #include <string>
 
+#include "cachelib/cachebench/runner/PhaseTracker.h"
 #include "cachelib/cachebench/runner/ProgressTracker.h"
 #include "cachelib/cachebench/runner/Stressor.h"
 #include "cachelib/cachebench/util/Config.h"
@@ -62,7 +63,13 @@ class Runner {
   // instance of the stressor.
   std::unique_ptr<Stressor> stressor_;
 
+  // whether the workload runs a schedule of phases to be reported separately.
+  const bool usesPhases_{false};
+
   bool aborted_{false};
+
+  // how often the phase tracker checks for phase transitions.
+  static constexpr uint64_t kPhaseCheckIntervalMs{10};
 };
 } // namespace cachebench
 } // namespace cachelib
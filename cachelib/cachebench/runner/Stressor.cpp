@@ -24,7 +24,9 @@
 #include "cachelib/cachebench/workload/BlockChunkReplayGenerator.h"
 #include "cachelib/cachebench/workload/KVReplayGenerator.h"
 #include "cachelib/cachebench/workload/OnlineGenerator.h"
+#include "cachelib/cachebench/workload/PhasedGenerator.h"
 #include "cachelib/cachebench/workload/PieceWiseReplayGenerator.h"
+#include "cachelib/cachebench/workload/ProceduralGenerator.h"
 #include "cachelib/cachebench/workload/WorkloadGenerator.h"
 #include "cachelib/common/Utils.h"
 
@@ -49,6 +51,24 @@ ThroughputStats& ThroughputStats::operator+=(const ThroughputStats& other) {
   return *this;
 }
 
+ThroughputStats& ThroughputStats::operator-=(const ThroughputStats& other) {
+  set -= other.set;
+  setFailure -= other.setFailure;
+  get -= other.get;
+  getMiss -= other.getMiss;
+  del -= other.del;
+  update -= other.update;
+  updateMiss -= other.updateMiss;
+  delNotFound -= other.delNotFound;
+  addChained -= other.addChained;
+  addChainedFailure -= other.addChainedFailure;
+  couldExistOp -= other.couldExistOp;
+  couldExistOpFalse -= other.couldExistOpFalse;
+  ops -= other.ops;
+
+  return *this;
+}
+
 void ThroughputStats::render(uint64_t elapsedTimeNs, std::ostream& out) const {
   const double elapsedSecs = elapsedTimeNs / static_cast<double>(1e9);
 
@@ -139,7 +159,14 @@ void ThroughputStats::render(uint64_t elapsedTimeNs,
 
 namespace {
 std::unique_ptr<GeneratorBase> makeGenerator(const StressorConfig& config) {
-  if (config.generator == "piecewise-replay") {
+  if (config.usesPhases()) {
+    if (config.generator != "procedural") {
+      throw std::invalid_argument(fmt::format(
+          "Invalid config: phases require the procedural generator, got {}",
+          config.generator));
+    }
+    return std::make_unique<PhasedGenerator>(config);
+  } else if (config.generator == "piecewise-replay") {
     return std::make_unique<PieceWiseReplayGenerator>(config);
   } else if (config.generator == "replay") {
     return std::make_unique<KVReplayGenerator>(config);
@@ -151,7 +178,8 @@ std::unique_ptr<GeneratorBase> makeGenerator(const StressorConfig& config) {
     return std::make_unique<WorkloadGenerator>(config);
   } else if (config.generator == "online") {
     return std::make_unique<OnlineGenerator>(config);
-
+  } else if (config.generator == "procedural") {
+    return std::make_unique<ProceduralGenerator>(config);
   } else {
     throw std::invalid_argument(fmt::format(
         "Invalid config: unsupported generator {}", config.generator));
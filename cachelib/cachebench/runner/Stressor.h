@@ -17,12 +17,15 @@
 #pragma once
 
 #include <folly/Benchmark.h>
+#include <folly/Conv.h>
 
 #include <atomic>
 #include <memory>
+#include <string>
 
 #include "cachelib/cachebench/cache/Cache.h"
 #include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/util/PerfCounters.h"
 
 namespace facebook {
 namespace cachelib {
@@ -50,6 +53,9 @@ struct ThroughputStats {
   // from each  thread
   ThroughputStats& operator+=(const ThroughputStats& other);
 
+  // subtract an earlier snapshot to get the stats for an interval.
+  ThroughputStats& operator-=(const ThroughputStats& other);
+
   // convenience method to print the final throughput and hit ratio to stdout.
   void render(uint64_t elapsedTimeNs, std::ostream& out) const;
 
@@ -77,6 +83,10 @@ class Stressor {
   // aggregate the throughput related stats at any given point in time.
   virtual ThroughputStats aggregateThroughputStats() const = 0;
 
+  // aggregate the perf counters of the stressor and background threads at
+  // any given point in time. Empty unless StressorConfig::perfCounters is set.
+  virtual PerfStats getPerfStats() const { return {}; }
+
   // ouputs workload generator specific stats to either an output stream or to
   // an output counter map
   virtual void renderWorkloadGeneratorStats(uint64_t /*elapsedTimeNs*/,
@@ -84,6 +94,12 @@ class Stressor {
   virtual void renderWorkloadGeneratorStats(
       uint64_t /*elapsedTimeNs*/, folly::UserCounters& /*counters*/) const {}
 
+  // index and name of the workload phase that is currently running.
+  virtual size_t getCurrentPhase() const { return 0; }
+  virtual std::string getPhaseName(size_t phase) const {
+    return folly::to<std::string>("phase-", phase);
+  }
+
   // get the duration the test has run so far. If the test is finished, this
   // is not expected to change.
   virtual uint64_t getTestDurationNs() const = 0;
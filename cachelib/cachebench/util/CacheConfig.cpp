@@ -68,6 +68,9 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, navyBigHashSizePct);
   JSONSetVal(configJson, navyBigHashBucketSize);
   JSONSetVal(configJson, navyBloomFilterPerBucketSize);
+  JSONSetVal(configJson, navyBigHashDirectorySize);
+  JSONSetVal(configJson, navyDiscardRateMB);
+  JSONSetVal(configJson, navySizeBands);
   JSONSetVal(configJson, navySmallItemMaxSize);
   JSONSetVal(configJson, navyParcelMemoryMB);
   JSONSetVal(configJson, navyHitsReinsertionThreshold);
@@ -89,6 +92,7 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, navyEncryption);
   JSONSetVal(configJson, deviceMaxWriteSize);
   JSONSetVal(configJson, deviceEnableFDP);
+  JSONSetVal(configJson, navyMetadataHugePages);
 
   JSONSetVal(configJson, memoryOnlyTTL);
 
@@ -101,6 +105,15 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
     }
   }
 
+  if (configJson.count("navyDeviceEmulation")) {
+    navyDeviceEmulation =
+        NavyDeviceEmulationConfig(configJson["navyDeviceEmulation"])
+            .getDeviceEmulationConfig();
+  }
+
+  JSONSetVal(configJson, navyRequestTraceSampleRate);
+  JSONSetVal(configJson, navyRequestTraceSlowThresholdUs);
+
   JSONSetVal(configJson, useTraceTimeStamp);
   JSONSetVal(configJson, printNvmCounters);
   JSONSetVal(configJson, tickerSynchingSeconds);
@@ -112,7 +125,7 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   // if you added new fields to the configuration, update the JSONSetVal
   // to make them available for the json configs and increment the size
   // below
-  checkCorrectSize<CacheConfig, 760>();
+  checkCorrectSize<CacheConfig, 888>();
 
   if (numPools != poolSizes.size()) {
     throw std::invalid_argument(folly::sformat(
@@ -148,6 +161,39 @@ MemoryTierConfig::MemoryTierConfig(const folly::dynamic& configJson) {
 
   checkCorrectSize<MemoryTierConfig, 40>();
 }
+
+NavyDeviceEmulationConfig::NavyDeviceEmulationConfig(
+    const folly::dynamic& configJson) {
+  JSONSetVal(configJson, readLatencyUs);
+  JSONSetVal(configJson, writeLatencyUs);
+  JSONSetVal(configJson, latencySigma);
+  JSONSetVal(configJson, readBandwidthMBps);
+  JSONSetVal(configJson, writeBandwidthMBps);
+  JSONSetVal(configJson, numQueues);
+  JSONSetVal(configJson, queueDepthLatencyFactor);
+  JSONSetVal(configJson, overProvisioningPct);
+  JSONSetVal(configJson, writeAmplification);
+  JSONSetVal(configJson, gcUnitSizeKB);
+  JSONSetVal(configJson, gcStallUs);
+
+  checkCorrectSize<NavyDeviceEmulationConfig, 64>();
+}
+
+navy::DeviceEmulationConfig
+NavyDeviceEmulationConfig::getDeviceEmulationConfig() const {
+  navy::DeviceEmulationConfig config;
+  config.setLatencyUs(readLatencyUs, writeLatencyUs)
+      .setLatencySigma(latencySigma)
+      .setBandwidthMBps(readBandwidthMBps, writeBandwidthMBps)
+      .setNumQueues(numQueues)
+      .setQueueDepthLatencyFactor(queueDepthLatencyFactor)
+      .setOverProvisioningPct(overProvisioningPct)
+      .setGcParams(gcUnitSizeKB, gcStallUs);
+  if (writeAmplification > 0) {
+    config.setWriteAmplification(writeAmplification);
+  }
+  return config;
+}
 } // namespace cachebench
 } // namespace cachelib
 } // namespace facebook
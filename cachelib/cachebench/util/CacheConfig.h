@@ -17,6 +17,7 @@
 #pragma once
 
 #include <any>
+#include <optional>
 
 #include "cachelib/allocator/CacheAllocator.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
@@ -61,6 +62,36 @@ struct MemoryTierConfig : public JSONConfig {
   std::string memBindNodes{""};
 };
 
+// Parse navy device emulation configuration from JSON config. See
+// navy::DeviceEmulationConfig for the meaning of the parameters.
+struct NavyDeviceEmulationConfig : public JSONConfig {
+  NavyDeviceEmulationConfig() {}
+
+  explicit NavyDeviceEmulationConfig(const folly::dynamic& configJson);
+
+  // Returns navy::DeviceEmulationConfig parsed from JSON config
+  navy::DeviceEmulationConfig getDeviceEmulationConfig() const;
+
+  // median latency of a single IO in microseconds
+  uint32_t readLatencyUs{80};
+  uint32_t writeLatencyUs{20};
+  // sigma of the lognormal latency jitter
+  double latencySigma{0};
+  // per queue bandwidth in MB/s. 0 means unlimited
+  uint32_t readBandwidthMBps{0};
+  uint32_t writeBandwidthMBps{0};
+  uint32_t numQueues{1};
+  // fraction of the base latency added per outstanding IO
+  double queueDepthLatencyFactor{0};
+  // over-provisioning in percent; 0 disables GC emulation
+  uint32_t overProvisioningPct{0};
+  // overrides the write amplification derived from over-provisioning
+  double writeAmplification{0};
+  // GC stalls for gcStallUs every gcUnitSizeKB of GC debt
+  uint32_t gcUnitSizeKB{1024};
+  uint32_t gcStallUs{2000};
+};
+
 struct CacheConfig : public JSONConfig {
   // by defaullt, lru allocator. can be set to LRU-2Q.
   std::string allocator{"LRU"};
@@ -163,6 +194,18 @@ struct CacheConfig : public JSONConfig {
   // Big Hash bloom filter size in bytes per bucket above.
   uint64_t navyBloomFilterPerBucketSize = 8;
 
+  // Bytes at the start of each BigHash bucket used for a key fingerprint
+  // directory so lookups read only part of the bucket. 0 disables it.
+  uint64_t navyBigHashDirectorySize = 0;
+
+  // Rate in MB/s at which BlockCache discards (TRIMs) reclaimed regions on the
+  // device. 0 disables discards.
+  uint64_t navyDiscardRateMB = 0;
+
+  // If non-empty, BlockCache segregates items by size into bands with these
+  // ascending upper bounds in bytes, plus a last band for larger items.
+  std::vector<uint32_t> navySizeBands{};
+
   // Small Item Max Size determines the upper bound of an item size that
   // can be admitted into Big Hash engine.
   uint64_t navySmallItemMaxSize = 2048;
@@ -230,6 +273,10 @@ struct CacheConfig : public JSONConfig {
   // Enable the FDP Data placement mode in the device, if it is capable.
   bool deviceEnableFDP{false};
 
+  // Back the navy index, bloom filters and nvm cache shards with transparent
+  // huge pages.
+  bool navyMetadataHugePages{false};
+
   // Don't write to flash if cache TTL is smaller than this value.
   // Not used when its value is 0.  In seconds.
   uint32_t memoryOnlyTTL{0};
@@ -243,6 +290,17 @@ struct CacheConfig : public JSONConfig {
   // Memory tiers configs
   std::vector<MemoryTierCacheConfig> memoryTierConfigs{};
 
+  // If set, navy runs on an emulated SSD with these latency and bandwidth
+  // characteristics on top of the configured device (usually memory).
+  std::optional<navy::DeviceEmulationConfig> navyDeviceEmulation{};
+
+  // Trace the lifecycle of one in every navyRequestTraceSampleRate navy
+  // requests (0 disables). Per stage latencies show up in the nvm counters,
+  // and traces slower than navyRequestTraceSlowThresholdUs are kept for
+  // dumping. Requires navyMaxNumReads and navyMaxNumWrites to be set.
+  uint64_t navyRequestTraceSampleRate{0};
+  uint64_t navyRequestTraceSlowThresholdUs{10'000};
+
   // If enabled, we will use the timestamps from the trace file in the ticker
   // so that the cachebench will observe time based on timestamps from the trace
   // instead of the system time.
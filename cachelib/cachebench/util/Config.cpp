@@ -69,6 +69,8 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
 
   JSONSetVal(configJson, useCombinedLockForIterators);
 
+  JSONSetVal(configJson, perfCounters);
+
   if (configJson.count("poolDistributions")) {
     for (auto& it : configJson["poolDistributions"]) {
       poolDistributions.emplace_back(it, configPath);
@@ -82,6 +84,12 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
         ReplayGeneratorConfig{configJson["replayGeneratorConfig"]};
   }
 
+  if (configJson.count("phases")) {
+    for (auto& it : configJson["phases"]) {
+      phases.emplace_back(it);
+    }
+  }
+
   if (!traceFileName.empty() && !traceFileNames.empty()) {
     throw std::invalid_argument(
         folly::sformat("set only one of traceFileName or traceFileNames"));
@@ -90,7 +98,7 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
   // If you added new fields to the configuration, update the JSONSetVal
   // to make them available for the json configs and increment the size
   // below
-  checkCorrectSize<StressorConfig, 512>();
+  checkCorrectSize<StressorConfig, 536>();
 }
 
 bool StressorConfig::usesChainedItems() const {
@@ -159,6 +167,7 @@ DistributionConfig::DistributionConfig(const folly::dynamic& jsonConfig,
   JSONSetVal(jsonConfig, popularityWeights);
 
   JSONSetVal(jsonConfig, popDistFile);
+  JSONSetVal(jsonConfig, zipfAlpha);
 
   JSONSetVal(jsonConfig, getRatio);
   JSONSetVal(jsonConfig, setRatio);
@@ -192,7 +201,7 @@ DistributionConfig::DistributionConfig(const folly::dynamic& jsonConfig,
     JSONSetVal(configJsonPop, popularityWeights);
   }
 
-  checkCorrectSize<DistributionConfig, 368>();
+  checkCorrectSize<DistributionConfig, 376>();
 }
 
 ReplayGeneratorConfig::ReplayGeneratorConfig(const folly::dynamic& configJson) {
@@ -233,6 +242,53 @@ ReplayGeneratorConfig::getSerializationMode() const {
   return ReplayGeneratorConfig::SerializeMode::strict;
 }
 
+PhaseConfig::PhaseConfig(const folly::dynamic& configJson) {
+  JSONSetVal(configJson, name);
+  JSONSetVal(configJson, durationSec);
+  JSONSetVal(configJson, opRatePerSec);
+  JSONSetVal(configJson, diurnalPeriodSec);
+  JSONSetVal(configJson, hotSetRotationSec);
+  JSONSetVal(configJson, diurnalAmplitude);
+  JSONSetVal(configJson, keySpaceShift);
+  JSONSetVal(configJson, hotSetRotationFraction);
+  JSONSetVal(configJson, zipfAlpha);
+  JSONSetVal(configJson, popularityBuckets);
+  JSONSetVal(configJson, popularityWeights);
+  JSONSetVal(configJson, valSizeRange);
+  JSONSetVal(configJson, valSizeRangeProbability);
+
+  if (durationSec == 0) {
+    throw std::invalid_argument(
+        folly::sformat("Phase {} must have a non-zero duration", name));
+  }
+  if (diurnalAmplitude < 0 || diurnalAmplitude > 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Phase {}: diurnalAmplitude must be within [0, 1]. Got {}", name,
+        diurnalAmplitude));
+  }
+  if (popularityBuckets.size() != popularityWeights.size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Phase {}: popularity buckets and weights do not match up", name));
+  }
+
+  checkCorrectSize<PhaseConfig, 192>();
+}
+
+void PhaseConfig::applyTo(DistributionConfig& c) const {
+  if (zipfAlpha > 0) {
+    c.zipfAlpha = zipfAlpha;
+  } else if (!popularityBuckets.empty()) {
+    c.zipfAlpha = 0;
+    c.popularityBuckets = popularityBuckets;
+    c.popularityWeights = popularityWeights;
+  }
+
+  if (!valSizeRange.empty()) {
+    c.valSizeRange = valSizeRange;
+    c.valSizeRangeProbability = valSizeRangeProbability;
+  }
+}
+
 MLAdmissionConfig::MLAdmissionConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, modelPath);
   JSONSetVal(configJson, numericFeatures);
@@ -64,6 +64,10 @@ struct DistributionConfig : public JSONConfig {
   // loaded by the distribution
   std::string popDistFile{};
 
+  // If positive, key popularity follows a zipf distribution with this skew
+  // instead of the bucketed or normal distributions above.
+  double zipfAlpha{0.0};
+
   // Operation distribution
   double getRatio{0.0};
   double setRatio{0.0};
@@ -82,6 +86,8 @@ struct DistributionConfig : public JSONConfig {
     return valSizeRange.size() == valSizeRangeProbability.size();
   }
 
+  bool usesZipfPopularity() const { return zipfAlpha > 0; }
+
   bool usesDiscretePopularity() const {
     return popularityBuckets.size() && popularityWeights.size();
   }
@@ -156,6 +162,53 @@ struct ReplayGeneratorConfig : public JSONConfig {
   SerializeMode getSerializationMode() const;
 };
 
+// A phase of a time varying workload. Phases run one after another for their
+// duration and the schedule repeats once the last phase finishes. Unset
+// fields keep the values from the base workload config.
+struct PhaseConfig : public JSONConfig {
+  PhaseConfig() {}
+
+  explicit PhaseConfig(const folly::dynamic& configJson);
+
+  // name used when reporting stats for the phase.
+  std::string name{};
+
+  // how long the phase lasts.
+  uint64_t durationSec{0};
+
+  // target op rate across all threads during the phase. 0 means unlimited.
+  uint64_t opRatePerSec{0};
+
+  // if set, the op rate follows a sine wave with this period and
+  // diurnalAmplitude (fraction of opRatePerSec) to model diurnal load.
+  uint64_t diurnalPeriodSec{0};
+
+  // if set, the hot set moves by hotSetRotationFraction of the key space
+  // every hotSetRotationSec while the phase runs.
+  uint64_t hotSetRotationSec{0};
+
+  double diurnalAmplitude{0.0};
+
+  // shift the popularity over the key space by this fraction for the whole
+  // phase. Used to model working set shifts between phases.
+  double keySpaceShift{0.0};
+
+  double hotSetRotationFraction{0.0};
+
+  // popularity override for the phase. zipfAlpha takes precedence over
+  // popularity buckets, as in DistributionConfig.
+  double zipfAlpha{0.0};
+  std::vector<size_t> popularityBuckets{};
+  std::vector<double> popularityWeights{};
+
+  // value size mix override for the phase.
+  std::vector<double> valSizeRange{};
+  std::vector<double> valSizeRangeProbability{};
+
+  // apply the overrides of this phase to a workload distribution.
+  void applyTo(DistributionConfig& c) const;
+};
+
 // The class defines the admission policy at stressor level. The stressor
 // checks the admission policy first before inserting an item into cache.
 //
@@ -174,6 +227,8 @@ struct StressorConfig : public JSONConfig {
   // Which workload generator to use, default is
   // workload generator which samples from some distribution
   // but "replay" allows replaying a production trace, for example.
+  // "procedural" derives keys and sizes from the key index on the fly, so
+  // that memory use and setup time do not grow with numKeys.
   std::string generator{};
 
   // Valid when generator is replay generator
@@ -275,14 +330,26 @@ struct StressorConfig : public JSONConfig {
 
   bool useCombinedLockForIterators{false};
 
+  // If enabled, collects hardware performance counters (cycles, instructions,
+  // LLC, dTLB and branch misses, context switches) through perf_event_open
+  // for the stressor threads and the cache's background threads. Events that
+  // are not available in the environment are reported as n/a.
+  bool perfCounters{false};
+
   // admission policy for cache.
   std::shared_ptr<StressorAdmPolicy> admPolicy{};
 
+  // Optional schedule of time varying workload phases. Requires the
+  // procedural generator. Stats are reported per phase at the end of the run.
+  std::vector<PhaseConfig> phases{};
+
   StressorConfig() {}
   explicit StressorConfig(const folly::dynamic& configJson);
 
   // return true if the workload configuration uses chained items.
   bool usesChainedItems() const;
+
+  bool usesPhases() const { return !phases.empty(); }
 };
 
 // user defined function to configure parts of cache config outside of the
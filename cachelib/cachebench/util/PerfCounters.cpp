@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/util/PerfCounters.h"
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadId.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace {
+struct PerfEventDesc {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+};
+
+#ifdef __linux__
+constexpr uint64_t kDTLBReadMiss =
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+// indexed by PerfEvent
+constexpr std::array<PerfEventDesc, kNumPerfEvents> kEventDescs{{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"LLC misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"dTLB misses", PERF_TYPE_HW_CACHE, kDTLBReadMiss},
+    {"branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"context switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+}};
+
+int openEvent(const PerfEventDesc& desc, int tid, bool excludeKernel) {
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = desc.type;
+  attr.config = desc.config;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.exclude_kernel = excludeKernel ? 1 : 0;
+  attr.exclude_hv = 1;
+  return static_cast<int>(::syscall(__NR_perf_event_open, &attr, tid,
+                                    -1 /* any cpu */, -1 /* no group */,
+                                    PERF_FLAG_FD_CLOEXEC));
+}
+#endif
+
+const char* eventName(size_t i) {
+#ifdef __linux__
+  return kEventDescs[i].name;
+#else
+  static constexpr std::array<const char*, kNumPerfEvents> kNames{
+      "cycles",        "instructions",    "LLC misses", "dTLB misses",
+      "branch misses", "context switches"};
+  return kNames[i];
+#endif
+}
+
+double perOp(uint64_t count, uint64_t ops) {
+  return ops == 0 ? 0.0 : static_cast<double>(count) / ops;
+}
+} // namespace
+
+bool PerfCounterValues::anySupported() const {
+  return std::any_of(supported.begin(), supported.end(),
+                     [](bool s) { return s; });
+}
+
+PerfCounterValues& PerfCounterValues::operator+=(
+    const PerfCounterValues& other) {
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    counts[i] += other.counts[i];
+    supported[i] = supported[i] || other.supported[i];
+  }
+  return *this;
+}
+
+PerfCounterValues& PerfCounterValues::operator-=(
+    const PerfCounterValues& other) {
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    // counts of a thread are monotonic, but the set of threads summed up can
+    // only grow. Clamp instead of wrapping around.
+    counts[i] = counts[i] > other.counts[i] ? counts[i] - other.counts[i] : 0;
+  }
+  return *this;
+}
+
+std::string PerfCounterValues::toString(uint64_t ops) const {
+  std::string res;
+  if (isSupported(PerfEvent::kCycles) &&
+      isSupported(PerfEvent::kInstructions)) {
+    const auto cycles = get(PerfEvent::kCycles);
+    res = folly::sformat(
+        "IPC {:.2f}",
+        cycles == 0 ? 0.0
+                    : static_cast<double>(get(PerfEvent::kInstructions)) /
+                          cycles);
+  } else {
+    res = "IPC n/a";
+  }
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    if (supported[i]) {
+      res += folly::sformat(", {}/op {:.2f}", eventName(i),
+                            perOp(counts[i], ops));
+    } else {
+      res += folly::sformat(", {}/op n/a", eventName(i));
+    }
+  }
+  return res;
+}
+
+PerfStats& PerfStats::operator-=(const PerfStats& other) {
+  stressor -= other.stressor;
+  background -= other.background;
+  return *this;
+}
+
+void PerfStats::render(uint64_t ops, std::ostream& out) const {
+  out << folly::sformat("{:10}: {}", "stressor", stressor.toString(ops))
+      << std::endl;
+  out << folly::sformat("{:10}: {}", "background", background.toString(ops))
+      << std::endl;
+}
+
+void PerfStats::render(uint64_t ops, folly::UserCounters& counters) const {
+  constexpr std::array<const char*, kNumPerfEvents> kCounterNames{
+      "cycles",        "instructions",  "llc_misses",
+      "dtlb_misses",   "branch_misses", "context_switches"};
+  auto renderValues = [&](const std::string& prefix,
+                          const PerfCounterValues& values) {
+    const auto cycles = values.get(PerfEvent::kCycles);
+    if (cycles > 0 && values.isSupported(PerfEvent::kInstructions)) {
+      counters[prefix + "ipc_x100"] = util::narrow_cast<uint64_t>(
+          100.0 * values.get(PerfEvent::kInstructions) / cycles);
+    }
+    // per op values are multiplied by 100 to keep the precision in the
+    // integer counters.
+    for (size_t i = 0; i < kNumPerfEvents; i++) {
+      if (values.supported[i]) {
+        counters[prefix + kCounterNames[i] + "_per_op_x100"] =
+            util::narrow_cast<uint64_t>(100.0 * perOp(values.counts[i], ops));
+      }
+    }
+  };
+  renderValues("perf_stressor_", stressor);
+  renderValues("perf_background_", background);
+}
+
+ThreadPerfCounters::ThreadPerfCounters(int tid) {
+  fds_.fill(-1);
+#ifdef __linux__
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    // counting kernel time needs perf_event_paranoid <= 1. Fall back to user
+    // space only, which is what most containers permit.
+    int fd = openEvent(kEventDescs[i], tid, false /* excludeKernel */);
+    if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+      fd = openEvent(kEventDescs[i], tid, true /* excludeKernel */);
+    }
+    if (fd < 0) {
+      XLOG_FIRST_N(WARN, kNumPerfEvents)
+          << "Unable to open perf event " << kEventDescs[i].name
+          << ", reporting it as unsupported: " << folly::errnoStr(errno);
+      continue;
+    }
+    fds_[i] = fd;
+  }
+#else
+  (void)tid;
+  XLOG_FIRST_N(WARN, 1) << "perf events are only supported on linux";
+#endif
+}
+
+ThreadPerfCounters::~ThreadPerfCounters() {
+  for (auto fd : fds_) {
+    if (fd >= 0) {
+      folly::closeNoInt(fd);
+    }
+  }
+}
+
+PerfCounterValues ThreadPerfCounters::read() const {
+  PerfCounterValues values;
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    if (fds_[i] < 0) {
+      continue;
+    }
+    // value, time enabled, time running as requested through read_format.
+    uint64_t buf[3] = {};
+    if (folly::readNoInt(fds_[i], buf, sizeof(buf)) !=
+        static_cast<ssize_t>(sizeof(buf))) {
+      continue;
+    }
+    values.supported[i] = true;
+    if (buf[2] == 0) {
+      // never got scheduled on the PMU.
+      continue;
+    }
+    values.counts[i] =
+        buf[2] >= buf[1]
+            ? buf[0]
+            : util::narrow_cast<uint64_t>(static_cast<double>(buf[0]) *
+                                          buf[1] / buf[2]);
+  }
+  return values;
+}
+
+std::vector<std::unique_ptr<ThreadPerfCounters>>
+ThreadPerfCounters::forOtherThreads(const std::string& skipPrefix) {
+  std::vector<std::unique_ptr<ThreadPerfCounters>> res;
+#ifdef __linux__
+  const auto self = folly::getOSThreadID();
+  std::error_code ec;
+  for (const auto& entry :
+       std::filesystem::directory_iterator("/proc/self/task", ec)) {
+    const auto tidStr = entry.path().filename().string();
+    const auto tid = folly::tryTo<int>(tidStr);
+    if (!tid.hasValue() || static_cast<uint64_t>(tid.value()) == self) {
+      continue;
+    }
+    std::string name;
+    if (!skipPrefix.empty() &&
+        folly::readFile((entry.path() / "comm").c_str(), name) &&
+        folly::StringPiece{name}.startsWith(skipPrefix)) {
+      continue;
+    }
+    res.push_back(std::make_unique<ThreadPerfCounters>(tid.value()));
+  }
+  if (ec) {
+    XLOG(WARN) << "Unable to list the threads of the process: "
+               << ec.message();
+  }
+#else
+  (void)skipPrefix;
+#endif
+  return res;
+}
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
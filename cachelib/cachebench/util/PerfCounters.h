@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+// Events collected through perf_event_open for every tracked thread.
+enum class PerfEvent : uint8_t {
+  kCycles = 0,
+  kInstructions,
+  kLLCMisses,
+  kDTLBMisses,
+  kBranchMisses,
+  kContextSwitches,
+  kNumEvents,
+};
+
+constexpr size_t kNumPerfEvents = static_cast<size_t>(PerfEvent::kNumEvents);
+
+// Counter values summed over a set of threads. An event is marked as
+// unsupported when the kernel refused to open it for every thread in the set,
+// which is common in VMs and containers without access to the PMU.
+struct PerfCounterValues {
+  std::array<uint64_t, kNumPerfEvents> counts{};
+  std::array<bool, kNumPerfEvents> supported{};
+
+  uint64_t get(PerfEvent e) const { return counts[static_cast<size_t>(e)]; }
+  bool isSupported(PerfEvent e) const {
+    return supported[static_cast<size_t>(e)];
+  }
+
+  // true if at least one event could be opened.
+  bool anySupported() const;
+
+  PerfCounterValues& operator+=(const PerfCounterValues& other);
+
+  // subtract an earlier snapshot to get the counts for an interval.
+  PerfCounterValues& operator-=(const PerfCounterValues& other);
+
+  // one line summary with IPC and every event normalized by @ops.
+  std::string toString(uint64_t ops) const;
+};
+
+// Counters for the stressor threads and for the cache's background threads
+// (pool rebalancer, reaper, navy job schedulers etc.). Both are normalized by
+// the number of operations issued by the stressor threads, so the background
+// numbers show the cost of background work per cache operation.
+struct PerfStats {
+  PerfCounterValues stressor;
+  PerfCounterValues background;
+
+  bool enabled() const {
+    return stressor.anySupported() || background.anySupported();
+  }
+
+  PerfStats& operator-=(const PerfStats& other);
+
+  void render(uint64_t ops, std::ostream& out) const;
+  void render(uint64_t ops, folly::UserCounters& counters) const;
+};
+
+// Opens the perf events for a single thread. Events that cannot be opened are
+// skipped and reported as unsupported. Counts are scaled by the time the event
+// was actually scheduled on the PMU when the kernel multiplexes counters.
+//
+// The counters can be read from any thread.
+class ThreadPerfCounters {
+ public:
+  // @param tid   OS thread id to attach to, 0 for the calling thread.
+  explicit ThreadPerfCounters(int tid = 0);
+  ~ThreadPerfCounters();
+
+  ThreadPerfCounters(const ThreadPerfCounters&) = delete;
+  ThreadPerfCounters& operator=(const ThreadPerfCounters&) = delete;
+
+  PerfCounterValues read() const;
+
+  // Attach to every thread of this process except the calling thread and
+  // threads whose name starts with @skipPrefix. Threads started after this
+  // call are not tracked.
+  static std::vector<std::unique_ptr<ThreadPerfCounters>> forOtherThreads(
+      const std::string& skipPrefix);
+
+ private:
+  std::array<int, kNumPerfEvents> fds_;
+};
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
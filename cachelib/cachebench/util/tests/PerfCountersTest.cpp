@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "cachelib/cachebench/util/PerfCounters.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace tests {
+
+TEST(PerfCountersTest, Arithmetic) {
+  PerfCounterValues a;
+  a.supported[static_cast<size_t>(PerfEvent::kCycles)] = true;
+  a.counts[static_cast<size_t>(PerfEvent::kCycles)] = 100;
+
+  PerfCounterValues b;
+  b.supported[static_cast<size_t>(PerfEvent::kInstructions)] = true;
+  b.counts[static_cast<size_t>(PerfEvent::kInstructions)] = 250;
+
+  auto sum = a;
+  sum += b;
+  EXPECT_TRUE(sum.isSupported(PerfEvent::kCycles));
+  EXPECT_TRUE(sum.isSupported(PerfEvent::kInstructions));
+  EXPECT_FALSE(sum.isSupported(PerfEvent::kLLCMisses));
+  EXPECT_EQ(100, sum.get(PerfEvent::kCycles));
+  EXPECT_EQ(250, sum.get(PerfEvent::kInstructions));
+  EXPECT_EQ(0, sum.toString(10).find("IPC 2.50"));
+  EXPECT_NE(std::string::npos, sum.toString(10).find("cycles/op 10.00"));
+  EXPECT_NE(std::string::npos, sum.toString(10).find("LLC misses/op n/a"));
+
+  // snapshots taken after more threads are tracked never wrap around.
+  auto delta = a;
+  delta -= sum;
+  EXPECT_EQ(0, delta.get(PerfEvent::kCycles));
+  EXPECT_EQ(0, delta.get(PerfEvent::kInstructions));
+
+  EXPECT_FALSE(PerfStats{}.enabled());
+  EXPECT_EQ("IPC n/a", PerfCounterValues{}.toString(0).substr(0, 7));
+}
+
+TEST(PerfCountersTest, ThreadCounters) {
+  // events might not be available in the test environment. Whatever could be
+  // opened must only move forward.
+  ThreadPerfCounters counters;
+  const auto before = counters.read();
+  volatile uint64_t sink = 0;
+  for (uint64_t i = 0; i < 1000000; i++) {
+    sink = sink + i;
+  }
+  const auto after = counters.read();
+  for (size_t i = 0; i < kNumPerfEvents; i++) {
+    EXPECT_EQ(before.supported[i], after.supported[i]);
+    EXPECT_GE(after.counts[i], before.counts[i]);
+  }
+}
+
+TEST(PerfCountersTest, OtherThreads) {
+  std::atomic<bool> stop{false};
+  std::thread t([&] {
+    while (!stop) {
+      std::this_thread::yield();
+    }
+  });
+  // the calling thread is never included.
+  auto all = ThreadPerfCounters::forOtherThreads("");
+  EXPECT_GE(all.size(), 1);
+  stop = true;
+  t.join();
+
+  // finished threads can still be read.
+  PerfCounterValues total;
+  for (const auto& c : all) {
+    total += c->read();
+  }
+  (void)total;
+}
+
+} // namespace tests
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -18,6 +18,7 @@
 #include <folly/logging/xlog.h>
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <string>
@@ -59,6 +60,50 @@ class NormalDistribution final : public Distribution {
   std::normal_distribution<double> dist_;
 };
 
+// Zipf distribution over [left, right] sampled through the inverse of the
+// continuous approximation of its CDF. Unlike FastDiscreteDistribution, this
+// keeps no per-bucket state and takes O(1) memory irrespective of the number
+// of objects. Index left is the most popular object.
+class ZipfDistribution final : public Distribution {
+ public:
+  // @param alpha   skew of the distribution. Must be positive.
+  ZipfDistribution(double alpha, size_t left, size_t right)
+      : left_(left), right_(right), alpha_(alpha) {
+    XDCHECK_GT(alpha_, 0.0);
+    XDCHECK_LE(left_, right_);
+    const double n = static_cast<double>(right_ - left_ + 1);
+    if (std::abs(1.0 - alpha_) < kAlphaEpsilon) {
+      logN_ = std::log(n + 1);
+    } else {
+      oneMinusAlpha_ = 1.0 - alpha_;
+      hN_ = std::pow(n + 1, oneMinusAlpha_) - 1.0;
+    }
+  }
+
+  size_t operator()(std::mt19937_64& gen) override {
+    return sample(std::uniform_real_distribution<double>(0.0, 1.0)(gen));
+  }
+
+  // map a uniform variate in [0, 1) to an index in [left, right].
+  size_t sample(double u) const {
+    double x = logN_ > 0 ? std::exp(u * logN_)
+                         : std::pow(1.0 + u * hN_, 1.0 / oneMinusAlpha_);
+    auto rank = static_cast<size_t>(x) - 1;
+    return left_ + std::min(rank, right_ - left_);
+  }
+
+ private:
+  static constexpr double kAlphaEpsilon = 1e-6;
+
+  const size_t left_;
+  const size_t right_;
+  const double alpha_;
+  // precomputed terms of the inverse CDF. logN_ is used when alpha is 1.
+  double logN_{0};
+  double oneMinusAlpha_{0};
+  double hN_{0};
+};
+
 // sampling object id and object size from a Zipf-like distribution
 // (aka the independent reference model (IRM))
 //
@@ -17,8 +17,10 @@
 #pragma once
 
 #include <folly/Benchmark.h>
+#include <folly/Conv.h>
 
 #include <atomic>
+#include <string>
 
 #include "cachelib/cachebench/util/Request.h"
 
@@ -67,6 +69,15 @@ class GeneratorBase {
     // not implemented by default
   }
 
+  // Index of the workload phase that is currently running. Generators
+  // without time varying phases always run phase 0.
+  virtual size_t getCurrentPhase() const { return 0; }
+
+  // Name of the workload phase for reporting.
+  virtual std::string getPhaseName(size_t phase) const {
+    return folly::to<std::string>("phase-", phase);
+  }
+
   // Should be called when all working threads are finished, or aborted
   void markShutdown() { isShutdown_.store(true, std::memory_order_relaxed); }
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/workload/PhasedGenerator.h"
+
+#include <cmath>
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+PhaseSchedule::PhaseSchedule(std::vector<PhaseConfig> phases)
+    : phases_(std::move(phases)) {
+  if (phases_.empty()) {
+    throw std::invalid_argument("Phase schedule needs at least one phase");
+  }
+  std::chrono::nanoseconds end{0};
+  for (const auto& p : phases_) {
+    end += std::chrono::seconds{p.durationSec};
+    phaseEnds_.push_back(end);
+  }
+}
+
+std::pair<size_t, std::chrono::nanoseconds> PhaseSchedule::locate(
+    std::chrono::nanoseconds elapsed) const {
+  const auto offset = elapsed % phaseEnds_.back();
+  for (size_t i = 0; i < phaseEnds_.size(); i++) {
+    if (offset < phaseEnds_[i]) {
+      const auto phaseStart =
+          i == 0 ? std::chrono::nanoseconds{0} : phaseEnds_[i - 1];
+      return {i, offset - phaseStart};
+    }
+  }
+  // unreachable since offset is always less than the last end.
+  return {phaseEnds_.size() - 1, std::chrono::nanoseconds{0}};
+}
+
+size_t PhaseSchedule::getPhase(std::chrono::nanoseconds elapsed) const {
+  return locate(elapsed).first;
+}
+
+double PhaseSchedule::getOpRate(std::chrono::nanoseconds elapsed) const {
+  auto [idx, inPhase] = locate(elapsed);
+  const auto& p = phases_[idx];
+  if (p.opRatePerSec == 0) {
+    return 0;
+  }
+  double rate = static_cast<double>(p.opRatePerSec);
+  if (p.diurnalPeriodSec > 0) {
+    const double t = std::chrono::duration<double>(inPhase).count();
+    rate *= 1.0 + p.diurnalAmplitude *
+                      std::sin(2 * M_PI * t / p.diurnalPeriodSec);
+  }
+  // never stall completely at the trough of the wave.
+  return std::max(rate, 1.0);
+}
+
+double PhaseSchedule::getKeySpaceShift(std::chrono::nanoseconds elapsed) const {
+  auto [idx, inPhase] = locate(elapsed);
+  const auto& p = phases_[idx];
+  double shift = p.keySpaceShift;
+  if (p.hotSetRotationSec > 0) {
+    const auto rotations =
+        inPhase / std::chrono::nanoseconds{std::chrono::seconds{
+                      p.hotSetRotationSec}};
+    shift += rotations * p.hotSetRotationFraction;
+  }
+  return shift;
+}
+
+PhasedGenerator::PhasedGenerator(const StressorConfig& config, uint64_t seed)
+    : schedule_(config.phases) {
+  for (size_t i = 0; i < schedule_.numPhases(); i++) {
+    auto phaseConfig = config;
+    for (auto& c : phaseConfig.poolDistributions) {
+      schedule_.getPhaseConfig(i).applyTo(c);
+    }
+    generators_.push_back(
+        std::make_unique<ProceduralGenerator>(phaseConfig, seed));
+  }
+}
+
+std::chrono::nanoseconds PhasedGenerator::elapsed() {
+  const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  int64_t start = startNs_.load(std::memory_order_relaxed);
+  if (start == 0) {
+    // the first thread to get here starts the clock.
+    if (!startNs_.compare_exchange_strong(start, now)) {
+      return std::chrono::nanoseconds{std::max<int64_t>(now - start, 0)};
+    }
+    return std::chrono::nanoseconds{0};
+  }
+  return std::chrono::nanoseconds{std::max<int64_t>(now - start, 0)};
+}
+
+const Request& PhasedGenerator::getReq(uint8_t poolId,
+                                       std::mt19937_64& gen,
+                                       std::optional<uint64_t>) {
+  const auto now = elapsed();
+  const double rate = schedule_.getOpRate(now);
+  if (rate > 0) {
+    rateLimiter_.consumeWithBorrowAndWait(1, rate, rate);
+  }
+  return generators_[schedule_.getPhase(now)]->getShiftedReq(
+      poolId, gen, schedule_.getKeySpaceShift(now));
+}
+
+size_t PhasedGenerator::getCurrentPhase() const {
+  const int64_t start = startNs_.load(std::memory_order_relaxed);
+  if (start == 0) {
+    return 0;
+  }
+  const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  return schedule_.getPhase(
+      std::chrono::nanoseconds{std::max<int64_t>(now - start, 0)});
+}
+
+std::string PhasedGenerator::getPhaseName(size_t phase) const {
+  const auto& name = schedule_.getPhaseConfig(phase).name;
+  return name.empty() ? folly::sformat("phase-{}", phase) : name;
+}
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
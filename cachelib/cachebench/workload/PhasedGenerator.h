@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Random.h>
+#include <folly/TokenBucket.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/util/Request.h"
+#include "cachelib/cachebench/workload/GeneratorBase.h"
+#include "cachelib/cachebench/workload/ProceduralGenerator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+// Maps the time elapsed since the start of a run to the active workload
+// phase and its time dependent parameters. The schedule repeats once the last
+// phase ends.
+class PhaseSchedule {
+ public:
+  explicit PhaseSchedule(std::vector<PhaseConfig> phases);
+
+  size_t numPhases() const { return phases_.size(); }
+
+  const PhaseConfig& getPhaseConfig(size_t idx) const { return phases_[idx]; }
+
+  // index of the phase active at the elapsed time.
+  size_t getPhase(std::chrono::nanoseconds elapsed) const;
+
+  // target op rate at the elapsed time. 0 means unlimited.
+  double getOpRate(std::chrono::nanoseconds elapsed) const;
+
+  // fraction of the key space the popularity is shifted by at the elapsed
+  // time.
+  double getKeySpaceShift(std::chrono::nanoseconds elapsed) const;
+
+ private:
+  // returns the active phase and the time spent in it so far.
+  std::pair<size_t, std::chrono::nanoseconds> locate(
+      std::chrono::nanoseconds elapsed) const;
+
+  const std::vector<PhaseConfig> phases_;
+
+  // end offsets of each phase within one iteration of the schedule.
+  std::vector<std::chrono::nanoseconds> phaseEnds_;
+};
+
+// Generator that runs a schedule of workload phases on top of the procedural
+// generator. Every phase gets its own procedural generator with the phase's
+// popularity and size overrides, all sharing one seed and thereby one key
+// space. Op rate shaping and hot set rotation are applied per request
+// according to the time since the first request.
+class PhasedGenerator : public GeneratorBase {
+ public:
+  explicit PhasedGenerator(const StressorConfig& config,
+                           uint64_t seed = folly::Random::rand64());
+  virtual ~PhasedGenerator() {}
+
+  const Request& getReq(
+      uint8_t poolId,
+      std::mt19937_64& gen,
+      std::optional<uint64_t> lastRequestId = std::nullopt) override;
+
+  const std::vector<std::string>& getAllKeys() const override {
+    throw std::logic_error("PhasedGenerator has no keys precomputed!");
+  }
+
+  size_t getCurrentPhase() const override;
+
+  std::string getPhaseName(size_t phase) const override;
+
+ private:
+  // time since the first request. Starts the clock on first use.
+  std::chrono::nanoseconds elapsed();
+
+  const PhaseSchedule schedule_;
+
+  // one generator per phase
+  std::vector<std::unique_ptr<ProceduralGenerator>> generators_;
+
+  // shapes the op rate of the active phase across all threads.
+  folly::DynamicTokenBucket rateLimiter_;
+
+  // steady clock time of the first request in nanoseconds. 0 until then.
+  std::atomic<int64_t> startNs_{0};
+};
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/workload/ProceduralGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace detail {
+
+InverseCdf::InverseCdf(const std::vector<double>& ranges,
+                       const std::vector<double>& probs)
+    : ranges_(ranges), discrete_(ranges.size() == probs.size()) {
+  if (probs.empty()) {
+    return;
+  }
+  if (!discrete_ && ranges.size() != probs.size() + 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Ranges ({}) and probabilities ({}) do not match up", ranges.size(),
+        probs.size()));
+  }
+
+  const double total = std::accumulate(probs.begin(), probs.end(), 0.0);
+  if (total <= 0) {
+    throw std::invalid_argument("Probabilities must add up to more than 0");
+  }
+  double sum = 0;
+  for (auto p : probs) {
+    sum += p;
+    cdf_.push_back(sum / total);
+  }
+  // guard against rounding so that every u < 1 finds an interval.
+  cdf_.back() = 1.0;
+}
+
+double InverseCdf::sample(double u) const {
+  if (cdf_.empty()) {
+    return 0;
+  }
+  size_t i = std::upper_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+  i = std::min(i, cdf_.size() - 1);
+  if (discrete_) {
+    return ranges_[i];
+  }
+
+  // interpolate uniformly inside the interval like
+  // std::piecewise_constant_distribution does.
+  const double prev = i == 0 ? 0.0 : cdf_[i - 1];
+  const double width = cdf_[i] - prev;
+  const double frac = width > 0 ? (u - prev) / width : 0.0;
+  return ranges_[i] + frac * (ranges_[i + 1] - ranges_[i]);
+}
+} // namespace detail
+
+ProceduralGenerator::ProceduralGenerator(const StressorConfig& config,
+                                         uint64_t seed)
+    : config_{config},
+      seed_{seed},
+      req_([&]() {
+        return new Request(*key_, sizes_->begin(), sizes_->end());
+      }) {
+  for (const auto& c : config_.poolDistributions) {
+    if (c.keySizeRange.size() != c.keySizeRangeProbability.size() + 1) {
+      throw std::invalid_argument(
+          "Key size range and their probabilities do not match up. Check your "
+          "test config.");
+    }
+    workloadDist_.push_back(WorkloadDistribution(c));
+
+    SizeDists dists;
+    dists.keySize = {c.keySizeRange, c.keySizeRangeProbability};
+    dists.valSize = {c.valSizeRange, c.valSizeRangeProbability};
+    dists.chainLen = {c.chainedItemLengthRange,
+                      c.chainedItemLengthRangeProbability};
+    dists.chainSize = {c.chainedItemValSizeRange,
+                       c.chainedItemValSizeRangeProbability};
+    sizeDists_.push_back(std::move(dists));
+  }
+
+  if (config_.keyPoolDistribution.size() < config_.opPoolDistribution.size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Operations are distributed across {} pools, but keys only across {}",
+        config_.opPoolDistribution.size(),
+        config_.keyPoolDistribution.size()));
+  }
+
+  generateFirstKeyIndexForPool();
+  for (size_t i = 0; i < config_.opPoolDistribution.size(); i++) {
+    if (firstKeyIndexForPool_[i + 1] == firstKeyIndexForPool_[i]) {
+      throw std::invalid_argument(
+          folly::sformat("No keys are assigned to pool {}", i));
+    }
+    workloadPopDist_.push_back(workloadDist_[workloadIdx(i)].getPopDist(
+        firstKeyIndexForPool_[i], firstKeyIndexForPool_[i + 1] - 1));
+  }
+}
+
+const Request& ProceduralGenerator::getReq(uint8_t poolId,
+                                           std::mt19937_64& gen,
+                                           std::optional<uint64_t>) {
+  return getShiftedReq(poolId, gen, 0.0);
+}
+
+const Request& ProceduralGenerator::getShiftedReq(uint8_t poolId,
+                                                  std::mt19937_64& gen,
+                                                  double keySpaceShift) {
+  XDCHECK_LT(poolId, workloadPopDist_.size());
+  uint64_t keyIdx = (*workloadPopDist_[poolId])(gen);
+  if (keySpaceShift != 0.0) {
+    const uint64_t first = firstKeyIndexForPool_[poolId];
+    const uint64_t numKeys = firstKeyIndexForPool_[poolId + 1] - first;
+    double frac = keySpaceShift - std::floor(keySpaceShift);
+    auto offset = static_cast<uint64_t>(frac * numKeys);
+    keyIdx = first + (keyIdx - first + offset) % numKeys;
+  }
+
+  generateKey(poolId, keyIdx, req_->key);
+  generateSizes(poolId, keyIdx, *sizes_);
+  req_->sizeBegin = sizes_->begin();
+  req_->sizeEnd = sizes_->end();
+  auto op =
+      static_cast<OpType>(workloadDist_[workloadIdx(poolId)].sampleOpDist(gen));
+  req_->setOp(op);
+  return *req_;
+}
+
+void ProceduralGenerator::generateKey(uint8_t poolId,
+                                      uint64_t idx,
+                                      std::string& key) const {
+  const auto& dists = sizeDists_[workloadIdx(poolId)];
+  // we need at least the bytes of the scrambled index to keep keys unique.
+  const size_t keySize =
+      std::max(util::narrow_cast<size_t>(dists.keySize.sample(
+                   detail::toUnitInterval(
+                       detail::counterRand(seed_, idx, Stream::kKeyLen)))),
+               sizeof(idx));
+  key.resize(keySize);
+
+  // the counter based RNG is a bijection on the index for a given seed and
+  // stream. This spreads consecutive (and similarly popular) indices across
+  // the key space while keeping keys unique.
+  const uint64_t scrambled = detail::counterRand(seed_, idx, Stream::kKeyBytes);
+  std::memcpy(key.data(), &scrambled, sizeof(scrambled));
+
+  // pad with lower case letters that are a function of the index as well.
+  constexpr size_t kCharsPerDraw = 12;
+  uint64_t bits = 0;
+  for (size_t i = sizeof(scrambled); i < keySize; i++) {
+    const size_t pos = i - sizeof(scrambled);
+    if (pos % kCharsPerDraw == 0) {
+      bits = detail::counterRand(seed_ + pos, idx, Stream::kKeyBytes);
+    }
+    key[i] = static_cast<char>('a' + bits % 26);
+    bits /= 26;
+  }
+}
+
+void ProceduralGenerator::generateSizes(uint8_t poolId,
+                                        uint64_t idx,
+                                        std::vector<size_t>& sizes) const {
+  const auto& dists = sizeDists_[workloadIdx(poolId)];
+  auto draw = [this, idx](uint64_t stream) {
+    return detail::toUnitInterval(detail::counterRand(seed_, idx, stream));
+  };
+
+  sizes.clear();
+  sizes.push_back(
+      util::narrow_cast<size_t>(dists.valSize.sample(draw(Stream::kValSize))));
+  const auto chainLen =
+      util::narrow_cast<size_t>(dists.chainLen.sample(draw(Stream::kChainLen)));
+  for (size_t k = 0; k < chainLen; k++) {
+    // every chained item gets its own stream past the fixed ones.
+    sizes.push_back(util::narrow_cast<size_t>(
+        dists.chainSize.sample(draw(Stream::kChainSize + k))));
+  }
+}
+
+void ProceduralGenerator::generateFirstKeyIndexForPool() {
+  auto sumProb = std::accumulate(config_.keyPoolDistribution.begin(),
+                                 config_.keyPoolDistribution.end(), 0.);
+  auto accumProb = 0.;
+  firstKeyIndexForPool_.push_back(0);
+  for (auto prob : config_.keyPoolDistribution) {
+    accumProb += prob;
+    firstKeyIndexForPool_.push_back(
+        util::narrow_cast<uint64_t>(config_.numKeys * accumProb / sumProb));
+  }
+}
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Random.h>
+#include <folly/ThreadLocal.h>
+#include <folly/logging/xlog.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/util/Request.h"
+#include "cachelib/cachebench/workload/GeneratorBase.h"
+#include "cachelib/cachebench/workload/WorkloadDistribution.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace detail {
+
+// Counter based random number generator. Returns the same 64 bits for the
+// same (seed, counter, stream) without keeping any state, which lets us
+// derive the properties of a key from its index on demand.
+inline uint64_t counterRand(uint64_t seed, uint64_t counter, uint64_t stream) {
+  // splitmix64 finalizer over a weyl sequence keyed by seed and stream.
+  uint64_t z = seed + (counter + 1) * 0x9E3779B97F4A7C15ULL +
+               stream * 0xD1B54A32D192ED03ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+// uniform double in [0, 1) from 64 random bits.
+inline double toUnitInterval(uint64_t bits) {
+  return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+// Inverse CDF of a piecewise constant or discrete distribution described by
+// the same range/probability vectors used in DistributionConfig. Memory is
+// proportional to the number of ranges, not the number of keys.
+class InverseCdf {
+ public:
+  InverseCdf() = default;
+
+  // @param ranges    interval boundaries (piecewise) or values (discrete)
+  // @param probs     probabilities per interval or per value
+  InverseCdf(const std::vector<double>& ranges,
+             const std::vector<double>& probs);
+
+  // map a uniform variate in [0, 1) to a value of the distribution.
+  double sample(double u) const;
+
+  bool empty() const { return cdf_.empty(); }
+
+ private:
+  std::vector<double> ranges_;
+  std::vector<double> cdf_;
+  bool discrete_{false};
+};
+} // namespace detail
+
+// Workload generator that derives everything about a key from its index
+// instead of materializing keys, sizes and sampled accesses upfront. Key
+// bytes, key length and value/chain sizes are functions of the key index
+// computed through a counter based RNG, and key popularity is sampled with
+// O(1) state distributions (zipf, bucketed FastDiscrete or normal). Memory
+// use and startup time do not depend on numKeys.
+class ProceduralGenerator : public GeneratorBase {
+ public:
+  // @param config  stressor config
+  // @param seed    seed for deriving keys and sizes. Runs with the same seed
+  //                and config operate on the same key space.
+  explicit ProceduralGenerator(const StressorConfig& config,
+                               uint64_t seed = folly::Random::rand64());
+  virtual ~ProceduralGenerator() {}
+
+  const Request& getReq(
+      uint8_t poolId,
+      std::mt19937_64& gen,
+      std::optional<uint64_t> lastRequestId = std::nullopt) override;
+
+  // same as getReq, but moves the sampled popularity over the pool's key
+  // space by keySpaceShift (a fraction of the pool, wrapping around). This
+  // makes a different set of keys hot without changing the key space.
+  const Request& getShiftedReq(uint8_t poolId,
+                               std::mt19937_64& gen,
+                               double keySpaceShift);
+
+  const std::vector<std::string>& getAllKeys() const override {
+    throw std::logic_error("ProceduralGenerator has no keys precomputed!");
+  }
+
+  // fill in the key for the key index. The key index fully determines the
+  // key, so this can be called concurrently.
+  void generateKey(uint8_t poolId, uint64_t idx, std::string& key) const;
+
+  // fill in the value size followed by chained item sizes for the key index.
+  void generateSizes(uint8_t poolId,
+                     uint64_t idx,
+                     std::vector<size_t>& sizes) const;
+
+ private:
+  // streams of the counter based RNG used for each key property.
+  enum Stream : uint64_t {
+    kKeyLen = 0,
+    kKeyBytes,
+    kValSize,
+    kChainLen,
+    kChainSize,
+  };
+
+  // per pool inverse CDFs used to derive sizes from the key index.
+  struct SizeDists {
+    detail::InverseCdf keySize;
+    detail::InverseCdf valSize;
+    detail::InverseCdf chainLen;
+    detail::InverseCdf chainSize;
+  };
+
+  void generateFirstKeyIndexForPool();
+
+  // if there is only one workloadDistribution, use it for everything.
+  size_t workloadIdx(size_t i) const {
+    return workloadDist_.size() > 1 ? i : 0;
+  }
+
+  const StressorConfig config_;
+  const uint64_t seed_;
+
+  // @firstKeyIndexForPool_ contains the first key in each pool (As represented
+  // by key pool distribution).
+  std::vector<uint64_t> firstKeyIndexForPool_;
+
+  std::vector<WorkloadDistribution> workloadDist_;
+  std::vector<SizeDists> sizeDists_;
+
+  // popularity distribution for keys per pool
+  std::vector<std::unique_ptr<Distribution>> workloadPopDist_;
+
+  // thread local copy of key, sizes and request to return as a part of getReq
+  class Tag;
+  folly::ThreadLocal<std::string, Tag> key_;
+  folly::ThreadLocal<std::vector<size_t>, Tag> sizes_;
+  folly::ThreadLocal<Request, Tag> req_;
+};
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
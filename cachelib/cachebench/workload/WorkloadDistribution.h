@@ -28,7 +28,7 @@ namespace cachebench {
 // Implementation that controls overall workloa distribution. The following
 // are modeled
 // 1. op distribution to identify the type of operation
-// 2. popularity of key distribution  (discrete popularity and normal
+// 2. popularity of key distribution  (discrete popularity, zipf and normal
 //    dist)
 // 3. key size, value size and chained item sizes.
 class WorkloadDistribution {
@@ -90,7 +90,9 @@ class WorkloadDistribution {
   // unlike other sources, we let the workload generator directly make copies
   // of the base popularity distribution and sample from that.
   std::unique_ptr<Distribution> getPopDist(size_t left, size_t right) const {
-    if (config_.usesDiscretePopularity()) {
+    if (config_.usesZipfPopularity()) {
+      return std::make_unique<ZipfDistribution>(config_.zipfAlpha, left, right);
+    } else if (config_.usesDiscretePopularity()) {
       return std::make_unique<FastDiscreteDistribution>(
           left, right, config_.popularityBuckets, config_.popularityWeights);
     } else {
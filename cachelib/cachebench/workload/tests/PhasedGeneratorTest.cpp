@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_set>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/workload/PhasedGenerator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace {
+PhaseConfig makePhase(const std::string& name, uint64_t durationSec) {
+  PhaseConfig p;
+  p.name = name;
+  p.durationSec = durationSec;
+  return p;
+}
+
+StressorConfig makeConfig() {
+  StressorConfig config;
+  config.generator = "procedural";
+  config.numKeys = 10000;
+  config.numOps = 10000;
+  config.numThreads = 1;
+  config.poolDistributions.push_back(DistributionConfig{});
+  auto& workloadConfig = config.poolDistributions.back();
+  workloadConfig.getRatio = 1.0;
+  workloadConfig.keySizeRange = std::vector<double>{16, 32};
+  workloadConfig.keySizeRangeProbability = std::vector<double>{1.0};
+  workloadConfig.valSizeRange = std::vector<double>{100, 200};
+  workloadConfig.valSizeRangeProbability = std::vector<double>{1.0};
+  workloadConfig.zipfAlpha = 1.2;
+  config.opPoolDistribution = std::vector<double>{1.0};
+  config.keyPoolDistribution = std::vector<double>{1.0};
+  return config;
+}
+} // namespace
+
+TEST(PhasedGeneratorTest, Schedule) {
+  auto peak = makePhase("peak", 10);
+  peak.opRatePerSec = 1000;
+  peak.diurnalPeriodSec = 8;
+  peak.diurnalAmplitude = 0.5;
+  auto shift = makePhase("shift", 5);
+  shift.keySpaceShift = 0.5;
+  shift.hotSetRotationSec = 1;
+  shift.hotSetRotationFraction = 0.1;
+  PhaseSchedule schedule{{peak, shift}};
+
+  using namespace std::chrono_literals;
+  EXPECT_EQ(2, schedule.numPhases());
+  EXPECT_EQ(0, schedule.getPhase(0s));
+  EXPECT_EQ(0, schedule.getPhase(9s));
+  EXPECT_EQ(1, schedule.getPhase(10s));
+  EXPECT_EQ(1, schedule.getPhase(14s));
+  // the schedule repeats
+  EXPECT_EQ(0, schedule.getPhase(15s));
+  EXPECT_EQ(1, schedule.getPhase(26s));
+
+  // sine wave over the configured rate
+  EXPECT_DOUBLE_EQ(1000, schedule.getOpRate(0s));
+  EXPECT_DOUBLE_EQ(1500, schedule.getOpRate(2s));
+  EXPECT_NEAR(500, schedule.getOpRate(15s + 6s), 1e-6);
+  // unlimited
+  EXPECT_EQ(0, schedule.getOpRate(10s));
+
+  EXPECT_EQ(0, schedule.getKeySpaceShift(5s));
+  EXPECT_DOUBLE_EQ(0.5, schedule.getKeySpaceShift(10s));
+  EXPECT_DOUBLE_EQ(0.7, schedule.getKeySpaceShift(12s + 500ms));
+}
+
+TEST(PhasedGeneratorTest, InvalidPhases) {
+  EXPECT_THROW(PhaseSchedule(std::vector<PhaseConfig>{}),
+               std::invalid_argument);
+  EXPECT_THROW(PhaseConfig(folly::dynamic::object("name", "a")),
+               std::invalid_argument);
+  EXPECT_THROW(PhaseConfig(folly::dynamic::object("durationSec", 1)(
+                   "diurnalAmplitude", 2.0)),
+               std::invalid_argument);
+}
+
+TEST(PhasedGeneratorTest, PhasesShareKeySpace) {
+  auto config = makeConfig();
+  config.phases.push_back(makePhase("base", 1000));
+  ProceduralGenerator base{config, 7};
+  PhasedGenerator phased{config, 7};
+
+  // without any overrides, the phased generator operates on the same keys.
+  std::unordered_set<std::string> keys;
+  for (uint64_t i = 0; i < config.numKeys; i++) {
+    std::string key;
+    base.generateKey(0, i, key);
+    keys.insert(key);
+  }
+
+  std::mt19937_64 gen;
+  for (int i = 0; i < 1000; ++i) {
+    const Request& r = phased.getReq(0, gen);
+    EXPECT_EQ(1, keys.count(r.key));
+  }
+  EXPECT_EQ(0, phased.getCurrentPhase());
+  EXPECT_EQ("base", phased.getPhaseName(0));
+}
+
+TEST(PhasedGeneratorTest, SizeMixOverride) {
+  auto config = makeConfig();
+  auto phase = makePhase("large", 1000);
+  phase.valSizeRange = std::vector<double>{5000, 6000};
+  phase.valSizeRangeProbability = std::vector<double>{1.0};
+  config.phases.push_back(phase);
+  PhasedGenerator phased{config};
+
+  std::mt19937_64 gen;
+  for (int i = 0; i < 1000; ++i) {
+    const Request& r = phased.getReq(0, gen);
+    EXPECT_GE(*r.sizeBegin, 5000);
+    EXPECT_LT(*r.sizeBegin, 6000);
+  }
+}
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <unordered_set>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/workload/ProceduralGenerator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace {
+StressorConfig makeConfig(uint64_t numKeys) {
+  StressorConfig config;
+  config.numKeys = numKeys;
+  config.numOps = 10000;
+  config.numThreads = 1;
+  config.poolDistributions.push_back(DistributionConfig{});
+  auto& workloadConfig = config.poolDistributions.back();
+  workloadConfig.getRatio = 1.0;
+  workloadConfig.keySizeRange = std::vector<double>{16, 32};
+  workloadConfig.keySizeRangeProbability = std::vector<double>{1.0};
+  workloadConfig.valSizeRange = std::vector<double>{100, 200, 300};
+  workloadConfig.valSizeRangeProbability = std::vector<double>{0.5, 0.5};
+  config.opPoolDistribution = std::vector<double>{1.0};
+  config.keyPoolDistribution = std::vector<double>{1.0};
+  return config;
+}
+} // namespace
+
+TEST(ProceduralGeneratorTest, KeysAndSizesAreStable) {
+  auto config = makeConfig(1000);
+  ProceduralGenerator keygen{config, 42};
+  ProceduralGenerator keygen2{config, 42};
+
+  std::unordered_set<std::string> keys;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    std::string key1, key2;
+    keygen.generateKey(0, i, key1);
+    keygen2.generateKey(0, i, key2);
+    EXPECT_EQ(key1, key2);
+    EXPECT_GE(key1.size(), 16);
+    EXPECT_LT(key1.size(), 32);
+    keys.insert(key1);
+
+    std::vector<size_t> sizes1, sizes2;
+    keygen.generateSizes(0, i, sizes1);
+    keygen2.generateSizes(0, i, sizes2);
+    EXPECT_EQ(sizes1, sizes2);
+    ASSERT_EQ(1, sizes1.size());
+    EXPECT_GE(sizes1[0], 100);
+    EXPECT_LT(sizes1[0], 300);
+  }
+  // every index maps to a distinct key
+  EXPECT_EQ(1000, keys.size());
+}
+
+TEST(ProceduralGeneratorTest, BillionKeys) {
+  // setup must not depend on the number of keys.
+  auto config = makeConfig(1ULL << 40);
+  config.poolDistributions.back().zipfAlpha = 0.9;
+  ProceduralGenerator keygen{config};
+  std::mt19937_64 gen;
+  for (int i = 0; i < 1000; ++i) {
+    const Request& r(keygen.getReq(0, gen));
+    EXPECT_GE(r.key.size(), 16);
+    EXPECT_EQ(OpType::kGet, r.getOp());
+    EXPECT_EQ(1, std::distance(r.sizeBegin, r.sizeEnd));
+  }
+}
+
+TEST(ProceduralGeneratorTest, ChainedSizes) {
+  auto config = makeConfig(1000);
+  auto& workloadConfig = config.poolDistributions.back();
+  workloadConfig.chainedItemLengthRange = std::vector<double>{3, 4};
+  workloadConfig.chainedItemLengthRangeProbability = std::vector<double>{1.0};
+  workloadConfig.chainedItemValSizeRange = std::vector<double>{10, 20};
+  workloadConfig.chainedItemValSizeRangeProbability = std::vector<double>{1.0};
+  ProceduralGenerator keygen{config};
+  for (uint64_t i = 0; i < 100; ++i) {
+    std::vector<size_t> sizes;
+    keygen.generateSizes(0, i, sizes);
+    ASSERT_EQ(4, sizes.size());
+    for (size_t k = 1; k < sizes.size(); k++) {
+      EXPECT_GE(sizes[k], 10);
+      EXPECT_LT(sizes[k], 20);
+    }
+  }
+}
+
+TEST(ProceduralGeneratorTest, DiscreteValueSizes) {
+  auto config = makeConfig(1000);
+  auto& workloadConfig = config.poolDistributions.back();
+  workloadConfig.valSizeRange = std::vector<double>{10, 20, 30};
+  workloadConfig.valSizeRangeProbability = std::vector<double>{0.5, 0.4, 0.1};
+  ProceduralGenerator keygen{config};
+  std::mt19937_64 gen;
+  for (int i = 0; i < 1500; ++i) {
+    const Request& r(keygen.getReq(0, gen));
+    auto size = *r.sizeBegin;
+    EXPECT_TRUE(size == 10 || size == 20 || size == 30) << size;
+  }
+}
+
+TEST(ProceduralGeneratorTest, ZipfSkew) {
+  ZipfDistribution dist{1.0, 100, 100 + 9999};
+  std::mt19937_64 gen;
+  std::vector<size_t> counts(10000);
+  for (int i = 0; i < 100000; ++i) {
+    auto idx = dist(gen);
+    ASSERT_GE(idx, 100);
+    ASSERT_LE(idx, 100 + 9999);
+    counts[idx - 100]++;
+  }
+  // the head of the distribution is much hotter than the tail.
+  EXPECT_GT(counts[0], 10 * counts[5000]);
+  EXPECT_GT(counts[0], counts[10]);
+  EXPECT_EQ(100, dist.sample(0.0));
+}
+
+TEST(ProceduralGeneratorTest, InvalidConfig) {
+  auto config = makeConfig(1000);
+  config.poolDistributions.back().keySizeRangeProbability =
+      std::vector<double>{0.5, 0.5};
+  ASSERT_THROW(ProceduralGenerator keygen{config}, std::invalid_argument);
+
+  // more op pools than key pools
+  config = makeConfig(1000);
+  config.opPoolDistribution = std::vector<double>{0.5, 0.5};
+  ASSERT_THROW(ProceduralGenerator keygen{config}, std::invalid_argument);
+}
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -16,9 +16,13 @@
 
 #pragma once
 
+#include <folly/Range.h>
 #include <folly/SpinLock.h>
 
 #include <atomic>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "cachelib/common/BloomFilter.h"
@@ -28,7 +32,15 @@
 
 namespace facebook::cachelib {
 namespace detail {
-// Template type for CMS
+// Tracks the accesses to keys in the last config_.numBuckets bucket spans.
+// Recording and reading accesses take no locks and do not allocate when
+// counting with a CMS: every bucket is tagged with the span (epoch) it holds
+// counts for, and the first access in a new span claims the bucket with a
+// CAS on its epoch, resets it, and only then publishes the new epoch. Bloom
+// filters can not be updated concurrently, so they are still protected by a
+// lock per bucket.
+//
+// Template type for CMS. It must be safe to increment concurrently.
 template <typename CMS>
 class AccessTrackerBase {
  public:
@@ -61,13 +73,12 @@ class AccessTrackerBase {
     // certainity that the error is within the above margin.
     double cmsErrorCertainity{0.99};
 
-    // TODO (sathya) this can be cut short by 4x using a uin8_t instead of
-    // uint32_t for counts in CMS.
-    //
-    // maximum width param to control  the max memory usage of 256mb per hour
+    // maximum width param to control the max memory usage of 64mb per hour
+    // with 8 bit counters
     size_t cmsMaxWidth{8'000'000};
 
-    // maximum depth param to control  the max memory usage of 256mb per hour
+    // maximum depth param to control the max memory usage of 64mb per hour
+    // with 8 bit counters
     size_t cmsMaxDepth{8};
 
     // BloomFilter specific configs.
@@ -78,44 +89,54 @@ class AccessTrackerBase {
 
   explicit AccessTrackerBase(Config config);
 
-  // 1. The access count of the accessed key in the current
-  // bucket is incremented.
-  // 2. Collect the most recent config_.numBuckets access counts
-  // and return in a vector.
-  // @param key accessed key.
-  // @return vector of length config_.numBuckets. element i contains
-  // the access count of current - i bucket span.
+  // 1. Collect the most recent config_.numBuckets access counts of the key
+  // into @features.
+  // 2. The access count of the accessed key in the current bucket is
+  // incremented.
+  // @param key       accessed key.
+  // @param features  of length config_.numBuckets. element i is set to the
+  //                  access count of current - i bucket span.
+  // @throw std::invalid_argument if features is not config_.numBuckets long
+  void recordAndPopulateAccessFeatures(folly::StringPiece key,
+                                       folly::Range<double*> features) {
+    const auto hashVal = hashKey(key);
+    const auto epoch = getCurrentEpoch();
+    populateAccesses(hashVal, epoch, features);
+    recordAccess(hashVal, epoch);
+  }
+
+  // Same as above, but returns the features in a new vector.
   std::vector<double> recordAndPopulateAccessFeatures(folly::StringPiece key) {
-    auto features = getAccesses(key);
-    recordAccess(key);
+    std::vector<double> features(config_.numBuckets);
+    recordAndPopulateAccessFeatures(key, folly::range(features));
     return features;
   }
 
   // Record access to the current bucket.
-  void recordAccess(folly::StringPiece key);
+  void recordAccess(folly::StringPiece key) {
+    recordAccess(hashKey(key), getCurrentEpoch());
+  }
+
+  // Fill @features with the access histories of the given key.
+  // @throw std::invalid_argument if features is not config_.numBuckets long
+  void getAccesses(folly::StringPiece key, folly::Range<double*> features) {
+    populateAccesses(hashKey(key), getCurrentEpoch(), features);
+  }
 
   // Return the access histories of the given key.
-  std::vector<double> getAccesses(folly::StringPiece key);
+  std::vector<double> getAccesses(folly::StringPiece key) {
+    std::vector<double> features(config_.numBuckets);
+    getAccesses(key, folly::range(features));
+    return features;
+  }
 
   size_t getNumBuckets() const noexcept { return config_.numBuckets; }
 
   AccessTrackerBase(const AccessTrackerBase& other) = delete;
   AccessTrackerBase& operator=(const AccessTrackerBase& other) = delete;
 
-  AccessTrackerBase(AccessTrackerBase&& other) noexcept
-      : config_(std::move(other.config_)),
-        mostRecentAccessedBucket_(other.mostRecentAccessedBucket_.load()),
-        filters_(std::move(other.filters_)),
-        counts_(std::exchange(other.counts_, {})),
-        locks_(std::exchange(other.locks_, {})) {}
-
-  AccessTrackerBase& operator=(AccessTrackerBase&& other) {
-    if (this != &other) {
-      this->~AccessTrackerBase();
-      new (this) AccessTrackerBase(std::move(other));
-    }
-    return *this;
-  }
+  AccessTrackerBase(AccessTrackerBase&& other) = default;
+  AccessTrackerBase& operator=(AccessTrackerBase&& other) = default;
 
   size_t getByteSize() const noexcept {
     return filters_.getByteSize() +
@@ -130,37 +151,66 @@ class AccessTrackerBase {
   // this means we can have the estimate be off by 0.001% of max
   static constexpr uint64_t kRandomSeed{314159};
 
-  size_t getCurrentBucketIndex() const {
-    return rotatedIdx(config_.ticker->getCurrentTick() /
-                      config_.numTicksPerBucket);
+  static uint64_t hashKey(folly::StringPiece key) {
+    return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(),
+                                             kRandomSeed);
   }
 
-  // rotate raw bucket index to fit into the output.
-  size_t rotatedIdx(size_t bucket) const { return bucket % config_.numBuckets; }
+  // the current bucket span, counted from the ticker's first tick.
+  uint64_t getCurrentEpoch() const {
+    return config_.ticker->getCurrentTick() / config_.numTicksPerBucket;
+  }
 
-  // Update the most recent accessed bucket.
-  void updateMostRecentAccessedBucket();
+  // rotate an epoch to the index of the bucket holding it.
+  size_t rotatedIdx(uint64_t epoch) const {
+    return epoch % config_.numBuckets;
+  }
 
-  // Get current access count of the value from one bucket.
+  // whether the bucket at idx holds the counts of @epoch. A bucket that is
+  // being reset holds no epoch.
+  bool holdsEpoch(size_t idx, uint64_t epoch) const {
+    // epochs are stored off by one so that 0 marks an unused bucket.
+    return epochs_[idx].load(std::memory_order_acquire) == epoch + 1;
+  }
+
+  // Make the bucket of @epoch hold it, resetting the bucket if it held an
+  // older epoch. This is the first access in a new bucket span, and it drops
+  // the oldest bucket's counts, keeping the number of buckets constant at
+  // config_.numBuckets. The bucket is marked kResettingEpoch while it is
+  // reset, so that readers see it as empty rather than the old counts, and
+  // the new epoch is published only once the reset is done.
   //
-  // @param idx bucket index.
-  // @param hashVal the value to look up
-  double getBucketAccessCountLocked(size_t idx, uint64_t hashVal) const;
+  // @return false if the bucket already holds a newer epoch, i.e. the
+  //         caller's tick is more than config_.numBuckets spans old, or if
+  //         another thread is resetting it. The access is dropped then.
+  bool advanceToEpoch(uint64_t epoch);
+
+  void recordAccess(uint64_t hashVal, uint64_t epoch);
+
+  void populateAccesses(uint64_t hashVal,
+                        uint64_t epoch,
+                        folly::Range<double*> features);
 
-  // Record the access of the value to a bucket
+  // Get current access count of the value from one bucket.
   //
   // @param idx bucket index.
-  // @param hashval the value to look up.
-  void updateBucketLocked(size_t idx, uint64_t hashVal);
+  // @param hashVal the value to look up
+  double getBucketAccessCount(size_t idx, uint64_t hashVal) const;
 
   // Reset the access count of the bucket. Used when bucket rotation happens.
   //
   // @param idx bucket index.
-  void resetBucketLocked(size_t idx);
+  void resetBucket(size_t idx);
 
   Config config_;
 
-  std::atomic<size_t> mostRecentAccessedBucket_{0};
+  // Marks a bucket whose counts are being reset by advanceToEpoch.
+  static constexpr uint64_t kResettingEpoch{
+      std::numeric_limits<uint64_t>::max()};
+
+  // The epoch + 1 each bucket holds counts for, 0 if it was never used, or
+  // kResettingEpoch.
+  std::unique_ptr<std::atomic<uint64_t>[]> epochs_;
 
   // Record last config_.numBuckets buckets of potential flash admissions, as
   // input features to admission model.  Each bloom filter is written to for a
@@ -172,17 +222,19 @@ class AccessTrackerBase {
   std::vector<CMS> counts_;
 
   using LockHolder = std::lock_guard<folly::SpinLock>;
-  // locks protecting each hour of the filters_ or counts_
-  std::vector<folly::SpinLock> locks_;
+  // locks protecting each hour of the filters_. Not used for counts_.
+  mutable std::vector<folly::SpinLock> locks_;
 
-  std::vector<uint64_t> itemCounts_;
+  // number of accesses recorded in each bucket
+  std::unique_ptr<std::atomic<uint64_t>[]> itemCounts_;
 };
 
 template <typename CMS>
 AccessTrackerBase<CMS>::AccessTrackerBase(Config config)
     : config_(std::move(config)),
-      locks_{config_.numBuckets},
-      itemCounts_(config_.numBuckets, 0) {
+      epochs_(std::make_unique<std::atomic<uint64_t>[]>(config_.numBuckets)),
+      itemCounts_(
+          std::make_unique<std::atomic<uint64_t>[]>(config_.numBuckets)) {
   if (config_.useCounts) {
     counts_.reserve(config_.numBuckets);
     const double errorMargin = config_.cmsMaxErrorValue /
@@ -198,107 +250,107 @@ AccessTrackerBase<CMS>::AccessTrackerBase(Config config)
         config_.numBuckets,
         config_.maxNumOpsPerBucket,
         config_.bfFalsePositiveRate);
+    locks_ = std::vector<folly::SpinLock>(config_.numBuckets);
   }
   if (!config_.ticker) {
     config_.ticker = std::make_shared<ClockBasedTicker>();
   }
 }
 
-// Record access to the current bucket.
 template <typename CMS>
-void AccessTrackerBase<CMS>::recordAccess(folly::StringPiece key) {
-  updateMostRecentAccessedBucket();
-  const auto hashVal =
-      folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), kRandomSeed);
-  const auto idx = mostRecentAccessedBucket_.load(std::memory_order_relaxed);
-  LockHolder l(locks_[idx]);
-  updateBucketLocked(idx, hashVal);
+bool AccessTrackerBase<CMS>::advanceToEpoch(uint64_t epoch) {
+  const auto idx = rotatedIdx(epoch);
+  auto curr = epochs_[idx].load(std::memory_order_acquire);
+  while (curr < epoch + 1) {
+    if (epochs_[idx].compare_exchange_weak(curr, kResettingEpoch,
+                                           std::memory_order_acq_rel)) {
+      resetBucket(idx);
+      epochs_[idx].store(epoch + 1, std::memory_order_release);
+      return true;
+    }
+  }
+  // curr is kResettingEpoch if another thread is resetting the bucket.
+  return curr == epoch + 1;
 }
 
-// Return the access histories of the given key.
+// Record access to the bucket of the epoch.
 template <typename CMS>
-std::vector<double> AccessTrackerBase<CMS>::getAccesses(
-    folly::StringPiece key) {
-  updateMostRecentAccessedBucket();
-  const auto hashVal =
-      folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), kRandomSeed);
-  const auto mostRecentBucketIdx =
-      mostRecentAccessedBucket_.load(std::memory_order_relaxed);
-
-  std::vector<double> features(config_.numBuckets);
-  // Extract values from buckets.
-  // features[i]: count for bucket number (mostRecentBucket - i).
-  for (size_t i = 0; i < config_.numBuckets; i++) {
-    const auto idx = rotatedIdx(mostRecentBucketIdx + config_.numBuckets - i);
+void AccessTrackerBase<CMS>::recordAccess(uint64_t hashVal, uint64_t epoch) {
+  if (!advanceToEpoch(epoch)) {
+    return;
+  }
+  const auto idx = rotatedIdx(epoch);
+  if (config_.useCounts) {
+    counts_[idx].increment(hashVal);
+  } else {
     LockHolder l(locks_[idx]);
-    features[i] = getBucketAccessCountLocked(idx, hashVal);
+    filters_.set(idx, hashVal);
   }
-  return features;
+  itemCounts_[idx].fetch_add(1, std::memory_order_relaxed);
 }
 
-// Update the most recent accessed bucket.
-// If updated, this is the first time entering a new bucket, the oldest
-// bucket's count would be cleared, keeping the number of buckets
-// constant at config_.numBuckets.
+// Fill the access histories of the given key up to epoch.
 template <typename CMS>
-void AccessTrackerBase<CMS>::updateMostRecentAccessedBucket() {
-  const auto bucketIdx = getCurrentBucketIndex();
-  while (true) {
-    auto mostRecent = mostRecentAccessedBucket_.load(std::memory_order_relaxed);
-    // if we are in the border of currently tracked bucket, we don't need to
-    // reset the data. we assume that all threads accessing this don't run for
-    // more than 2 buckets.
-    if (bucketIdx == mostRecent || rotatedIdx(bucketIdx + 1) == mostRecent) {
-      return;
-    }
-
-    const bool success = mostRecentAccessedBucket_.compare_exchange_strong(
-        mostRecent, bucketIdx);
-    if (success) {
-      LockHolder l(locks_[bucketIdx]);
-      resetBucketLocked(bucketIdx);
-      return;
-    }
+void AccessTrackerBase<CMS>::populateAccesses(uint64_t hashVal,
+                                              uint64_t epoch,
+                                              folly::Range<double*> features) {
+  if (features.size() != config_.numBuckets) {
+    throw std::invalid_argument(
+        folly::sformat("Expected {} features, got {}", config_.numBuckets,
+                       features.size()));
+  }
+  // Extract values from buckets.
+  // features[i]: count for bucket span (epoch - i). Spans that had no
+  // accesses, and so were never rotated in, count as 0.
+  for (size_t i = 0; i < config_.numBuckets; i++) {
+    const auto idx = rotatedIdx(epoch - i);
+    features[i] = i <= epoch && holdsEpoch(idx, epoch - i)
+                      ? getBucketAccessCount(idx, hashVal)
+                      : 0;
   }
 }
 
 template <typename CMS>
-double AccessTrackerBase<CMS>::getBucketAccessCountLocked(
-    size_t idx, uint64_t hashVal) const {
-  return config_.useCounts ? counts_.at(idx).getCount(hashVal)
-         : (filters_.couldExist(idx, hashVal)) ? 1
-                                               : 0;
-}
-
-template <typename CMS>
-void AccessTrackerBase<CMS>::updateBucketLocked(size_t idx, uint64_t hashVal) {
-  config_.useCounts ? counts_[idx].increment(hashVal)
-                    : filters_.set(idx, hashVal);
-  itemCounts_[idx]++;
+double AccessTrackerBase<CMS>::getBucketAccessCount(size_t idx,
+                                                    uint64_t hashVal) const {
+  if (config_.useCounts) {
+    return counts_[idx].getCount(hashVal);
+  }
+  LockHolder l(locks_[idx]);
+  return filters_.couldExist(idx, hashVal) ? 1 : 0;
 }
 
 template <typename CMS>
-void AccessTrackerBase<CMS>::resetBucketLocked(size_t idx) {
-  config_.useCounts ? counts_[idx].reset() : filters_.clear(idx);
-  itemCounts_[idx] = 0;
+void AccessTrackerBase<CMS>::resetBucket(size_t idx) {
+  if (config_.useCounts) {
+    counts_[idx].reset();
+  } else {
+    LockHolder l(locks_[idx]);
+    filters_.clear(idx);
+  }
+  itemCounts_[idx].store(0, std::memory_order_relaxed);
 }
 
 template <typename CMS>
 std::vector<uint64_t> AccessTrackerBase<CMS>::getRotatedAccessCounts() {
-  size_t currentBucketIdx = getCurrentBucketIndex();
+  const auto epoch = getCurrentEpoch();
   std::vector<uint64_t> counts(config_.numBuckets);
 
   for (size_t i = 0; i < config_.numBuckets; i++) {
-    const auto idx = rotatedIdx(currentBucketIdx + config_.numBuckets - i);
-    LockHolder l(locks_[idx]);
-    counts[i] = itemCounts_[idx];
+    const auto idx = rotatedIdx(epoch - i);
+    counts[i] = i <= epoch && holdsEpoch(idx, epoch - i)
+                    ? itemCounts_[idx].load(std::memory_order_relaxed)
+                    : 0;
   }
 
   return counts;
 }
 } // namespace detail
 
-using AccessTracker = detail::AccessTrackerBase<util::CountMinSketch>;
-using AccessTracker8 = detail::AccessTrackerBase<util::CountMinSketch8>;
-using AccessTracker16 = detail::AccessTrackerBase<util::CountMinSketch16>;
+// The counts are per bucket span, so saturating 8 bit counters are enough for
+// the admission features and take a quarter of the memory of 32 bit ones.
+using AccessTracker = detail::AccessTrackerBase<util::AtomicCountMinSketch8>;
+using AccessTracker8 = detail::AccessTrackerBase<util::AtomicCountMinSketch8>;
+using AccessTracker16 = detail::AccessTrackerBase<util::AtomicCountMinSketch16>;
+using AccessTracker32 = detail::AccessTrackerBase<util::AtomicCountMinSketch>;
 } // namespace facebook::cachelib
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "cachelib/common/Hash.h"
+
+namespace facebook::cachelib::util {
+// A count-min sketch of 4-bit saturating counters where all the counters of
+// a key live in the same cache line. The table is an array of 64-byte
+// blocks of eight 64-bit words, and every word holds 16 counters:
+//
+//   block: | w0 w1 w2 w3 | w4 w5 w6 w7 |
+//            row 0..3      row 0..3
+//
+// A key picks a block and one half of it, and then a counter in each of the
+// kDepth words of that half. An update or a query touches 32 contiguous
+// bytes instead of one cache line per row, and with AVX2 all rows are
+// updated and compared in a single 256-bit register.
+//
+// Counters saturate at 15, which is enough to tell popular keys apart in a
+// frequency based admission policy as long as the counts are periodically
+// halved. halveCounts() does that for 16 counters at a time by shifting
+// whole words.
+//
+// Users are supposed to synchronize concurrent accesses to the data
+// structure.
+class BlockedCountMinSketch {
+ public:
+  // number of counters per key
+  static constexpr uint32_t kDepth = 4;
+
+  // @param numCounters   number of counters per row of an equivalent
+  //                      CountMinSketch with kDepth rows. The table holds at
+  //                      least numCounters * kDepth counters.
+  // Throws std::invalid_argument if numCounters is 0.
+  explicit BlockedCountMinSketch(uint64_t numCounters)
+      : numBlocks_{calculateNumBlocks(numCounters)},
+        table_{std::make_unique<Block[]>(numBlocks_)} {
+    reset();
+  }
+
+  BlockedCountMinSketch() = default;
+
+  BlockedCountMinSketch(const BlockedCountMinSketch&) = delete;
+  BlockedCountMinSketch& operator=(const BlockedCountMinSketch&) = delete;
+
+  BlockedCountMinSketch(BlockedCountMinSketch&& other) noexcept
+      : numBlocks_(other.numBlocks_), table_(std::move(other.table_)) {
+    other.numBlocks_ = 0;
+  }
+
+  BlockedCountMinSketch& operator=(BlockedCountMinSketch&& other) noexcept {
+    if (this != &other) {
+      numBlocks_ = other.numBlocks_;
+      table_ = std::move(other.table_);
+      other.numBlocks_ = 0;
+    }
+    return *this;
+  }
+
+  uint8_t getCount(uint64_t key) const {
+    if (numBlocks_ == 0) {
+      return 0;
+    }
+    uint64_t shifts[kDepth];
+    const uint64_t* words = locate(key, shifts);
+#if defined(__AVX2__)
+    const auto counts = extractCounts(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(words)), shifts);
+    // the counts are in the low 32 bits of every 64-bit lane
+    auto m = _mm_min_epu32(_mm256_castsi256_si128(counts),
+                           _mm256_extracti128_si256(counts, 1));
+    m = _mm_min_epu32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(0, 0, 0, 2)));
+    return static_cast<uint8_t>(_mm_cvtsi128_si32(m));
+#else
+    uint64_t count = kMaxCount;
+    for (uint32_t i = 0; i < kDepth; i++) {
+      count = std::min(count, (words[i] >> shifts[i]) & kMaxCount);
+    }
+    return static_cast<uint8_t>(count);
+#endif
+  }
+
+  void increment(uint64_t key) {
+    if (numBlocks_ == 0) {
+      return;
+    }
+    uint64_t shifts[kDepth];
+    uint64_t* words = locate(key, shifts);
+#if defined(__AVX2__)
+    auto* vec = reinterpret_cast<__m256i*>(words);
+    const auto w = _mm256_load_si256(vec);
+    const auto sh =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shifts));
+    // add one to every counter that is not saturated. A counter below 15
+    // never carries into its neighbour.
+    const auto saturated = _mm256_cmpeq_epi64(
+        extractCounts(w, shifts), _mm256_set1_epi64x(kMaxCount));
+    const auto ones = _mm256_sllv_epi64(_mm256_set1_epi64x(1), sh);
+    _mm256_store_si256(
+        vec, _mm256_add_epi64(w, _mm256_andnot_si256(saturated, ones)));
+#else
+    for (uint32_t i = 0; i < kDepth; i++) {
+      if (((words[i] >> shifts[i]) & kMaxCount) != kMaxCount) {
+        words[i] += uint64_t{1} << shifts[i];
+      }
+    }
+#endif
+  }
+
+  // Halves all counts. Shifting a word right by one moves the low bit of
+  // every counter into its neighbour, so those bits are masked off.
+  void halveCounts() {
+    constexpr uint64_t kHalfMask = 0x7777777777777777ULL;
+    auto* words = reinterpret_cast<uint64_t*>(table_.get());
+    const uint64_t numWords = numBlocks_ * kWordsPerBlock;
+    for (uint64_t i = 0; i < numWords; i++) {
+      words[i] = (words[i] >> 1) & kHalfMask;
+    }
+  }
+
+  // Sets count for all keys to zero
+  void reset() {
+    if (numBlocks_ > 0) {
+      std::memset(table_.get(), 0, getByteSize());
+    }
+  }
+
+  uint64_t numBlocks() const { return numBlocks_; }
+
+  uint64_t getByteSize() const { return numBlocks_ * sizeof(Block); }
+
+  uint8_t getMaxCount() const { return kMaxCount; }
+
+ private:
+  static constexpr uint64_t kMaxCount = 15;
+  static constexpr uint32_t kWordsPerBlock = 8;
+  static constexpr uint32_t kCountersPerBlock = kWordsPerBlock * 16;
+  static_assert(kDepth * 2 == kWordsPerBlock,
+                "a key's counters must fit in half a block");
+
+  struct alignas(64) Block {
+    uint64_t words[kWordsPerBlock];
+  };
+
+  static uint64_t calculateNumBlocks(uint64_t numCounters) {
+    if (numCounters == 0) {
+      throw std::invalid_argument{folly::sformat(
+          "Number of counters must be greater than 0. Counters: {}",
+          numCounters)};
+    }
+    return folly::nextPowTwo(
+        (numCounters * kDepth + kCountersPerBlock - 1) / kCountersPerBlock);
+  }
+
+  // Returns the kDepth words of @key and fills in the bit offset of the
+  // key's counter in each of them. The low 16 bits of the hash pick the
+  // counters, the next one the half block and the high bits the block.
+  uint64_t* locate(uint64_t key, uint64_t (&shifts)[kDepth]) const {
+    const uint64_t h = hashInt(key);
+    for (uint32_t i = 0; i < kDepth; i++) {
+      shifts[i] = ((h >> (4 * i)) & 0xF) * 4;
+    }
+    const uint64_t block = (h >> 32) & (numBlocks_ - 1);
+    const uint64_t half = (h >> 16) & 1;
+    return table_[block].words + half * kDepth;
+  }
+
+#if defined(__AVX2__)
+  static __m256i extractCounts(__m256i words, const uint64_t* shifts) {
+    const auto sh =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shifts));
+    return _mm256_and_si256(_mm256_srlv_epi64(words, sh),
+                            _mm256_set1_epi64x(kMaxCount));
+  }
+#endif
+
+  uint64_t numBlocks_{0};
+
+  // Stores counts
+  std::unique_ptr<Block[]> table_{};
+};
+} // namespace facebook::cachelib::util
@@ -82,18 +82,18 @@ constexpr uint32_t BloomFilter::kPersistFragmentSize;
 
 BloomFilter::BloomFilter(uint32_t numFilters,
                          uint32_t numHashes,
-                         size_t hashTableBitSize)
+                         size_t hashTableBitSize,
+                         util::HugePagePolicy hugePages)
     : numFilters_{numFilters},
       hashTableBitSize_{hashTableBitSize},
       filterByteSize_{bitsToBytes(numHashes * hashTableBitSize)},
       seeds_(numHashes),
-      bits_{std::make_unique<uint8_t[]>(getByteSize())} {
+      bits_{getByteSize(), hugePages} {
   if (numFilters == 0 || numHashes == 0 || hashTableBitSize == 0) {
     throw std::invalid_argument("invalid bloom filter params");
   }
   // Don't have to worry about @bits_ memory:
-  // make_unique initialized memory with 0, because it news explicitly init
-  // array: new T[N]().
+  // MetadataArray value initializes its elements, which zeroes them.
   for (size_t i = 0; i < seeds_.size(); i++) {
     seeds_[i] = facebook::cachelib::hashInt(i);
   }
@@ -137,7 +137,7 @@ void BloomFilter::clear(uint32_t idx) {
 void BloomFilter::reset() {
   if (bits_) {
     // make the bits indicate that no keys are set
-    std::memset(bits_.get(), 0, getByteSize());
+    std::memset(bits_.data(), 0, getByteSize());
   }
 }
 
@@ -146,7 +146,7 @@ void BloomFilter::serializeBits(RecordWriter& rw, uint64_t fragmentSize) {
   uint64_t off = 0;
   while (off < bitsSize) {
     auto nBytes = std::min(bitsSize - off, fragmentSize);
-    auto wbuf = folly::IOBuf::copyBuffer(bits_.get() + off, nBytes);
+    auto wbuf = folly::IOBuf::copyBuffer(bits_.data() + off, nBytes);
     rw.writeRecord(std::move(wbuf));
     off += nBytes;
   }
@@ -174,7 +174,7 @@ void BloomFilter::deserializeBits(RecordReader& rr) {
       throw std::invalid_argument(
           folly::sformat("Failed to recover bits_ off: {}", off));
     }
-    memcpy(bits_.get() + off, bitsBuf->data(), bitsBuf->length());
+    memcpy(bits_.data() + off, bitsBuf->data(), bitsBuf->length());
     off += bitsBuf->length();
   }
 
@@ -21,6 +21,7 @@
 #include <stdexcept>
 #include <vector>
 
+#include "cachelib/common/HugePageAllocator.h"
 #include "cachelib/common/Serialization.h"
 
 #pragma GCC diagnostic push
@@ -44,10 +45,13 @@ class BloomFilter {
   // Creates @numFilters BFs. Each small BF uses @numHashes hash functions, maps
   // hash value into a table of @hashTableBitSize bits (must be power of 2).
   // Each small BF takes rounded up to byte @numHashes * @hashTableBitSize bits.
-  //
+  // @hugePages decides whether the bits are backed by huge pages.
   //
   // Throws std::exception if invalid arguments.
-  BloomFilter(uint32_t numFilters, uint32_t numHashes, size_t hashTableBitSize);
+  BloomFilter(uint32_t numFilters,
+              uint32_t numHashes,
+              size_t hashTableBitSize,
+              util::HugePagePolicy hugePages = util::HugePagePolicy::kNone);
 
   // calculates the optimal numHashes and hashTableBitSize for the fbProb and
   // creates one.
@@ -66,7 +70,7 @@ class BloomFilter {
         hashTableBitSize_(other.hashTableBitSize_),
         filterByteSize_(other.filterByteSize_),
         seeds_(std::exchange(other.seeds_, {})),
-        bits_(std::exchange(other.bits_, nullptr)) {}
+        bits_(std::move(other.bits_)) {}
 
   BloomFilter& operator=(BloomFilter&& other) {
     if (this != &other) {
@@ -116,7 +120,7 @@ class BloomFilter {
  private:
   uint8_t* getFilterBytes(uint32_t idx) const {
     XDCHECK(bits_);
-    return bits_.get() + idx * filterByteSize_;
+    return bits_.data() + idx * filterByteSize_;
   }
 
   void serializeBits(RecordWriter& rw, uint64_t fragmentSize);
@@ -128,7 +132,7 @@ class BloomFilter {
   const size_t hashTableBitSize_{};
   const size_t filterByteSize_{};
   std::vector<uint64_t> seeds_;
-  std::unique_ptr<uint8_t[]> bits_;
+  util::MetadataArray<uint8_t> bits_;
 };
 
 template <typename SerializationProto>
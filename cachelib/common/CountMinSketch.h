@@ -18,10 +18,12 @@
 
 #include <folly/Format.h>
 
+#include <atomic>
 #include <cmath>
 #include <limits>
 #include <memory>
 #include <stdexcept>
+#include <utility>
 
 #include "cachelib/common/Hash.h"
 #include "cachelib/common/Utils.h"
@@ -113,6 +115,9 @@ class CountMinSketchBase {
   uint64_t getSaturatedCounts() { return saturated; }
 
  private:
+  template <typename>
+  friend class AtomicCountMinSketchBase;
+
   static uint32_t calculateWidth(double error, uint32_t maxWidth);
   static uint32_t calculateDepth(double probability, uint32_t maxDepth);
 
@@ -238,10 +243,113 @@ uint64_t CountMinSketchBase<UINT>::getIndex(uint32_t hashNum,
                   width_;
   return hashNum * width_ + rowIndex;
 }
+
+// Same as CountMinSketchBase, but safe to increment and read concurrently
+// without locks. Counters are updated with relaxed atomics and saturate at
+// the counter's capacity. reset() racing with increments may drop some of
+// them.
+template <typename UINT>
+class AtomicCountMinSketchBase {
+ public:
+  // See CountMinSketchBase.
+  // Throws std::exception.
+  AtomicCountMinSketchBase(double error,
+                           double probability,
+                           uint32_t maxWidth,
+                           uint32_t maxDepth)
+      : AtomicCountMinSketchBase{
+            CountMinSketchBase<UINT>::calculateWidth(error, maxWidth),
+            CountMinSketchBase<UINT>::calculateDepth(probability, maxDepth)} {}
+
+  AtomicCountMinSketchBase(uint32_t width, uint32_t depth)
+      : width_{width}, depth_{depth} {
+    if (width_ == 0 || depth_ == 0) {
+      throw std::invalid_argument{folly::sformat(
+          "Width and depth must be greater than 0. Width: {}, Depth: {}",
+          width, depth)};
+    }
+    table_ = std::make_unique<std::atomic<UINT>[]>(width_ * depth_);
+    reset();
+  }
+
+  AtomicCountMinSketchBase() = default;
+
+  AtomicCountMinSketchBase(const AtomicCountMinSketchBase&) = delete;
+  AtomicCountMinSketchBase& operator=(const AtomicCountMinSketchBase&) =
+      delete;
+
+  AtomicCountMinSketchBase(AtomicCountMinSketchBase&& other) noexcept
+      : width_(std::exchange(other.width_, 0)),
+        depth_(std::exchange(other.depth_, 0)),
+        table_(std::move(other.table_)) {}
+
+  AtomicCountMinSketchBase& operator=(AtomicCountMinSketchBase&& other) {
+    if (this != &other) {
+      this->~AtomicCountMinSketchBase();
+      new (this) AtomicCountMinSketchBase(std::move(other));
+    }
+    return *this;
+  }
+
+  UINT getCount(uint64_t key) const {
+    UINT count = getMaxCount();
+    for (uint32_t hashNum = 0; hashNum < depth_; hashNum++) {
+      const auto& counter = table_[getIndex(hashNum, key)];
+      count = std::min(count, counter.load(std::memory_order_relaxed));
+    }
+    return count * (depth_ != 0);
+  }
+
+  void increment(uint64_t key) {
+    for (uint32_t hashNum = 0; hashNum < depth_; hashNum++) {
+      auto& counter = table_[getIndex(hashNum, key)];
+      auto curr = counter.load(std::memory_order_relaxed);
+      while (curr < getMaxCount() &&
+             !counter.compare_exchange_weak(curr, curr + 1,
+                                            std::memory_order_relaxed)) {
+      }
+    }
+  }
+
+  // Sets count for all keys to zero
+  void reset() {
+    const uint64_t tableSize = uint64_t{width_} * depth_;
+    for (uint64_t i = 0; i < tableSize; i++) {
+      table_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  uint32_t width() const { return width_; }
+
+  uint32_t depth() const { return depth_; }
+
+  uint64_t getByteSize() const {
+    return uint64_t{width_} * depth_ * sizeof(std::atomic<UINT>);
+  }
+
+  UINT getMaxCount() const { return std::numeric_limits<UINT>::max(); }
+
+ private:
+  uint64_t getIndex(uint32_t hashNum, uint64_t key) const {
+    auto rowIndex = facebook::cachelib::combineHashes(
+                        facebook::cachelib::hashInt(hashNum), key) %
+                    width_;
+    return hashNum * width_ + rowIndex;
+  }
+
+  uint32_t width_{0};
+  uint32_t depth_{0};
+
+  std::unique_ptr<std::atomic<UINT>[]> table_{};
+};
 } // namespace detail
 
 // By default, use uint32_t as count type.
 using CountMinSketch = detail::CountMinSketchBase<uint32_t>;
 using CountMinSketch8 = detail::CountMinSketchBase<uint8_t>;
 using CountMinSketch16 = detail::CountMinSketchBase<uint16_t>;
+
+using AtomicCountMinSketch = detail::AtomicCountMinSketchBase<uint32_t>;
+using AtomicCountMinSketch8 = detail::AtomicCountMinSketchBase<uint8_t>;
+using AtomicCountMinSketch16 = detail::AtomicCountMinSketchBase<uint16_t>;
 } // namespace facebook::cachelib::util
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/common/HugePageAllocator.h"
+
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "cachelib/common/Utils.h"
+
+/* On Mac OS / FreeBSD, mmap(2) and madvise(2) do not support these flags */
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB 0
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 0
+#endif
+
+namespace facebook::cachelib::util {
+namespace {
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+std::atomic<uint64_t> gMetadataBytes[3]{};
+
+std::atomic<uint64_t>& bytesFor(HugePageBacking backing) {
+  return gMetadataBytes[static_cast<size_t>(backing)];
+}
+
+void* mapHugeTlb(size_t size) {
+  if (MAP_HUGETLB == 0) {
+    return nullptr;
+  }
+  // no MAP_NORESERVE: without enough reserved pages the mmap fails here
+  // instead of the first access to an unbacked page raising SIGBUS.
+  void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB,
+                   -1, 0);
+  return mem == MAP_FAILED ? nullptr : mem;
+}
+
+// Maps @size bytes aligned to the huge page size, so that the kernel can back
+// all of it with huge pages, and advises it.
+void* mapTransparent(size_t size) {
+  const size_t mapSize = size + kHugePageSize;
+  void* mem = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    return nullptr;
+  }
+  auto* start = static_cast<uint8_t*>(mem);
+  auto* aligned = reinterpret_cast<uint8_t*>(
+      getAlignedSize(reinterpret_cast<uintptr_t>(start), kHugePageSize));
+  // trim the unaligned head and the tail
+  if (aligned != start) {
+    munmap(start, aligned - start);
+  }
+  const size_t tail = (start + mapSize) - (aligned + size);
+  if (tail > 0) {
+    munmap(aligned + size, tail);
+  }
+  if (MADV_HUGEPAGE != 0 && madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+    XLOGF(DBG, "madvise(MADV_HUGEPAGE) failed: {}", std::strerror(errno));
+  }
+  return aligned;
+}
+} // namespace
+
+MetadataMemoryStats getMetadataMemoryStats() noexcept {
+  MetadataMemoryStats stats;
+  stats.regularBytes =
+      bytesFor(HugePageBacking::kRegular).load(std::memory_order_relaxed);
+  stats.transparentHugePageBytes =
+      bytesFor(HugePageBacking::kTransparent).load(std::memory_order_relaxed);
+  stats.hugeTlbBytes =
+      bytesFor(HugePageBacking::kHugeTlb).load(std::memory_order_relaxed);
+  return stats;
+}
+
+MetadataAllocation allocateMetadata(size_t numBytes,
+                                    size_t alignment,
+                                    HugePagePolicy policy) {
+  MetadataAllocation ret;
+  if (numBytes == 0) {
+    return ret;
+  }
+
+  if (policy != HugePagePolicy::kNone && numBytes >= kHugePageSize) {
+    const size_t size = getAlignedSize(numBytes, kHugePageSize);
+    if (policy == HugePagePolicy::kHugeTlb) {
+      ret.memory = mapHugeTlb(size);
+      ret.backing = HugePageBacking::kHugeTlb;
+      if (ret.memory == nullptr) {
+        XLOGF(INFO,
+              "Not enough hugetlbfs pages for {} bytes of metadata, falling "
+              "back to transparent huge pages",
+              size);
+      }
+    }
+    if (ret.memory == nullptr) {
+      ret.memory = mapTransparent(size);
+      ret.backing = HugePageBacking::kTransparent;
+    }
+    if (ret.memory != nullptr) {
+      ret.size = size;
+      bytesFor(ret.backing).fetch_add(size, std::memory_order_relaxed);
+      return ret;
+    }
+  }
+
+  // posix_memalign needs at least the alignment of a pointer
+  alignment = std::max(alignment, sizeof(void*));
+  if (posix_memalign(&ret.memory, alignment, numBytes) != 0) {
+    throw std::bad_alloc();
+  }
+  std::memset(ret.memory, 0, numBytes);
+  ret.size = numBytes;
+  ret.backing = HugePageBacking::kRegular;
+  bytesFor(ret.backing).fetch_add(numBytes, std::memory_order_relaxed);
+  return ret;
+}
+
+void freeMetadata(const MetadataAllocation& allocation) noexcept {
+  if (allocation.memory == nullptr) {
+    return;
+  }
+  bytesFor(allocation.backing)
+      .fetch_sub(allocation.size, std::memory_order_relaxed);
+  if (allocation.backing == HugePageBacking::kRegular) {
+    std::free(allocation.memory);
+  } else {
+    munmap(allocation.memory, allocation.size);
+  }
+}
+} // namespace facebook::cachelib::util
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace facebook::cachelib::util {
+// How large, randomly accessed metadata arrays (hash table buckets, the navy
+// index, bloom filters) are backed. A lookup in such an array usually misses
+// the TLB with 4KB pages, so backing them with 2MB pages saves a page walk
+// per access.
+enum class HugePagePolicy : uint8_t {
+  // regular heap allocation
+  kNone,
+  // anonymous mapping advised with MADV_HUGEPAGE, so that transparent huge
+  // pages are used when the system has them enabled in madvise mode or
+  // always
+  kTransparent,
+  // 2MB pages from the hugetlbfs pool. Falls back to kTransparent when the
+  // pool does not have enough pages reserved (vm.nr_hugepages).
+  kHugeTlb,
+};
+
+// What actually backs a metadata allocation.
+enum class HugePageBacking : uint8_t {
+  kRegular,
+  kTransparent,
+  kHugeTlb,
+};
+
+// Bytes of metadata allocated through allocateMetadata() in this process, by
+// backing.
+struct MetadataMemoryStats {
+  uint64_t regularBytes{0};
+  uint64_t transparentHugePageBytes{0};
+  uint64_t hugeTlbBytes{0};
+
+  uint64_t totalBytes() const noexcept {
+    return regularBytes + transparentHugePageBytes + hugeTlbBytes;
+  }
+};
+
+MetadataMemoryStats getMetadataMemoryStats() noexcept;
+
+// A block of zeroed memory returned by allocateMetadata().
+struct MetadataAllocation {
+  void* memory{nullptr};
+  // size of the block, rounded up to the huge page size when mapped
+  size_t size{0};
+  HugePageBacking backing{HugePageBacking::kRegular};
+};
+
+// Allocates @numBytes of zeroed memory aligned to at least @alignment (a
+// power of two no larger than the page size). Allocations smaller than a
+// huge page always use the heap since they would waste most of the page.
+//
+// @throw std::bad_alloc if no memory could be allocated
+MetadataAllocation allocateMetadata(size_t numBytes,
+                                    size_t alignment,
+                                    HugePagePolicy policy);
+
+// Releases memory returned by allocateMetadata().
+void freeMetadata(const MetadataAllocation& allocation) noexcept;
+
+// A fixed size array of value initialized T in memory from
+// allocateMetadata(). Owns its elements and is movable but not copyable.
+template <typename T>
+class MetadataArray {
+ public:
+  MetadataArray() = default;
+
+  MetadataArray(size_t size, HugePagePolicy policy)
+      : allocation_{allocateMetadata(size * sizeof(T), alignof(T), policy)},
+        size_{size} {
+    // the memory is zeroed, which is the value initialized state of trivial
+    // types
+    if constexpr (!std::is_trivially_default_constructible_v<T>) {
+      size_t i = 0;
+      try {
+        for (; i < size_; i++) {
+          new (data() + i) T();
+        }
+      } catch (...) {
+        destroy(i);
+        freeMetadata(allocation_);
+        throw;
+      }
+    }
+  }
+
+  MetadataArray(const MetadataArray&) = delete;
+  MetadataArray& operator=(const MetadataArray&) = delete;
+
+  MetadataArray(MetadataArray&& other) noexcept
+      : allocation_{std::exchange(other.allocation_, MetadataAllocation{})},
+        size_{std::exchange(other.size_, 0)} {}
+
+  MetadataArray& operator=(MetadataArray&& other) noexcept {
+    if (this != &other) {
+      reset();
+      allocation_ = std::exchange(other.allocation_, MetadataAllocation{});
+      size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+  }
+
+  ~MetadataArray() { reset(); }
+
+  T* data() const noexcept { return static_cast<T*>(allocation_.memory); }
+
+  T& operator[](size_t i) const noexcept { return data()[i]; }
+
+  size_t size() const noexcept { return size_; }
+
+  explicit operator bool() const noexcept { return data() != nullptr; }
+
+  HugePageBacking backing() const noexcept { return allocation_.backing; }
+
+ private:
+  void destroy(size_t n) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      for (size_t i = 0; i < n; i++) {
+        data()[i].~T();
+      }
+    }
+  }
+
+  void reset() noexcept {
+    if (allocation_.memory != nullptr) {
+      destroy(size_);
+      freeMetadata(allocation_);
+      allocation_ = MetadataAllocation{};
+      size_ = 0;
+    }
+  }
+
+  MetadataAllocation allocation_{};
+  size_t size_{0};
+};
+} // namespace facebook::cachelib::util
@@ -381,6 +381,33 @@ class RWBucketLocks : public BaseBucketLocks<LockType, LockAlignmentType> {
             ? WriteLockHolder(Base::getLock(args...))
             : WriteLockHolder(Base::getLock(args...), timeout);
   }
+
+  // grab the writer locks for two keys, each for a limited _timeout_
+  // duration. The locks are always acquired in the same global order, so
+  // callers holding two locks at once can't deadlock each other.
+  // Returns the holders for key1 and key2, in that order. If both keys map
+  // to the same lock, the second holder is empty. If either lock times out,
+  // both holders are empty.
+  template <typename T>
+  std::pair<WriteLockHolder, WriteLockHolder> lockExclusivePair(
+      const std::chrono::microseconds& timeout, T key1, T key2) {
+    Lock& l1 = Base::getLock(key1);
+    Lock& l2 = Base::getLock(key2);
+    if (&l1 == &l2) {
+      return {lockExclusive(timeout, key1), WriteLockHolder{}};
+    }
+    const bool firstIsLower = std::less<Lock*>{}(&l1, &l2);
+    auto lower = lockExclusive(timeout, firstIsLower ? key1 : key2);
+    if (!lower.owns_lock()) {
+      return {};
+    }
+    auto higher = lockExclusive(timeout, firstIsLower ? key2 : key1);
+    if (!higher.owns_lock()) {
+      return {};
+    }
+    return firstIsLower ? std::make_pair(std::move(lower), std::move(higher))
+                        : std::make_pair(std::move(higher), std::move(lower));
+  }
 };
 
 using SharedMutexBuckets = RWBucketLocks<folly::SharedMutex>;
@@ -17,6 +17,9 @@
 #include <folly/Random.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <thread>
+
 #include "cachelib/common/AccessTracker.h"
 
 namespace facebook {
@@ -185,5 +188,151 @@ TEST_P(AccessTrackerTest, separateAccessTrackingAndPopulate) {
   assertVecEq(tracker.getAccesses(key), {1, 5, 0});
 }
 
+TEST_P(AccessTrackerTest, populateIntoSpan) {
+  auto config = AccessTracker::Config();
+  config.numBuckets = 3;
+  config.useCounts = GetParam();
+  config.numTicksPerBucket = 2;
+  config.ticker = ticker_;
+  initializeTicks(
+      config.numTicksPerBucket, config.numBuckets, config.numTicksPerBucket);
+  auto tracker = AccessTracker(std::move(config));
+
+  folly::StringPiece key = "key0";
+  std::vector<double> features(3);
+  tracker.recordAndPopulateAccessFeatures(key, folly::range(features));
+  assertVecEq(features, {0, 0, 0});
+  tracker.recordAndPopulateAccessFeatures(key, folly::range(features));
+  assertVecEq(features, {1, 0, 0});
+  tracker.getAccesses(key, folly::range(features));
+  assertVecEq(features, {2, 0, 0});
+
+  std::vector<double> tooShort(2);
+  ASSERT_THROW(tracker.getAccesses(key, folly::range(tooShort)),
+               std::invalid_argument);
+}
+
+// Buckets of spans without any access are not rotated in. Their stale counts
+// must not show up.
+TEST_P(AccessTrackerTest, skippedBuckets) {
+  auto config = AccessTracker::Config();
+  config.numBuckets = 3;
+  config.useCounts = GetParam();
+  config.numTicksPerBucket = 1;
+  config.ticker = ticker_;
+  initializeTicks(
+      config.numTicksPerBucket, config.numBuckets, config.numTicksPerBucket);
+  auto tracker = AccessTracker(std::move(config));
+
+  folly::StringPiece key = "key0";
+  tracker.recordAccess(key);
+  advanceTicks();
+  tracker.recordAccess(key);
+  tracker.recordAccess(key);
+  assertVecEq(tracker.getAccesses(key), {2, 1, 0});
+  ASSERT_EQ(std::vector<uint64_t>({2, 1, 0}), tracker.getRotatedAccessCounts());
+
+  // skip a span. The current bucket still holds the counts from three spans
+  // ago.
+  advanceTicks();
+  advanceTicks();
+  assertVecEq(tracker.getAccesses(key), {0, 0, 2});
+  ASSERT_EQ(std::vector<uint64_t>({0, 0, 2}), tracker.getRotatedAccessCounts());
+
+  // skip more spans than there are buckets
+  for (int i = 0; i < 5; i++) {
+    advanceTicks();
+  }
+  assertVecEq(tracker.getAccesses(key), {0, 0, 0});
+  tracker.recordAccess(key);
+  assertVecEq(tracker.getAccesses(key), {1, 0, 0});
+}
+
+TEST(AccessTracker, SaturatingCounts) {
+  auto config = AccessTracker::Config();
+  config.numBuckets = 2;
+  config.ticker = std::make_shared<detail::NumberTicker>();
+  auto tracker = AccessTracker(std::move(config));
+  auto config32 = AccessTracker32::Config();
+  config32.numBuckets = 2;
+  config32.ticker = std::make_shared<detail::NumberTicker>();
+  auto tracker32 = AccessTracker32(std::move(config32));
+
+  folly::StringPiece key = "key0";
+  for (int i = 0; i < 300; i++) {
+    tracker.recordAccess(key);
+    tracker32.recordAccess(key);
+  }
+  ASSERT_EQ(std::numeric_limits<uint8_t>::max(), tracker.getAccesses(key)[0]);
+  ASSERT_EQ(300, tracker32.getAccesses(key)[0]);
+  ASSERT_EQ(tracker32.getByteSize(), 4 * tracker.getByteSize());
+}
+
+TEST(AccessTracker, ConcurrentAccesses) {
+  auto config = AccessTracker16::Config();
+  config.numBuckets = 4;
+  config.ticker = std::make_shared<detail::NumberTicker>();
+  auto tracker = AccessTracker16(std::move(config));
+  // rotate the bucket in before the threads race on it
+  tracker.recordAccess("key");
+
+  constexpr int kThreads = 8;
+  constexpr int kAccesses = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&tracker]() {
+      std::array<double, 4> features;
+      for (int i = 0; i < kAccesses; i++) {
+        tracker.recordAndPopulateAccessFeatures("key",
+                                                folly::range(features));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(kThreads * kAccesses + 1, tracker.getAccesses("key")[0]);
+  ASSERT_EQ(kThreads * kAccesses + 1, tracker.getRotatedAccessCounts()[0]);
+}
+
+TEST(AccessTracker, ConcurrentRotation) {
+  auto ticker = std::make_shared<detail::NumberTicker>();
+  auto config = AccessTracker16::Config();
+  config.numBuckets = 2;
+  config.numTicksPerBucket = 1;
+  config.ticker = ticker;
+  auto tracker = AccessTracker16(std::move(config));
+
+  // fill the bucket that epoch 2 rotates into
+  constexpr int kStaleAccesses = 1000;
+  for (int i = 0; i < kStaleAccesses; i++) {
+    tracker.recordAccess("key");
+  }
+  ticker->setTicks(2);
+
+  // the threads race on resetting the bucket. None of them may see the
+  // stale counts of epoch 0 while it is being reset.
+  constexpr int kThreads = 8;
+  constexpr int kAccesses = 100;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&]() {
+      std::array<double, 2> features;
+      for (int i = 0; i < kAccesses; i++) {
+        tracker.recordAndPopulateAccessFeatures("key",
+                                                folly::range(features));
+        EXPECT_GT(kThreads * kAccesses, features[0]);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  // accesses racing with the reset are dropped
+  ASSERT_GE(kThreads * kAccesses, tracker.getAccesses("key")[0]);
+  ASSERT_GE(kThreads * kAccesses, tracker.getRotatedAccessCounts()[0]);
+  ASSERT_EQ(0, tracker.getRotatedAccessCounts()[1]);
+}
+
 } // namespace cachelib
 } // namespace facebook
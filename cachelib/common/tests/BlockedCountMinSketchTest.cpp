@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Random.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "cachelib/common/BlockedCountMinSketch.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+using facebook::cachelib::util::BlockedCountMinSketch;
+
+namespace {
+uint32_t sanitizeCt(uint32_t ct, const BlockedCountMinSketch& cms) {
+  return std::min<uint32_t>(ct, cms.getMaxCount());
+}
+} // namespace
+
+TEST(BlockedCountMinSketchTest, Simple) {
+  BlockedCountMinSketch cms{100};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  for (uint32_t i = 0; i < 20; i++) {
+    keys.push_back(rg());
+    for (uint32_t j = 0; j < i; j++) {
+      cms.increment(keys[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    EXPECT_GE(cms.getCount(keys[i]), sanitizeCt(i, cms));
+  }
+}
+
+TEST(BlockedCountMinSketchTest, Size) {
+  // 4 bits for each of the kDepth counters, rounded up to a power of two
+  // number of 64 byte blocks.
+  BlockedCountMinSketch cms{1000};
+  EXPECT_EQ(32, cms.numBlocks());
+  EXPECT_EQ(32 * 64, cms.getByteSize());
+
+  BlockedCountMinSketch small{1};
+  EXPECT_EQ(1, small.numBlocks());
+}
+
+TEST(BlockedCountMinSketchTest, Reset) {
+  BlockedCountMinSketch cms{100};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  for (uint32_t i = 0; i < 10; i++) {
+    keys.push_back(rg());
+    cms.increment(keys[i]);
+  }
+
+  cms.reset();
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(0, cms.getCount(keys[i]));
+  }
+}
+
+TEST(BlockedCountMinSketchTest, Collisions) {
+  // 8 blocks hold 256 counters per hash.
+  BlockedCountMinSketch cms{256};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  uint32_t overcount{0};
+  for (uint32_t i = 0; i < 100; i++) {
+    keys.push_back(rg());
+    for (uint32_t j = 0; j < i % 8; j++) {
+      cms.increment(keys[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    // never undercounts
+    EXPECT_GE(cms.getCount(keys[i]), i % 8);
+    overcount += cms.getCount(keys[i]) - i % 8;
+  }
+  // the keys share blocks, but the min over the hashes keeps the total error
+  // well below one per key
+  EXPECT_LT(overcount, keys.size() / 4);
+}
+
+TEST(BlockedCountMinSketchTest, InvalidArgs) {
+  EXPECT_THROW(BlockedCountMinSketch(0), std::invalid_argument);
+}
+
+// ensure all the apis return menaningful results on a default constructed
+// empty object.
+TEST(BlockedCountMinSketchTest, Default) {
+  BlockedCountMinSketch cms{};
+  uint64_t key = folly::Random::rand32();
+  EXPECT_EQ(cms.getCount(key), 0);
+  EXPECT_NO_THROW(cms.increment(key));
+  EXPECT_EQ(cms.getCount(key), 0);
+  EXPECT_EQ(0, cms.getByteSize());
+  cms.halveCounts();
+  cms.reset();
+  EXPECT_EQ(0, cms.getCount(key));
+}
+
+TEST(BlockedCountMinSketchTest, Move) {
+  BlockedCountMinSketch cms{40};
+  uint64_t key = folly::Random::rand32();
+  for (int i = 0; i < 10; i++) {
+    cms.increment(key);
+  }
+  EXPECT_EQ(10, cms.getCount(key));
+
+  auto cms2 = std::move(cms);
+  EXPECT_EQ(10, cms2.getCount(key));
+  EXPECT_EQ(0, cms.getCount(key));
+}
+
+TEST(BlockedCountMinSketchTest, HalveCounts) {
+  BlockedCountMinSketch cms{1000};
+  std::mt19937_64 rg{1};
+  std::vector<uint64_t> keys;
+  // key i is incremented i times.
+  for (uint32_t i = 0; i < 40; i++) {
+    keys.push_back(rg());
+    for (uint32_t j = 0; j < i; j++) {
+      cms.increment(keys[i]);
+    }
+  }
+
+  cms.halveCounts();
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    EXPECT_GE(cms.getCount(keys[i]), sanitizeCt(i, cms) / 2);
+    // halving does not leak bits into the neighbouring counters
+    EXPECT_LE(cms.getCount(keys[i]), cms.getMaxCount() / 2);
+  }
+}
+
+// Make sure the counters saturate instead of wrapping into their neighbours.
+TEST(BlockedCountMinSketchTest, Overflow) {
+  BlockedCountMinSketch cms{10};
+  uint64_t key = folly::Random::rand32();
+  for (uint32_t i = 0; i < 100; i++) {
+    cms.increment(key);
+  }
+  EXPECT_EQ(cms.getMaxCount(), cms.getCount(key));
+
+  cms.halveCounts();
+  EXPECT_EQ(cms.getMaxCount() / 2, cms.getCount(key));
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
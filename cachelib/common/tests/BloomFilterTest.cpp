@@ -101,6 +101,24 @@ TEST(BloomFilter, Move) {
   }
 }
 
+TEST(BloomFilter, HugePages) {
+  // 4MB of bits, large enough to be mapped with huge pages
+  const auto before = util::getMetadataMemoryStats();
+  {
+    BloomFilter bf{1024 * 1024, 4, 8, util::HugePagePolicy::kTransparent};
+    EXPECT_EQ(4 * 1024 * 1024, bf.getByteSize());
+    EXPECT_EQ(before.transparentHugePageBytes + bf.getByteSize(),
+              util::getMetadataMemoryStats().transparentHugePageBytes);
+
+    for (uint64_t key = 0; key < 1000; key++) {
+      EXPECT_FALSE(bf.couldExist(key % 1024, key));
+      bf.set(key % 1024, key);
+      EXPECT_TRUE(bf.couldExist(key % 1024, key));
+    }
+  }
+  EXPECT_EQ(before.totalBytes(), util::getMetadataMemoryStats().totalBytes());
+}
+
 TEST(BloomFilter, Reset) {
   BloomFilter bf{4, 2, 4};
   EXPECT_EQ(4, bf.getByteSize());
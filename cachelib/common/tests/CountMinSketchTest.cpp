@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <random>
+#include <thread>
 
 #include "cachelib/common/CountMinSketch.h"
 
@@ -218,6 +219,39 @@ TYPED_TEST(CountMinSketchTest, DecayCounts) { this->testDefault(); }
 // Make sure we don't crash when the count overflows.
 TYPED_TEST(CountMinSketchTest, Overflow) { this->testOverflow(); }
 
+TEST(AtomicCountMinSketchTest, ConcurrentIncrements) {
+  util::AtomicCountMinSketch16 cms{1000, 4};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&cms]() {
+      for (int i = 0; i < 1000; i++) {
+        cms.increment(5);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(8000, cms.getCount(5));
+  EXPECT_EQ(0, cms.getCount(6));
+
+  cms.reset();
+  EXPECT_EQ(0, cms.getCount(5));
+}
+
+TEST(AtomicCountMinSketchTest, Saturates) {
+  util::AtomicCountMinSketch8 cms{100, 3};
+  for (int i = 0; i < 300; i++) {
+    cms.increment(1);
+  }
+  EXPECT_EQ(cms.getMaxCount(), cms.getCount(1));
+  EXPECT_EQ(300, cms.getByteSize());
+
+  auto moved = std::move(cms);
+  EXPECT_EQ(moved.getMaxCount(), moved.getCount(1));
+  EXPECT_EQ(0, cms.getByteSize());
+}
+
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "cachelib/common/HugePageAllocator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+using namespace facebook::cachelib::util;
+
+namespace {
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+bool isZeroed(const void* mem, size_t size) {
+  const auto* p = static_cast<const uint8_t*>(mem);
+  return std::all_of(p, p + size, [](uint8_t b) { return b == 0; });
+}
+
+// counts live instances to check that MetadataArray constructs and destroys
+// its elements
+struct Counted {
+  static inline int live{0};
+  uint32_t value{7};
+  Counted() { live++; }
+  ~Counted() { live--; }
+};
+} // namespace
+
+TEST(HugePageAllocatorTest, SmallAllocationsUseTheHeap) {
+  for (auto policy : {HugePagePolicy::kNone, HugePagePolicy::kTransparent,
+                      HugePagePolicy::kHugeTlb}) {
+    const auto before = getMetadataMemoryStats();
+    auto a = allocateMetadata(4096, 64, policy);
+    ASSERT_NE(nullptr, a.memory);
+    EXPECT_EQ(HugePageBacking::kRegular, a.backing);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a.memory) % 64);
+    EXPECT_TRUE(isZeroed(a.memory, 4096));
+    EXPECT_EQ(before.regularBytes + 4096,
+              getMetadataMemoryStats().regularBytes);
+    freeMetadata(a);
+    EXPECT_EQ(before.regularBytes, getMetadataMemoryStats().regularBytes);
+  }
+
+  auto empty = allocateMetadata(0, 8, HugePagePolicy::kTransparent);
+  EXPECT_EQ(nullptr, empty.memory);
+  freeMetadata(empty);
+}
+
+TEST(HugePageAllocatorTest, TransparentHugePages) {
+  const auto before = getMetadataMemoryStats();
+  const size_t size = 3 * kHugePageSize + 100;
+  auto a = allocateMetadata(size, 8, HugePagePolicy::kTransparent);
+  ASSERT_NE(nullptr, a.memory);
+  EXPECT_EQ(HugePageBacking::kTransparent, a.backing);
+  // aligned and rounded up to huge pages
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a.memory) % kHugePageSize);
+  EXPECT_EQ(4 * kHugePageSize, a.size);
+  EXPECT_TRUE(isZeroed(a.memory, size));
+  std::fill_n(static_cast<uint8_t*>(a.memory), a.size, 0xff);
+  EXPECT_EQ(before.transparentHugePageBytes + a.size,
+            getMetadataMemoryStats().transparentHugePageBytes);
+  freeMetadata(a);
+  EXPECT_EQ(before.totalBytes(), getMetadataMemoryStats().totalBytes());
+}
+
+TEST(HugePageAllocatorTest, HugeTlbFallsBack) {
+  // the test host may not have hugetlbfs pages reserved, in which case the
+  // memory comes from transparent huge pages.
+  auto a = allocateMetadata(kHugePageSize, 8, HugePagePolicy::kHugeTlb);
+  ASSERT_NE(nullptr, a.memory);
+  EXPECT_NE(HugePageBacking::kRegular, a.backing);
+  EXPECT_EQ(kHugePageSize, a.size);
+  EXPECT_TRUE(isZeroed(a.memory, a.size));
+  freeMetadata(a);
+}
+
+TEST(HugePageAllocatorTest, Array) {
+  {
+    MetadataArray<uint64_t> arr{kHugePageSize, HugePagePolicy::kTransparent};
+    ASSERT_TRUE(arr);
+    EXPECT_EQ(kHugePageSize, arr.size());
+    EXPECT_EQ(HugePageBacking::kTransparent, arr.backing());
+    EXPECT_EQ(0, arr[0]);
+    EXPECT_EQ(0, arr[kHugePageSize - 1]);
+    arr[10] = 10;
+
+    auto moved = std::move(arr);
+    EXPECT_FALSE(arr);
+    EXPECT_EQ(0, arr.size());
+    EXPECT_EQ(10, moved[10]);
+  }
+
+  {
+    MetadataArray<Counted> arr{1000, HugePagePolicy::kNone};
+    EXPECT_EQ(1000, Counted::live);
+    EXPECT_EQ(7, arr[999].value);
+
+    MetadataArray<Counted> other;
+    EXPECT_FALSE(other);
+    other = std::move(arr);
+    EXPECT_EQ(1000, Counted::live);
+  }
+  EXPECT_EQ(0, Counted::live);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -43,6 +43,8 @@
 #include <folly/SharedMutex.h>
 #include <folly/logging/xlog.h>
 
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <typeinfo>
 
@@ -86,8 +88,6 @@ enum class CCacheReturn : int {
   FOUND = 1
 };
 
-enum class RehashOperation { COPY, DELETE };
-
 /**
  * Interface for a compact cache. User should not need to directly reference
  * this type. Instead, use CCacheCreator<...>::type as the Compact Cache type.
@@ -193,20 +193,26 @@ class CompactCache : public ICompactCache {
   ~CompactCache();
 
   /**
-   * Resize the arena of this compact cache.
-   * Shrinking the cache:
-   *  (1) Reduce num_chunks, so new requests only hash to the reduced size
-   *  (2) If currently taking requests, wait for all requests that picked up
-   *      the old num_chunk value to drain out. During this time some requests
-   *      will use the old and others will use the new num_chunk value, which
-   *      is ok because we're using a consistent hash.
-   *  (3) Walk the table and free the entries in the chunks we're not using.
-   *  (4) Free no longer used chunks.
-   * Growing the cache:
-   *  (1) Allocate new chunks
-   *  (2) Update num_chunks, wait for refcount on old value to hit 0
-   *  (3) Walk all the entries in the old table size and see which ones would
-   *      now hash to new chunks and move them.
+   * Resize the arena of this compact cache. This is called from the pool
+   * resizer's background thread and migrates entries incrementally while
+   * requests keep being served:
+   *  (1) When growing, allocate the new chunks.
+   *  (2) Switch to the new number of chunks while remembering the previous
+   *      one. From here on, requests for a key whose chunk changed also look
+   *      at its previous bucket until that bucket has been migrated. Reads
+   *      check the previous bucket first, writes move the key to its new
+   *      bucket before applying the change.
+   *  (3) Wait for requests that started before the switch to drain out.
+   *      Those that lock their bucket after the switch retry with the new
+   *      number of chunks.
+   *  (4) Walk the previous table chunk by chunk, a small batch of buckets at
+   *      a time, and move the entries that hash to a different chunk. Each
+   *      bucket is only locked while its own entries are moved.
+   *  (5) Forget the previous number of chunks, wait for the requests that
+   *      might still look at it and, when shrinking, free the unused chunks.
+   *
+   * A request never takes more than two bucket locks and never waits for
+   * the migration to finish.
    */
   void resize() override;
 
@@ -372,10 +378,9 @@ class CompactCache : public ICompactCache {
   bool forEachBucket(const BucketCallBack& cb);
 
   /** Move or purge entries that would change which chunk they hash to
-   * based on the specified old and new numbers of chunks. */
-  void tableRehash(size_t oldNumChunks,
-                   size_t newNumChunks,
-                   RehashOperation op);
+   * based on the specified old and new numbers of chunks. Chunks are
+   * marked as migrated as the walk progresses. */
+  void tableRehash(size_t oldNumChunks, size_t newNumChunks);
 
   /** return the current snapshot of all stats */
   CCacheStats getStats() const override { return stats_.getSnapshot(); }
@@ -386,7 +391,8 @@ class CompactCache : public ICompactCache {
    * The following operations are performed:
    *   1) Check if the cache should miss due to an ongoing purge.
    *   2) Increase the refcount on the current cohort;
-   *   3) Find the hash table bucket for the key;
+   *   3) Find the hash table bucket for the key, and its previous bucket if
+   *      a resize is migrating it;
    *   4) Lock the bucket;
    *   5) Call the request handler;
    *   6) Unlock the bucket;
@@ -410,6 +416,45 @@ class CompactCache : public ICompactCache {
                    Fn f,
                    Args... args);
 
+  /**
+   * Lock a single bucket and execute the request handler f on it. Reads take
+   * a shared lock and upgrade to an exclusive lock if the entry needs to be
+   * promoted.
+   *
+   * @param numChunks number of chunks the bucket was picked with.
+   *
+   * @return 0 on a miss, 1 on a hit, -2 on timeout, -1 on other error,
+   *         kMappingChanged if the number of chunks changed before the
+   *         bucket was locked
+   */
+  template <typename Fn, typename... Args>
+  int callBucketFnOn(size_t numChunks,
+                     Bucket* bucket,
+                     const Key& key,
+                     Operation op,
+                     const std::chrono::microseconds& timeout,
+                     Fn f,
+                     Args... args);
+
+  /** callBucketFnOn() picked its bucket with a stale number of chunks */
+  static constexpr int kMappingChanged = -3;
+
+  /**
+   * Move the entry for key, if any, from its bucket under the previous
+   * number of chunks to its current bucket. Used by writes during a resize
+   * so that they only have to be applied to the current bucket.
+   *
+   * @return false if locking either bucket timed out
+   */
+  bool migrateKey(Bucket* prevBucket,
+                  Bucket* bucket,
+                  const Key& key,
+                  const std::chrono::microseconds& timeout);
+
+  /** Insert a copy of entry into bucket. Must be called under the locks of
+   * both buckets. */
+  void copyEntry(Bucket* bucket, EntryHandle& entry);
+
   /** Free chunks whose index is between chunk_index_low, inclusive, and
    * chunk_index_high, exclusive. Used which shrinking the cache. */
   int tableChunksFree(size_t chunkIndexLow, size_t chunkIndexHigh);
@@ -427,6 +472,10 @@ class CompactCache : public ICompactCache {
    * @return pointer to the first bucket of the desired chunk.
    */
   Bucket* tableFindChunk(size_t numChunks, const Key& key);
+  size_t tableFindChunkIndex(size_t numChunks, const Key& key) const;
+
+  /** Offset of the key's bucket within its chunk. */
+  size_t bucketOffset(const Key& key) const;
 
   /**
    * Find out which bucket an entry might be in. Do this in a 2 step process:
@@ -442,12 +491,20 @@ class CompactCache : public ICompactCache {
    * either still to the 15th bucket of chunk 3, or to the 15th bucket of
    * chunk 10.
    *
+   * @param numChunks number of chunks loaded by the caller.
    * @param const Key& key for which to determine the corresponding bucket.
    *
    * @return bucket that maps to the key.
    */
-  Bucket* tableFindBucket(const Key& key);
-  Bucket* tableFindDblWriteBucket(const Key& key);
+  Bucket* tableFindBucket(size_t numChunks, const Key& key);
+
+  /**
+   * Find the bucket the key mapped to before the resize in progress.
+   *
+   * @return nullptr if no resize is in progress, the key stays in the same
+   *         chunk or its previous chunk has already been migrated.
+   */
+  Bucket* tableFindPrevBucket(size_t numChunks, const Key& key);
 
   /**
    * Callback called by the bucket descriptor when an entry is evicted.
@@ -550,17 +607,23 @@ class CompactCache : public ICompactCache {
   RemoveCb removeCb_;
   ReplaceCb replaceCb_;
   ValidCb validCb_;
-  facebook::cachelib::Cohort cohort_;     /**< resize cohort synchronization */
   mutable folly::SharedMutex resizeLock_; /**< Lock to synchronize resize. */
   const size_t bucketsPerChunk_;
   util::FastStats<CCacheStats> stats_;
   const bool allowPromotions_; /**< Whether promotions are allowed on read
                                     operations */
 
+  /** number of buckets migrated between yielding the cpu during a resize */
+  static constexpr size_t kRehashBatchBuckets = 64;
+
  protected:
-  // expose these two fields for test hack
+  // expose these fields for test hack
   std::atomic<size_t> numChunks_;
-  std::atomic<size_t> pendingNumChunks_;
+  // number of chunks before the resize in progress. 0 if none is in progress
+  std::atomic<size_t> prevNumChunks_;
+  // chunks of the previous table whose entries have already been migrated
+  std::atomic<size_t> migratedChunks_;
+  facebook::cachelib::Cohort cohort_; /**< resize cohort synchronization */
 };
 
 namespace detail {
@@ -670,7 +733,8 @@ CompactCache<C, A, B>::CompactCache(Allocator& allocator,
       stats_{},
       allowPromotions_(allowPromotions),
       numChunks_(allocator_.getNumChunks()),
-      pendingNumChunks_(0) {
+      prevNumChunks_(0),
+      migratedChunks_(0) {
   allocator_.attach(this);
 }
 
@@ -685,13 +749,10 @@ CompactCache<C, A, B>::~CompactCache() {
  *
  * @param oldNumChunks  old size of compact cache
  * @param newNumChunks  new size of compact cache
- * @param op            whether to create new entries COPY or delete
- *                      old ones DELETE in this call
  */
 template <typename C, typename A, typename B>
 void CompactCache<C, A, B>::tableRehash(size_t oldNumChunks,
-                                        size_t newNumChunks,
-                                        RehashOperation op) {
+                                        size_t newNumChunks) {
   XDCHECK_LE(newNumChunks, allocator_.getNumChunks());
   XDCHECK_GT(newNumChunks, 0u);
   XDCHECK_GT(oldNumChunks, 0u);
@@ -700,6 +761,12 @@ void CompactCache<C, A, B>::tableRehash(size_t oldNumChunks,
   for (size_t n = 0; n < oldNumChunks; n++) {
     Bucket* table_chunk = reinterpret_cast<Bucket*>(allocator_.getChunk(n));
     for (size_t i = 0; i < bucketsPerChunk_; i++) {
+      /* Give the cpu back to requests between batches. Buckets are locked
+       * one at a time, so requests only ever wait for a single bucket. */
+      if (i > 0 && i % kRehashBatchBuckets == 0) {
+        std::this_thread::yield();
+      }
+
       Bucket* bucket = &table_chunk[i];
       auto lock = locks_.lockExclusive(bucket);
 
@@ -730,59 +797,68 @@ void CompactCache<C, A, B>::tableRehash(size_t oldNumChunks,
          * a small initial fraction of the newly lost buckets to their
          * new home, putting them at the head of the LRU.
          *
-         * This occurs in two stages; first we insert the to-be-moved
-         * entries into their new home and call the removal callbacks
-         * for invalid or excess ones.
-         *
-         * Second, after reads have moved, we delete the old entries
-         * This is done in a new cohort to ensure reads never see
-         * a temporarily disappeared entry in cache.
+         * The entry is inserted into its new home before it is deleted
+         * from the old one while holding both locks. Requests check the
+         * old bucket before the new one, so they never see a temporarily
+         * disappeared entry.
          */
-        if (op == RehashOperation::COPY) {
-          if (valid_entry && moved < max_move) {
-            /* Add new entry. Offset is the same, so no need to
-             * re-compute that hash
-             */
-            Bucket* newBucket = &new_chunk[i];
-            // lock ordering is established by the hash function;
-            // old hash -> new hash
-            // However there can be arbitrary hash collisions, so
-            // don't relock the same lock (we don't use recursive
-            // locks in general)
-            bool sameLock = locks_.isSameLock(newBucket, bucket);
-            auto higher_lock //
-                = sameLock   //
-                      ? std::unique_lock<folly::SharedMutex>()
-                      : locks_.lockExclusive(newBucket);
-            if (kHasValues) {
-              if (kValuesFixedSize) {
-                bucketSet(newBucket, entry.key(), entry.val());
-              } else {
-                bucketSet(newBucket, entry.key(), entry.val(), entry.size());
-              }
-            } else {
-              bucketSet(newBucket, entry.key());
-            }
-            moved++;
-          } else {
-            // not moving this one, either invalid or we're full
-            // call evict (or delete if invalid) callback
-            if (removeCb_) {
-              detail::callRemoveCb<SelfType>(
-                  removeCb_, entry.key(), entry.val(), remove_context);
+        if (valid_entry && moved < max_move) {
+          /* Offset is the same, so no need to re-compute that hash */
+          Bucket* newBucket = &new_chunk[i];
+          // Lock stripes are picked by hashing the bucket address, so
+          // there is no fixed order between the old and the new bucket.
+          // Don't wait for the new bucket while holding the old one;
+          // requests migrating a key take both in stripe order instead.
+          // There can also be arbitrary hash collisions, so don't relock
+          // the same lock (we don't use recursive locks in general)
+          bool sameLock = locks_.isSameLock(newBucket, bucket);
+          auto higher_lock //
+              = sameLock   //
+                    ? std::unique_lock<folly::SharedMutex>()
+                    : locks_.tryLockExclusive(newBucket);
+          if (!sameLock && !higher_lock.owns_lock()) {
+            const Key key = entry.key();
+            lock.unlock();
+            std::tie(lock, higher_lock) = locks_.lockExclusivePair(
+                std::chrono::microseconds::zero(), bucket, newBucket);
+            // a request may have moved or deleted the entry meanwhile
+            entry = bucketFind(bucket, key);
+            if (!entry) {
+              entry = BucketDescriptor::first(bucket);
+              continue;
             }
           }
-          entry.next();
+          // a write during the resize already put a newer version there
+          if (!bucketFind(newBucket, entry.key())) {
+            copyEntry(newBucket, entry);
+          }
+          moved++;
         } else {
-          // on the second pass we run the deletes, to avoid
-          // read requests seeing no data in the interim
-          // actually delete here
-          BucketDescriptor::del(entry);
-          // no entry.next() call as del advances ptr
+          // not moving this one, either invalid or we're full
+          // call evict (or delete if invalid) callback
+          if (removeCb_) {
+            detail::callRemoveCb<SelfType>(
+                removeCb_, entry.key(), entry.val(), remove_context);
+          }
         }
+        // no entry.next() call as del advances ptr
+        BucketDescriptor::del(entry);
       }
-      XDCHECK(newNumChunks <= oldNumChunks || !entry);
     }
+    migratedChunks_ = n + 1;
+  }
+}
+
+template <typename C, typename A, typename B>
+void CompactCache<C, A, B>::copyEntry(Bucket* bucket, EntryHandle& entry) {
+  if (kHasValues) {
+    if (kValuesFixedSize) {
+      bucketSet(bucket, entry.key(), entry.val());
+    } else {
+      bucketSet(bucket, entry.key(), entry.val(), entry.size());
+    }
+  } else {
+    bucketSet(bucket, entry.key());
   }
 }
 
@@ -817,37 +893,33 @@ void CompactCache<C, A, B>::resize() {
     }
   }
 
-  /* Update the number of chunks so new write requests start hitting both
-   * old and new chunks */
   XDCHECK_NE(newNumChunks, oldNumChunks);
-  XDCHECK_EQ(pendingNumChunks_.load(), 0u);
+  XDCHECK_EQ(prevNumChunks_.load(), 0u);
   /* only bother resharding if not going from/to 0 size */
   if (newNumChunks > 0 && oldNumChunks > 0) {
-    pendingNumChunks_ = newNumChunks;
-    /* Ensure all writes are double writing now */
-    cohort_.switchCohorts();
-
-    /* Sweep through the table and find all buckets that should now rehash.
-     * In offline mode, move entries; online we just delete
-     * to avoid invalidate races
-     */
-    tableRehash(oldNumChunks, newNumChunks, RehashOperation::COPY);
-
-    // now that rehash happened, we can start reading from the new location
-    // don't yet stop double writes as that ordering (no double write, read
-    // from old location) may not be guaranteed
-    // It likely is fine as those are ordered by a lock which should order
-    // the loads of the num_chunks value properly
+    /* Publish the previous number of chunks before the new one, so that a
+     * request that sees the new value also finds the previous bucket of a
+     * key that has not been migrated yet. */
+    migratedChunks_ = 0;
+    prevNumChunks_ = oldNumChunks;
     numChunks_ = newNumChunks;
-    cohort_.switchCohorts();
 
-    // now stop double writes and wait for all requests to complete
-    // so that the old chunk locations are totally unused
-    pendingNumChunks_ = 0;
+    /* Requests that picked their bucket with the old number of chunks
+     * notice the switch under the bucket lock and start over, so none of
+     * them applies a change behind a key that was already moved by a
+     * request using the new number. Let them drain before walking the
+     * table. This only blocks the resizing thread. */
     cohort_.switchCohorts();
 
-    // now go through again and delete stale entries in the old location
-    tableRehash(oldNumChunks, newNumChunks, RehashOperation::DELETE);
+    /* Move entries in small batches while requests are served from both
+     * the previous and the new locations. */
+    tableRehash(oldNumChunks, newNumChunks);
+
+    /* Everything is at its new location. Stop looking at the previous
+     * buckets and wait for the requests that might still do so, so that
+     * the old chunks are totally unused. */
+    prevNumChunks_ = 0;
+    cohort_.switchCohorts();
   } else {
     numChunks_ = newNumChunks;
 
@@ -963,10 +1035,59 @@ int CompactCache<C, A, B>::callBucketFn(
   /* 1) Increase the refcount of the current cohort. */
   Cohort::Token tok = cohort_.incrActiveReqs();
 
-  /* 2) Find the hash table bucket for the key. */
-  Bucket* bucket = tableFindBucket(key);
+  for (;;) {
+    /* 2) Find the hash table bucket for the key. The number of chunks is
+     * loaded before the previous number of chunks, which is published
+     * first by resize(). */
+    const size_t numChunks = numChunks_;
+    if (numChunks == 0) {
+      return -1;
+    }
+    Bucket* bucket = tableFindBucket(numChunks, key);
+    Bucket* prevBucket = tableFindPrevBucket(numChunks, key);
+
+    /* 3) While a resize is migrating the key's previous bucket, reads look
+     * there first. Migration copies an entry to its new bucket before
+     * deleting it from the previous one, so checking in this order never
+     * misses an entry that is being moved. Writes move the key to its new
+     * bucket first so that they only need to be applied there. */
+    int rv;
+    if (prevBucket != nullptr) {
+      if (op == Operation::READ) {
+        rv = callBucketFnOn(
+            numChunks, prevBucket, key, op, timeout, f, args...);
+        if (rv == kMappingChanged) {
+          continue;
+        }
+        if (rv != toInt(BucketReturn::NOTFOUND)) {
+          return rv;
+        }
+      } else if (!migrateKey(prevBucket, bucket, key, timeout)) {
+        return -2;
+      }
+    }
+
+    /* 4) A resize started after the bucket was picked. The key may already
+     * have been moved by a request that uses the new number of chunks, so
+     * start over with it. */
+    rv = callBucketFnOn(numChunks, bucket, key, op, timeout, f, args...);
+    if (rv != kMappingChanged) {
+      return rv;
+    }
+  }
+}
 
-  /* 3) Lock the bucket. Immutable bucket is a parameter
+template <typename C, typename A, typename B>
+template <typename Fn, typename... Args>
+int CompactCache<C, A, B>::callBucketFnOn(
+    size_t numChunks,
+    Bucket* bucket,
+    const Key& key,
+    Operation op,
+    const std::chrono::microseconds& timeout,
+    Fn f,
+    Args... args) {
+  /* Lock the bucket. Immutable bucket is a parameter
    * regarding whether we're allowed to modify the bucket in any way,
    * meaning we take an exclusive lock, or not, meaning we take a
    * shared lock for reads without promotion. We may need to promote
@@ -974,7 +1095,9 @@ int CompactCache<C, A, B>::callBucketFn(
   BucketReturn rv;
   bool immutable_bucket = (op == Operation::READ);
 
-  /* 4) Call the request handler. */
+  /* Call the request handler. Migrating a key requires the lock of its
+   * previous bucket, so checking the number of chunks under the lock
+   * orders this request either entirely before the resize or after it. */
   if (immutable_bucket) {
     auto lock = locks_.lockShared(timeout, bucket);
     if (!lock.owns_lock()) {
@@ -982,6 +1105,9 @@ int CompactCache<C, A, B>::callBucketFn(
       ++stats_.tlStats().lockTimeout;
       return -2;
     }
+    if (numChunks_ != numChunks) {
+      return kMappingChanged;
+    }
 
     rv = (this->*f)(bucket, key, args...);
   } else {
@@ -991,11 +1117,14 @@ int CompactCache<C, A, B>::callBucketFn(
       ++stats_.tlStats().lockTimeout;
       return -2;
     }
+    if (numChunks_ != numChunks) {
+      return kMappingChanged;
+    }
 
     rv = (this->*f)(bucket, key, args...);
   }
 
-  /* 5.5) Promote if necessary from a read operation */
+  /* Promote if necessary from a read operation */
   if (UNLIKELY(rv == BucketReturn::PROMOTE)) {
     XDCHECK(immutable_bucket);
     XDCHECK_EQ(op, Operation::READ);
@@ -1013,65 +1142,81 @@ int CompactCache<C, A, B>::callBucketFn(
     }
   }
   XDCHECK(rv != BucketReturn::PROMOTE);
+  return toInt(rv);
+}
 
-  /* 6) Do the operation on the new location if necessary
-   * Note that although we release the old lock, the order is very
-   * important. The rehasher will be doing lock old -> read old ->
-   * lock new -> write new -> unlock both
-   * So, we need to make sure that our old update either happens
-   * before the rehasher reads, or if it happens after then the new update
-   * also happens after. IE new update has to be second.
-   */
-  Bucket* bucketDbl =
-      (op == Operation::WRITE) ? tableFindDblWriteBucket(key) : nullptr;
+template <typename C, typename A, typename B>
+bool CompactCache<C, A, B>::migrateKey(
+    Bucket* prevBucket,
+    Bucket* bucket,
+    const Key& key,
+    const std::chrono::microseconds& timeout) {
+  /* Both locks are taken in stripe order, see tableRehash(). */
+  auto locks = locks_.lockExclusivePair(timeout, prevBucket, bucket);
+  if (!locks.first.owns_lock()) {
+    XDCHECK(timeout > std::chrono::microseconds::zero());
+    ++stats_.tlStats().lockTimeout;
+    return false;
+  }
 
-  if (bucketDbl != nullptr) {
-    auto lockDbl = locks_.lockExclusive(bucketDbl);
-    if ((this->*f)(bucketDbl, key, args...) == BucketReturn::ERROR) {
-      rv = BucketReturn::ERROR;
-    }
+  EntryHandle entry = bucketFind(prevBucket, key);
+  if (!entry) {
+    return true;
   }
-  XDCHECK_NE(toInt(rv), 2);
-  return toInt(rv);
+  if (!bucketFind(bucket, key)) {
+    copyEntry(bucket, entry);
+  }
+  BucketDescriptor::del(entry);
+  return true;
 }
 
 template <typename C, typename A, typename B>
-typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindChunk(
-    size_t numChunks, const Key& key) {
+size_t CompactCache<C, A, B>::tableFindChunkIndex(size_t numChunks,
+                                                  const Key& key) const {
   XDCHECK_GT(numChunks, 0u);
   XDCHECK_LE(numChunks, allocator_.getNumChunks());
 
   /* furcHash is well behaved; numChunks <= 1 returns 0 for chunkIndex */
-  auto chunkIndex = facebook::cachelib::furcHash(
+  return facebook::cachelib::furcHash(
       reinterpret_cast<const void*>(&key), sizeof(key), numChunks);
-  return reinterpret_cast<Bucket*>(allocator_.getChunk(chunkIndex));
 }
 
 template <typename C, typename A, typename B>
-typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindBucket(
-    const Key& key) {
-  Bucket* chunk = tableFindChunk(numChunks_, key);
+typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindChunk(
+    size_t numChunks, const Key& key) {
+  return reinterpret_cast<Bucket*>(
+      allocator_.getChunk(tableFindChunkIndex(numChunks, key)));
+}
 
+template <typename C, typename A, typename B>
+size_t CompactCache<C, A, B>::bucketOffset(const Key& key) const {
   uint32_t hv = MurmurHash2()(reinterpret_cast<const void*>(&key), sizeof(key));
-  return &chunk[hv % bucketsPerChunk_];
+  return hv % bucketsPerChunk_;
+}
+
+template <typename C, typename A, typename B>
+typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindBucket(
+    size_t numChunks, const Key& key) {
+  Bucket* chunk = tableFindChunk(numChunks, key);
+  return &chunk[bucketOffset(key)];
 }
 
 template <typename C, typename A, typename B>
 typename CompactCache<C, A, B>::Bucket*
-CompactCache<C, A, B>::tableFindDblWriteBucket(const Key& key) {
+CompactCache<C, A, B>::tableFindPrevBucket(size_t numChunks, const Key& key) {
   // this var is volatile and can be 0, which will cause
   // asserts later; avoid this case
-  size_t pending = pendingNumChunks_;
-  if (pending == 0) {
+  const size_t prev = prevNumChunks_;
+  if (prev == 0 || prev == numChunks) {
     return nullptr;
   }
-  Bucket* chunk = tableFindChunk(numChunks_, key);
-  Bucket* chunkNew = tableFindChunk(pending, key);
-  if (chunk == chunkNew) {
+  const size_t prevIndex = tableFindChunkIndex(prev, key);
+  if (prevIndex < migratedChunks_ ||
+      prevIndex == tableFindChunkIndex(numChunks, key)) {
     return nullptr;
   }
-  uint32_t hv = MurmurHash2()(reinterpret_cast<const void*>(&key), sizeof(key));
-  return &chunkNew[hv % bucketsPerChunk_];
+  Bucket* chunk = reinterpret_cast<Bucket*>(allocator_.getChunk(prevIndex));
+  return &chunk[bucketOffset(key)];
 }
 
 template <typename C, typename A, typename B>
@@ -1205,7 +1350,7 @@ bool CompactCache<C, A, B>::forEachBucket(const BucketCallBack& cb) {
 
   // this obtains a resize lock so it cannot be occuring during an actual
   // resize; assert that
-  XDCHECK_EQ(pendingNumChunks_.load(), 0u);
+  XDCHECK_EQ(prevNumChunks_.load(), 0u);
 
   /* Loop through all buckets in the table. */
   for (size_t n = 0; n < numChunks_; n++) {
@@ -24,7 +24,10 @@
 #include <folly/Random.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "cachelib/compact_cache/CCacheCreator.h"
 
@@ -135,7 +138,11 @@ class CCWrapper : public CC {
  public:
   std::atomic<size_t>& numChunks() { return CC::numChunks_; }
 
-  std::atomic<size_t>& pendingNumChunks() { return CC::pendingNumChunks_; }
+  std::atomic<size_t>& prevNumChunks() { return CC::prevNumChunks_; }
+
+  std::atomic<size_t>& migratedChunks() { return CC::migratedChunks_; }
+
+  void switchCohorts() { CC::cohort_.switchCohorts(); }
 };
 
 /**
@@ -297,17 +304,38 @@ static void testResizeSmaller(bool allowPromotions) {
   auto ccache = setup.getCache();
 
   ASSERT_EQ(ccache->numChunks(), wantSlabs);
-  ccache->pendingNumChunks() = 1;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &dummyValue));
-    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  // also find them in the new chunk from the double writing
-  ccache->numChunks() = ccache->pendingNumChunks().load();
+  // start shrinking to half the chunks. Nothing has been migrated yet, but
+  // everything is found through the previous mapping.
+  ccache->migratedChunks() = 0;
+  ccache->prevNumChunks() = wantSlabs;
+  ccache->numChunks() = wantSlabs / 2;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
+
+  // writes during the resize go to the new location.
+  for (int i = 100; i < 150; i++) {
+    ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &dummyValue));
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
+  }
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->set(1, &dummyValue));
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->del(2, &out));
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->get(2, &out));
+
+  // finish the migration. Deleted keys must not come back and keys written
+  // during the resize are all in their final location.
+  ccache->tableRehash(wantSlabs, wantSlabs / 2);
+  ccache->prevNumChunks() = 0;
+  ASSERT_EQ(wantSlabs, ccache->migratedChunks());
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->get(1, &out));
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->get(2, &out));
+  for (int i = 100; i < 150; i++) {
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
+  }
 }
 
 template <typename CC>
@@ -321,18 +349,108 @@ static void testResizeLarger(bool allowPromotions) {
   auto ccache = setup.getCache();
 
   ASSERT_EQ(ccache->numChunks(), wantSlabs);
-  ccache->pendingNumChunks() = ccache->numChunks().load();
   ccache->numChunks() = 1;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &dummyValue));
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  // also find them in the new chunk from the double writing
-  ccache->numChunks() = ccache->pendingNumChunks().load();
+  // start growing back to all the chunks.
+  ccache->migratedChunks() = 0;
+  ccache->prevNumChunks() = 1;
+  ccache->numChunks() = wantSlabs;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->del(1, &out));
+
+  // growing moves everything.
+  ccache->tableRehash(1, wantSlabs);
+  ccache->prevNumChunks() = 0;
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->get(1, &out));
+  for (int i = 2; i < 100; i++) {
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
+  }
+}
+
+template <typename CC>
+static void testConcurrentResize(bool allowPromotions) {
+  const int wantSlabs = 16;
+  const int invertBuckets = wantSlabs * BUCKETS_PER_CHUNK;
+  TestSetup<CC> setup(invertBuckets, allowPromotions);
+  auto ccache = setup.getCache();
+
+  ASSERT_EQ(ccache->numChunks(), wantSlabs);
+
+  // Writers race on the same keys with unique values while the number of
+  // chunks changes under them. Entries may be dropped when shrinking, but a
+  // key whose last write by every writer was a delete must stay deleted and
+  // a key must never hold a value that no writer wrote last.
+  constexpr int kWriters = 4;
+  constexpr int kKeys = 64;
+  for (int round = 0; round < 20; round++) {
+    const size_t oldNumChunks = ccache->numChunks();
+    const size_t newNumChunks =
+        oldNumChunks == static_cast<size_t>(wantSlabs) ? wantSlabs / 2
+                                                       : wantSlabs;
+
+    std::atomic<bool> stop{false};
+    // last value written to each key by each writer, 0 for a delete
+    std::vector<std::vector<int>> last(kWriters, std::vector<int>(kKeys));
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; w++) {
+      writers.emplace_back([&, w]() {
+        int seq = 0;
+        while (!stop) {
+          for (int k = 0; k < kKeys; k++) {
+            if (folly::Random::oneIn(2)) {
+              typename CC::Value out;
+              ccache->del(k + 1, &out);
+              last[w][k] = 0;
+            } else {
+              const int v = ++seq * kWriters + w;
+              typename CC::Value val(v);
+              ccache->set(k + 1, &val);
+              last[w][k] = v;
+            }
+          }
+        }
+      });
+    }
+
+    // same steps as CompactCache::resize(), with the chunks already there
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ccache->migratedChunks() = 0;
+    ccache->prevNumChunks() = oldNumChunks;
+    ccache->numChunks() = newNumChunks;
+    ccache->switchCohorts();
+    ccache->tableRehash(oldNumChunks, newNumChunks);
+    ccache->prevNumChunks() = 0;
+    ccache->switchCohorts();
+
+    stop = true;
+    for (auto& t : writers) {
+      t.join();
+    }
+
+    for (int k = 0; k < kKeys; k++) {
+      bool written = false;
+      bool matches = !CC::kHasValues;
+      typename CC::Value out;
+      if (ccache->get(k + 1, &out) != CCacheReturn::FOUND) {
+        continue;
+      }
+      for (int w = 0; w < kWriters; w++) {
+        if (last[w][k] != 0) {
+          written = true;
+          matches = matches || out == typename CC::Value(last[w][k]);
+        }
+      }
+      ASSERT_TRUE(written) << "deleted key " << k + 1 << " came back";
+      ASSERT_TRUE(matches) << "stale value for key " << k + 1;
+    }
+  }
 }
 
 template <typename CC>
@@ -368,8 +486,7 @@ static void testRehashSmaller(bool allowPromotions) {
   ASSERT_TRUE(hits < 60);
   ASSERT_TRUE(hits > 40);
 
-  ccache->tableRehash(
-      curChunks, curChunks / 2, facebook::cachelib::RehashOperation::COPY);
+  ccache->tableRehash(curChunks, curChunks / 2);
 
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
@@ -411,8 +528,7 @@ static void testRehashLarger(bool allowPromotions) {
   ASSERT_TRUE(hits < 60);
   ASSERT_TRUE(hits > 40);
 
-  ccache->tableRehash(
-      curChunks / 2, curChunks, facebook::cachelib::RehashOperation::COPY);
+  ccache->tableRehash(curChunks / 2, curChunks);
 
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
@@ -630,6 +746,7 @@ static void CompactCacheRunBasicTestsUtil(bool allowPromotions) {
   testDel<CC>(allowPromotions);
   testResizeSmaller<CC>(allowPromotions);
   testResizeLarger<CC>(allowPromotions);
+  testConcurrentResize<CC>(allowPromotions);
   testRehashSmaller<CC>(allowPromotions);
   testRehashLarger<CC>(allowPromotions);
   testEvict<CC>(allowPromotions);
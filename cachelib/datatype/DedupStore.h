@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/logging/xlog.h>
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "cachelib/allocator/memory/Slab.h"
+#include "cachelib/common/AtomicCounter.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+// Layout of a key item in DedupStore. Small values are stored inline after
+// the header. Big values are stored once in a value item keyed by the hash
+// of their content and the key item only holds a reference to it.
+struct FOLLY_PACK_ATTR DedupKeyItem {
+  enum Kind : uint8_t {
+    kInline = 0,
+    kRef = 1,
+  };
+
+  Kind kind;
+  // hash of the value for kRef
+  uint64_t hash1;
+  uint64_t hash2;
+  // size of the value
+  uint32_t size;
+  uint8_t data[0];
+
+  static uint32_t getInlineSize(uint32_t size) {
+    return static_cast<uint32_t>(sizeof(DedupKeyItem)) + size;
+  }
+};
+
+// Layout of a shared value item in DedupStore. Value items are not reference
+// counted. They are evicted like any other item once no key reads them
+// anymore.
+struct FOLLY_PACK_ATTR DedupValueItem {
+  uint32_t size;
+  uint8_t data[0];
+
+  static uint32_t getAllocSize(uint32_t size) {
+    return static_cast<uint32_t>(sizeof(DedupValueItem)) + size;
+  }
+};
+} // namespace detail
+
+// Content addressed value deduplication on top of a cache. Values of at least
+// minValueSize bytes are hashed on insert and stored once in a value item
+// whose key is derived from the hash. The keys users insert become thin items
+// referencing the value item. Both are regular cache items, so they are
+// evicted, flushed to nvm and read back like any other item. A key whose
+// value item is gone is treated as a miss and removed.
+//
+// Keys starting with Config::valueKeyPrefix are reserved for the value items
+// and are rejected. The store creates and owns its cache so that it can hook
+// the cache's item destructor and keep the live byte counts in Stats exact.
+//
+// The chained item machinery ties every chained item to exactly one parent,
+// so sharing a value among many keys is done through a reference by hash
+// instead. The content is compared byte by byte before a value is shared, so
+// hash collisions never return the wrong value.
+template <typename CacheT>
+class DedupStore {
+ public:
+  using ReadHandle = typename CacheT::ReadHandle;
+  using WriteHandle = typename CacheT::WriteHandle;
+
+  struct Config {
+    // values smaller than this are stored inline in the key item.
+    uint32_t minValueSize{1024};
+
+    // prefix for the keys of the shared value items. User keys must not
+    // start with it.
+    std::string valueKeyPrefix{"__dedup:"};
+  };
+
+  struct Stats {
+    // values inserted by reference to an existing value item
+    uint64_t numDedupHits{0};
+    // values inserted by creating a new value item
+    uint64_t numDedupMisses{0};
+    // values stored inline because they are small
+    uint64_t numInlineValues{0};
+    // values stored inline because their hash collided with another value
+    uint64_t numHashCollisions{0};
+    // lookups that found a key whose value item was gone
+    uint64_t numDanglingRefs{0};
+    // bytes of the values of the keys currently in the cache
+    uint64_t logicalBytes{0};
+    // bytes of the key and value items currently in the cache
+    uint64_t physicalBytes{0};
+
+    // ratio of bytes of values readable to bytes stored
+    double dedupRatio() const {
+      return physicalBytes == 0 ? 1.0
+                                : static_cast<double>(logicalBytes) /
+                                      static_cast<double>(physicalBytes);
+    }
+  };
+
+  // A value read from the store. The handle keeps the item holding the value
+  // alive for as long as the data is used.
+  struct Value {
+    ReadHandle handle;
+    folly::StringPiece data;
+
+    explicit operator bool() const { return handle != nullptr; }
+  };
+
+  // Creates the cache with a single pool for keys and values. Any item
+  // destructor in @cacheConfig is still called, after the store's, and a
+  // remove callback can not be used along with it.
+  //
+  // @param cacheConfig   config of the cache to store keys and values in
+  // @param config        dedup config
+  explicit DedupStore(typename CacheT::Config cacheConfig, Config config = {});
+
+  // Inserts the value for the key, replacing any existing value.
+  //
+  // @return true if the value was inserted. false if the allocations failed.
+  // @throw std::invalid_argument if the key or value size is invalid, or if
+  //        the key starts with the value key prefix
+  bool insertOrReplace(folly::StringPiece key,
+                       folly::StringPiece value,
+                       uint32_t ttlSecs = 0);
+
+  // @return the value for the key, or a Value that converts to false if the
+  //         key does not exist.
+  Value find(folly::StringPiece key);
+
+  // Removes the key. The shared value stays until it is evicted.
+  //
+  // @return true if the key existed
+  bool remove(folly::StringPiece key);
+
+  Stats getStats() const;
+
+  // @return the cache holding the key and value items
+  CacheT& getCache() { return *cache_; }
+
+  // @return the key of the value item for the hash
+  std::string getValueKey(uint64_t hash1, uint64_t hash2) const {
+    return folly::sformat("{}{:016x}{:016x}", config_.valueKeyPrefix, hash1,
+                          hash2);
+  }
+
+ private:
+  // reference to the shared value item for the value, creating it if it
+  // does not exist yet. Returns nullptr on collisions and allocation
+  // failures.
+  ReadHandle acquireValue(folly::StringPiece value,
+                          uint64_t hash1,
+                          uint64_t hash2);
+
+  bool isValueKey(folly::StringPiece key) const {
+    return key.startsWith(config_.valueKeyPrefix);
+  }
+
+  // Keeps the live byte counts up to date. Called from the item destructor
+  // of the cache, which runs once an item is gone from both DRAM and nvm.
+  void onItemDestroyed(const typename CacheT::DestructorData& data);
+
+  bool insertInline(folly::StringPiece key,
+                    folly::StringPiece value,
+                    uint32_t ttlSecs);
+
+  std::mutex& getLock(uint64_t hash) { return locks_[hash % locks_.size()]; }
+
+  static const detail::DedupKeyItem& getKeyItem(const ReadHandle& handle) {
+    return *reinterpret_cast<const detail::DedupKeyItem*>(handle->getMemory());
+  }
+
+  static const detail::DedupValueItem& getValueItem(const ReadHandle& handle) {
+    return *reinterpret_cast<const detail::DedupValueItem*>(
+        handle->getMemory());
+  }
+
+  const Config config_;
+
+  // serializes the creation of value items.
+  std::array<std::mutex, 64> locks_;
+
+  mutable AtomicCounter numDedupHits_;
+  mutable AtomicCounter numDedupMisses_;
+  mutable AtomicCounter numInlineValues_;
+  mutable AtomicCounter numHashCollisions_;
+  mutable AtomicCounter numDanglingRefs_;
+  mutable AtomicCounter logicalBytes_;
+  mutable AtomicCounter physicalBytes_;
+
+  // declared last, so that it is destroyed before the counters its item
+  // destructor updates
+  std::unique_ptr<CacheT> cache_;
+  PoolId pid_;
+};
+
+template <typename CacheT>
+DedupStore<CacheT>::DedupStore(typename CacheT::Config cacheConfig,
+                               Config config)
+    : config_{std::move(config)} {
+  cacheConfig.setItemDestructor(
+      [this, userDestructor = cacheConfig.itemDestructor](
+          const typename CacheT::DestructorData& data) {
+        onItemDestroyed(data);
+        if (userDestructor) {
+          userDestructor(data);
+        }
+      });
+  cache_ = std::make_unique<CacheT>(cacheConfig);
+  pid_ = cache_->addPool("dedup", cache_->getCacheMemoryStats().ramCacheSize);
+}
+
+template <typename CacheT>
+bool DedupStore<CacheT>::insertOrReplace(folly::StringPiece key,
+                                         folly::StringPiece value,
+                                         uint32_t ttlSecs) {
+  if (isValueKey(key)) {
+    throw std::invalid_argument(folly::sformat(
+        "Key {} uses the reserved prefix {}", key, config_.valueKeyPrefix));
+  }
+  if (value.size() < config_.minValueSize) {
+    numInlineValues_.inc();
+    return insertInline(key, value, ttlSecs);
+  }
+
+  uint64_t hash1 = 0;
+  uint64_t hash2 = 0;
+  folly::hash::SpookyHashV2::Hash128(value.data(), value.size(), &hash1,
+                                     &hash2);
+  auto valueHandle = acquireValue(value, hash1, hash2);
+  if (!valueHandle) {
+    return insertInline(key, value, ttlSecs);
+  }
+
+  auto handle =
+      cache_->allocate(pid_, key, sizeof(detail::DedupKeyItem), ttlSecs);
+  if (!handle) {
+    return false;
+  }
+  new (handle->getMemory()) detail::DedupKeyItem{
+      detail::DedupKeyItem::kRef, hash1, hash2,
+      static_cast<uint32_t>(value.size())};
+  logicalBytes_.add(value.size());
+  physicalBytes_.add(sizeof(detail::DedupKeyItem));
+
+  cache_->insertOrReplace(handle);
+  return true;
+}
+
+template <typename CacheT>
+bool DedupStore<CacheT>::insertInline(folly::StringPiece key,
+                                      folly::StringPiece value,
+                                      uint32_t ttlSecs) {
+  const auto size = detail::DedupKeyItem::getInlineSize(value.size());
+  auto handle = cache_->allocate(pid_, key, size, ttlSecs);
+  if (!handle) {
+    return false;
+  }
+  auto* item = new (handle->getMemory()) detail::DedupKeyItem{
+      detail::DedupKeyItem::kInline, 0, 0, static_cast<uint32_t>(value.size())};
+  std::memcpy(item->data, value.data(), value.size());
+  logicalBytes_.add(value.size());
+  physicalBytes_.add(size);
+
+  cache_->insertOrReplace(handle);
+  return true;
+}
+
+template <typename CacheT>
+typename DedupStore<CacheT>::ReadHandle DedupStore<CacheT>::acquireValue(
+    folly::StringPiece value, uint64_t hash1, uint64_t hash2) {
+  const auto valueKey = getValueKey(hash1, hash2);
+  std::lock_guard<std::mutex> l{getLock(hash1)};
+
+  auto handle = cache_->find(valueKey);
+  if (handle) {
+    auto& valueItem = getValueItem(handle);
+    if (valueItem.size != value.size() ||
+        std::memcmp(valueItem.data, value.data(), value.size()) != 0) {
+      numHashCollisions_.inc();
+      return ReadHandle{};
+    }
+    numDedupHits_.inc();
+    return handle;
+  }
+
+  const auto size = detail::DedupValueItem::getAllocSize(value.size());
+  auto newHandle = cache_->allocate(pid_, valueKey, size);
+  if (!newHandle) {
+    return ReadHandle{};
+  }
+  auto* valueItem = new (newHandle->getMemory())
+      detail::DedupValueItem{static_cast<uint32_t>(value.size())};
+  std::memcpy(valueItem->data, value.data(), value.size());
+  cache_->insertOrReplace(newHandle);
+  numDedupMisses_.inc();
+  physicalBytes_.add(size);
+  return std::move(newHandle);
+}
+
+template <typename CacheT>
+typename DedupStore<CacheT>::Value DedupStore<CacheT>::find(
+    folly::StringPiece key) {
+  if (isValueKey(key)) {
+    return Value{};
+  }
+  auto handle = cache_->find(key);
+  if (!handle) {
+    return Value{};
+  }
+
+  const auto& keyItem = getKeyItem(handle);
+  if (keyItem.kind == detail::DedupKeyItem::kInline) {
+    folly::StringPiece data{reinterpret_cast<const char*>(keyItem.data),
+                            keyItem.size};
+    return Value{std::move(handle), data};
+  }
+
+  auto valueHandle = cache_->find(getValueKey(keyItem.hash1, keyItem.hash2));
+  if (!valueHandle) {
+    // the value was evicted or dropped. The key is of no use anymore.
+    numDanglingRefs_.inc();
+    cache_->remove(handle);
+    return Value{};
+  }
+  const auto& valueItem = getValueItem(valueHandle);
+  XDCHECK_EQ(valueItem.size, keyItem.size);
+  folly::StringPiece data{reinterpret_cast<const char*>(valueItem.data),
+                          valueItem.size};
+  return Value{std::move(valueHandle), data};
+}
+
+template <typename CacheT>
+bool DedupStore<CacheT>::remove(folly::StringPiece key) {
+  if (isValueKey(key)) {
+    return false;
+  }
+  return cache_->remove(key) == CacheT::RemoveRes::kSuccess;
+}
+
+template <typename CacheT>
+void DedupStore<CacheT>::onItemDestroyed(
+    const typename CacheT::DestructorData& data) {
+  if (data.pool != pid_) {
+    return;
+  }
+  const auto& item = data.item;
+  physicalBytes_.sub(item.getSize());
+  if (!isValueKey(item.getKey())) {
+    logicalBytes_.sub(
+        reinterpret_cast<const detail::DedupKeyItem*>(item.getMemory())->size);
+  }
+}
+
+template <typename CacheT>
+typename DedupStore<CacheT>::Stats DedupStore<CacheT>::getStats() const {
+  Stats stats;
+  stats.numDedupHits = numDedupHits_.get();
+  stats.numDedupMisses = numDedupMisses_.get();
+  stats.numInlineValues = numInlineValues_.get();
+  stats.numHashCollisions = numHashCollisions_.get();
+  stats.numDanglingRefs = numDanglingRefs_.get();
+  stats.logicalBytes = logicalBytes_.get();
+  stats.physicalBytes = physicalBytes_.get();
+  return stats;
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/datatype/DedupStore.h"
+#include "cachelib/datatype/tests/DataTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+template <typename AllocatorT>
+class DedupStoreTest : public ::testing::Test {
+ public:
+  using Store = DedupStore<AllocatorT>;
+
+  void testSharedValues() {
+    // the store keeps its live byte counts through the item destructor, and
+    // still calls the one of the config
+    size_t numDestroyed = 0;
+    auto config = makeCacheConfig();
+    config.setItemDestructor(
+        [&numDestroyed](const typename AllocatorT::DestructorData&) {
+          numDestroyed++;
+        });
+    Store store{config};
+    auto* cache = &store.getCache();
+
+    const std::string big(4096, 'x');
+    for (int i = 0; i < 10; i++) {
+      ASSERT_TRUE(store.insertOrReplace(folly::sformat("key{}", i), big));
+    }
+    for (int i = 0; i < 10; i++) {
+      auto value = store.find(folly::sformat("key{}", i));
+      ASSERT_TRUE(value);
+      ASSERT_EQ(big, value.data);
+    }
+
+    auto stats = store.getStats();
+    EXPECT_EQ(1, stats.numDedupMisses);
+    EXPECT_EQ(9, stats.numDedupHits);
+    EXPECT_EQ(10 * big.size(), stats.logicalBytes);
+    EXPECT_GT(stats.dedupRatio(), 5.0);
+
+    // small values are stored inline
+    ASSERT_TRUE(store.insertOrReplace("small", "hello"));
+    ASSERT_EQ("hello", store.find("small").data);
+    EXPECT_EQ(1, store.getStats().numInlineValues);
+
+    // replacing a key with a different value keeps the other keys intact
+    const std::string other(4096, 'y');
+    ASSERT_TRUE(store.insertOrReplace("key0", other));
+    ASSERT_EQ(other, store.find("key0").data);
+    ASSERT_EQ(big, store.find("key1").data);
+    EXPECT_EQ(10 * big.size() + 5, store.getStats().logicalBytes);
+
+    // removing keys updates the live counts, but the shared value is left
+    // to be evicted
+    const auto valueKey = getValueKey(store, big);
+    for (int i = 1; i < 10; i++) {
+      ASSERT_TRUE(store.remove(folly::sformat("key{}", i)));
+    }
+    ASSERT_NE(nullptr, cache->peek(valueKey));
+    ASSERT_FALSE(store.remove("key1"));
+    stats = store.getStats();
+    EXPECT_EQ(other.size() + 5, stats.logicalBytes);
+    EXPECT_LT(stats.dedupRatio(), 1.0);
+
+    // once the shared value is gone, only the remaining items are counted
+    cache->remove(valueKey);
+    stats = store.getStats();
+    EXPECT_EQ(other.size() + 5, stats.logicalBytes);
+    EXPECT_EQ(other.size() + 5 + 2 * sizeof(detail::DedupKeyItem) +
+                  sizeof(detail::DedupValueItem),
+              stats.physicalBytes);
+    EXPECT_EQ(11, numDestroyed);
+  }
+
+  void testReservedKeys() {
+    Store store{makeCacheConfig()};
+    auto* cache = &store.getCache();
+
+    const std::string big(2048, 'z');
+    ASSERT_TRUE(store.insertOrReplace("a", big));
+    const auto valueKey = getValueKey(store, big);
+
+    // the value items can't be read, overwritten or removed as user keys
+    ASSERT_THROW(store.insertOrReplace(valueKey, "oops"),
+                 std::invalid_argument);
+    ASSERT_FALSE(store.find(valueKey));
+    ASSERT_FALSE(store.remove(valueKey));
+    ASSERT_NE(nullptr, cache->peek(valueKey));
+    ASSERT_EQ(big, store.find("a").data);
+  }
+
+  void testDanglingRefs() {
+    Store store{makeCacheConfig()};
+    auto* cache = &store.getCache();
+
+    const std::string big(2048, 'z');
+    ASSERT_TRUE(store.insertOrReplace("a", big));
+    ASSERT_TRUE(store.insertOrReplace("b", big));
+
+    // evictions of the value item turn its keys into misses
+    cache->remove(getValueKey(store, big));
+    ASSERT_FALSE(store.find("a"));
+    ASSERT_EQ(nullptr, cache->peek("a"));
+    EXPECT_EQ(1, store.getStats().numDanglingRefs);
+
+    // inserting the value again creates a new value item
+    ASSERT_TRUE(store.insertOrReplace("a", big));
+    ASSERT_EQ(big, store.find("a").data);
+    ASSERT_EQ(big, store.find("b").data);
+  }
+
+ private:
+  static typename AllocatorT::Config makeCacheConfig() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+    return config;
+  }
+
+  static std::string getValueKey(const Store& store, const std::string& value) {
+    uint64_t hash1 = 0;
+    uint64_t hash2 = 0;
+    folly::hash::SpookyHashV2::Hash128(value.data(), value.size(), &hash1,
+                                       &hash2);
+    return store.getValueKey(hash1, hash2);
+  }
+};
+
+TYPED_TEST_CASE(DedupStoreTest, AllocatorTypes);
+TYPED_TEST(DedupStoreTest, SharedValues) { this->testSharedValues(); }
+TYPED_TEST(DedupStoreTest, DanglingRefs) { this->testDanglingRefs(); }
+TYPED_TEST(DedupStoreTest, ReservedKeys) { this->testReservedKeys(); }
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
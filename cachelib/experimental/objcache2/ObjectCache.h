@@ -38,6 +38,7 @@
 #include "cachelib/experimental/objcache2/ObjectCacheConfig.h"
 #include "cachelib/experimental/objcache2/ObjectCacheSizeController.h"
 #include "cachelib/experimental/objcache2/ObjectCacheSizeDistTracker.h"
+#include "cachelib/experimental/objcache2/persistence/Checkpointer.h"
 #include "cachelib/experimental/objcache2/persistence/Persistence.h"
 #include "cachelib/experimental/objcache2/persistence/gen-cpp2/persistent_data_types.h"
 #include "cachelib/experimental/objcache2/util/ThreadMemoryTracker.h"
@@ -156,6 +157,8 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   using DeserializeCb = std::function<bool(Deserializer)>;
   using Persistor = Persistor<ObjectCache<AllocatorT>>;
   using Restorer = Restorer<ObjectCache<AllocatorT>>;
+  using Checkpointer = Checkpointer<ObjectCache<AllocatorT>>;
+  using CheckpointRestorer = CheckpointRestorer<ObjectCache<AllocatorT>>;
   using EvictionIterator = typename AllocatorT::EvictionIterator;
   using AccessIterator = typename AllocatorT::AccessIterator;
 
@@ -244,13 +247,17 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   bool remove(folly::StringPiece key);
 
   // Persist all non-expired objects in the cache if cache persistence is
-  // enabled.
+  // enabled. With checkpointing enabled, this writes the changes that the
+  // background checkpointer has not written yet (or a full snapshot if it has
+  // not started).
   // No-op if cache persistence is not enabled.
   // @return false if no persistence happened
   bool persist();
 
   // Recover non-expired objects to the cache if cache persistence is
-  // enabled.
+  // enabled. With checkpointing enabled, objects are recovered from the
+  // latest checkpoint, and background checkpointing starts once this
+  // returns, also when there was nothing to recover.
   // No-op if cache persistence is not enabled.
   // @return false if no recovery happened
   bool recover();
@@ -355,8 +362,12 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
     if (object == nullptr) {
       return false;
     }
-    return getWriteHandleRefInternal<T>(object)->updateExpiryTime(
-        expiryTimeSecs);
+    auto& hdl = getWriteHandleRefInternal<T>(object);
+    if (!hdl->updateExpiryTime(expiryTimeSecs)) {
+      return false;
+    }
+    markCheckpointDirty(hdl->getKey());
+    return true;
   }
 
   // Update expiry time to @ttl seconds from now.
@@ -370,7 +381,12 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
     if (object == nullptr) {
       return false;
     }
-    return getWriteHandleRefInternal<T>(object)->extendTTL(ttl);
+    auto& hdl = getWriteHandleRefInternal<T>(object);
+    if (!hdl->extendTTL(ttl)) {
+      return false;
+    }
+    markCheckpointDirty(hdl->getKey());
+    return true;
   }
 
   // Mutate object and update the object size
@@ -429,6 +445,8 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
         util::stopPeriodicWorker(kSizeControllerName, sizeController_, timeout);
     success &= util::stopPeriodicWorker(kSizeDistTrackerName, sizeDistTracker_,
                                         timeout);
+    success &=
+        util::stopPeriodicWorker(kCheckpointerName, checkpointer_, timeout);
     success &= this->l1Cache_->stopWorkers(timeout);
     return success;
   }
@@ -450,11 +468,22 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   // Names of periodic workers
   static constexpr folly::StringPiece kSizeControllerName{"SizeController"};
   static constexpr folly::StringPiece kSizeDistTrackerName{"SizeDistTracker"};
+  static constexpr folly::StringPiece kCheckpointerName{"Checkpointer"};
 
   void init();
 
   void initWorkers();
 
+  void startCheckpointer();
+
+  // Record a change of the key for the background checkpointer. No-op until
+  // checkpointing starts in recover().
+  void markCheckpointDirty(folly::StringPiece key, bool removed = false) {
+    if (checkpointingStarted_.load(std::memory_order_relaxed)) {
+      removed ? dirtyKeys_.markRemoved(key) : dirtyKeys_.markUpdated(key);
+    }
+  }
+
   // Allocate an item handle from the interal cache allocator. This item's
   // storage is used to cache pointer to objects in object-cache.
   typename AllocatorT::WriteHandle allocateFromL1(folly::StringPiece key,
@@ -510,6 +539,19 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   std::unique_ptr<ObjectCacheSizeDistTracker<ObjectCache<AllocatorT>>>
       sizeDistTracker_;
 
+  // A periodic worker that writes changed objects to the checkpoint.
+  std::unique_ptr<Checkpointer> checkpointer_;
+
+  // Keys changed since the last checkpoint
+  DirtyKeySet dirtyKeys_;
+
+  // Changes are tracked once recover() has restored the previous checkpoint.
+  // The first checkpoint is a full snapshot, so earlier changes are covered.
+  std::atomic<bool> checkpointingStarted_{false};
+
+  // Whether initWorkers() has run
+  bool workersStarted_{false};
+
   // Actual object size in total
   std::atomic<size_t> totalObjectSizeBytes_{0};
 
@@ -527,6 +569,7 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   friend class ObjectCacheSizeController;
 
   friend Persistor;
+  friend Checkpointer;
 };
 
 template <typename AllocatorT>
@@ -632,6 +675,7 @@ void ObjectCache<AllocatorT>::startCacheWorkers() {
 
 template <typename AllocatorT>
 void ObjectCache<AllocatorT>::initWorkers() {
+  workersStarted_ = true;
   if (config_.objectSizeTrackingEnabled &&
       config_.sizeControllerIntervalMs != 0) {
     util::startPeriodicWorker(
@@ -646,6 +690,19 @@ void ObjectCache<AllocatorT>::initWorkers() {
         kSizeDistTrackerName, sizeDistTracker_,
         std::chrono::seconds{60} /*default interval to be 60s*/, *this);
   }
+
+  if (checkpointingStarted_) {
+    startCheckpointer();
+  }
+}
+
+template <typename AllocatorT>
+void ObjectCache<AllocatorT>::startCheckpointer() {
+  util::startPeriodicWorker(
+      kCheckpointerName, checkpointer_,
+      std::chrono::milliseconds{config_.checkpointIntervalMs}, *this,
+      dirtyKeys_, config_.persistBaseFilePath, config_.serializeCb,
+      config_.checkpointMaxSegments, config_.checkpointThrottlerConfig);
 }
 
 template <typename AllocatorT>
@@ -735,6 +792,7 @@ ObjectCache<AllocatorT>::insertOrReplace(folly::StringPiece key,
   }
 
   auto replaced = this->l1Cache_->insertOrReplace(handle);
+  markCheckpointDirty(key);
 
   std::shared_ptr<T> replacedPtr = nullptr;
   if (replaced) {
@@ -788,6 +846,7 @@ ObjectCache<AllocatorT>::insert(folly::StringPiece key,
 
   auto success = this->l1Cache_->insert(handle);
   if (success) {
+    markCheckpointDirty(key);
     // update total object size
     if (config_.objectSizeTrackingEnabled) {
       totalObjectSizeBytes_.fetch_add(objectSize, std::memory_order_relaxed);
@@ -854,6 +913,9 @@ ObjectCache<AllocatorT>::~ObjectCache() {
 template <typename AllocatorT>
 bool ObjectCache<AllocatorT>::remove(folly::StringPiece key) {
   removes_.inc();
+  // An evicted object may still be in the checkpoint, so the removal is
+  // recorded even if the key is not found.
+  markCheckpointDirty(key, true /* removed */);
   return this->l1Cache_->remove(key) == AllocatorT::RemoveRes::kSuccess;
 }
 
@@ -882,6 +944,10 @@ void ObjectCache<AllocatorT>::getObjectCacheCounters(
   if (sizeDistTracker_) {
     sizeDistTracker_->getCounters(visitor);
   }
+
+  if (checkpointer_) {
+    checkpointer_->getCounters(visitor);
+  }
 }
 
 template <typename AllocatorT>
@@ -897,6 +963,12 @@ ObjectCache<AllocatorT>::serializeConfigParams() const {
     config["sizeControllerIntervalMs"] =
         std::to_string(config_.sizeControllerIntervalMs);
   }
+  if (config_.checkpointIntervalMs > 0) {
+    config["checkpointIntervalMs"] =
+        std::to_string(config_.checkpointIntervalMs);
+    config["checkpointMaxSegments"] =
+        std::to_string(config_.checkpointMaxSegments);
+  }
   return config;
 }
 
@@ -911,6 +983,15 @@ bool ObjectCache<AllocatorT>::persist() {
     return false;
   }
 
+  if (config_.checkpointIntervalMs > 0) {
+    if (!checkpointer_) {
+      checkpointer_ = std::make_unique<Checkpointer>(
+          *this, dirtyKeys_, config_.persistBaseFilePath, config_.serializeCb,
+          config_.checkpointMaxSegments, config_.checkpointThrottlerConfig);
+    }
+    return checkpointer_->flush();
+  }
+
   Persistor persistor(config_.persistThreadCount, config_.persistBaseFilePath,
                       config_.serializeCb, *this);
   return persistor.run();
@@ -921,6 +1002,19 @@ bool ObjectCache<AllocatorT>::recover() {
   if (config_.persistBaseFilePath.empty() || !config_.deserializeCb) {
     return false;
   }
+
+  if (config_.checkpointIntervalMs > 0) {
+    CheckpointRestorer restorer(config_.persistThreadCount,
+                                config_.persistBaseFilePath,
+                                config_.deserializeCb, *this);
+    bool success = restorer.run();
+    // The previous checkpoint is only replaced after it has been read.
+    if (!checkpointingStarted_.exchange(true) && workersStarted_) {
+      startCheckpointer();
+    }
+    return success;
+  }
+
   Restorer restorer(config_.persistBaseFilePath, config_.deserializeCb, *this);
   return restorer.run();
 }
@@ -939,6 +1033,7 @@ void ObjectCache<AllocatorT>::mutateObject(const std::shared_ptr<T>& object,
   size_t memUsageAfter = tMemTracker.getMemUsageBytes();
 
   auto& hdl = getWriteHandleRefInternal<T>(object);
+  markCheckpointDirty(hdl->getKey());
   size_t memUsageDiff = 0;
   if (memUsageAfter > memUsageBefore) { // updated to a larger value
     memUsageDiff = memUsageAfter - memUsageBefore;
@@ -977,11 +1072,12 @@ bool ObjectCache<AllocatorT>::updateObjectSize(const std::shared_ptr<T>& object,
     return false;
   }
 
+  auto& hdl = getWriteHandleRefInternal<T>(object);
+  markCheckpointDirty(hdl->getKey());
+
   // do atomic update on objectSize
   const auto oldSize = __sync_lock_test_and_set(
-      &(reinterpret_cast<ObjectCacheItem*>(
-            getWriteHandleRefInternal<T>(object)->getMemory())
-            ->objectSize),
+      &(reinterpret_cast<ObjectCacheItem*>(hdl->getMemory())->objectSize),
       newSize);
   if (newSize > oldSize) {
     totalObjectSizeBytes_.fetch_add(newSize - oldSize,
@@ -130,6 +130,19 @@ struct ObjectCacheConfig {
       SerializeCb serializeCallback,
       DeserializeCb deserializeCallback);
 
+  // Continuously checkpoint changed objects in the background so that the
+  // cache can be recovered after a crash, not only after persist(). Cache
+  // persistence must be enabled as well; recover() then reads the checkpoint,
+  // and checkpointing starts once recover() has been called.
+  // Checkpoint files are saved in "baseFilePath_ckpt_*".
+  // @param interval           time between two checkpoint runs
+  // @param cpuBudgetPercent   share of a core in (0, 100] a run may use
+  // @param maxSegments        number of segments of changes after which the
+  //                           checkpoint is compacted into a new snapshot
+  ObjectCacheConfig& enableCheckpointing(std::chrono::milliseconds interval,
+                                         uint32_t cpuBudgetPercent = 10,
+                                         uint32_t maxSegments = 8);
+
   // Enable tracking Jemalloc external fragmentation.
   ObjectCacheConfig& enableFragmentationTracking();
 
@@ -221,6 +234,16 @@ struct ObjectCacheConfig {
   // Deserialize callback for cache persistence
   DeserializeCb deserializeCb{};
 
+  // Period to run the background checkpointer in milliseconds. 0 means
+  // checkpointing is disabled.
+  uint64_t checkpointIntervalMs{0};
+
+  // Throttler config of the checkpointer, derived from its CPU budget
+  util::Throttler::Config checkpointThrottlerConfig{};
+
+  // Number of checkpoint segments after which a new snapshot is written
+  uint32_t checkpointMaxSegments{8};
+
   // Config of the eviction policy
   EvictionPolicyConfig evictionPolicyConfig{};
 
@@ -375,6 +398,36 @@ ObjectCacheConfig<T>& ObjectCacheConfig<T>::enablePersistenceWithEvictionOrder(
   return *this;
 }
 
+template <typename T>
+ObjectCacheConfig<T>& ObjectCacheConfig<T>::enableCheckpointing(
+    std::chrono::milliseconds interval,
+    uint32_t cpuBudgetPercent,
+    uint32_t maxSegments) {
+  if (interval.count() <= 0) {
+    throw std::invalid_argument(
+        "A positive interval must be set to enable checkpointing");
+  }
+
+  if (cpuBudgetPercent == 0 || cpuBudgetPercent > 100) {
+    throw std::invalid_argument(
+        "Checkpoint CPU budget must be a percentage in (0, 100]");
+  }
+
+  if (maxSegments == 0) {
+    throw std::invalid_argument(
+        "A non-zero number of segments must be set to enable checkpointing");
+  }
+  checkpointIntervalMs = static_cast<uint64_t>(interval.count());
+  // work for workMs, then sleep long enough to stay within the budget
+  constexpr uint64_t kWorkMs = 10;
+  const uint64_t sleepMs =
+      kWorkMs * (100 - cpuBudgetPercent) / cpuBudgetPercent;
+  checkpointThrottlerConfig =
+      util::Throttler::Config{.sleepMs = sleepMs, .workMs = kWorkMs};
+  checkpointMaxSegments = maxSegments;
+  return *this;
+}
+
 template <typename T>
 ObjectCacheConfig<T>& ObjectCacheConfig<T>::setItemReaperInterval(
     std::chrono::milliseconds _reaperInterval) {
@@ -438,6 +491,12 @@ const ObjectCacheConfig<T>& ObjectCacheConfig<T>::validate() const {
         "Object size tracking has to be enabled to track object size "
         "distribution");
   }
+
+  if (checkpointIntervalMs &&
+      (persistBaseFilePath.empty() || !serializeCb || !deserializeCb)) {
+    throw std::invalid_argument(
+        "Cache persistence has to be enabled to checkpoint in the background");
+  }
   return *this;
 }
 
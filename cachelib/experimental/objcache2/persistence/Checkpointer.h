@@ -0,0 +1,704 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/container/F14Map.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/Hash.h"
+#include "cachelib/common/PeriodicWorker.h"
+#include "cachelib/common/Serialization.h"
+#include "cachelib/common/Throttler.h"
+#include "cachelib/common/Time.h"
+#include "cachelib/common/Utils.h"
+#include "cachelib/experimental/objcache2/persistence/Serialization.h"
+#include "cachelib/experimental/objcache2/persistence/gen-cpp2/persistent_data_types.h"
+#include "cachelib/navy/serialization/RecordIO.h"
+
+namespace facebook::cachelib::objcache2 {
+// Keys changed since the checkpointer last wrote them. Writers mark a key
+// under the lock of its shard and the checkpointer takes all shards at once,
+// so marking never waits for a checkpoint to be written.
+class DirtyKeySet {
+ public:
+  // key -> true if the key was removed
+  using Changes = folly::F14FastMap<std::string, bool>;
+
+  // Records that @key was inserted, replaced or mutated.
+  void markUpdated(folly::StringPiece key) { mark(key, false); }
+
+  // Records that @key was removed.
+  void markRemoved(folly::StringPiece key) { mark(key, true); }
+
+  // Returns the changes of every shard and clears the set.
+  std::vector<Changes> take() {
+    std::vector<Changes> changes(kNumShards);
+    for (size_t i = 0; i < kNumShards; i++) {
+      std::lock_guard<std::mutex> l(shards_[i].mutex);
+      changes[i].swap(shards_[i].keys);
+    }
+    return changes;
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> l(shard.mutex);
+      size += shard.keys.size();
+    }
+    return size;
+  }
+
+ private:
+  static constexpr size_t kNumShards = 64;
+
+  struct Shard {
+    mutable std::mutex mutex;
+    Changes keys;
+  };
+
+  void mark(folly::StringPiece key, bool removed) {
+    auto& shard = shards_[MurmurHash2{}(key.data(), key.size()) % kNumShards];
+    std::lock_guard<std::mutex> l(shard.mutex);
+    // the latest change of a key wins
+    shard.keys.insert_or_assign(key.str(), removed);
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+// Continuously writes the changed objects of an object-cache to disk so that
+// the cache can be recovered after a crash without a persist() at shutdown.
+//
+// The checkpoint is a sequence of append-only segment files
+// "baseFilePath_ckpt_<id>". The segment named by the manifest
+// "baseFilePath_ckpt_manifest" holds a full snapshot of the cache; every
+// later segment holds the keys that changed since, each written with its
+// value at the time of writing or as a tombstone if it was removed. Because
+// a record always carries the latest value of its key, replaying the
+// segments in order and keeping the last record of every key yields a state
+// the cache was in at some point after the last completed run.
+//
+// The first run of a checkpointer writes a snapshot, and so does every run
+// after the number of segments exceeds maxSegments. A snapshot is written as
+// the segment after the last one of the current checkpoint, which stays the
+// one to recover from until the snapshot is synced and the manifest is
+// switched to it atomically; only then are the older segments deleted. The
+// changes taken before the snapshot are first written to the current
+// checkpoint, and a snapshot segment starts with a synced marker record at
+// which recovery stops, so a crash in the middle of a snapshot recovers the
+// state at its start. A segment is synced before the next one is started,
+// so a crash only loses the tail of the last segment. A record torn by a
+// crash fails its checksum and is skipped on recovery.
+//
+// The checkpointer serializes objects while the cache keeps serving them, so
+// objects mutated in place must be synchronized with the serialize callback
+// by the user, as they must be for concurrent readers.
+template <typename ObjectCache>
+class Checkpointer : public PeriodicWorker {
+ public:
+  using SerializeCb = typename ObjectCache::SerializeCb;
+
+  // @param objCache          the cache to checkpoint
+  // @param dirtyKeys         keys changed by the cache since the last run
+  // @param baseFilePath      base path of the checkpoint files
+  // @param serializeCb       callback to serialize an object
+  // @param maxSegments       number of segments after which the checkpoint is
+  //                          compacted into a new snapshot
+  // @param throttlerConfig   limits the share of a core used by a run
+  Checkpointer(ObjectCache& objCache,
+               DirtyKeySet& dirtyKeys,
+               std::string baseFilePath,
+               SerializeCb& serializeCb,
+               uint32_t maxSegments,
+               const util::Throttler::Config& throttlerConfig);
+
+  // Write all pending changes without throttling and sync them to disk.
+  // Used by persist(). Runs are serialized, so this is safe to call while the
+  // worker is running.
+  // @return false if the checkpoint could not be written
+  bool flush() {
+    return checkpoint(util::Throttler::Config::makeNoThrottleConfig(),
+                      true /* sync */);
+  }
+
+  void getCounters(const util::CounterVisitor& visitor) const;
+
+  // @return the path of the segment with the given id
+  static std::string getSegmentPath(const std::string& basePath, uint64_t id) {
+    return folly::sformat("{}_ckpt_{}", basePath, id);
+  }
+
+  // @return the path of the checkpoint manifest
+  static std::string getManifestPath(const std::string& basePath) {
+    return folly::sformat("{}_ckpt_manifest", basePath);
+  }
+
+  // @return the id of the snapshot segment of the checkpoint, or nullopt if
+  //         there is no checkpoint at the base path
+  // @throw std::exception if the manifest cannot be deserialized
+  static std::optional<uint64_t> readManifest(const std::string& basePath);
+
+  static bool segmentExists(const std::string& basePath, uint64_t id) {
+    return ::access(getSegmentPath(basePath, id).c_str(), F_OK) == 0;
+  }
+
+ private:
+  // Minimum size of a segment before the checkpointer starts a new one
+  static constexpr size_t kMinSegmentBytes = 1024 * 1024;
+
+  void work() override final {
+    checkpoint(throttlerConfig_, false /* sync */);
+  }
+
+  // @param sync  whether to sync the current segment to disk at the end
+  bool checkpoint(const util::Throttler::Config& throttlerConfig, bool sync);
+
+  // Write a full snapshot of the cache into a new segment and make it the
+  // base of the checkpoint.
+  void writeSnapshot(util::Throttler& throttler);
+
+  // Write the current value of every key changed since the last run, or a
+  // tombstone if the key is no longer in the cache.
+  void writeChanges(util::Throttler& throttler);
+
+  template <typename Handle>
+  void writeObject(const Handle& hdl);
+
+  void writeTombstone(folly::StringPiece key);
+
+  // Write the record that marks the current segment as a snapshot.
+  void writeSnapshotMarker();
+
+  void appendRecord(const persistence::CheckpointRecord& record);
+
+  // Create (or truncate) the segment with the given id and write to it.
+  void openSegment(uint64_t id);
+
+  void writeManifest(uint64_t baseSegmentId);
+
+  // fsync the current segment.
+  // @throw std::system_error on failure
+  void syncSegment();
+
+  // fsync the directory of the checkpoint files, making created, renamed and
+  // deleted files durable.
+  // @throw std::system_error on failure
+  void syncDirectory();
+
+  // Delete all segments older than the given id.
+  void removeSegmentsBefore(uint64_t id);
+
+  ObjectCache& objCache_;
+  DirtyKeySet& dirtyKeys_;
+  const std::string baseFilePath_;
+  SerializeCb& serializeCb_;
+  const uint32_t maxSegments_;
+  const util::Throttler::Config throttlerConfig_;
+
+  // serializes runs of the worker with flush()
+  std::mutex mutex_;
+
+  std::unique_ptr<RecordWriter> writer_;
+  // the segment writer_ appends to, kept to sync it
+  folly::File segmentFile_;
+  // whether this checkpointer has written a snapshot. Until it has, the
+  // segments on disk may not reflect the cache.
+  bool snapshotWritten_{false};
+  uint64_t baseSegmentId_{0};
+  uint64_t currentSegmentId_{0};
+  uint64_t nextSegmentId_{0};
+  size_t segmentBytes_{0};
+  size_t snapshotBytes_{0};
+
+  std::atomic<uint64_t> numRecords_{0};
+  std::atomic<uint64_t> numTombstones_{0};
+  std::atomic<uint64_t> numBytes_{0};
+  std::atomic<uint64_t> numSnapshots_{0};
+  std::atomic<uint64_t> numErrors_{0};
+  std::atomic<uint64_t> numSegments_{0};
+};
+
+// Restores the objects of the latest checkpoint written by a Checkpointer.
+// Segments are read and objects are deserialized in parallel; the records are
+// merged in segment order in between so that the last record of a key wins.
+template <typename ObjectCache>
+class CheckpointRestorer {
+ public:
+  using DeserializeCb = typename ObjectCache::DeserializeCb;
+  using Checkpointer = Checkpointer<ObjectCache>;
+
+  explicit CheckpointRestorer(uint32_t threadCount,
+                              const std::string& baseFilePath,
+                              DeserializeCb& deserializeCb,
+                              ObjectCache& objCache)
+      : threadCount_(std::max<uint32_t>(threadCount, 1)),
+        baseFilePath_(baseFilePath),
+        deserializeCb_(deserializeCb),
+        objCache_(objCache) {}
+
+  // @return false if there is no checkpoint or it could not be read
+  bool run();
+
+  // @return number of expired objects that are not restored.
+  uint32_t getNumExpired() const { return numExpired_; }
+
+ private:
+  // Run fn(i) for i in [0, n) on up to threadCount_ threads.
+  template <typename Fn>
+  void runInParallel(size_t n, Fn&& fn);
+
+  // Records of a segment in the order they were written. Records that fail
+  // to deserialize are skipped.
+  static std::vector<persistence::CheckpointRecord> readSegment(
+      const std::string& path);
+
+  static bool isSnapshot(
+      const std::vector<persistence::CheckpointRecord>& records) {
+    return !records.empty() && records.front().snapshot().value();
+  }
+
+  void restoreItem(persistence::Item& item, uint32_t currentTime);
+
+  const uint32_t threadCount_;
+  const std::string baseFilePath_;
+  DeserializeCb& deserializeCb_;
+  ObjectCache& objCache_;
+  std::atomic<uint32_t> numExpired_{0};
+};
+
+template <typename ObjectCache>
+Checkpointer<ObjectCache>::Checkpointer(
+    ObjectCache& objCache,
+    DirtyKeySet& dirtyKeys,
+    std::string baseFilePath,
+    SerializeCb& serializeCb,
+    uint32_t maxSegments,
+    const util::Throttler::Config& throttlerConfig)
+    : objCache_(objCache),
+      dirtyKeys_(dirtyKeys),
+      baseFilePath_(std::move(baseFilePath)),
+      serializeCb_(serializeCb),
+      maxSegments_(maxSegments),
+      throttlerConfig_(throttlerConfig) {
+  // continue after the segments of the previous checkpoint; they stay valid
+  // until our first snapshot replaces them
+  try {
+    baseSegmentId_ = readManifest(baseFilePath_).value_or(0);
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Checkpointer failed to read the manifest, reason = {}",
+          folly::exceptionStr(e));
+  }
+  nextSegmentId_ = baseSegmentId_;
+  while (segmentExists(baseFilePath_, nextSegmentId_)) {
+    nextSegmentId_++;
+  }
+}
+
+template <typename ObjectCache>
+std::optional<uint64_t> Checkpointer<ObjectCache>::readManifest(
+    const std::string& basePath) {
+  std::string content;
+  if (!folly::readFile(getManifestPath(basePath).c_str(), content)) {
+    return std::nullopt;
+  }
+  Deserializer deserializer(
+      reinterpret_cast<const uint8_t*>(content.data()),
+      reinterpret_cast<const uint8_t*>(content.data() + content.size()));
+  auto manifest = deserializer.deserialize<persistence::CheckpointManifest>();
+  return static_cast<uint64_t>(manifest.baseSegmentId().value());
+}
+
+template <typename ObjectCache>
+bool Checkpointer<ObjectCache>::checkpoint(
+    const util::Throttler::Config& throttlerConfig, bool sync) {
+  std::lock_guard<std::mutex> l(mutex_);
+  util::Throttler throttler(throttlerConfig);
+  try {
+    if (!snapshotWritten_ ||
+        currentSegmentId_ - baseSegmentId_ + 1 > maxSegments_) {
+      writeSnapshot(throttler);
+    } else {
+      writeChanges(throttler);
+    }
+    if (sync) {
+      syncSegment();
+    }
+  } catch (const std::exception& e) {
+    numErrors_++;
+    // the changes taken by this run are lost, so start over with a snapshot
+    snapshotWritten_ = false;
+    XLOGF(ERR, "Checkpointer failed to write the checkpoint, reason = {}",
+          folly::exceptionStr(e));
+    return false;
+  }
+  return true;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::writeSnapshot(util::Throttler& throttler) {
+  // The current checkpoint is recovered from if we crash before the manifest
+  // is switched, so bring it up to the start of the snapshot. Without an
+  // open segment there is no checkpoint of ours yet, and the changes are
+  // left for the first segment after the snapshot.
+  if (writer_) {
+    writeChanges(throttler);
+  }
+
+  const uint64_t id = nextSegmentId_++;
+  openSegment(id);
+  // synced ahead of the objects so that recovery never mistakes a partial
+  // snapshot for changes
+  writeSnapshotMarker();
+  syncSegment();
+  for (auto itr = objCache_.begin(); itr != objCache_.end(); ++itr) {
+    if (!itr->isExpired()) {
+      writeObject(itr.asHandle());
+    }
+    throttler.throttle();
+  }
+  snapshotBytes_ = segmentBytes_;
+
+  // the manifest must not point to a snapshot that a crash can still lose
+  syncSegment();
+  writeManifest(id);
+  removeSegmentsBefore(id);
+  baseSegmentId_ = id;
+  snapshotWritten_ = true;
+  numSnapshots_++;
+  numSegments_ = 1;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::writeChanges(util::Throttler& throttler) {
+  for (auto& changes : dirtyKeys_.take()) {
+    for (auto& [key, removed] : changes) {
+      if (removed) {
+        writeTombstone(key);
+      } else if (auto hdl = objCache_.l1Cache_->peek(key);
+                 hdl && !hdl->isExpired()) {
+        writeObject(hdl);
+      } else {
+        writeTombstone(key);
+      }
+      throttler.throttle();
+    }
+  }
+
+  // Segments grow with the snapshot so that a compaction rewrites about as
+  // much data as the changes it discards.
+  if (segmentBytes_ >=
+      std::max<size_t>(kMinSegmentBytes, snapshotBytes_ / maxSegments_)) {
+    openSegment(nextSegmentId_++);
+    numSegments_++;
+  }
+}
+
+template <typename ObjectCache>
+template <typename Handle>
+void Checkpointer<ObjectCache>::writeObject(const Handle& hdl) {
+  auto itemPtr =
+      reinterpret_cast<const typename ObjectCache::Item*>(hdl->getMemory());
+  auto payloadIobuf = serializeCb_(
+      typename ObjectCache::Serializer(hdl->getKey(), itemPtr->objectPtr));
+  if (!payloadIobuf) {
+    numErrors_++;
+    XLOG_EVERY_N(ERR, 1000) << folly::sformat(
+        "Checkpointer failed to serialize object for key = {}", hdl->getKey());
+    // an older value of the key may be in the checkpoint
+    writeTombstone(hdl->getKey());
+    return;
+  }
+
+  persistence::CheckpointRecord record;
+  auto& item = record.item().value();
+  item.key().value() = hdl->getKey().str();
+  item.objectSize().value() = itemPtr->objectSize;
+  item.expiryTime().value() = hdl->getExpiryTime();
+  item.payload().value() = payloadIobuf->moveToFbString().toStdString();
+  record.removed().value() = false;
+  appendRecord(record);
+  numRecords_++;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::writeTombstone(folly::StringPiece key) {
+  persistence::CheckpointRecord record;
+  record.item().value().key().value() = key.str();
+  record.removed().value() = true;
+  appendRecord(record);
+  numTombstones_++;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::writeSnapshotMarker() {
+  persistence::CheckpointRecord record;
+  record.snapshot().value() = true;
+  appendRecord(record);
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::appendRecord(
+    const persistence::CheckpointRecord& record) {
+  auto iobuf = Serializer::serializeToIOBuf(record);
+  const auto length = iobuf->computeChainDataLength();
+  writer_->writeRecord(std::move(iobuf));
+  segmentBytes_ += length;
+  numBytes_ += length;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::openSegment(uint64_t id) {
+  // later segments are only replayed if the ones before them are complete
+  if (writer_) {
+    syncSegment();
+  }
+  folly::File file(getSegmentPath(baseFilePath_, id),
+                   O_CREAT | O_WRONLY | O_TRUNC);
+  segmentFile_ = file.dup();
+  writer_ = navy::createFileRecordWriter(std::move(file));
+  syncDirectory();
+  currentSegmentId_ = id;
+  segmentBytes_ = 0;
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::syncSegment() {
+  folly::checkUnixError(::fsync(segmentFile_.fd()),
+                        "Checkpointer failed to sync segment ",
+                        currentSegmentId_);
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::syncDirectory() {
+  auto dir = std::filesystem::path(baseFilePath_).parent_path();
+  folly::File dirFile(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY);
+  folly::checkUnixError(::fsync(dirFile.fd()),
+                        "Checkpointer failed to sync directory ",
+                        dir.string());
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::writeManifest(uint64_t baseSegmentId) {
+  persistence::CheckpointManifest manifest;
+  manifest.baseSegmentId().value() = static_cast<int64_t>(baseSegmentId);
+  auto content = Serializer::serializeToIOBuf(manifest)->moveToFbString();
+  // written to a temporary file and renamed, so a reader sees either the old
+  // or the new manifest. The rename is synced before the old segments are
+  // deleted.
+  folly::writeFileAtomic(getManifestPath(baseFilePath_),
+                         folly::StringPiece{content}, 0644,
+                         folly::SyncType::WITH_SYNC);
+  syncDirectory();
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::removeSegmentsBefore(uint64_t id) {
+  // Segments are deleted oldest first, so the ones left behind by an
+  // interrupted deletion are right below the base and found here next time.
+  uint64_t first = id;
+  while (first > 0 && segmentExists(baseFilePath_, first - 1)) {
+    first--;
+  }
+  for (; first < id; first++) {
+    if (::unlink(getSegmentPath(baseFilePath_, first).c_str()) != 0) {
+      XLOGF(ERR, "Checkpointer failed to delete segment {}, errno = {}", first,
+            errno);
+    }
+  }
+}
+
+template <typename ObjectCache>
+void Checkpointer<ObjectCache>::getCounters(
+    const util::CounterVisitor& visitor) const {
+  visitor("objcache.checkpoint.records", numRecords_.load(),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("objcache.checkpoint.tombstones", numTombstones_.load(),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("objcache.checkpoint.bytes", numBytes_.load(),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("objcache.checkpoint.snapshots", numSnapshots_.load(),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("objcache.checkpoint.errors", numErrors_.load(),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("objcache.checkpoint.segments", numSegments_.load());
+  visitor("objcache.checkpoint.dirty_keys", dirtyKeys_.size());
+}
+
+template <typename ObjectCache>
+template <typename Fn>
+void CheckpointRestorer<ObjectCache>::runInParallel(size_t n, Fn&& fn) {
+  const size_t numThreads = std::min<size_t>(threadCount_, n);
+  std::vector<std::thread> ts;
+  for (size_t t = 0; t < numThreads; t++) {
+    ts.emplace_back([&, t]() {
+      for (size_t i = t; i < n; i += numThreads) {
+        fn(i);
+      }
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+}
+
+template <typename ObjectCache>
+std::vector<persistence::CheckpointRecord>
+CheckpointRestorer<ObjectCache>::readSegment(const std::string& path) {
+  std::vector<persistence::CheckpointRecord> records;
+  auto reader = navy::createFileRecordReader(folly::File(path, O_RDONLY));
+  while (!reader->isEnd()) {
+    auto iobuf = reader->readRecord();
+    try {
+      Deserializer deserializer(iobuf->data(), iobuf->data() + iobuf->length());
+      records.push_back(
+          deserializer.deserialize<persistence::CheckpointRecord>());
+    } catch (const std::exception& e) {
+      XLOG_EVERY_N(ERR, 1000) << folly::sformat(
+          "CheckpointRestorer skipped a record in {}, reason = {}", path,
+          folly::exceptionStr(e));
+    }
+  }
+  return records;
+}
+
+template <typename ObjectCache>
+bool CheckpointRestorer<ObjectCache>::run() {
+  std::optional<uint64_t> baseSegmentId;
+  try {
+    baseSegmentId = Checkpointer::readManifest(baseFilePath_);
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "CheckpointRestorer failed to read the manifest, reason = {}",
+          folly::exceptionStr(e));
+    return false;
+  }
+  if (!baseSegmentId) {
+    XLOGF(INFO, "CheckpointRestorer found no checkpoint at {}", baseFilePath_);
+    return false;
+  }
+
+  std::vector<std::string> paths;
+  for (uint64_t id = *baseSegmentId;
+       Checkpointer::segmentExists(baseFilePath_, id);
+       id++) {
+    paths.push_back(Checkpointer::getSegmentPath(baseFilePath_, id));
+  }
+  if (paths.empty()) {
+    XLOGF(ERR, "CheckpointRestorer found no snapshot segment {}",
+          *baseSegmentId);
+    return false;
+  }
+
+  std::vector<std::vector<persistence::CheckpointRecord>> segments(
+      paths.size());
+  std::atomic<bool> success{true};
+  runInParallel(paths.size(), [&](size_t i) {
+    try {
+      segments[i] = readSegment(paths[i]);
+    } catch (const std::exception& e) {
+      XLOGF(ERR, "CheckpointRestorer failed to read {}, reason = {}", paths[i],
+            folly::exceptionStr(e));
+      success = false;
+    }
+  });
+  if (!success) {
+    return false;
+  }
+
+  // A snapshot the manifest does not name was interrupted by a crash; the
+  // checkpoint ends right before it.
+  size_t numSegments = 1;
+  while (numSegments < segments.size() &&
+         !isSnapshot(segments[numSegments])) {
+    numSegments++;
+  }
+  segments.resize(numSegments);
+
+  // replay the segments in order; the last record of a key wins
+  folly::F14FastMap<std::string, persistence::Item> latest;
+  for (auto& records : segments) {
+    for (auto& record : records) {
+      if (record.snapshot().value()) {
+        continue;
+      }
+      auto& item = record.item().value();
+      if (record.removed().value()) {
+        latest.erase(item.key().value());
+      } else {
+        auto key = item.key().value();
+        latest.insert_or_assign(std::move(key), std::move(item));
+      }
+    }
+    records = {};
+  }
+
+  std::vector<persistence::Item> items;
+  items.reserve(latest.size());
+  for (auto& kv : latest) {
+    items.push_back(std::move(kv.second));
+  }
+  latest = {};
+
+  const uint32_t currentTime = util::getCurrentTimeSec();
+  runInParallel(items.size(),
+                [&](size_t i) { restoreItem(items[i], currentTime); });
+  XLOGF(INFO,
+        "CheckpointRestorer restored {} segments, found {} expired objects",
+        numSegments, numExpired_.load());
+  return true;
+}
+
+template <typename ObjectCache>
+void CheckpointRestorer<ObjectCache>::restoreItem(persistence::Item& item,
+                                                  uint32_t currentTime) {
+  uint32_t expiryTime = item.expiryTime().value();
+  // no need to recover if object is already expired
+  if (expiryTime > 0 && expiryTime <= currentTime) {
+    numExpired_++;
+    return;
+  }
+  uint32_t ttlSecs = (expiryTime == 0) ? 0 : expiryTime - currentTime;
+  try {
+    bool success = deserializeCb_(typename ObjectCache::Deserializer(
+        item.key().value(), item.payload().value(), item.objectSize().value(),
+        ttlSecs, objCache_));
+    if (!success) {
+      XLOG_EVERY_N(ERR, 1000) << folly::sformat(
+          "CheckpointRestorer failed to deserialize object for key = {}",
+          item.key().value());
+    }
+  } catch (const std::exception& e) {
+    XLOG_EVERY_N(ERR, 1000) << folly::sformat(
+        "CheckpointRestorer failed to deserialize object for key = {}, "
+        "exception = {}",
+        item.key().value(), folly::exceptionStr(e));
+  }
+}
+} // namespace facebook::cachelib::objcache2
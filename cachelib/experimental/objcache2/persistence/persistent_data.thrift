@@ -26,3 +26,21 @@ struct Item {
 struct Metadata {
   1: i32 threadCount;
 }
+
+// A change written by the background checkpointer. Records are appended to
+// checkpoint segments in the order they were written, and the last record of
+// a key wins on recovery.
+struct CheckpointRecord {
+  1: Item item;
+  // true if the key was removed; only item.key is set
+  2: bool removed;
+  // true only for the record that starts a snapshot segment; item is unset
+  3: bool snapshot;
+}
+
+// Points to the first segment of the current checkpoint. That segment holds
+// a full snapshot of the cache and the segments after it hold the changes
+// since the snapshot.
+struct CheckpointManifest {
+  1: i64 baseSegmentId;
+}
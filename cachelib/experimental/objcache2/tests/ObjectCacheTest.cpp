@@ -1462,6 +1462,131 @@ class ObjectCacheTest : public ::testing::Test {
     }
   }
 
+  void testCheckpointing() {
+    auto persistBaseFilePath = std::tmpnam(nullptr);
+    ThriftFoo foo1;
+    foo1.a().value() = 1;
+    foo1.b().value() = 2;
+    foo1.c().value() = 3;
+
+    ThriftFoo foo2;
+    foo2.a().value() = 4;
+    foo2.b().value() = 5;
+    foo2.c().value() = 6;
+
+    ObjectCacheConfig config;
+    config.setCacheName("test")
+        .setCacheCapacity(10'000 /*l1EntriesLimit*/)
+        .setItemDestructor([&](ObjectCacheDestructorData data) {
+          data.deleteObject<ThriftFoo>();
+        });
+    config.enableCheckpointing(std::chrono::milliseconds{10});
+    // checkpointing needs cache persistence
+    EXPECT_THROW(ObjectCache::create(config), std::invalid_argument);
+    EXPECT_THROW(config.enableCheckpointing(std::chrono::milliseconds{0}),
+                 std::invalid_argument);
+    EXPECT_THROW(
+        config.enableCheckpointing(std::chrono::milliseconds{10}, 101),
+        std::invalid_argument);
+
+    config.enablePersistence(
+        4, persistBaseFilePath,
+        [&](typename ObjectCache::Serializer serializer) {
+          return serializer.template serialize<ThriftFoo>();
+        },
+        [&](typename ObjectCache::Deserializer deserializer) {
+          return deserializer.template deserialize<ThriftFoo>();
+        });
+
+    // The cache is destroyed without persist() to simulate a crash; the
+    // objects are only recovered from what the background checkpointer wrote.
+    {
+      auto objcache = ObjectCache::create(config);
+      // nothing to recover yet, but checkpointing starts
+      ASSERT_EQ(objcache->recover(), false);
+
+      objcache->insertOrReplace("Foo1", std::make_unique<ThriftFoo>(foo1));
+      objcache->insertOrReplace("Foo2", std::make_unique<ThriftFoo>(foo1));
+      objcache->insertOrReplace("Foo3", std::make_unique<ThriftFoo>(foo1));
+      objcache->remove("Foo3");
+      auto found = objcache->template findToWrite<ThriftFoo>("Foo2");
+      ASSERT_NE(nullptr, found);
+      objcache->mutateObject(found, [&]() { *found = foo2; });
+      std::this_thread::sleep_for(std::chrono::seconds{1});
+    }
+
+    {
+      auto objcache = ObjectCache::create(config);
+      ASSERT_EQ(objcache->recover(), true);
+
+      auto found1 = objcache->template find<ThriftFoo>("Foo1");
+      ASSERT_NE(nullptr, found1);
+      EXPECT_EQ(1, found1->a_ref());
+      auto found2 = objcache->template find<ThriftFoo>("Foo2");
+      ASSERT_NE(nullptr, found2);
+      EXPECT_EQ(4, found2->a_ref());
+      EXPECT_EQ(nullptr, objcache->template find<ThriftFoo>("Foo3"));
+      EXPECT_EQ(2, objcache->getNumEntries());
+
+      // changes after recovery go on top of the recovered objects
+      objcache->remove("Foo1");
+      objcache->insertOrReplace("Foo4", std::make_unique<ThriftFoo>(foo2));
+      std::this_thread::sleep_for(std::chrono::seconds{1});
+    }
+
+    {
+      auto objcache = ObjectCache::create(config);
+      ASSERT_EQ(objcache->recover(), true);
+      EXPECT_EQ(nullptr, objcache->template find<ThriftFoo>("Foo1"));
+      EXPECT_NE(nullptr, objcache->template find<ThriftFoo>("Foo2"));
+      EXPECT_NE(nullptr, objcache->template find<ThriftFoo>("Foo4"));
+      EXPECT_EQ(2, objcache->getNumEntries());
+
+      // persist() writes the changes the checkpointer has not written yet
+      objcache->stopAllWorkers();
+      objcache->remove("Foo2");
+      ASSERT_EQ(objcache->persist(), true);
+    }
+
+    {
+      auto objcache = ObjectCache::create(config);
+      ASSERT_EQ(objcache->recover(), true);
+      EXPECT_EQ(nullptr, objcache->template find<ThriftFoo>("Foo2"));
+      EXPECT_NE(nullptr, objcache->template find<ThriftFoo>("Foo4"));
+      EXPECT_EQ(1, objcache->getNumEntries());
+    }
+
+    // Simulate a crash in the middle of a snapshot: the segment after the
+    // checkpoint starts with the snapshot marker but misses "Foo4".
+    {
+      using Checkpointer = typename ObjectCache::Checkpointer;
+      auto id = Checkpointer::readManifest(persistBaseFilePath);
+      ASSERT_TRUE(id.has_value());
+      while (Checkpointer::segmentExists(persistBaseFilePath, *id)) {
+        (*id)++;
+      }
+      auto writer = navy::createFileRecordWriter(
+          folly::File(Checkpointer::getSegmentPath(persistBaseFilePath, *id),
+                      O_CREAT | O_WRONLY | O_TRUNC));
+      persistence::CheckpointRecord marker;
+      marker.snapshot().value() = true;
+      writer->writeRecord(Serializer::serializeToIOBuf(marker));
+      persistence::CheckpointRecord record;
+      record.item().value().key().value() = "Foo5";
+      record.item().value().payload().value() =
+          Serializer::serializeToIOBuf(foo1)->moveToFbString().toStdString();
+      writer->writeRecord(Serializer::serializeToIOBuf(record));
+    }
+
+    {
+      auto objcache = ObjectCache::create(config);
+      ASSERT_EQ(objcache->recover(), true);
+      EXPECT_NE(nullptr, objcache->template find<ThriftFoo>("Foo4"));
+      EXPECT_EQ(nullptr, objcache->template find<ThriftFoo>("Foo5"));
+      EXPECT_EQ(1, objcache->getNumEntries());
+    }
+  }
+
   void testGetTtl() {
     const uint32_t ttlSecs = 600;
 
@@ -1866,6 +1991,7 @@ TYPED_TEST(ObjectCacheTest, PersistenceUserDefinedCb) {
 TYPED_TEST(ObjectCacheTest, PersistenceDesrFailure) {
   this->testPersistenceDesrFailure();
 }
+TYPED_TEST(ObjectCacheTest, Checkpointing) { this->testCheckpointing(); }
 TYPED_TEST(ObjectCacheTest, GetTtl) { this->testGetTtl(); }
 TYPED_TEST(ObjectCacheTest, UpdateTtl) { this->testUpdateTtl(); }
 TYPED_TEST(ObjectCacheTest, GetLastAccessTime) {
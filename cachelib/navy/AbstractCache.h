@@ -21,6 +21,7 @@
 #include <folly/Range.h>
 
 #include <functional>
+#include <string>
 #include <memory>
 #include <stdexcept>
 
@@ -130,9 +131,21 @@ class AbstractCache {
   //         false if AdissionPolicy is not set or not DynamicRandom.
   virtual bool updateMaxRateForDynamicRandomAP(uint64_t) = 0;
 
+  // Return the lifecycle traces of recent slow requests, one per line.
+  // Empty if request tracing is not enabled.
+  virtual std::string dumpSlowRequests() const { return {}; }
+
   // Get key and Buffer for a random sample
   virtual std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) = 0;
+
+  // Walks partition @partition out of @numPartitions disjoint partitions of
+  // the cache and calls @visitor for every item found. Different partitions
+  // can be walked concurrently from different threads. This reads the device,
+  // so it is meant for background analytics and dumps.
+  virtual void forEachItem(uint32_t partition,
+                           uint32_t numPartitions,
+                           const ItemVisitor& visitor) = 0;
 };
 } // namespace navy
 } // namespace cachelib
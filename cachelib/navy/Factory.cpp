@@ -19,6 +19,7 @@
 #include <folly/Format.h>
 #include <folly/Random.h>
 
+#include <functional>
 #include <stdexcept>
 
 #include "cachelib/navy/admission_policy/DynamicRandomAP.h"
@@ -65,14 +66,18 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     if (config_.evictionPolicy) {
       throw std::invalid_argument("There's already an eviction policy set");
     }
-    config_.evictionPolicy = std::make_unique<LruPolicy>(numRegions);
+    makeEvictionPolicy_ = [numRegions] {
+      return std::make_unique<LruPolicy>(numRegions);
+    };
+    config_.evictionPolicy = makeEvictionPolicy_();
   }
 
   void setFifoEvictionPolicy() override {
     if (config_.evictionPolicy) {
       throw std::invalid_argument("There's already an eviction policy set");
     }
-    config_.evictionPolicy = std::make_unique<FifoPolicy>();
+    makeEvictionPolicy_ = [] { return std::make_unique<FifoPolicy>(); };
+    config_.evictionPolicy = makeEvictionPolicy_();
   }
 
   void setSegmentedFifoEvictionPolicy(
@@ -81,8 +86,10 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
       throw std::invalid_argument("There's already an eviction policy set");
     }
     config_.numPriorities = static_cast<uint16_t>(segmentRatio.size());
-    config_.evictionPolicy =
-        std::make_unique<SegmentedFifoPolicy>(std::move(segmentRatio));
+    makeEvictionPolicy_ = [segmentRatio = std::move(segmentRatio)] {
+      return std::make_unique<SegmentedFifoPolicy>(segmentRatio);
+    };
+    config_.evictionPolicy = makeEvictionPolicy_();
   }
 
   void setReadBufferSize(uint32_t size) override {
@@ -118,18 +125,49 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     config_.preciseRemove = preciseRemove;
   }
 
+  void setIndexMetadata(bool keyFingerprint,
+                        uint32_t expiryGranularitySecs) override {
+    config_.indexMetadata.keyFingerprint = keyFingerprint;
+    config_.indexMetadata.expiryGranularitySecs = expiryGranularitySecs;
+  }
+
+  void setDiscardRate(uint64_t bytesPerSec) override {
+    config_.discardBytesPerSec = bytesPerSec;
+  }
+
+  void setIndexHugePages(util::HugePagePolicy policy) override {
+    config_.indexHugePages = policy;
+  }
+
+  void setSizeBands(std::vector<uint32_t> sizeBands) override {
+    config_.sizeBands = std::move(sizeBands);
+  }
+
+  void setExpiryTimeGetter(ExpiryTimeGetter getExpiryTime) {
+    config_.getExpiryTime = std::move(getExpiryTime);
+  }
+
   std::unique_ptr<Engine> create(JobScheduler& scheduler,
                                  ExpiredCheck checkExpired,
                                  DestructorCallback cb) && {
     config_.scheduler = &scheduler;
     config_.checkExpired = std::move(checkExpired);
     config_.destructorCb = std::move(cb);
+    // every size band gets an instance of the configured eviction policy
+    config_.sizeBandPolicies.clear();
+    if (makeEvictionPolicy_) {
+      for (size_t i = 0; i < config_.sizeBands.size(); i++) {
+        config_.sizeBandPolicies.push_back(makeEvictionPolicy_());
+      }
+    }
     config_.validate();
     return std::make_unique<BlockCache>(std::move(config_));
   }
 
  private:
   BlockCache::Config config_;
+  // creates an instance of the eviction policy set through set*EvictionPolicy
+  std::function<std::unique_ptr<EvictionPolicy>()> makeEvictionPolicy_;
 };
 
 class BigHashProtoImpl final : public BigHashProto {
@@ -155,6 +193,14 @@ class BigHashProtoImpl final : public BigHashProto {
     hashTableBitSize_ = hashTableBitSize;
   }
 
+  void setDirectory(uint32_t directorySize) override {
+    config_.directorySize = directorySize;
+  }
+
+  void setBloomFilterHugePages(util::HugePagePolicy policy) override {
+    bloomFilterHugePages_ = policy;
+  }
+
   void setDevice(Device* device) { config_.device = device; }
 
   void setDestructorCb(DestructorCallback cb) {
@@ -168,7 +214,8 @@ class BigHashProtoImpl final : public BigHashProto {
         throw std::invalid_argument{"invalid bucket size"};
       }
       config_.bloomFilter = std::make_unique<BloomFilter>(
-          config_.numBuckets(), numHashes_, hashTableBitSize_);
+          config_.numBuckets(), numHashes_, hashTableBitSize_,
+          bloomFilterHugePages_);
     }
     return std::make_unique<BigHash>(std::move(config_));
   }
@@ -178,6 +225,7 @@ class BigHashProtoImpl final : public BigHashProto {
   bool bloomFilterEnabled_{false};
   uint32_t numHashes_{};
   uint32_t hashTableBitSize_{};
+  util::HugePagePolicy bloomFilterHugePages_{util::HugePagePolicy::kNone};
 };
 
 class EnginePairProtoImpl final : public EnginePairProto {
@@ -202,6 +250,7 @@ class EnginePairProtoImpl final : public EnginePairProto {
 
   EnginePair create(Device* device,
                     ExpiredCheck checkExpired,
+                    ExpiryTimeGetter getExpiryTime,
                     DestructorCallback destructorCb,
                     JobScheduler& scheduler) {
     std::unique_ptr<Engine> bh;
@@ -220,6 +269,7 @@ class EnginePairProtoImpl final : public EnginePairProto {
       auto bcProto = dynamic_cast<BlockCacheProtoImpl*>(blockCacheProto_.get());
       if (bcProto != nullptr) {
         bcProto->setDevice(device);
+        bcProto->setExpiryTimeGetter(std::move(getExpiryTime));
         bc = std::move(*bcProto).create(scheduler, checkExpired, destructorCb);
       }
     }
@@ -261,6 +311,10 @@ class CacheProtoImpl final : public CacheProto {
     checkExpired_ = std::move(checkExpired);
   }
 
+  void setExpiryTimeGetter(ExpiryTimeGetter getExpiryTime) override {
+    getExpiryTime_ = std::move(getExpiryTime);
+  }
+
   void setDestructorCallback(DestructorCallback cb) override {
     destructorCb_ = std::move(cb);
   }
@@ -325,8 +379,8 @@ class CacheProtoImpl final : public CacheProto {
     for (auto& p : enginePairsProto_) {
       config_.enginePairs.push_back(
           dynamic_cast<EnginePairProtoImpl*>(p.get())->create(
-              config_.device.get(), checkExpired_, destructorCb_,
-              *config_.scheduler));
+              config_.device.get(), checkExpired_, getExpiryTime_,
+              destructorCb_, *config_.scheduler));
     }
 
     return std::make_unique<Driver>(std::move(config_));
@@ -334,6 +388,7 @@ class CacheProtoImpl final : public CacheProto {
 
  private:
   ExpiredCheck checkExpired_;
+  ExpiryTimeGetter getExpiryTime_;
   DestructorCallback destructorCb_;
   std::vector<std::unique_ptr<EnginePairProto>> enginePairsProto_;
   Driver::Config config_;
@@ -86,6 +86,23 @@ class BlockCacheProto {
 
   // (Optional) Set if the preciseRemove flag.
   virtual void setPreciseRemove(bool preciseRemove) = 0;
+
+  // (Optional) Keep key fingerprints and/or coarse expiry times in the index.
+  // See Index::MetadataConfig.
+  virtual void setIndexMetadata(bool keyFingerprint,
+                                uint32_t expiryGranularitySecs) = 0;
+
+  // (Optional) Discard reclaimed regions on the device at up to
+  // @bytesPerSec. 0 disables discards.
+  virtual void setDiscardRate(uint64_t bytesPerSec) = 0;
+
+  // (Optional) Back the index buckets with huge pages.
+  virtual void setIndexHugePages(util::HugePagePolicy policy) = 0;
+
+  // (Optional) Segregate items by size into bands with their own regions and
+  // eviction policy. @sizeBands are the ascending upper bounds (bytes) of all
+  // but the last band. Default: a single band.
+  virtual void setSizeBands(std::vector<uint32_t> sizeBands) = 0;
 };
 
 // BigHash engine proto. BigHash is used to cache small objects (under 2KB)
@@ -106,6 +123,13 @@ class BigHashProto {
   // bit array of @hashTableBitSize bits.
   virtual void setBloomFilter(uint32_t numHashes,
                               uint32_t hashTableBitSize) = 0;
+
+  // Reserve @directorySize bytes at the start of each bucket for a key
+  // fingerprint directory so lookups only read the blocks they need.
+  virtual void setDirectory(uint32_t directorySize) = 0;
+
+  // (Optional) Back the Bloom filter bit arrays with huge pages.
+  virtual void setBloomFilterHugePages(util::HugePagePolicy policy) = 0;
 };
 
 class EnginePairProto {
@@ -156,6 +180,10 @@ class CacheProto {
   // Set callback used to if the passed NvmItem is expired
   virtual void setExpiredCheck(ExpiredCheck checkExpired) = 0;
 
+  // (Optional) Set callback to get the expiry time of the passed NvmItem.
+  // Only used if the block cache index keeps expiry times.
+  virtual void setExpiryTimeGetter(ExpiryTimeGetter getExpiryTime) = 0;
+
   // (Optional) Set destructor callback.
   //   - Callback invoked exactly once for every insert, even if it was removed
   //     manually from the cache with @AbstractCache::remove.
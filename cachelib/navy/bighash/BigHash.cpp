@@ -23,6 +23,7 @@
 
 #include "cachelib/common/Hash.h"
 #include "cachelib/navy/bighash/Bucket.h"
+#include "cachelib/navy/bighash/BucketDirectory.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/common/Utils.h"
 #include "cachelib/navy/serialization/Serialization.h"
@@ -64,6 +65,15 @@ BigHash::Config& BigHash::Config::validate() {
     throw std::invalid_argument("device cannot be null");
   }
 
+  if (directorySize > 0 &&
+      (directorySize >= bucketSize ||
+       BucketDirectory::capacity(directorySize) == 0)) {
+    throw std::invalid_argument(
+        folly::sformat("invalid directory size: {}, bucket size: {}",
+                       directorySize,
+                       bucketSize));
+  }
+
   if (bloomFilter && bloomFilter->numFilters() != numBuckets()) {
     throw std::invalid_argument(
         folly::sformat("bloom filter #filters mismatch #buckets: {} vs {}",
@@ -87,14 +97,23 @@ BigHash::BigHash(Config&& config, ValidConfigTag)
       bucketSize_{config.bucketSize},
       cacheBaseOffset_{config.cacheBaseOffset},
       numBuckets_{config.numBuckets()},
+      directorySize_{config.directorySize},
+      partialDirectoryReads_{
+          directorySize_ > 0 &&
+          directorySize_ % config.device->getIOAlignmentSize() == 0 &&
+          bucketSize_ >= kMinPartialReadBlocks *
+                             config.device->getIOAlignmentSize()},
       bloomFilter_{std::move(config.bloomFilter)},
       device_{*config.device},
       placementHandle_{device_.allocatePlacementHandle()} {
   XLOGF(INFO,
-        "BigHash created: buckets: {}, bucket size: {}, base offset: {}",
+        "BigHash created: buckets: {}, bucket size: {}, base offset: {}, "
+        "directory size: {}, partial directory reads: {}",
         numBuckets_,
         bucketSize_,
-        cacheBaseOffset_);
+        cacheBaseOffset_,
+        directorySize_,
+        partialDirectoryReads_);
   reset();
 }
 
@@ -122,6 +141,9 @@ void BigHash::reset() {
   bfProbeCount_.set(0);
   checksumErrorCount_.set(0);
   usedSizeBytes_.set(0);
+  dirLookupCount_.set(0);
+  dirFallbackCount_.set(0);
+  dirFingerprintCollisionCount_.set(0);
 }
 
 double BigHash::bfFalsePositivePct() const {
@@ -135,7 +157,7 @@ double BigHash::bfFalsePositivePct() const {
 
 uint64_t BigHash::getMaxItemSize() const {
   auto itemOverhead = BucketStorage::slotSize(sizeof(details::BucketEntry));
-  return bucketSize_ - sizeof(Bucket) - itemOverhead;
+  return bucketSize_ - directorySize_ - sizeof(Bucket) - itemOverhead;
 }
 
 std::pair<Status, std::string> BigHash::getRandomAlloc(Buffer& value) {
@@ -151,7 +173,7 @@ std::pair<Status, std::string> BigHash::getRandomAlloc(Buffer& value) {
       return std::make_pair(Status::NotFound, "");
     }
 
-    bucket = reinterpret_cast<Bucket*>(buffer.data());
+    bucket = getBucket(buffer);
   }
 
   auto [key, valueView] = bucket->getRandomAlloc();
@@ -163,6 +185,36 @@ std::pair<Status, std::string> BigHash::getRandomAlloc(Buffer& value) {
   return std::make_pair(Status::Ok, key);
 }
 
+void BigHash::forEachItem(uint32_t partition,
+                          uint32_t numPartitions,
+                          const ItemVisitor& visitor) {
+  const uint64_t beginBucket = numBuckets_ * partition / numPartitions;
+  const uint64_t endBucket = numBuckets_ * (partition + 1) / numPartitions;
+  for (uint64_t i = beginBucket; i < endBucket; i++) {
+    BucketId bid{static_cast<uint32_t>(i)};
+    Buffer buffer;
+    {
+      std::shared_lock<SharedMutex> lock{getMutex(bid)};
+      buffer = readBucket(bid);
+    }
+    if (buffer.isNull()) {
+      ioErrorCount_.inc();
+      continue;
+    }
+
+    const auto* bucket = getBucket(buffer);
+    for (auto itr = bucket->getFirst(); !itr.done();
+         itr = bucket->getNext(itr)) {
+      const auto key = itr.key();
+      visitor(HashedKey::precomputed(
+                  folly::StringPiece{reinterpret_cast<const char*>(key.data()),
+                                     key.size()},
+                  itr.keyHash()),
+              itr.value());
+    }
+  }
+}
+
 void BigHash::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_bh_size", getSize());
   visitor("navy_bh_items", itemCount_.get());
@@ -207,6 +259,17 @@ void BigHash::getCounters(const CounterVisitor& visitor) const {
           checksumErrorCount_.get(),
           CounterVisitor::CounterType::RATE);
   visitor("navy_bh_used_size_bytes", usedSizeBytes_.get());
+  if (directorySize_ > 0) {
+    visitor("navy_bh_dir_lookups",
+            dirLookupCount_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bh_dir_fallbacks",
+            dirFallbackCount_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bh_dir_fp_collisions",
+            dirFingerprintCollisionCount_.get(),
+            CounterVisitor::CounterType::RATE);
+  }
   bucketExpirationsDist_x100_.visitQuantileEstimator(
       visitor, "navy_bh_expired_loop_x100");
 }
@@ -221,6 +284,7 @@ void BigHash::persist(RecordWriter& rw) {
   *pd.cacheBaseOffset() = cacheBaseOffset_;
   *pd.numBuckets() = numBuckets_;
   *pd.usedSizeBytes() = usedSizeBytes_.get();
+  *pd.directorySize() = directorySize_;
   serializeProto(pd, rw);
 
   if (bloomFilter_) {
@@ -245,7 +309,8 @@ bool BigHash::recover(RecordReader& rr) {
     auto configEquals =
         static_cast<uint64_t>(*pd.bucketSize()) == bucketSize_ &&
         static_cast<uint64_t>(*pd.cacheBaseOffset()) == cacheBaseOffset_ &&
-        static_cast<uint64_t>(*pd.numBuckets()) == numBuckets_;
+        static_cast<uint64_t>(*pd.numBuckets()) == numBuckets_ &&
+        static_cast<uint32_t>(*pd.directorySize()) == directorySize_;
     if (!configEquals) {
       auto configStr = serializeToJson(pd);
       XLOGF(ERR, "Recovery config: {}", configStr.c_str());
@@ -298,7 +363,7 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
       return Status::DeviceError;
     }
 
-    auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
+    auto* bucket = getBucket(buffer);
     oldRemainingBytes = bucket->remainingBytes();
     removed = bucket->remove(hk, cb);
     std::tie(evicted, evictExpired) =
@@ -369,6 +434,7 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
 
   Bucket* bucket{nullptr};
   Buffer buffer;
+  bool bucketValid{false};
 
   // scope of the lock is only needed until we read and mutate state for the
   // bucket. Once the bucket is read, the buffer is local and we can find
@@ -379,13 +445,36 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
       return Status::NotFound;
     }
 
-    buffer = readBucket(bid);
+    if (partialDirectoryReads_) {
+      if (auto status = lookupWithDirectory(bid, hk, value)) {
+        if (*status == Status::Ok) {
+          succLookupCount_.inc();
+        } else if (*status == Status::NotFound) {
+          bfFalsePositiveCount_.inc();
+        }
+        return *status;
+      }
+    }
+
+    buffer = readBucket(bid, &bucketValid);
     if (buffer.isNull()) {
       ioErrorCount_.inc();
       return Status::DeviceError;
     }
 
-    bucket = reinterpret_cast<Bucket*>(buffer.data());
+    bucket = getBucket(buffer);
+  }
+
+  // the directory of a reinitialized bucket still points at the old entries
+  if (directorySize_ > 0 && !partialDirectoryReads_ && bucketValid) {
+    if (auto status = findWithDirectory(buffer, hk, value)) {
+      if (*status == Status::Ok) {
+        succLookupCount_.inc();
+      } else {
+        bfFalsePositiveCount_.inc();
+      }
+      return *status;
+    }
   }
 
   auto valueView = bucket->find(hk);
@@ -426,7 +515,7 @@ Status BigHash::remove(HashedKey hk) {
       return Status::DeviceError;
     }
 
-    auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
+    auto* bucket = getBucket(buffer);
     oldRemainingBytes = bucket->remainingBytes();
     if (!bucket->remove(hk, cb)) {
       bfFalsePositiveCount_.inc();
@@ -515,7 +604,87 @@ void BigHash::flush() {
   device_.flush();
 }
 
-Buffer BigHash::readBucket(BucketId bid) {
+std::optional<Status> BigHash::lookupWithDirectory(BucketId bid,
+                                                   HashedKey hk,
+                                                   Buffer& value) {
+  const auto bucketOffset = getBucketOffset(bid);
+  auto dirBuffer = device_.makeIOBuffer(directorySize_);
+  if (!device_.read(bucketOffset, dirBuffer.size(), dirBuffer.data())) {
+    ioErrorCount_.inc();
+    return Status::DeviceError;
+  }
+
+  // a directory that fails its checksum usually means the bucket was never
+  // written. Let the full read sort it out.
+  const auto* dir = BucketDirectory::get(
+      dirBuffer.view(), directorySize_, generationTime_.count());
+  if (dir == nullptr || dir->overflowed()) {
+    dirFallbackCount_.inc();
+    return std::nullopt;
+  }
+  dirLookupCount_.inc();
+
+  std::optional<Status> status = Status::NotFound;
+  dir->findMatches(hk.keyHash(), [&](const BucketDirectory::Slot& slot) {
+    // reads the aligned blocks covering the entry and trims to the entry
+    auto entryBuffer = device_.read(bucketOffset + slot.offset, slot.size);
+    if (entryBuffer.isNull()) {
+      ioErrorCount_.inc();
+      status = Status::DeviceError;
+      return true;
+    }
+    if (navy::checksum(entryBuffer.view()) != slot.checksum) {
+      dirFallbackCount_.inc();
+      status = std::nullopt;
+      return true;
+    }
+    const auto* entry =
+        reinterpret_cast<const details::BucketEntry*>(entryBuffer.data());
+    if (!entry->keyEqualsTo(hk)) {
+      dirFingerprintCollisionCount_.inc();
+      return false;
+    }
+    value = Buffer{entry->value()};
+    status = Status::Ok;
+    return true;
+  });
+  return status;
+}
+
+std::optional<Status> BigHash::findWithDirectory(const Buffer& buffer,
+                                                 HashedKey hk,
+                                                 Buffer& value) {
+  const auto* dir = BucketDirectory::get(
+      buffer.view(), directorySize_, generationTime_.count());
+  if (dir == nullptr || dir->overflowed()) {
+    dirFallbackCount_.inc();
+    return std::nullopt;
+  }
+  dirLookupCount_.inc();
+
+  std::optional<Status> status = Status::NotFound;
+  dir->findMatches(hk.keyHash(), [&](const BucketDirectory::Slot& slot) {
+    if (static_cast<uint64_t>(slot.offset) + slot.size > buffer.size() ||
+        navy::checksum(buffer.view().slice(slot.offset, slot.size)) !=
+            slot.checksum) {
+      dirFallbackCount_.inc();
+      status = std::nullopt;
+      return true;
+    }
+    const auto* entry = reinterpret_cast<const details::BucketEntry*>(
+        buffer.data() + slot.offset);
+    if (!entry->keyEqualsTo(hk)) {
+      dirFingerprintCollisionCount_.inc();
+      return false;
+    }
+    value = Buffer{entry->value()};
+    status = Status::Ok;
+    return true;
+  });
+  return status;
+}
+
+Buffer BigHash::readBucket(BucketId bid, bool* valid) {
   auto buffer = device_.makeIOBuffer(bucketSize_);
   XDCHECK(!buffer.isNull());
 
@@ -525,10 +694,12 @@ Buffer BigHash::readBucket(BucketId bid) {
     return {};
   }
 
-  auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
+  auto* bucket = getBucket(buffer);
+  const auto bucketView =
+      buffer.view().slice(directorySize_, buffer.size() - directorySize_);
 
   const auto checksumSuccess =
-      Bucket::computeChecksum(buffer.view()) == bucket->getChecksum();
+      Bucket::computeChecksum(bucketView) == bucket->getChecksum();
   // TODO (T93631284) we only read a bucket if the bloom filter indicates that
   // the bucket could have the element. Hence, if check sum errors out and bloom
   // filter is enable, we could record the checksum error. However, doing so
@@ -541,16 +712,27 @@ Buffer BigHash::readBucket(BucketId bid) {
   //  checksumErrorCount_.inc();
   // }
 
-  if (!checksumSuccess || static_cast<uint64_t>(generationTime_.count()) !=
-                              bucket->generationTime()) {
-    Bucket::initNew(buffer.mutableView(), generationTime_.count());
+  const bool bucketValid = checksumSuccess &&
+                           static_cast<uint64_t>(generationTime_.count()) ==
+                               bucket->generationTime();
+  if (valid) {
+    *valid = bucketValid;
+  }
+  if (!bucketValid) {
+    Bucket::initNew(buffer.mutableView().slice(
+                        directorySize_, buffer.size() - directorySize_),
+                    generationTime_.count());
   }
   return buffer;
 }
 
 bool BigHash::writeBucket(BucketId bid, Buffer buffer) {
-  auto* bucket = reinterpret_cast<Bucket*>(buffer.data());
-  bucket->setChecksum(Bucket::computeChecksum(buffer.view()));
+  auto* bucket = getBucket(buffer);
+  bucket->setChecksum(Bucket::computeChecksum(
+      buffer.view().slice(directorySize_, buffer.size() - directorySize_)));
+  if (directorySize_ > 0) {
+    BucketDirectory::build(buffer.mutableView(), directorySize_, *bucket);
+  }
   return device_.write(
       getBucketOffset(bid), std::move(buffer), placementHandle_);
 }
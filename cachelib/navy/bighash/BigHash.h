@@ -19,6 +19,7 @@
 #include <folly/fibers/TimedMutex.h>
 
 #include <chrono>
+#include <optional>
 #include <stdexcept>
 
 #include "cachelib/common/AtomicCounter.h"
@@ -72,6 +73,18 @@ class BigHash final : public Engine {
     // Optional bloom filter to reduce IO
     std::unique_ptr<BloomFilter> bloomFilter;
 
+    // Bytes at the start of each bucket reserved for a fingerprint directory
+    // (see BucketDirectory). 0 disables the directory.
+    //
+    // If the directory is a multiple of the device IO alignment and the
+    // bucket is at least four IO blocks, lookups read the
+    // directory and then only the blocks holding the matching entry instead
+    // of the whole bucket. That takes two serial IOs. Otherwise, e.g. for 4KB
+    // buckets, lookups read the whole bucket in one IO as without a
+    // directory, and search the directory in memory instead of walking every
+    // entry of the bucket.
+    uint32_t directorySize{0};
+
     uint64_t numBuckets() const { return cacheSize / bucketSize; }
 
     Config& validate();
@@ -143,6 +156,12 @@ class BigHash final : public Engine {
   std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) override;
 
+  // Walks the buckets of the partition. Each bucket is read under its lock
+  // and visited after the lock is released.
+  void forEachItem(uint32_t partition,
+                   uint32_t numPartitions,
+                   const ItemVisitor& visitor) override;
+
  private:
   class BucketId {
    public:
@@ -164,9 +183,42 @@ class BigHash final : public Engine {
   struct ValidConfigTag {};
   BigHash(Config&& config, ValidConfigTag);
 
-  Buffer readBucket(BucketId bid);
+  // Read the bucket and its directory. A bucket that fails its checksum or
+  // is from an older generation is reinitialized as empty in the buffer,
+  // while the directory is left as read.
+  //
+  // @param valid   set to whether the bucket was read as written, if given
+  Buffer readBucket(BucketId bid, bool* valid = nullptr);
   bool writeBucket(BucketId bid, Buffer buffer);
 
+  // Smallest bucket, in device IO blocks, for which lookups read the
+  // directory and the matching entry instead of the whole bucket.
+  static constexpr uint32_t kMinPartialReadBlocks{4};
+
+  // Look up @hk by reading the bucket's directory and then the blocks that
+  // hold the entry with a matching fingerprint. Must be called with the
+  // bucket lock held.
+  //
+  // @return  std::nullopt if the directory can't answer the lookup and the
+  //          whole bucket has to be read instead
+  std::optional<Status> lookupWithDirectory(BucketId bid,
+                                            HashedKey hk,
+                                            Buffer& value);
+
+  // Look up @hk in a bucket read in full and found valid by readBucket() by
+  // searching its directory.
+  //
+  // @return  std::nullopt if the directory can't answer the lookup and the
+  //          bucket has to be searched instead
+  std::optional<Status> findWithDirectory(const Buffer& buffer,
+                                          HashedKey hk,
+                                          Buffer& value);
+
+  // The bucket follows the directory in a bucket sized buffer.
+  Bucket* getBucket(Buffer& buffer) const {
+    return reinterpret_cast<Bucket*>(buffer.data() + directorySize_);
+  }
+
   // The corresponding r/w bucket lock must be held during the entire
   // duration of the read and write operations. For example, during write,
   // if write lock is dropped after a bucket is read from device, user
@@ -209,6 +261,10 @@ class BigHash final : public Engine {
   const uint64_t bucketSize_{};
   const uint64_t cacheBaseOffset_{};
   const uint64_t numBuckets_{};
+  const uint32_t directorySize_{};
+  // whether lookups read the directory and the matching entry rather than
+  // the whole bucket.
+  const bool partialDirectoryReads_{};
   std::unique_ptr<BloomFilter> bloomFilter_;
   std::chrono::nanoseconds generationTime_{};
   Device& device_;
@@ -245,6 +301,11 @@ class BigHash final : public Engine {
   mutable AtomicCounter bfRebuildCount_;
   mutable AtomicCounter checksumErrorCount_;
   mutable AtomicCounter usedSizeBytes_;
+  // lookups served from the bucket directory, lookups that had to read the
+  // whole bucket and fingerprint matches with a different key.
+  mutable AtomicCounter dirLookupCount_;
+  mutable AtomicCounter dirFallbackCount_;
+  mutable AtomicCounter dirFingerprintCollisionCount_;
   // counters to quantify the expired eviction overhead (temporary)
   // PercentileStats generates outputs in integers, so amplify by 100x
   mutable util::PercentileStats bucketExpirationsDist_x100_;
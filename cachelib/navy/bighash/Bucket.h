@@ -58,6 +58,9 @@ class FOLLY_PACK_ATTR Bucket {
 
     bool keyEqualsTo(HashedKey hk) const;
 
+    // the raw bytes of the entry as laid out in the bucket
+    BufferView entry() const { return toView(itr_.view()); }
+
    private:
     friend Bucket;
 
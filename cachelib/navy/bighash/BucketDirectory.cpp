@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/bighash/BucketDirectory.h"
+
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace facebook::cachelib::navy {
+static_assert(sizeof(BucketDirectory) == 17,
+              "BucketDirectory overhead. If this changes, the directory "
+              "capacity for a given size changes as well.");
+
+uint32_t BucketDirectory::computeChecksum(BufferView view) {
+  constexpr auto kChecksumStart = sizeof(checksum_);
+  return navy::checksum(
+      view.slice(kChecksumStart, view.size() - kChecksumStart));
+}
+
+void BucketDirectory::build(MutableBufferView block,
+                            uint32_t directorySize,
+                            const Bucket& bucket) {
+  XDCHECK_LT(directorySize, block.size());
+  std::memset(block.data(), 0, directorySize);
+  auto* dir = reinterpret_cast<BucketDirectory*>(block.data());
+  dir->generationTime_ = bucket.generationTime();
+  dir->capacity_ = static_cast<uint16_t>(
+      std::min<uint32_t>(capacity(directorySize),
+                         std::numeric_limits<uint16_t>::max()));
+
+  if (bucket.size() > dir->capacity_) {
+    dir->overflowed_ = 1;
+  } else {
+    auto* fps = dir->fingerprints();
+    auto* slotArr = dir->slots();
+    uint32_t i = 0;
+    for (auto itr = bucket.getFirst(); !itr.done();
+         itr = bucket.getNext(itr), i++) {
+      const auto entry = itr.entry();
+      fps[i] = fingerprint(itr.keyHash());
+      slotArr[i].offset = static_cast<uint32_t>(entry.data() - block.data());
+      slotArr[i].size = static_cast<uint32_t>(entry.size());
+      slotArr[i].checksum = navy::checksum(entry);
+    }
+    dir->numEntries_ = static_cast<uint16_t>(i);
+  }
+  dir->checksum_ = computeChecksum(toView(block.slice(0, directorySize)));
+}
+
+const BucketDirectory* BucketDirectory::get(BufferView block,
+                                            uint32_t directorySize,
+                                            uint64_t generationTime) {
+  XDCHECK_LE(directorySize, block.size());
+  const auto* dir = reinterpret_cast<const BucketDirectory*>(block.data());
+  if (computeChecksum(block.slice(0, directorySize)) != dir->checksum_ ||
+      dir->generationTime_ != generationTime ||
+      dir->capacity_ > capacity(directorySize) ||
+      dir->numEntries_ > dir->capacity_) {
+    return nullptr;
+  }
+  return dir;
+}
+
+uint32_t BucketDirectory::matchMask(const uint16_t* fps,
+                                    uint32_t end,
+                                    uint16_t fp) {
+  XDCHECK_GT(end, 0u);
+#if defined(__SSE2__)
+  if (end >= kLanes) {
+    const auto needle = _mm_set1_epi16(static_cast<int16_t>(fp));
+    const auto group = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(fps + end - kLanes));
+    // narrow the 16-bit lane results to bytes so movemask yields one bit per
+    // fingerprint.
+    const auto eq = _mm_cmpeq_epi16(group, needle);
+    return static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_packs_epi16(eq, _mm_setzero_si128())));
+  }
+#endif
+  const uint32_t begin = end >= kLanes ? end - kLanes : 0;
+  uint32_t mask = 0;
+  for (uint32_t i = begin; i < end; i++) {
+    if (fps[i] == fp) {
+      mask |= 1u << (i - begin);
+    }
+  }
+  return mask;
+}
+} // namespace facebook::cachelib::navy
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+#include <folly/lang/Bits.h>
+
+#include "cachelib/navy/bighash/Bucket.h"
+#include "cachelib/navy/common/Buffer.h"
+#include "cachelib/navy/common/Hash.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+// Fingerprint directory stored in front of a bucket on device. When BigHash
+// is configured with a directory, every bucket block is laid out as
+//
+//   | BucketDirectory (directorySize bytes) | Bucket (bucketSize - dirSize) |
+//
+// The directory keeps a 16-bit fingerprint of every entry's key hash along
+// with the entry's location and checksum. A lookup reads only the directory
+// block, searches the fingerprints and then reads the aligned blocks that
+// hold the matching entry instead of the whole bucket.
+//
+// The directory is rebuilt from the bucket on every bucket write, and both
+// go to the device in the same write. If the bucket has more entries than
+// the directory can hold, the directory is marked as overflowed and lookups
+// fall back to reading the whole bucket.
+class FOLLY_PACK_ATTR BucketDirectory {
+ public:
+  // Location of an entry within the bucket block.
+  struct FOLLY_PACK_ATTR Slot {
+    // offset of the BucketEntry from the start of the bucket block
+    uint32_t offset{};
+    // size of the BucketEntry including key and value
+    uint32_t size{};
+    // checksum of the BucketEntry bytes
+    uint32_t checksum{};
+  };
+
+  // Bytes used by the directory for every entry it tracks.
+  static constexpr uint32_t kBytesPerEntry = sizeof(uint16_t) + sizeof(Slot);
+
+  // Number of entries a directory of @directorySize bytes can hold.
+  static uint32_t capacity(uint32_t directorySize) {
+    return directorySize <= sizeof(BucketDirectory)
+               ? 0
+               : (directorySize - sizeof(BucketDirectory)) / kBytesPerEntry;
+  }
+
+  // The bucket is picked with the low bits of the key hash, so the
+  // fingerprint is taken from the high bits.
+  static uint16_t fingerprint(uint64_t keyHash) {
+    return static_cast<uint16_t>(keyHash >> 48);
+  }
+
+  // Rebuild the directory in the first @directorySize bytes of @block from
+  // the bucket that follows it.
+  static void build(MutableBufferView block,
+                    uint32_t directorySize,
+                    const Bucket& bucket);
+
+  // Return the directory at the start of @block if its checksum and
+  // generation are valid, nullptr otherwise.
+  static const BucketDirectory* get(BufferView block,
+                                    uint32_t directorySize,
+                                    uint64_t generationTime);
+
+  // true if the bucket has more entries than the directory tracks. Lookups
+  // must read the whole bucket in that case.
+  bool overflowed() const { return overflowed_ != 0; }
+
+  uint32_t numEntries() const { return numEntries_; }
+
+  // Invoke @fn(const Slot&) for every entry whose fingerprint matches
+  // @keyHash, newest entry first, until it returns true.
+  //
+  // @return true if @fn returned true for any entry
+  template <typename Fn>
+  bool findMatches(uint64_t keyHash, Fn&& fn) const {
+    const auto fp = fingerprint(keyHash);
+    const auto* fps = fingerprints();
+    const auto* slotArr = slots();
+    uint32_t i = numEntries_;
+    while (i > 0) {
+      const auto mask = matchMask(fps, i, fp);
+      if (mask == 0) {
+        i = i >= kLanes ? i - kLanes : 0;
+        continue;
+      }
+      // highest set lane in the group is the newest candidate
+      const uint32_t base = i >= kLanes ? i - kLanes : 0;
+      const uint32_t idx = base + folly::findLastSet(mask) - 1;
+      if (fn(slotArr[idx])) {
+        return true;
+      }
+      i = idx;
+    }
+    return false;
+  }
+
+ private:
+  // number of fingerprints compared at once
+  static constexpr uint32_t kLanes = 8;
+
+  // Bitmask of the fingerprints in [max(0, end - kLanes), end) equal to @fp,
+  // bit k set for entry max(0, end - kLanes) + k.
+  static uint32_t matchMask(const uint16_t* fps, uint32_t end, uint16_t fp);
+
+  static uint32_t computeChecksum(BufferView view);
+
+  const uint16_t* fingerprints() const {
+    return reinterpret_cast<const uint16_t*>(data_);
+  }
+  uint16_t* fingerprints() { return reinterpret_cast<uint16_t*>(data_); }
+
+  const Slot* slots() const {
+    return reinterpret_cast<const Slot*>(data_ + sizeof(uint16_t) * capacity_);
+  }
+  Slot* slots() {
+    return reinterpret_cast<Slot*>(data_ + sizeof(uint16_t) * capacity_);
+  }
+
+  uint32_t checksum_{};
+  uint64_t generationTime_{};
+  uint16_t capacity_{};
+  uint16_t numEntries_{};
+  uint8_t overflowed_{};
+  uint8_t data_[];
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
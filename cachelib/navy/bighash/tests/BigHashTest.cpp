@@ -19,6 +19,7 @@
 #include <gtest/gtest.h>
 
 #include <map>
+#include <set>
 
 #include "cachelib/common/Hash.h"
 #include "cachelib/common/Utils.h"
@@ -794,4 +795,190 @@ TEST(BigHash, EstimateWriteSize) {
     EXPECT_EQ(bh.estimateWriteSize(makeHK("key4"), makeView("1")), bucketSize);
   }
 }
+
+TEST(BigHash, Directory) {
+  constexpr uint32_t kBucketSize = 1024;
+  BigHash::Config config;
+  setLayout(config, kBucketSize, 2);
+  config.directorySize = 256;
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 64);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  EXPECT_EQ(kBucketSize - 256 - sizeof(Bucket) -
+                BucketStorage::slotSize(sizeof(details::BucketEntry)),
+            bh.getMaxItemSize());
+
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < 10; i++) {
+    keys.push_back(genKey(2, 0));
+    EXPECT_EQ(Status::Ok, bh.insert(makeHK(keys.back().c_str()),
+                                    makeView(keys.back().c_str())));
+  }
+
+  for (const auto& key : keys) {
+    const auto bytesRead = device->getBytesRead();
+    Buffer value;
+    EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+    EXPECT_EQ(makeView(key.c_str()), value.view());
+    // the directory and the block holding the entry, not the whole bucket
+    EXPECT_GT(kBucketSize, device->getBytesRead() - bytesRead);
+  }
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK(genKey(2, 0).c_str()), value));
+
+  // removes rebuild the directory
+  EXPECT_EQ(Status::Ok, bh.remove(makeHK(keys[3].c_str())));
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK(keys[3].c_str()), value));
+  EXPECT_EQ(Status::Ok, bh.lookup(makeHK(keys[4].c_str()), value));
+
+  MockCounterVisitor helper;
+  EXPECT_CALL(helper, call(_, _)).Times(AtLeast(0));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_lookups"), 13));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_fallbacks"), 0));
+  bh.getCounters({toCallback(helper)});
+}
+
+TEST(BigHash, DirectoryOverflow) {
+  BigHash::Config config;
+  setLayout(config, 1024, 1);
+  // room for 3 entries only
+  config.directorySize = 64;
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 64);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  for (uint32_t i = 0; i < 6; i++) {
+    const auto key = folly::sformat("key_{}", i);
+    EXPECT_EQ(Status::Ok, bh.insert(makeHK(key.c_str()), makeView(key)));
+  }
+  for (uint32_t i = 0; i < 6; i++) {
+    const auto key = folly::sformat("key_{}", i);
+    Buffer value;
+    EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+    EXPECT_EQ(makeView(key), value.view());
+  }
+
+  MockCounterVisitor helper;
+  EXPECT_CALL(helper, call(_, _)).Times(AtLeast(0));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_lookups"), 0));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_fallbacks"), 6));
+  bh.getCounters({toCallback(helper)});
+}
+
+TEST(BigHash, DirectoryBadConfig) {
+  BigHash::Config config;
+  setLayout(config, 1024, 1);
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 64);
+  config.device = device.get();
+
+  // no room for a single entry
+  config.directorySize = 16;
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+  // no room for the bucket
+  config.directorySize = 1024;
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+  // directories need not be aligned to the device
+  config.directorySize = 100;
+  EXPECT_NO_THROW(config.validate());
+}
+
+TEST(BigHash, DirectoryInBucketRead) {
+  // a bucket of a single IO block can't be read partially, so lookups read
+  // the whole bucket and search the unaligned directory in memory
+  constexpr uint32_t kBucketSize = 1024;
+  BigHash::Config config;
+  setLayout(config, kBucketSize, 2);
+  config.directorySize = 200;
+  auto device =
+      std::make_unique<NiceMock<MockDevice>>(config.cacheSize, kBucketSize);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  std::vector<std::string> keys;
+  for (uint32_t i = 0; i < 10; i++) {
+    keys.push_back(genKey(2, 0));
+    EXPECT_EQ(Status::Ok, bh.insert(makeHK(keys.back().c_str()),
+                                    makeView(keys.back().c_str())));
+  }
+
+  for (const auto& key : keys) {
+    const auto bytesRead = device->getBytesRead();
+    Buffer value;
+    EXPECT_EQ(Status::Ok, bh.lookup(makeHK(key.c_str()), value));
+    EXPECT_EQ(makeView(key.c_str()), value.view());
+    EXPECT_EQ(kBucketSize, device->getBytesRead() - bytesRead);
+  }
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK(genKey(2, 0).c_str()), value));
+
+  MockCounterVisitor helper;
+  EXPECT_CALL(helper, call(_, _)).Times(AtLeast(0));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_lookups"), 11));
+  EXPECT_CALL(helper, call(strPiece("navy_bh_dir_fallbacks"), 0));
+  bh.getCounters({toCallback(helper)});
+}
+
+TEST(BigHash, DirectoryCorruptBucket) {
+  // the directory survives the corruption of the bucket after it, but the
+  // reinitialized bucket must not be searched through it
+  constexpr uint32_t kBucketSize = 1024;
+  constexpr uint32_t kDirectorySize = 200;
+  BigHash::Config config;
+  setLayout(config, kBucketSize, 1);
+  config.directorySize = kDirectorySize;
+  auto device =
+      std::make_unique<NiceMock<MockDevice>>(config.cacheSize, kBucketSize);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key"), makeView("12345")));
+  Buffer value;
+  EXPECT_EQ(Status::Ok, bh.lookup(makeHK("key"), value));
+  EXPECT_EQ(makeView("12345"), value.view());
+
+  // flip the bucket checksum, which directly follows the directory
+  Buffer buf{kBucketSize, kBucketSize};
+  ASSERT_TRUE(device->getRealDeviceRef().read(0, kBucketSize, buf.data()));
+  buf.data()[kDirectorySize] ^= 0xff;
+  ASSERT_TRUE(device->getRealDeviceRef().write(0, std::move(buf)));
+
+  EXPECT_EQ(Status::NotFound, bh.lookup(makeHK("key"), value));
+}
+
+TEST(BigHash, ForEachItem) {
+  constexpr uint32_t kNumBuckets = 8;
+  BigHash::Config config;
+  setLayout(config, 1024, kNumBuckets);
+  auto device = std::make_unique<NiceMock<MockDevice>>(config.cacheSize, 64);
+  config.device = device.get();
+
+  BigHash bh(std::move(config));
+  std::set<std::string> keys;
+  for (uint32_t bid = 0; bid < kNumBuckets; bid++) {
+    for (uint32_t i = 0; i < 3; i++) {
+      auto key = genKey(kNumBuckets, bid);
+      EXPECT_EQ(Status::Ok,
+                bh.insert(makeHK(key.c_str()), makeView(key.c_str())));
+      keys.insert(std::move(key));
+    }
+  }
+  const auto removed = *keys.begin();
+  EXPECT_EQ(Status::Ok, bh.remove(makeHK(removed.c_str())));
+  keys.erase(removed);
+
+  // every live key is visited exactly once across the partitions
+  constexpr uint32_t kNumPartitions = 3;
+  std::map<std::string, uint32_t> visits;
+  for (uint32_t p = 0; p < kNumPartitions; p++) {
+    bh.forEachItem(p, kNumPartitions, [&](HashedKey hk, BufferView value) {
+      EXPECT_EQ(makeView(hk.key()), value);
+      visits[hk.key().str()]++;
+    });
+  }
+  EXPECT_EQ(keys.size(), visits.size());
+  for (const auto& key : keys) {
+    EXPECT_EQ(1, visits[key]) << key;
+  }
+}
 } // namespace facebook::cachelib::navy::tests
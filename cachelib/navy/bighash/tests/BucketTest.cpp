@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <folly/Format.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "cachelib/navy/bighash/Bucket.h"
+#include "cachelib/navy/bighash/BucketDirectory.h"
 #include "cachelib/navy/testing/BufferGen.h"
 #include "cachelib/navy/testing/Callbacks.h"
 
@@ -386,4 +388,75 @@ TEST(Bucket, EvictionExpired) {
     }
   }
 }
+
+TEST(Bucket, Directory) {
+  constexpr uint32_t kDirSize = 256;
+  Buffer buf(1024);
+  auto& bucket = Bucket::initNew(
+      buf.mutableView().slice(kDirSize, buf.size() - kDirSize), 7);
+
+  // 12 entries so that matching goes through more than one group of
+  // fingerprints. Entries 2 and 10 share a fingerprint.
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < 12; i++) {
+    keys.push_back(folly::sformat("key {}", i));
+    const uint64_t fp = (i == 10 ? 2 : i) + 1;
+    bucket.insert(HashedKey::precomputed(keys.back(), (fp << 48) | i),
+                  makeView(keys.back()), nullptr, nullptr);
+  }
+  BucketDirectory::build(buf.mutableView(), kDirSize, bucket);
+
+  // stale generation means the directory can't be trusted
+  EXPECT_EQ(nullptr, BucketDirectory::get(buf.view(), kDirSize, 8));
+  const auto* dir = BucketDirectory::get(buf.view(), kDirSize, 7);
+  ASSERT_NE(nullptr, dir);
+  EXPECT_FALSE(dir->overflowed());
+  EXPECT_EQ(12, dir->numEntries());
+
+  auto entryKey = [&buf](const BucketDirectory::Slot& slot) {
+    const auto* entry = reinterpret_cast<const details::BucketEntry*>(
+        buf.data() + slot.offset);
+    EXPECT_EQ(slot.checksum,
+              checksum(buf.view().slice(slot.offset, slot.size)));
+    return toStringPiece(entry->key()).str();
+  };
+
+  std::vector<std::string> matched;
+  EXPECT_FALSE(dir->findMatches(uint64_t{3} << 48, [&](const auto& slot) {
+    matched.push_back(entryKey(slot));
+    return false;
+  }));
+  EXPECT_EQ((std::vector<std::string>{"key 10", "key 2"}), matched);
+
+  matched.clear();
+  EXPECT_TRUE(dir->findMatches(uint64_t{12} << 48, [&](const auto& slot) {
+    matched.push_back(entryKey(slot));
+    return true;
+  }));
+  EXPECT_EQ((std::vector<std::string>{"key 11"}), matched);
+
+  EXPECT_FALSE(dir->findMatches(uint64_t{100} << 48,
+                                [](const auto&) { return true; }));
+
+  // corrupting the directory invalidates it
+  buf.data()[20] ^= 1;
+  EXPECT_EQ(nullptr, BucketDirectory::get(buf.view(), kDirSize, 7));
+}
+
+TEST(Bucket, DirectoryOverflow) {
+  constexpr uint32_t kDirSize = 64;
+  Buffer buf(1024);
+  auto& bucket = Bucket::initNew(
+      buf.mutableView().slice(kDirSize, buf.size() - kDirSize), 0);
+  for (uint32_t i = 0; i < BucketDirectory::capacity(kDirSize) + 1; i++) {
+    const auto key = folly::sformat("key {}", i);
+    bucket.insert(makeHK(key.c_str()), makeView(key), nullptr, nullptr);
+  }
+  BucketDirectory::build(buf.mutableView(), kDirSize, bucket);
+
+  const auto* dir = BucketDirectory::get(buf.view(), kDirSize, 0);
+  ASSERT_NE(nullptr, dir);
+  EXPECT_TRUE(dir->overflowed());
+  EXPECT_EQ(0, dir->numEntries());
+}
 } // namespace facebook::cachelib::navy::tests
@@ -35,25 +35,29 @@ void RegionAllocator::setAllocationRegion(RegionId rid) {
 void RegionAllocator::reset() { rid_ = RegionId{}; }
 
 Allocator::Allocator(RegionManager& regionManager, uint16_t numPriorities)
-    : regionManager_{regionManager} {
+    : regionManager_{regionManager}, numPriorities_{numPriorities} {
   XLOGF(INFO,
         "Enable priority-based allocation for Allocator. Number of "
-        "priorities: {}",
-        numPriorities);
-  for (uint16_t i = 0; i < numPriorities; i++) {
-    allocators_.emplace_back(i /* priority */);
+        "priorities: {}, number of size bands: {}",
+        numPriorities,
+        regionManager_.numSizeBands());
+  for (uint16_t band = 0; band < regionManager_.numSizeBands(); band++) {
+    for (uint16_t i = 0; i < numPriorities; i++) {
+      allocators_.emplace_back(i /* priority */, band);
+    }
   }
 }
 
 std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocate(
     uint32_t size, uint16_t priority, bool canWait) {
-  XDCHECK_LT(priority, allocators_.size());
-  RegionAllocator* ra = &allocators_[priority];
+  XDCHECK_LT(priority, numPriorities_);
   if (size == 0 || size > regionManager_.regionSize()) {
     return std::make_tuple(RegionDescriptor{OpenStatus::Error}, size,
                            RelAddress());
   }
-  return allocateWith(*ra, size, canWait);
+  const auto band = regionManager_.getSizeBand(size);
+  return allocateWith(allocators_[band * numPriorities_ + priority], size,
+                      canWait);
 } // namespace cachelib
 
 // Allocates using region allocator @ra. If region is full, we take another
@@ -105,6 +109,7 @@ std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocateWith(
   // we got a region fresh off of reclaim. Need to initialize it.
   auto& region = regionManager_.getRegion(rid);
   region.setPriority(ra.priority());
+  region.setBand(ra.band());
 
   // Replace with a reclaimed region and allocate
   ra.setAllocationRegion(rid);
@@ -38,14 +38,15 @@ using folly::fibers::TimedMutex;
 // has to sync access.
 class RegionAllocator {
  public:
-  // @param classId   size class this region allocator is associated with
   // @param priority  priority this region allocator is associated with
-  explicit RegionAllocator(uint16_t priority) : priority_{priority} {}
+  // @param band      size band this region allocator is associated with
+  explicit RegionAllocator(uint16_t priority, uint16_t band = 0)
+      : priority_{priority}, band_{band} {}
 
   RegionAllocator(const RegionAllocator&) = delete;
   RegionAllocator& operator=(const RegionAllocator&) = delete;
   RegionAllocator(RegionAllocator&& other) noexcept
-      : priority_{other.priority_}, rid_{other.rid_} {}
+      : priority_{other.priority_}, band_{other.band_}, rid_{other.rid_} {}
 
   // Sets new region to allocate from. Region allocator has to be reset before
   // calling this.
@@ -60,11 +61,15 @@ class RegionAllocator {
   // Returns the priority this region allocator is associated with.
   uint16_t priority() const { return priority_; }
 
+  // Returns the size band this region allocator is associated with.
+  uint16_t band() const { return band_; }
+
   // Returns the mutex lock.
   TimedMutex& getLock() const { return mutex_; }
 
  private:
   const uint16_t priority_{};
+  const uint16_t band_{};
 
   // The current region id from which we are allocating
   RegionId rid_;
@@ -80,7 +85,8 @@ class Allocator {
   // @param regionManager     Used to get eviction information and for
   //                          locking regions
   // @param numPriorities     Specifies how many priorities this allocator
-  //                          supports
+  //                          supports. Each size band of the region manager
+  //                          has a region allocator per priority
   // Throws std::exception if invalid arguments
   explicit Allocator(RegionManager& regionManager, uint16_t numPriorities);
 
@@ -99,7 +105,8 @@ class Allocator {
   //  - Error   Can't allocate this size even later (hard failure)
   // When allocating with a priority, the priority must NOT exceed the
   // max priority which is (@numPriorities - 1) specified when constructing
-  // this allocator.
+  // this allocator. The allocation is made in a region of the size band of
+  // @size.
   std::tuple<RegionDescriptor, uint32_t, RelAddress> allocate(uint32_t size,
                                                               uint16_t priority,
                                                               bool canWait);
@@ -131,7 +138,9 @@ class Allocator {
       RegionAllocator& ra, uint32_t size, bool wait);
 
   RegionManager& regionManager_;
-  // Multiple allocators when we use priority-based allocation
+  const uint16_t numPriorities_{};
+  // Multiple allocators when we use priority-based allocation or size bands,
+  // indexed by band * numPriorities_ + priority
   std::vector<RegionAllocator> allocators_;
 
   mutable AtomicCounter allocRetryWaits_;
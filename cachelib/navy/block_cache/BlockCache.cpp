@@ -66,6 +66,35 @@ BlockCache::Config& BlockCache::Config::validate() {
   if (numPriorities == 0) {
     throw std::invalid_argument("allocator must have at least one priority");
   }
+  if (sizeBandPolicies.size() != sizeBands.size()) {
+    throw std::invalid_argument("every size band needs an eviction policy");
+  }
+  // Every band keeps an open region, holding an in-mem buffer, per priority.
+  // Without a spare buffer to flush through, a busy band waits for the idle
+  // bands to fill their regions.
+  const size_t numOpenRegions = (sizeBands.size() + 1) * numPriorities;
+  if (!sizeBands.empty() && numInMemBuffers <= numOpenRegions) {
+    throw std::invalid_argument(folly::sformat(
+        "{} size bands with {} priorities need more than {} in-mem buffers, "
+        "got {}",
+        sizeBands.size() + 1,
+        numPriorities,
+        numOpenRegions,
+        numInMemBuffers));
+  }
+  for (size_t i = 0; i < sizeBands.size(); i++) {
+    if (!sizeBandPolicies[i]) {
+      throw std::invalid_argument("missing size band eviction policy");
+    }
+    if (sizeBands[i] == 0 || sizeBands[i] >= regionSize ||
+        (i > 0 && sizeBands[i] <= sizeBands[i - 1])) {
+      throw std::invalid_argument(folly::sformat(
+          "size bands must be ascending and below the region size, got {} "
+          "for band {}",
+          sizeBands[i],
+          i));
+    }
+  }
 
   reinsertionConfig.validate();
 
@@ -116,6 +145,7 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
     : config_{serializeConfig(config)},
       numPriorities_{config.numPriorities},
       checkExpired_{std::move(config.checkExpired)},
+      getExpiryTime_{std::move(config.getExpiryTime)},
       destructorCb_{std::move(config.destructorCb)},
       checksumData_{config.checksum},
       device_{*config.device},
@@ -126,6 +156,7 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
       regionSize_{config.regionSize},
       itemDestructorEnabled_{config.itemDestructorEnabled},
       preciseRemove_{config.preciseRemove},
+      index_{config.indexMetadata, config.indexHugePages},
       regionManager_{config.getNumRegions(),
                      config.regionSize,
                      config.cacheBaseOffset,
@@ -138,7 +169,10 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
                      std::move(config.evictionPolicy),
                      config.numInMemBuffers,
                      config.numPriorities,
-                     config.inMemBufFlushRetryLimit},
+                     config.inMemBufFlushRetryLimit,
+                     config.discardBytesPerSec,
+                     std::move(config.sizeBands),
+                     std::move(config.sizeBandPolicies)},
       allocator_{regionManager_, config.numPriorities},
       reinsertionPolicy_{makeReinsertionPolicy(config.reinsertionConfig)} {
   validate(config);
@@ -197,8 +231,12 @@ Status BlockCache::insert(HashedKey hk, BufferView value) {
   const auto status = writeEntry(addr, slotSize, hk, value);
   auto newObjSizeHint = encodeSizeHint(slotSize);
   if (status == Status::Ok) {
-    const auto lr = index_.insert(
-        hk.keyHash(), encodeRelAddress(addr.add(slotSize)), newObjSizeHint);
+    const uint32_t expiryTime =
+        index_.hasExpiry() && getExpiryTime_ ? getExpiryTime_(value) : 0;
+    const auto lr = index_.insert(hk.keyHash(),
+                                  encodeRelAddress(addr.add(slotSize)),
+                                  newObjSizeHint,
+                                  expiryTime);
     // We replaced an existing key in the index
     uint64_t newObjSize = decodeSizeHint(newObjSizeHint);
     uint64_t oldObjSize = 0;
@@ -222,7 +260,7 @@ Status BlockCache::insert(HashedKey hk, BufferView value) {
 
 bool BlockCache::couldExist(HashedKey hk) {
   const auto lr = index_.lookup(hk.keyHash());
-  if (!lr.found()) {
+  if (!lr.found() || lr.expired()) {
     lookupCount_.inc();
     return false;
   }
@@ -234,12 +272,22 @@ uint64_t BlockCache::estimateWriteSize(HashedKey hk, BufferView value) const {
 }
 
 Status BlockCache::lookup(HashedKey hk, Buffer& value) {
+  return lookupImpl(hk, value, false /* allowExpired */);
+}
+
+Status BlockCache::lookupImpl(HashedKey hk, Buffer& value, bool allowExpired) {
   const auto seqNumber = regionManager_.getSeqNumber();
   const auto lr = index_.lookup(hk.keyHash());
   if (!lr.found()) {
     lookupCount_.inc();
     return Status::NotFound;
   }
+  if (lr.expired() && !allowExpired) {
+    // the item is left in the index and dropped when its region is reclaimed
+    lookupCount_.inc();
+    lookupExpiredInIndexCount_.inc();
+    return Status::NotFound;
+  }
   // If relative address has offset 0, the entry actually belongs to the
   // previous region (this is address of its end). To compensate for this, we
   // subtract 1 before conversion and add after to relative address.
@@ -349,12 +397,77 @@ std::pair<Status, std::string> BlockCache::getRandomAlloc(Buffer& value) {
   return std::make_pair(Status::NotFound, "");
 }
 
+void BlockCache::forEachItem(uint32_t partition,
+                             uint32_t numPartitions,
+                             const ItemVisitor& visitor) {
+  const uint64_t numRegions = regionManager_.numRegions();
+  const uint64_t beginRegion = numRegions * partition / numPartitions;
+  const uint64_t endRegion = numRegions * (partition + 1) / numPartitions;
+  for (uint64_t i = beginRegion; i < endRegion; i++) {
+    RegionId rid{static_cast<uint32_t>(i)};
+    const auto seqNumber = regionManager_.getSeqNumber();
+    RegionDescriptor rdesc = regionManager_.openForRead(rid, seqNumber);
+    if (rdesc.status() != OpenStatus::Ready) {
+      // The region is being reclaimed and its items are going away
+      continue;
+    }
+    // Read the whole region at once and release it, so that reclaim is not
+    // held back while we call the visitor
+    auto offset = regionManager_.getRegion(rid).getLastEntryEndOffset();
+    auto buffer = regionManager_.read(rdesc, RelAddress{rid, 0}, offset);
+    regionManager_.close(std::move(rdesc));
+    if (buffer.size() != offset) {
+      continue;
+    }
+
+    while (offset > 0) {
+      auto entryEnd = buffer.data() + offset;
+      auto desc =
+          *reinterpret_cast<const EntryDesc*>(entryEnd - sizeof(EntryDesc));
+      if (desc.csSelf != desc.computeChecksum()) {
+        // Can't find the next entry without a valid header
+        XLOGF(ERR,
+              "Item header checksum mismatch. Region {} is likely corrupted.",
+              rid.index());
+        break;
+      }
+
+      RelAddress addrEnd{rid, offset};
+      const auto entrySize = serializedSize(desc.keySize, desc.valueSize);
+      XDCHECK_GE(offset, entrySize);
+      offset -= entrySize;
+
+      BufferView valueView{desc.valueSize, entryEnd - entrySize};
+      if (checksumData_ && desc.cs != checksum(valueView)) {
+        continue;
+      }
+      HashedKey hk = HashedKey::precomputed(
+          folly::StringPiece{reinterpret_cast<const char*>(
+                                 entryEnd - sizeof(EntryDesc) - desc.keySize),
+                             desc.keySize},
+          desc.keyHash);
+      // Only the latest version of the key is alive
+      const auto lr = index_.peek(hk.keyHash());
+      if (!lr.found() || lr.expired() ||
+          addrEnd != decodeRelAddress(lr.address())) {
+        continue;
+      }
+      visitor(hk, valueView);
+    }
+  }
+}
+
 Status BlockCache::remove(HashedKey hk) {
   removeCount_.inc();
 
   Buffer value;
-  if ((itemDestructorEnabled_ && destructorCb_) || preciseRemove_) {
-    Status status = lookup(hk, value);
+  // with key fingerprints the index already tells apart colliding keys, so
+  // the value only needs to be read for the destructor callback
+  const bool needsValue =
+      (itemDestructorEnabled_ && destructorCb_) ||
+      (preciseRemove_ && !index_.hasKeyFingerprint());
+  if (needsValue) {
+    Status status = lookupImpl(hk, value, true /* allowExpired */);
 
     if (status != Status::Ok) {
       // device error, or region reclaimed, or item not found
@@ -448,6 +561,7 @@ uint32_t BlockCache::onRegionReclaim(RegionId rid, BufferView buffer) {
         holeSizeTotal_.sub(decodeSizeHint(encodeSizeHint(entrySize)));
         break;
       case ReinsertionRes::kReinserted:
+        regionManager_.recordReinsertion(rid);
         break;
       }
     }
@@ -538,7 +652,8 @@ BlockCache::ReinsertionRes BlockCache::reinsertOrRemoveItem(
     return ReinsertionRes::kRemoved;
   }
 
-  if (checkExpired_ && checkExpired_(value)) {
+  // the index may already know the item is expired, which saves parsing it
+  if (lr.expired() || (checkExpired_ && checkExpired_(value))) {
     return removeItem(true);
   }
 
@@ -732,6 +847,11 @@ void BlockCache::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_lookup_false_positives", lookupFalsePositiveCount_.get(),
           CounterVisitor::CounterType::RATE);
+  if (index_.hasExpiry()) {
+    visitor("navy_bc_lookup_expired_in_index",
+            lookupExpiredInIndexCount_.get(),
+            CounterVisitor::CounterType::RATE);
+  }
   visitor("navy_bc_lookup_entry_header_checksum_errors",
           lookupEntryHeaderChecksumErrorCount_.get(),
           CounterVisitor::CounterType::RATE);
@@ -89,6 +89,27 @@ class BlockCache final : public Engine {
     // whether to remove an item by checking the full key.
     bool preciseRemove{false};
 
+    // metadata kept in the index besides the address of the item
+    Index::MetadataConfig indexMetadata{};
+
+    // whether the index bucket arrays are backed by huge pages
+    util::HugePagePolicy indexHugePages{util::HugePagePolicy::kNone};
+
+    // returns the expiry time of the value, used if the index keeps expiry
+    ExpiryTimeGetter getExpiryTime;
+
+    // Max rate of discarding reclaimed regions on the device. 0 to disable.
+    uint64_t discardBytesPerSec{0};
+
+    // Ascending upper bounds (bytes) of the size bands but the last. Items of
+    // each band are written to the band's own regions, which are evicted by
+    // the policy at the same index of sizeBandPolicies. Items larger than all
+    // bounds form the last band, evicted by evictionPolicy. Empty disables
+    // size bands. With size bands, numInMemBuffers must be larger than the
+    // number of bands times numPriorities.
+    std::vector<uint32_t> sizeBands;
+    std::vector<std::unique_ptr<EvictionPolicy>> sizeBandPolicies;
+
     // Calculates the total region number.
     uint32_t getNumRegions() const {
       XDCHECK_EQ(0ul, cacheSize % regionSize);
@@ -193,6 +214,12 @@ class BlockCache final : public Engine {
   std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) override;
 
+  // Walks the regions of the partition and visits the entries the index
+  // still points at. Regions being reclaimed are skipped.
+  void forEachItem(uint32_t partition,
+                   uint32_t numPartitions,
+                   const ItemVisitor& visitor) override;
+
   // The minimum alloc alignment size can be as small as 1. Since the
   // test cases have very small device size, they will end up with alloc
   // alignment size of 1 (if determined as device_size >> 32 ) and we may
@@ -208,6 +235,10 @@ class BlockCache final : public Engine {
       static_cast<uint32_t>(std::numeric_limits<uint16_t>::max());
 
  private:
+  // Looks up a key like lookup(). Items the index knows to be expired are
+  // reported as NotFound without reading the device unless @allowExpired.
+  Status lookupImpl(HashedKey hk, Buffer& value, bool allowExpired);
+
   // Serialization format version. Never 0. Versions < 10 reserved for testing.
   static constexpr uint32_t kFormatVersion = 12;
   // This should be at least the nextTwoPow(sizeof(EntryDesc)).
@@ -343,6 +374,7 @@ class BlockCache final : public Engine {
   const serialization::BlockCacheConfig config_;
   const uint16_t numPriorities_{};
   const ExpiredCheck checkExpired_;
+  const ExpiryTimeGetter getExpiryTime_;
   const DestructorCallback destructorCb_;
   const bool checksumData_{};
   // reference to the under-lying device.
@@ -385,6 +417,7 @@ class BlockCache final : public Engine {
   mutable AtomicCounter insertHashCollisionCount_;
   mutable AtomicCounter succInsertCount_;
   mutable AtomicCounter lookupFalsePositiveCount_;
+  mutable AtomicCounter lookupExpiredInIndexCount_;
   mutable AtomicCounter lookupEntryHeaderChecksumErrorCount_;
   mutable AtomicCounter lookupValueChecksumErrorCount_;
   mutable AtomicCounter removeCount_;
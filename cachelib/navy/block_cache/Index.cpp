@@ -18,6 +18,7 @@
 
 #include <folly/Format.h>
 
+#include "cachelib/common/Time.h"
 #include "cachelib/navy/serialization/Serialization.h"
 
 namespace facebook::cachelib::navy {
@@ -33,6 +34,75 @@ uint8_t safeInc(uint8_t val) {
 }
 } // namespace
 
+Index::Index(MetadataConfig metadataConfig, util::HugePagePolicy hugePages)
+    : buckets_{kNumBuckets, hugePages}, metadataConfig_{metadataConfig} {
+  if (metadataConfig_.enabled()) {
+    meta_ = util::MetadataArray<MetaMap>{kNumBuckets, hugePages};
+  }
+}
+
+Index::ItemMeta Index::makeMeta(uint64_t hash, uint32_t expiryTime) const {
+  ItemMeta meta;
+  if (metadataConfig_.keyFingerprint) {
+    meta.fingerprint = fingerprint(hash);
+  }
+  meta.expiry = toExpiryBucket(expiryTime);
+  return meta;
+}
+
+uint16_t Index::toExpiryBucket(uint32_t expiryTime) const {
+  const auto granularity = metadataConfig_.expiryGranularitySecs;
+  if (granularity == 0 || expiryTime == 0) {
+    return 0;
+  }
+  // round up so that the item is never reported expired too early
+  const uint64_t expiryBucket =
+      (uint64_t{expiryTime} + granularity - 1) / granularity;
+  const uint64_t nowBucket = util::getCurrentTimeSec() / granularity;
+  // the bucket wraps around, so expiries too far out are left unknown
+  if (expiryBucket >= nowBucket + std::numeric_limits<int16_t>::max()) {
+    return 0;
+  }
+  // 0 is reserved for unknown, report it one bucket later instead
+  return std::max<uint16_t>(static_cast<uint16_t>(expiryBucket), 1);
+}
+
+uint32_t Index::fromExpiryBucket(uint16_t expiry) const {
+  const auto granularity = metadataConfig_.expiryGranularitySecs;
+  if (granularity == 0 || expiry == 0) {
+    return 0;
+  }
+  const int64_t nowBucket = util::getCurrentTimeSec() / granularity;
+  const auto delta =
+      static_cast<int16_t>(expiry - static_cast<uint16_t>(nowBucket));
+  return static_cast<uint32_t>(std::max<int64_t>(nowBucket + delta, 1) *
+                               granularity);
+}
+
+bool Index::checkMeta(uint64_t hash, bool& expired) const {
+  expired = false;
+  if (!meta_) {
+    return true;
+  }
+  const auto& map = meta_[bucket(hash)];
+  auto it = map.find(subkey(hash));
+  if (it == map.end()) {
+    // entries recovered without metadata
+    return true;
+  }
+  const auto& meta = it->second;
+  if (metadataConfig_.keyFingerprint && meta.fingerprint != fingerprint(hash)) {
+    fingerprintMismatches_.inc();
+    return false;
+  }
+  if (meta.expiry != 0) {
+    const auto nowBucket = static_cast<uint16_t>(
+        util::getCurrentTimeSec() / metadataConfig_.expiryGranularitySecs);
+    expired = static_cast<int16_t>(nowBucket - meta.expiry) > 0;
+  }
+  return true;
+}
+
 void Index::setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits) {
   auto& map = getMap(key);
   auto lock = std::lock_guard{getMutex(key)};
@@ -50,7 +120,7 @@ Index::LookupResult Index::lookup(uint64_t key) {
   auto lock = std::lock_guard{getMutex(key)};
 
   auto it = map.find(subkey(key));
-  if (it != map.end()) {
+  if (it != map.end() && checkMeta(key, lr.expired_)) {
     lr.found_ = true;
     lr.record_ = it->second;
     it.value().totalHits = safeInc(lr.record_.totalHits);
@@ -65,7 +135,7 @@ Index::LookupResult Index::peek(uint64_t key) const {
   auto lock = std::shared_lock{getMutex(key)};
 
   auto it = map.find(subkey(key));
-  if (it != map.end()) {
+  if (it != map.end() && checkMeta(key, lr.expired_)) {
     lr.found_ = true;
     lr.record_ = it->second;
   }
@@ -74,7 +144,8 @@ Index::LookupResult Index::peek(uint64_t key) const {
 
 Index::LookupResult Index::insert(uint64_t key,
                                   uint32_t address,
-                                  uint16_t sizeHint) {
+                                  uint16_t sizeHint,
+                                  uint32_t expiryTime) {
   LookupResult lr;
   auto& map = getMap(key);
   auto lock = std::lock_guard{getMutex(key)};
@@ -91,6 +162,10 @@ Index::LookupResult Index::insert(uint64_t key,
   } else {
     map.try_emplace(key, address, sizeHint);
   }
+  if (meta_) {
+    // a colliding key replaces the entry, so the metadata follows the latest
+    meta_[bucket(key)].insert_or_assign(subkey(key), makeMeta(key, expiryTime));
+  }
   return lr;
 }
 
@@ -123,12 +198,13 @@ Index::LookupResult Index::remove(uint64_t key) {
   auto lock = std::lock_guard{getMutex(key)};
 
   auto it = map.find(subkey(key));
-  if (it != map.end()) {
+  if (it != map.end() && checkMeta(key, lr.expired_)) {
     lr.found_ = true;
     lr.record_ = it->second;
 
     trackRemove(it->second.totalHits);
     map.erase(it);
+    eraseMeta(key);
   }
   return lr;
 }
@@ -141,6 +217,7 @@ bool Index::removeIfMatch(uint64_t key, uint32_t address) {
   if (it != map.end() && it->second.address == address) {
     trackRemove(it->second.totalHits);
     map.erase(it);
+    eraseMeta(key);
     return true;
   }
   return false;
@@ -150,6 +227,9 @@ void Index::reset() {
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     auto lock = std::lock_guard{getMutexOfBucket(i)};
     buckets_[i].clear();
+    if (meta_) {
+      meta_[i].clear();
+    }
   }
   unAccessedItems_.set(0);
 }
@@ -175,6 +255,17 @@ void Index::persist(RecordWriter& rw) const {
       entry.sizeHint() = record.sizeHint;
       entry.totalHits() = record.totalHits;
       entry.currentHits() = record.currentHits;
+      if (meta_) {
+        auto it = meta_[i].find(key);
+        if (it != meta_[i].end()) {
+          if (metadataConfig_.keyFingerprint) {
+            entry.fingerprint() = static_cast<int16_t>(it->second.fingerprint);
+          }
+          if (auto expiryTime = fromExpiryBucket(it->second.expiry)) {
+            entry.expiryTime() = static_cast<int32_t>(expiryTime);
+          }
+        }
+      }
       bucket.entries()->push_back(entry);
     }
     // Serialize bucket then clear contents to reuse memory.
@@ -199,6 +290,22 @@ void Index::recover(RecordReader& rr) {
                                *entry.sizeHint(),
                                *entry.totalHits(),
                                *entry.currentHits());
+      // entries persisted without a fingerprint are left without metadata,
+      // which makes lookups fall back to reading the device
+      if (!meta_ || (metadataConfig_.keyFingerprint &&
+                     !entry.fingerprint().has_value())) {
+        continue;
+      }
+      ItemMeta meta;
+      if (metadataConfig_.keyFingerprint) {
+        meta.fingerprint = static_cast<uint16_t>(*entry.fingerprint());
+      }
+      if (entry.expiryTime().has_value()) {
+        // re-encode since the granularity may have changed
+        meta.expiry =
+            toExpiryBucket(static_cast<uint32_t>(*entry.expiryTime()));
+      }
+      meta_[id].insert_or_assign(*entry.key(), meta);
     }
   }
 }
@@ -206,5 +313,9 @@ void Index::recover(RecordReader& rr) {
 void Index::getCounters(const CounterVisitor& visitor) const {
   hitsEstimator_.visitQuantileEstimator(visitor, "navy_bc_item_hits");
   visitor("navy_bc_item_removed_with_no_access", unAccessedItems_.get());
+  if (metadataConfig_.keyFingerprint) {
+    visitor("navy_bc_index_fingerprint_mismatches",
+            fingerprintMismatches_.get());
+  }
 }
 } // namespace facebook::cachelib::navy
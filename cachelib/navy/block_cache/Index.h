@@ -28,6 +28,7 @@
 #include <utility>
 
 #include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/HugePageAllocator.h"
 #include "cachelib/common/PercentileStats.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
@@ -46,7 +47,30 @@ class Index {
   // Specify 1 second window size for quantile estimator.
   static constexpr std::chrono::seconds kQuantileWindowSize{1};
 
+  // Optional metadata kept next to the records so that some decisions can be
+  // made without reading the item from the device. Enabling any of these
+  // costs an extra ItemMeta entry per item (about 8 bytes including the
+  // sparse map overhead) on top of the 8 byte record.
+  struct MetadataConfig {
+    // keep the 16 hash bits not used to address the record. Lookups and
+    // removes of a colliding key are then resolved in DRAM.
+    bool keyFingerprint{false};
+
+    // keep the expiry time rounded up to this many seconds. Lookups of
+    // expired items return without IO and reclaim skips parsing them.
+    // 0 disables it.
+    uint32_t expiryGranularitySecs{0};
+
+    bool enabled() const { return keyFingerprint || expiryGranularitySecs > 0; }
+  };
+
   Index() = default;
+
+  // @param hugePages   whether the bucket arrays are backed by huge pages.
+  //                    The entries of a bucket are allocated on the heap.
+  explicit Index(
+      MetadataConfig metadataConfig,
+      util::HugePagePolicy hugePages = util::HugePagePolicy::kNone);
   Index(const Index&) = delete;
   Index& operator=(const Index&) = delete;
 
@@ -111,9 +135,17 @@ class Index {
       return record_.totalHits;
     }
 
+    // true if the index metadata tells the item is expired. false if it is
+    // not, or if the expiry is not tracked.
+    bool expired() const {
+      XDCHECK(found_);
+      return expired_;
+    }
+
    private:
     ItemRecord record_;
     bool found_{false};
+    bool expired_{false};
   };
 
   // Gets value and update tracking counters
@@ -126,7 +158,13 @@ class Index {
   // will reset hits counting. If the entry was successfully overwritten,
   // LookupResult.found() returns true and LookupResult.record() returns the old
   // record.
-  LookupResult insert(uint64_t key, uint32_t address, uint16_t sizeHint);
+  //
+  // @param expiryTime  absolute expiry time in seconds, 0 for none. Only
+  //                    used if the expiry metadata is enabled.
+  LookupResult insert(uint64_t key,
+                      uint32_t address,
+                      uint16_t sizeHint,
+                      uint32_t expiryTime = 0);
 
   // Replaces old address with new address if there exists the key with the
   // identical old address. Current hits will be reset after successful replace.
@@ -138,6 +176,7 @@ class Index {
   // If the entry was successfully removed, LookupResult.found() returns true
   // and LookupResult.record() returns the record that was just found.
   // If the entry wasn't found, then LookupResult.found() returns false.
+  // With key fingerprints, an entry of a colliding key is not removed.
   LookupResult remove(uint64_t key);
 
   // Removes only if both key and address match.
@@ -157,7 +196,24 @@ class Index {
   // Exports index stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // true if lookups and removes compare key fingerprints
+  bool hasKeyFingerprint() const { return metadataConfig_.keyFingerprint; }
+
+  // true if lookups report expired items
+  bool hasExpiry() const { return metadataConfig_.expiryGranularitySecs > 0; }
+
  private:
+  struct FOLLY_PACK_ATTR ItemMeta {
+    // top 16 bits of the key hash
+    uint16_t fingerprint{0};
+    // expiry in units of the granularity, wrapping around. 0 means the
+    // expiry is unknown or the item does not expire.
+    uint16_t expiry{0};
+  };
+  static_assert(4 == sizeof(ItemMeta), "ItemMeta size is 4 bytes");
+
+  using MetaMap = tsl::sparse_map<uint32_t, ItemMeta>;
+
   static constexpr uint32_t kNumBuckets{64 * 1024};
   static constexpr uint32_t kNumMutexes{1024};
 
@@ -169,6 +225,29 @@ class Index {
 
   static uint32_t subkey(uint64_t hash) { return hash & 0xffffffffu; }
 
+  // the hash bits not used by bucket() and subkey()
+  static uint16_t fingerprint(uint64_t hash) {
+    return static_cast<uint16_t>(hash >> 48);
+  }
+
+  ItemMeta makeMeta(uint64_t hash, uint32_t expiryTime) const;
+
+  // encode the expiry time into a wrapping bucket, 0 if unknown
+  uint16_t toExpiryBucket(uint32_t expiryTime) const;
+
+  // approximate expiry time of the bucket, 0 if unknown
+  uint32_t fromExpiryBucket(uint16_t expiry) const;
+
+  // returns false if the entry's metadata rules out the key. Fills in
+  // whether the entry is known to be expired.
+  bool checkMeta(uint64_t hash, bool& expired) const;
+
+  void eraseMeta(uint64_t hash) {
+    if (meta_) {
+      meta_[bucket(hash)].erase(subkey(hash));
+    }
+  }
+
   SharedMutex& getMutexOfBucket(uint32_t bucket) const {
     XDCHECK(folly::isPowTwo(kNumMutexes));
     return mutex_[bucket & (kNumMutexes - 1)];
@@ -189,10 +268,17 @@ class Index {
   // Experiments with 64 byte alignment didn't show any throughput test
   // performance improvement.
   std::unique_ptr<SharedMutex[]> mutex_{new SharedMutex[kNumMutexes]};
-  std::unique_ptr<Map[]> buckets_{new Map[kNumBuckets]};
+  util::MetadataArray<Map> buckets_{kNumBuckets, util::HugePagePolicy::kNone};
+
+  const MetadataConfig metadataConfig_{};
+
+  // per bucket metadata, only allocated if enabled. Protected by the mutex
+  // of the bucket.
+  util::MetadataArray<MetaMap> meta_;
 
   mutable util::PercentileStats hitsEstimator_{kQuantileWindowSize};
   mutable AtomicCounter unAccessedItems_;
+  mutable AtomicCounter fingerprintMismatches_;
 
   static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
                 "number of mutexes must be power of two");
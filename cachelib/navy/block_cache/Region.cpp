@@ -84,12 +84,13 @@ std::unique_ptr<Buffer> Region::detachBuffer() {
 
 // This function flushes the attached buffer if there are no active writers
 // by calling the callBack function that is expected to write the buffer to
-// underlying device. If there are active writers, the caller is expected
-// to call this function again.
+// underlying device. If there are active writers, or the region's device
+// range is still being discarded, the caller is expected to call this
+// function again.
 Region::FlushRes Region::flushBuffer(
     std::function<bool(RelAddress, BufferView)> callBack) {
   std::unique_lock<TimedMutex> lock{lock_};
-  if (activeWriters_ != 0) {
+  if (activeWriters_ != 0 || (flags_ & kDiscardPending) != 0) {
     return FlushRes::kRetryPendingWrites;
   }
   if (!isFlushedLocked()) {
@@ -121,6 +122,7 @@ void Region::reset() {
   std::lock_guard<TimedMutex> l{lock_};
   XDCHECK_EQ(activeOpenLocked(), 0U);
   priority_ = 0;
+  band_.store(0, std::memory_order_relaxed);
   flags_ = 0;
   activeWriters_ = 0;
   activePhysReaders_ = 0;
@@ -18,6 +18,8 @@
 
 #include <folly/fibers/TimedMutex.h>
 
+#include <atomic>
+
 #include "cachelib/common/ConditionVariable.h"
 #include "cachelib/navy/block_cache/Types.h"
 #include "cachelib/navy/common/Types.h"
@@ -67,6 +69,7 @@ class Region {
       : regionId_{static_cast<uint32_t>(*d.regionId())},
         regionSize_{regionSize},
         priority_{static_cast<uint16_t>(*d.priority())},
+        band_{static_cast<uint16_t>(*d.band())},
         lastEntryEndOffset_{static_cast<uint32_t>(*d.lastEntryEndOffset())},
         numItems_{static_cast<uint32_t>(*d.numItems())} {}
 
@@ -110,6 +113,15 @@ class Region {
     return priority_;
   }
 
+  // Assigns this region to a size band. Regions of a band only hold items
+  // of the band's sizes and are tracked by the band's eviction policy. The
+  // band only changes while the region is clean and not tracked.
+  void setBand(uint16_t band) { band_.store(band, std::memory_order_relaxed); }
+
+  // Gets the size band this region is assigned to. Takes no lock, so that
+  // it is cheap on the lookup path.
+  uint16_t getBand() const { return band_.load(std::memory_order_relaxed); }
+
   // Gets the end offset of last slot added to this region.
   uint32_t getLastEntryEndOffset() const {
     std::lock_guard<TimedMutex> l{lock_};
@@ -178,6 +190,20 @@ class Region {
     flags_ |= kFlushPending;
   }
 
+  // Marks the region's device range as being discarded. The buffer is not
+  // flushed until finishDiscard(), so that the discard can not drop the new
+  // data.
+  void setPendingDiscard() {
+    std::lock_guard l{lock_};
+    flags_ |= kDiscardPending;
+  }
+
+  // Lets the buffer be flushed once the discard is done.
+  void finishDiscard() {
+    std::lock_guard l{lock_};
+    flags_ &= ~kDiscardPending;
+  }
+
   // Checks if the region's buffer is flushed.
   bool isFlushedLocked() const { return (flags_ & kFlushed) != 0; }
 
@@ -217,11 +243,13 @@ class Region {
   static constexpr uint16_t kFlushPending{1u << 2};
   static constexpr uint16_t kFlushed{1u << 3};
   static constexpr uint16_t kCleanedup{1u << 4};
+  static constexpr uint16_t kDiscardPending{1u << 5};
 
   const RegionId regionId_{};
   const uint64_t regionSize_{0};
 
   uint16_t priority_{0};
+  std::atomic<uint16_t> band_{0};
   uint16_t flags_{0};
   uint32_t activePhysReaders_{0};
   uint32_t activeInMemReaders_{0};
@@ -16,6 +16,9 @@
 
 #include "cachelib/navy/block_cache/RegionManager.h"
 
+#include <folly/String.h>
+#include <folly/io/async/Request.h>
+
 #include "cachelib/common/inject_pause.h"
 #include "cachelib/navy/common/Utils.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
@@ -33,14 +36,21 @@ RegionManager::RegionManager(uint32_t numRegions,
                              std::unique_ptr<EvictionPolicy> policy,
                              uint32_t numInMemBuffers,
                              uint16_t numPriorities,
-                             uint16_t inMemBufFlushRetryLimit)
+                             uint16_t inMemBufFlushRetryLimit,
+                             uint64_t discardBytesPerSec,
+                             std::vector<uint32_t> sizeBands,
+                             std::vector<std::unique_ptr<EvictionPolicy>>
+                                 sizeBandPolicies)
     : numPriorities_{numPriorities},
       inMemBufFlushRetryLimit_{inMemBufFlushRetryLimit},
       numRegions_{numRegions},
       regionSize_{regionSize},
       baseOffset_{baseOffset},
       device_{device},
-      policy_{std::move(policy)},
+      sizeBands_{std::move(sizeBands)},
+      numBands_{static_cast<uint16_t>(sizeBands_.size() + 1)},
+      bands_(numBands_),
+      minBandRegions_{std::max<uint32_t>(1, numRegions / (numBands_ * 8))},
       regions_{std::make_unique<std::unique_ptr<Region>[]>(numRegions)},
       numCleanRegions_{numCleanRegions},
       evictCb_{evictCb},
@@ -48,6 +58,26 @@ RegionManager::RegionManager(uint32_t numRegions,
       numInMemBuffers_{numInMemBuffers},
       placementHandle_{device_.allocatePlacementHandle()} {
   XLOGF(INFO, "{} regions, {} bytes each", numRegions_, regionSize_);
+  if (sizeBandPolicies.size() != sizeBands_.size()) {
+    throw std::invalid_argument("every size band needs an eviction policy");
+  }
+  XDCHECK(std::is_sorted(sizeBands_.begin(), sizeBands_.end()));
+  for (size_t i = 0; i < sizeBands_.size(); i++) {
+    bands_[i].policy = std::move(sizeBandPolicies[i]);
+  }
+  bands_.back().policy = std::move(policy);
+  if (numBands_ > 1) {
+    XLOGF(INFO, "{} size bands, bounded by {} bytes", numBands_,
+          folly::join(", ", sizeBands_));
+  }
+  if (discardBytesPerSec > 0) {
+    // allow a burst of at least one region so that any rate can make progress
+    discardLimiter_ = std::make_unique<folly::TokenBucket>(
+        discardBytesPerSec,
+        std::max<double>(discardBytesPerSec, regionSize_));
+    XLOGF(INFO, "Discarding reclaimed regions at up to {} bytes/s",
+          discardBytesPerSec);
+  }
   for (uint32_t i = 0; i < numRegions; i++) {
     regions_[i] = std::make_unique<Region>(RegionId{i}, regionSize_);
   }
@@ -71,27 +101,96 @@ RegionManager::RegionManager(uint32_t numRegions,
 }
 
 RegionId RegionManager::evict() {
-  auto rid = policy_->evict();
+  RegionId rid;
+  uint16_t band = 0;
+  if (numBands_ == 1) {
+    rid = bands_[0].policy->evict();
+  } else {
+    std::lock_guard<TimedMutex> lock{bandMutex_};
+    band = pickBandToEvictLocked();
+    rid = bands_[band].policy->evict();
+    // the region counts may lag behind the policies
+    for (uint16_t i = 0; !rid.valid() && i < numBands_; i++) {
+      band = i;
+      rid = bands_[band].policy->evict();
+    }
+  }
   if (!rid.valid()) {
     XLOG(ERR, "Eviction failed");
   } else {
-    XLOGF(DBG, "Evict {}", rid.index());
+    XLOGF(DBG, "Evict {} from band {}", rid.index(), band);
+    bands_[band].numRegions.dec();
+    bands_[band].reclaims.inc();
+    bands_[band].reclaimedItems.add(getRegion(rid).getNumItems());
   }
   return rid;
 }
 
+uint16_t RegionManager::pickBandToEvictLocked() {
+  // Decaying by 1 - 1/numRegions per eviction weighs about the last pass
+  // over the cache.
+  const double decay = 1.0 - 1.0 / numRegions_;
+  auto fold = [decay](double& decayed, uint64_t& last, uint64_t curr) {
+    decayed = decayed * decay + static_cast<double>(curr - last);
+    last = curr;
+  };
+
+  uint16_t victim = numBands_;
+  bool victimAboveMin = false;
+  double victimValue = 0;
+  uint64_t victimRegions = 0;
+  for (uint16_t i = 0; i < numBands_; i++) {
+    auto& band = bands_[i];
+    fold(band.decayedHits, band.lastHits, band.hits.get());
+    fold(band.decayedReclaimedItems, band.lastReclaimedItems,
+         band.reclaimedItems.get());
+    fold(band.decayedReinsertions, band.lastReinsertions,
+         band.reinsertions.get());
+
+    const uint64_t regions = band.numRegions.get();
+    if (regions == 0) {
+      continue;
+    }
+    const double reinsertionRate =
+        band.decayedReinsertions / std::max(1.0, band.decayedReclaimedItems);
+    const double value =
+        band.decayedHits / static_cast<double>(regions) * (1 + reinsertionRate);
+    const bool aboveMin = regions > minBandRegions_;
+    // Among equally valuable bands, shrink the largest, which also reclaims
+    // the regions left empty at startup first.
+    if (victim == numBands_ || (aboveMin && !victimAboveMin) ||
+        (aboveMin == victimAboveMin &&
+         (value < victimValue ||
+          (value == victimValue && regions > victimRegions)))) {
+      victim = i;
+      victimAboveMin = aboveMin;
+      victimValue = value;
+      victimRegions = regions;
+    }
+  }
+  return victim == numBands_ ? 0 : victim;
+}
+
 void RegionManager::touch(RegionId rid) {
   auto& region = getRegion(rid);
   XDCHECK_EQ(rid, region.id());
+  auto& band = bands_[region.getBand()];
+  band.hits.inc();
   if (!region.hasBuffer()) {
-    policy_->touch(rid);
+    band.policy->touch(rid);
   }
 }
 
 void RegionManager::track(RegionId rid) {
   auto& region = getRegion(rid);
   XDCHECK_EQ(rid, region.id());
-  policy_->track(region);
+  auto& band = bands_[region.getBand()];
+  band.policy->track(region);
+  band.numRegions.inc();
+}
+
+void RegionManager::recordReinsertion(RegionId rid) {
+  bands_[getRegion(rid).getBand()].reinsertions.inc();
 }
 
 void RegionManager::reset() {
@@ -193,7 +292,11 @@ std::pair<std::unique_ptr<Buffer>, std::unique_ptr<CondWaiter>>
 RegionManager::claimBufferFromPool(bool addWaiter) {
   std::unique_ptr<Buffer> buf;
   {
-    std::lock_guard<TimedMutex> bufLock{bufferMutex_};
+    std::unique_lock<TimedMutex> bufLock{bufferMutex_, std::defer_lock};
+    {
+      RequestTraceTimer traceTimer{&RequestTrace::bufferLockNs};
+      bufLock.lock();
+    }
     if (buffers_.empty()) {
       std::unique_ptr<CondWaiter> waiter;
       if (addWaiter) {
@@ -267,7 +370,7 @@ void RegionManager::doFlush(RegionId rid, bool async) {
   if (!async || isOnWorker()) {
     doFlushInternal(rid);
   } else {
-    getNextWorker().addTaskRemote([this, rid]() { doFlushInternal(rid); });
+    addWorkerTask([this, rid]() { doFlushInternal(rid); });
   }
 }
 
@@ -308,7 +411,13 @@ void RegionManager::doFlushInternal(RegionId rid) {
 }
 
 void RegionManager::startReclaim() {
-  getNextWorker().addTaskRemote([&]() { doReclaim(); });
+  addWorkerTask([&]() { doReclaim(); });
+}
+
+void RegionManager::addWorkerTask(folly::Func func) {
+  folly::RequestContextScopeGuard noContext{
+      std::shared_ptr<folly::RequestContext>{}};
+  getNextWorker().addTaskRemote(std::move(func));
 }
 
 void RegionManager::doReclaim() {
@@ -350,10 +459,32 @@ void RegionManager::doReclaim() {
       doEviction(rid, buffer.view());
     }
   }
-  releaseEvictedRegion(rid, startTime);
+  const bool discard = shouldDiscard();
+  releaseEvictedRegion(rid, startTime, discard);
+  if (discard) {
+    discardRegion(rid);
+  }
   INJECT_PAUSE(pause_reclaim_done);
 }
 
+bool RegionManager::shouldDiscard() {
+  if (!discardLimiter_) {
+    return false;
+  }
+  if (!discardLimiter_->consume(static_cast<double>(regionSize_))) {
+    discardsSkipped_.inc();
+    return false;
+  }
+  return true;
+}
+
+void RegionManager::discardRegion(RegionId rid) {
+  if (device_.discard(physicalOffset(RelAddress{rid, 0}), regionSize_)) {
+    discardedRegions_.inc();
+  }
+  getRegion(rid).finishDiscard();
+}
+
 RegionDescriptor RegionManager::openForRead(RegionId rid, uint64_t seqNumber) {
   auto& region = getRegion(rid);
   auto desc = region.openForRead();
@@ -409,7 +540,8 @@ void RegionManager::close(RegionDescriptor&& desc) {
 }
 
 void RegionManager::releaseEvictedRegion(RegionId rid,
-                                         std::chrono::nanoseconds startTime) {
+                                         std::chrono::nanoseconds startTime,
+                                         bool discardPending) {
   auto& region = getRegion(rid);
   // Subtract the wasted bytes in the end since we're reclaiming this region now
   externalFragmentation_.sub(getRegion(rid).getFragmentationSize());
@@ -422,6 +554,9 @@ void RegionManager::releaseEvictedRegion(RegionId rid,
   // Reset all region internal state, making it ready to be
   // used by a region allocator.
   region.reset();
+  if (discardPending) {
+    region.setPendingDiscard();
+  }
   {
     std::lock_guard<TimedMutex> lock{cleanRegionsMutex_};
     reclaimsOutstanding_--;
@@ -461,6 +596,7 @@ void RegionManager::persist(RecordWriter& rw) const {
     *regionProto.regionId() = i;
     *regionProto.lastEntryEndOffset() = regions_[i]->getLastEntryEndOffset();
     regionProto.priority() = regions_[i]->getPriority();
+    regionProto.band() = regions_[i]->getBand();
     *regionProto.numItems() = regions_[i]->getNumItems();
   }
   serializeProto(regionData, rw);
@@ -488,6 +624,11 @@ void RegionManager::recover(RecordReader& rr) {
     if (numPriorities_ > 0 && regionProto.priority() >= numPriorities_) {
       regionProto.priority() = numPriorities_ - 1;
     }
+    // Same for size bands. Items of a region with a downgraded band may not
+    // fit the band's sizes, which only matters until it is reclaimed.
+    if (regionProto.band() >= numBands_) {
+      regionProto.band() = numBands_ - 1;
+    }
     regions_[index] =
         std::make_unique<Region>(regionProto, *regionData.regionSize());
   }
@@ -499,7 +640,10 @@ void RegionManager::recover(RecordReader& rr) {
 void RegionManager::resetEvictionPolicy() {
   XDCHECK_GT(numRegions_, 0u);
 
-  policy_->reset();
+  for (auto& band : bands_) {
+    band.policy->reset();
+    band.numRegions.set(0);
+  }
   externalFragmentation_.set(0);
 
   // Go through all the regions, restore fragmentation size, and track all empty
@@ -605,6 +749,35 @@ void RegionManager::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_inmem_flush_failures", numInMemBufFlushFailures_.get(),
           CounterVisitor::CounterType::RATE);
-  policy_->getCounters(visitor);
+  if (discardLimiter_) {
+    visitor("navy_bc_discarded_regions", discardedRegions_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_discards_skipped", discardsSkipped_.get(),
+            CounterVisitor::CounterType::RATE);
+  }
+  bands_.back().policy->getCounters(visitor);
+  if (numBands_ > 1) {
+    for (uint16_t i = 0; i < numBands_; i++) {
+      const auto& band = bands_[i];
+      visitor(fmt::format("navy_bc_band_{}_regions", i),
+              band.numRegions.get());
+      visitor(fmt::format("navy_bc_band_{}_hits", i), band.hits.get(),
+              CounterVisitor::CounterType::RATE);
+      visitor(fmt::format("navy_bc_band_{}_reclaims", i), band.reclaims.get(),
+              CounterVisitor::CounterType::RATE);
+      visitor(fmt::format("navy_bc_band_{}_reinsertions", i),
+              band.reinsertions.get(), CounterVisitor::CounterType::RATE);
+      if (i + 1 < numBands_) {
+        // the last band's policy exports the unsuffixed counters above
+        std::function<void(folly::StringPiece, double,
+                           CounterVisitor::CounterType)>
+            bandVisitor = [&visitor, i](folly::StringPiece name, double count,
+                                        CounterVisitor::CounterType type) {
+              visitor(fmt::format("{}_band_{}", name, i), count, type);
+            };
+        band.policy->getCounters(bandVisitor);
+      }
+    }
+  }
 }
 } // namespace facebook::cachelib::navy
@@ -17,12 +17,15 @@
 #pragma once
 
 #include <folly/Random.h>
+#include <folly/TokenBucket.h>
 #include <folly/container/F14Map.h>
 #include <folly/fibers/TimedMutex.h>
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/ConditionVariable.h"
@@ -32,6 +35,7 @@
 #include "cachelib/navy/common/Buffer.h"
 #include "cachelib/navy/common/Device.h"
 #include "cachelib/navy/common/NavyThread.h"
+#include "cachelib/navy/common/RequestTrace.h"
 #include "cachelib/navy/common/Types.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 #include "cachelib/navy/serialization/Serialization.h"
@@ -81,6 +85,13 @@ class RegionManager {
   //                                  regions
   // @param inMemBufFlushRetryLimit   max number of flushing retry times for
   //                                  in-mem buffer
+  // @param discardBytesPerSec        max rate of discarding reclaimed regions
+  //                                  on the device. 0 disables discards
+  // @param sizeBands                 ascending upper bounds of the item sizes
+  //                                  of all but the last size band. Empty
+  //                                  keeps all items in a single band
+  // @param sizeBandPolicies          eviction policy of each band bounded by
+  //                                  @sizeBands. The last band uses @policy
   RegionManager(uint32_t numRegions,
                 uint64_t regionSize,
                 uint64_t baseOffset,
@@ -93,7 +104,11 @@ class RegionManager {
                 std::unique_ptr<EvictionPolicy> policy,
                 uint32_t numInMemBuffers,
                 uint16_t numPriorities,
-                uint16_t inMemBufFlushRetryLimit);
+                uint16_t inMemBufFlushRetryLimit,
+                uint64_t discardBytesPerSec = 0,
+                std::vector<uint32_t> sizeBands = {},
+                std::vector<std::unique_ptr<EvictionPolicy>>
+                    sizeBandPolicies = {});
   RegionManager(const RegionManager&) = delete;
   RegionManager& operator=(const RegionManager&) = delete;
 
@@ -120,6 +135,8 @@ class RegionManager {
   const RegionId getRandomRegion() const {
     return RegionId{folly::Random::rand32(0, numRegions_)};
   }
+
+  uint32_t numRegions() const { return numRegions_; }
   // Flushes the in memory buffer attached to a region in either async or
   // sync mode.
   // In async mode, a flush job will be added to a job scheduler;
@@ -129,7 +146,17 @@ class RegionManager {
   // Returns the size of one region.
   uint64_t regionSize() const { return regionSize_; }
 
-  // Gets a region to evict.
+  // Returns the number of size bands, at least 1.
+  uint16_t numSizeBands() const { return numBands_; }
+
+  // Returns the size band that allocations of @size bytes belong to.
+  uint16_t getSizeBand(uint32_t size) const {
+    auto it = std::lower_bound(sizeBands_.begin(), sizeBands_.end(), size);
+    return static_cast<uint16_t>(it - sizeBands_.begin());
+  }
+
+  // Gets a region to evict. With size bands, the region comes from the band
+  // whose regions are currently worth the least. See pickBandToEvictLocked().
   RegionId evict();
 
   // Promote a region. If this region was still buffered in-mem,
@@ -139,6 +166,10 @@ class RegionManager {
   // Calling track on tracked regions is noop.
   void track(RegionId rid);
 
+  // Records that an item of region @rid was reinserted while the region was
+  // being reclaimed.
+  void recordReinsertion(RegionId rid);
+
   // Resets all region internal state.
   void reset();
 
@@ -170,7 +201,11 @@ class RegionManager {
   // Returns the buffer to the pool.
   void returnBufferToPool(std::unique_ptr<Buffer> buf) {
     {
-      std::lock_guard<TimedMutex> bufLock{bufferMutex_};
+      std::unique_lock<TimedMutex> bufLock{bufferMutex_, std::defer_lock};
+      {
+        RequestTraceTimer traceTimer{&RequestTrace::bufferLockNs};
+        bufLock.lock();
+      }
       buffers_.push_back(std::move(buf));
       if (bufferCond_.numWaiters() > 0) {
         bufferCond_.notifyAll();
@@ -255,10 +290,14 @@ class RegionManager {
 
   // Releases a region that was evicted during region reclamation.
   //
-  // @param rid        region ID
-  // @param startTime  time when a reclamation starts;
-  //                   it is used to count the reclamation time duration
-  void releaseEvictedRegion(RegionId rid, std::chrono::nanoseconds startTime);
+  // @param rid             region ID
+  // @param startTime       time when a reclamation starts;
+  //                        it is used to count the reclamation time duration
+  // @param discardPending  whether the region's device range is discarded
+  //                        after the release, see discardRegion()
+  void releaseEvictedRegion(RegionId rid,
+                            std::chrono::nanoseconds startTime,
+                            bool discardPending = false);
 
   // Evicts a region by calling @evictCb_ during region reclamation.
   void doEviction(RegionId rid, BufferView buffer) const;
@@ -273,6 +312,12 @@ class RegionManager {
     return *(workers_[numReclaimScheduled_.add_fetch(1) % workers_.size()]);
   }
 
+  // Runs @func on the next worker. Flushes and reclaims don't belong to the
+  // request that happens to trigger them, so they run without its request
+  // context. Otherwise they would time their IOs into the request's trace,
+  // which is freed once the request completes.
+  void addWorkerTask(folly::Func func);
+
   bool isOnWorker() {
     auto* thread = getCurrentNavyThread();
     if (!thread) {
@@ -285,12 +330,27 @@ class RegionManager {
   void doReclaim();
   void doFlushInternal(RegionId rid);
 
+  // Whether the discard rate allows discarding a reclaimed region now.
+  bool shouldDiscard();
+
+  // Discards the device range of a reclaimed region. The region is already
+  // back in the clean pool so that the reclaim does not wait on the device,
+  // and its buffer is not flushed until the discard is done.
+  void discardRegion(RegionId rid);
+
   bool deviceWrite(RelAddress addr, BufferView buf);
 
   bool isValidIORange(uint32_t offset, uint32_t size) const;
   std::pair<OpenStatus, std::unique_ptr<CondWaiter>> assignBufferToRegion(
       RegionId rid, bool addWaiter);
 
+  // Picks the size band to reclaim a region from: the one with the fewest
+  // recent hits per region, where hits count more in bands whose reclaimed
+  // items are often reinserted since reclaiming them mostly rewrites the same
+  // items. Bands at their minimum number of regions are skipped unless all
+  // bands are. Caller must hold bandMutex_.
+  uint16_t pickBandToEvictLocked();
+
   // Initializes the eviction policy. Even on a clean start, we will track all
   // the regions. The difference is that these regions will have no items in
   // them and can be evicted right away.
@@ -302,7 +362,36 @@ class RegionManager {
   const uint64_t regionSize_{};
   const uint64_t baseOffset_{};
   Device& device_;
-  const std::unique_ptr<EvictionPolicy> policy_;
+
+  // Items are segregated by size into bands, so that regions of small items
+  // are not reclaimed to make room for large ones and vice versa. Each band
+  // allocates from its own regions and has its own eviction policy, while the
+  // share of regions of each band follows from which band evict() picks.
+  struct SizeBand {
+    std::unique_ptr<EvictionPolicy> policy;
+    // regions tracked by the policy
+    AtomicCounter numRegions;
+    // bumped on every lookup hit, so kept thread local
+    TLCounter hits;
+    AtomicCounter reclaims;
+    AtomicCounter reclaimedItems;
+    AtomicCounter reinsertions;
+
+    // Guarded by bandMutex_. The counters above decayed at every eviction,
+    // and their values when last folded in.
+    double decayedHits{0};
+    double decayedReclaimedItems{0};
+    double decayedReinsertions{0};
+    uint64_t lastHits{0};
+    uint64_t lastReclaimedItems{0};
+    uint64_t lastReinsertions{0};
+  };
+  const std::vector<uint32_t> sizeBands_;
+  const uint16_t numBands_{};
+  std::vector<SizeBand> bands_;
+  // A band is not picked for eviction at or below this many regions
+  const uint32_t minBandRegions_{};
+  mutable TimedMutex bandMutex_;
   std::unique_ptr<std::unique_ptr<Region>[]> regions_;
   mutable AtomicCounter externalFragmentation_;
 
@@ -337,6 +426,11 @@ class RegionManager {
   mutable AtomicCounter reclaimTimeCountUs_;
   mutable AtomicCounter evictedCount_;
 
+  // Limits the bytes discarded per second. Null if discards are disabled.
+  std::unique_ptr<folly::TokenBucket> discardLimiter_;
+  mutable AtomicCounter discardedRegions_;
+  mutable AtomicCounter discardsSkipped_;
+
   // Stats to keep track of inmem buffer usage
   mutable AtomicCounter numInMemBufActive_;
   mutable AtomicCounter numInMemBufWaitingFlush_;
@@ -262,4 +262,59 @@ TEST(Allocator, UsePriorities) {
   }
 }
 
+TEST(Allocator, UseSizeBands) {
+  constexpr uint32_t kNumRegions = 4;
+  constexpr uint32_t kRegionSize = 16 * 1024;
+  auto device =
+      createMemoryDevice(kNumRegions * kRegionSize, nullptr /* encryption */);
+  std::vector<std::unique_ptr<EvictionPolicy>> bandPolicies;
+  bandPolicies.push_back(std::make_unique<FifoPolicy>());
+  RegionEvictCallback evictCb{[](RegionId, BufferView) { return 0; }};
+  RegionCleanupCallback cleanupCb{[](RegionId, BufferView) {}};
+  auto rm = std::make_unique<RegionManager>(
+      kNumRegions, kRegionSize, 0, *device, 1, 1, 0, std::move(evictCb),
+      std::move(cleanupCb), std::make_unique<FifoPolicy>(),
+      kNumRegions /* numInMemBuffers */, kNumPriorities, kFlushRetryLimit,
+      0 /* discardBytesPerSec */, std::vector<uint32_t>{2048},
+      std::move(bandPolicies));
+
+  Allocator allocator{*rm, kNumPriorities};
+
+  ENABLE_INJECT_PAUSE_IN_SCOPE();
+
+  injectPauseSet("pause_reclaim_done");
+
+  // Allocate to make sure a reclaim is triggered
+  auto [desc, slotSize, addr] = allocator.allocate(1024, kNoPriority, false);
+  EXPECT_EQ(OpenStatus::Retry, desc.status());
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+
+  // Small and large items go to separate regions of their bands
+  std::tie(desc, slotSize, addr) =
+      allocator.allocate(1024, kNoPriority, false);
+  ASSERT_TRUE(desc.isReady());
+  EXPECT_EQ(RegionId{0}, addr.rid());
+  EXPECT_EQ(0, addr.offset());
+  EXPECT_EQ(0, rm->getRegion(addr.rid()).getBand());
+  allocator.close(std::move(desc));
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+
+  std::tie(desc, slotSize, addr) =
+      allocator.allocate(4096, kNoPriority, false);
+  ASSERT_TRUE(desc.isReady());
+  EXPECT_EQ(RegionId{1}, addr.rid());
+  EXPECT_EQ(0, addr.offset());
+  EXPECT_EQ(1, rm->getRegion(addr.rid()).getBand());
+  allocator.close(std::move(desc));
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+
+  // The next small item is appended to the small item region
+  std::tie(desc, slotSize, addr) =
+      allocator.allocate(2048, kNoPriority, false);
+  ASSERT_TRUE(desc.isReady());
+  EXPECT_EQ(RegionId{0}, addr.rid());
+  EXPECT_EQ(1024, addr.offset());
+  allocator.close(std::move(desc));
+}
+
 } // namespace facebook::cachelib::navy::tests
@@ -1504,6 +1504,43 @@ TEST(BlockCache, RecoveryWithDifferentCacheSize) {
   }
 }
 
+TEST(BlockCache, SizeBandsNeedSpareBuffers) {
+  std::vector<uint32_t> hits(4);
+  std::vector<uint32_t> bandHits(4);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = makeJobScheduler();
+  auto makeBandConfig = [&](uint32_t numInMemBuffers) {
+    auto config = makeConfig(
+        *ex, std::make_unique<NiceMock<MockPolicy>>(&hits), *device);
+    config.sizeBands = {1024};
+    config.sizeBandPolicies.push_back(
+        std::make_unique<NiceMock<MockPolicy>>(&bandHits));
+    config.numInMemBuffers = numInMemBuffers;
+    return config;
+  };
+
+  // two bands keep two regions open, leaving no buffer to flush through
+  ASSERT_THROW(makeEngine(makeBandConfig(1)), std::invalid_argument);
+  ASSERT_THROW(makeEngine(makeBandConfig(2)), std::invalid_argument);
+
+  auto engine = makeEngine(makeBandConfig(3));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+  BufferGen bg;
+  std::vector<CacheEntry> log;
+  for (size_t i = 0; i < 4; i++) {
+    // alternate between the small and the large band
+    CacheEntry e{bg.gen(8), bg.gen(i % 2 == 0 ? 100 : 3000)};
+    EXPECT_EQ(Status::Ok, driver->insert(e.key(), e.value()));
+    log.push_back(std::move(e));
+  }
+  driver->flush();
+  for (auto& e : log) {
+    Buffer value;
+    EXPECT_EQ(Status::Ok, driver->lookup(e.key(), value));
+    EXPECT_EQ(e.value(), value.view());
+  }
+}
+
 // This test does the following
 // 1. Test creation of BlockCache with BlockCache::kMinAllocAlignSize aligned
 //    slot sizes fail when in memory buffers are not enabled
@@ -2312,6 +2349,60 @@ TEST(BlockCache, RandomAlloc) {
   EXPECT_LT(stddev, avg * 0.2);
 }
 
+TEST(BlockCache, ForEachItem) {
+  std::unordered_map<std::string, CacheEntry> log;
+
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = std::make_unique<MockJobScheduler>();
+  auto exPtr = ex.get();
+  auto config = makeConfig(*ex, std::move(policy), *device);
+  auto engine = makeEngine(std::move(config));
+  auto enginePtr = engine.get();
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  // Fill the first three regions
+  BufferGen bg;
+  auto insert = [&](const std::string& key) {
+    CacheEntry e{makeHK(key.c_str()), bg.gen(3800)};
+    driver->insertAsync(e.key(), e.value(),
+                        [](Status status, HashedKey /*key */) {
+                          EXPECT_EQ(Status::Ok, status);
+                        });
+    log.insert_or_assign(key, std::move(e));
+    finishAllJobs(*exPtr);
+  };
+  for (size_t j = 0; j < 3; j++) {
+    for (size_t i = 0; i < 4; i++) {
+      insert(folly::sformat("{}:{}", j, i));
+    }
+  }
+  // the old version of an overwritten key stays on the device, and so does
+  // a removed key
+  insert("1:2");
+  EXPECT_EQ(Status::Ok, driver->remove(makeHK("2:1")));
+  log.erase("2:1");
+  driver->flush();
+
+  // every live key is visited exactly once, with its latest value
+  constexpr uint32_t kNumPartitions = 3;
+  std::unordered_map<std::string, size_t> visits;
+  for (uint32_t p = 0; p < kNumPartitions; p++) {
+    enginePtr->forEachItem(
+        p, kNumPartitions, [&](HashedKey hk, BufferView value) {
+          auto it = log.find(hk.key().str());
+          ASSERT_NE(it, log.end());
+          EXPECT_EQ(it->second.value(), value);
+          visits[hk.key().str()]++;
+        });
+  }
+  EXPECT_EQ(log.size(), visits.size());
+  for (const auto& [key, count] : visits) {
+    EXPECT_EQ(1, count) << key;
+  }
+}
+
 // Test size alignment calculations on an alignment other than the default (512
 // on less than 2TB device size)
 TEST(BlockCache, SizeAndAlignment) {
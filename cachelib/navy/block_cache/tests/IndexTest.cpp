@@ -18,6 +18,7 @@
 
 #include <thread>
 
+#include "cachelib/common/Time.h"
 #include "cachelib/navy/block_cache/Index.h"
 
 namespace facebook::cachelib::navy::tests {
@@ -194,4 +195,125 @@ TEST(Index, ThreadSafe) {
   EXPECT_EQ(200, index.peek(key).currentHits());
 }
 
+TEST(Index, KeyFingerprint) {
+  Index::MetadataConfig metaConfig;
+  metaConfig.keyFingerprint = true;
+  Index index{metaConfig};
+  // Same bucket and subkey, different top 16 bits
+  const uint64_t key = 1ull << 48 | 5ull << 32 | 7;
+  const uint64_t collidingKey = 2ull << 48 | 5ull << 32 | 7;
+
+  index.insert(key, 1111, 11);
+  EXPECT_TRUE(index.lookup(key).found());
+  EXPECT_FALSE(index.lookup(collidingKey).found());
+  EXPECT_FALSE(index.peek(collidingKey).found());
+  EXPECT_FALSE(index.remove(collidingKey).found());
+  EXPECT_EQ(1111, index.peek(key).address());
+
+  // A colliding insert still replaces the record
+  EXPECT_TRUE(index.insert(collidingKey, 2222, 22).found());
+  EXPECT_FALSE(index.lookup(key).found());
+  EXPECT_EQ(2222, index.lookup(collidingKey).address());
+  EXPECT_TRUE(index.remove(collidingKey).found());
+  EXPECT_FALSE(index.lookup(collidingKey).found());
+
+  // Without fingerprints the collision is not detected
+  Index plainIndex;
+  plainIndex.insert(key, 1111, 11);
+  EXPECT_TRUE(plainIndex.lookup(collidingKey).found());
+}
+
+TEST(Index, Expiry) {
+  Index::MetadataConfig metaConfig;
+  metaConfig.expiryGranularitySecs = 4;
+  Index index{metaConfig};
+  const uint32_t now = util::getCurrentTimeSec();
+
+  index.insert(111, 1, 0);
+  index.insert(222, 2, 0, now - 100);
+  index.insert(333, 3, 0, now + 100);
+  // Too far out to be encoded, treated as unknown
+  index.insert(444, 4, 0, now + 4 * 40000);
+  // Expired less than the granularity ago
+  index.insert(555, 5, 0, now - 1);
+
+  EXPECT_FALSE(index.lookup(111).expired());
+  EXPECT_TRUE(index.lookup(222).expired());
+  EXPECT_TRUE(index.peek(222).expired());
+  EXPECT_FALSE(index.lookup(333).expired());
+  EXPECT_FALSE(index.lookup(444).expired());
+  // Expiries are rounded up, so this one is not reported yet
+  EXPECT_FALSE(index.lookup(555).expired());
+
+  // Expired entries are still found and can be removed
+  EXPECT_TRUE(index.lookup(222).found());
+  EXPECT_TRUE(index.remove(222).found());
+  EXPECT_FALSE(index.lookup(222).found());
+
+  // Reinserting resets the expiry
+  index.insert(333, 3, 0, now - 100);
+  EXPECT_TRUE(index.lookup(333).expired());
+  index.insert(333, 3, 0);
+  EXPECT_FALSE(index.lookup(333).expired());
+}
+
+TEST(Index, MetadataRecovery) {
+  Index::MetadataConfig metaConfig;
+  metaConfig.keyFingerprint = true;
+  metaConfig.expiryGranularitySecs = 4;
+  Index index{metaConfig};
+  const uint32_t now = util::getCurrentTimeSec();
+  const uint64_t key = 1ull << 48 | 5ull << 32 | 7;
+  const uint64_t collidingKey = 2ull << 48 | 5ull << 32 | 7;
+  index.insert(key, 1111, 11, now - 100);
+  index.insert(333, 3333, 33, now + 100);
+
+  // Reading consumes the queue, so persist once per recovery
+  folly::IOBufQueue ioq;
+  auto rw = createMemoryRecordWriter(ioq);
+  index.persist(*rw);
+  folly::IOBufQueue plainIoq;
+  auto plainRw = createMemoryRecordWriter(plainIoq);
+  index.persist(*plainRw);
+
+  {
+    // Recovering with a different granularity keeps the expiry
+    metaConfig.expiryGranularitySecs = 8;
+    auto rr = createMemoryRecordReader(ioq);
+    Index newIndex{metaConfig};
+    newIndex.recover(*rr);
+    EXPECT_TRUE(newIndex.lookup(key).expired());
+    EXPECT_FALSE(newIndex.lookup(collidingKey).found());
+    EXPECT_EQ(3333, newIndex.lookup(333).address());
+    EXPECT_FALSE(newIndex.lookup(333).expired());
+  }
+
+  {
+    // Recovering without metadata works as before
+    auto rr = createMemoryRecordReader(plainIoq);
+    Index newIndex;
+    newIndex.recover(*rr);
+    EXPECT_EQ(1111, newIndex.lookup(key).address());
+    EXPECT_FALSE(newIndex.lookup(key).expired());
+  }
+}
+
+TEST(Index, MetadataMissingAfterRecovery) {
+  Index index;
+  const uint64_t key = 1ull << 48 | 5ull << 32 | 7;
+  index.insert(key, 1111, 11);
+
+  folly::IOBufQueue ioq;
+  auto rw = createMemoryRecordWriter(ioq);
+  index.persist(*rw);
+
+  // Entries persisted without fingerprints must still be found
+  Index::MetadataConfig metaConfig;
+  metaConfig.keyFingerprint = true;
+  auto rr = createMemoryRecordReader(ioq);
+  Index newIndex{metaConfig};
+  newIndex.recover(*rr);
+  EXPECT_EQ(1111, newIndex.lookup(key).address());
+}
+
 } // namespace facebook::cachelib::navy::tests
@@ -16,7 +16,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "cachelib/common/inject_pause.h"
@@ -219,6 +221,184 @@ TEST(RegionManager, ReadWrite) {
   EXPECT_EQ(buf.view(), bufReadDirect.view());
 }
 
+TEST(RegionManager, BackgroundWorkIsNotTraced) {
+  constexpr uint32_t kNumRegions = 4;
+  constexpr uint32_t kRegionSize = 4 * 1024;
+  auto device =
+      createMemoryDevice(kNumRegions * kRegionSize, nullptr /* encryption */);
+  RegionEvictCallback evictCb{[](RegionId, BufferView) { return 0; }};
+  RegionCleanupCallback cleanupCb{[](RegionId, BufferView) {}};
+  auto rm = std::make_unique<RegionManager>(
+      kNumRegions, kRegionSize, 0, *device, 1, 1, 0, std::move(evictCb),
+      std::move(cleanupCb), std::make_unique<LruPolicy>(kNumRegions),
+      kNumRegions /* numInMemBuffers */, 0, kFlushRetryLimit);
+
+  ENABLE_INJECT_PAUSE_IN_SCOPE();
+  injectPauseSet("pause_reclaim_done");
+  injectPauseSet("pause_flush_done");
+
+  // a sampled request triggers a reclaim and a flush
+  auto trace = std::make_unique<RequestTrace>();
+  RegionId rid;
+  {
+    RequestTraceScope scope{trace.get()};
+    rm->startReclaim();
+  }
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  ASSERT_EQ(OpenStatus::Ready, rm->getCleanRegion(rid, false).first);
+
+  BufferGen bg;
+  auto& region = rm->getRegion(rid);
+  auto [desc, addr] = region.openAndAllocate(1024);
+  ASSERT_EQ(OpenStatus::Ready, desc.status());
+  rm->write(addr, bg.gen(1024));
+  region.close(std::move(desc));
+  {
+    RequestTraceScope scope{trace.get()};
+    rm->doFlush(rid, true /* async */);
+  }
+  EXPECT_TRUE(injectPauseWait("pause_flush_done"));
+  // the flush wrote to the device on the worker without touching the trace,
+  // which would have been freed by then in a real request
+  EXPECT_LT(0, device->getBytesWritten());
+  EXPECT_EQ(0, trace->numDeviceIos);
+  EXPECT_EQ(0, trace->deviceNs);
+}
+
+TEST(RegionManager, Discard) {
+  constexpr uint64_t kBaseOffset = 1024;
+  constexpr uint32_t kNumRegions = 4;
+  constexpr uint32_t kRegionSize = 4 * 1024;
+
+  auto device = createMemoryDevice(kBaseOffset + kNumRegions * kRegionSize,
+                                   nullptr /* encryption */);
+  RegionEvictCallback evictCb{[](RegionId, BufferView) { return 0; }};
+  RegionCleanupCallback cleanupCb{[](RegionId, BufferView) {}};
+  // one region per second, so back to back reclaims exceed the rate
+  auto rm = std::make_unique<RegionManager>(
+      kNumRegions, kRegionSize, kBaseOffset, *device, 1, 1, 0,
+      std::move(evictCb), std::move(cleanupCb), std::make_unique<LruPolicy>(4),
+      kNumRegions /* numInMemBuffers */, 0, kFlushRetryLimit,
+      kRegionSize /* discardBytesPerSec */);
+
+  ENABLE_INJECT_PAUSE_IN_SCOPE();
+  injectPauseSet("pause_reclaim_done");
+
+  // leave some data behind in region 0 and 1 on the device
+  BufferGen bg;
+  auto buf = bg.gen(kRegionSize);
+  ASSERT_TRUE(device->write(kBaseOffset, buf.copy()));
+  ASSERT_TRUE(device->write(kBaseOffset + kRegionSize, buf.copy()));
+
+  RegionId rid;
+  rm->startReclaim();
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  ASSERT_EQ(OpenStatus::Ready, rm->getCleanRegion(rid, false).first);
+  ASSERT_EQ(0, rid.index());
+  EXPECT_EQ(kRegionSize, device->getBytesDiscarded());
+  {
+    // memory device zeroes discarded ranges
+    Buffer read{kRegionSize};
+    ASSERT_TRUE(device->read(kBaseOffset, kRegionSize, read.data()));
+    EXPECT_TRUE(std::all_of(read.data(), read.data() + read.size(),
+                            [](uint8_t b) { return b == 0; }));
+  }
+
+  rm->startReclaim();
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  ASSERT_EQ(OpenStatus::Ready, rm->getCleanRegion(rid, false).first);
+  ASSERT_EQ(1, rid.index());
+  // the second discard is over the rate and skipped
+  EXPECT_EQ(kRegionSize, device->getBytesDiscarded());
+  {
+    Buffer read{kRegionSize};
+    ASSERT_TRUE(
+        device->read(kBaseOffset + kRegionSize, kRegionSize, read.data()));
+    EXPECT_EQ(buf.view(), read.view());
+  }
+
+  std::unordered_map<std::string, double> counters;
+  rm->getCounters({[&counters](folly::StringPiece name, double value) {
+    counters[name.str()] = value;
+  }});
+  EXPECT_EQ(1, counters["navy_bc_discarded_regions"]);
+  EXPECT_EQ(1, counters["navy_bc_discards_skipped"]);
+}
+
+TEST(RegionManager, SizeBands) {
+  constexpr uint32_t kNumRegions = 4;
+  constexpr uint32_t kRegionSize = 4 * 1024;
+  auto device =
+      createMemoryDevice(kNumRegions * kRegionSize, nullptr /* encryption */);
+  auto makeRegionManager = [&device] {
+    std::vector<std::unique_ptr<EvictionPolicy>> bandPolicies;
+    bandPolicies.push_back(std::make_unique<FifoPolicy>());
+    RegionEvictCallback evictCb{[](RegionId, BufferView) { return 0; }};
+    RegionCleanupCallback cleanupCb{[](RegionId, BufferView) {}};
+    return std::make_unique<RegionManager>(
+        kNumRegions, kRegionSize, 0, *device, 1, 1, 0, std::move(evictCb),
+        std::move(cleanupCb), std::make_unique<FifoPolicy>(),
+        kNumRegions /* numInMemBuffers */, 0, kFlushRetryLimit,
+        0 /* discardBytesPerSec */, std::vector<uint32_t>{1024},
+        std::move(bandPolicies));
+  };
+
+  folly::IOBufQueue ioq;
+  {
+    auto rm = makeRegionManager();
+    ASSERT_EQ(2, rm->numSizeBands());
+    EXPECT_EQ(0, rm->getSizeBand(1));
+    EXPECT_EQ(0, rm->getSizeBand(1024));
+    EXPECT_EQ(1, rm->getSizeBand(1025));
+    EXPECT_EQ(1, rm->getSizeBand(kRegionSize));
+
+    // all regions start out empty in the first band
+    for (uint32_t i = 0; i < kNumRegions; i++) {
+      EXPECT_EQ(RegionId{i}, rm->evict());
+    }
+    // regions 0 and 1 hold small items, 2 and 3 large ones
+    for (uint32_t i = 0; i < kNumRegions; i++) {
+      rm->getRegion(RegionId{i}).setBand(i < 2 ? 0 : 1);
+      rm->track(RegionId{i});
+    }
+    for (int i = 0; i < 5; i++) {
+      rm->touch(RegionId{0});
+    }
+
+    std::unordered_map<std::string, double> counters;
+    rm->getCounters({[&counters](folly::StringPiece name, double value) {
+      counters[name.str()] = value;
+    }});
+    EXPECT_EQ(2, counters["navy_bc_band_0_regions"]);
+    EXPECT_EQ(2, counters["navy_bc_band_1_regions"]);
+    EXPECT_EQ(5, counters["navy_bc_band_0_hits"]);
+    EXPECT_EQ(0, counters["navy_bc_band_1_hits"]);
+    EXPECT_EQ(4, counters["navy_bc_band_0_reclaims"]);
+    EXPECT_EQ(2, counters["navy_bc_fifo_size"]);
+    EXPECT_EQ(2, counters["navy_bc_fifo_size_band_0"]);
+
+    auto rw = createMemoryRecordWriter(ioq);
+    rm->persist(*rw);
+
+    // the band without hits shrinks to its minimum of one region first, then
+    // the band with hits gives up a region
+    EXPECT_EQ(RegionId{2}, rm->evict());
+    EXPECT_EQ(RegionId{0}, rm->evict());
+    EXPECT_EQ(RegionId{3}, rm->evict());
+    EXPECT_EQ(RegionId{1}, rm->evict());
+    EXPECT_EQ(RegionId{}, rm->evict()); // Invalid
+  }
+
+  {
+    auto rm = makeRegionManager();
+    auto rr = createMemoryRecordReader(ioq);
+    rm->recover(*rr);
+    for (uint32_t i = 0; i < kNumRegions; i++) {
+      EXPECT_EQ(i < 2 ? 0 : 1, rm->getRegion(RegionId{i}).getBand());
+    }
+  }
+}
+
 TEST(RegionManager, RecoveryLRUOrder) {
   constexpr uint32_t kNumRegions = 4;
   constexpr uint32_t kRegionSize = 4 * 1024;
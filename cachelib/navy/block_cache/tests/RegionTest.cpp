@@ -86,4 +86,27 @@ TEST(Region, BufferFlush) {
   EXPECT_EQ(Region::FlushRes::kSuccess,
             r.flushBuffer([](auto, auto) { return true; }));
 }
+
+TEST(Region, FlushAfterDiscard) {
+  Region r{RegionId(0), 1024};
+  r.setPendingDiscard();
+  r.attachBuffer(std::make_unique<Buffer>(1024));
+
+  auto [desc, addr] = r.openAndAllocate(100);
+  EXPECT_EQ(desc.status(), OpenStatus::Ready);
+  r.close(std::move(desc));
+
+  // the buffer is not written while the discard can still drop it
+  bool flushed = false;
+  auto flush = [&flushed](auto, auto) {
+    flushed = true;
+    return true;
+  };
+  EXPECT_EQ(Region::FlushRes::kRetryPendingWrites, r.flushBuffer(flush));
+  EXPECT_FALSE(flushed);
+
+  r.finishDiscard();
+  EXPECT_EQ(Region::FlushRes::kSuccess, r.flushBuffer(flush));
+  EXPECT_TRUE(flushed);
+}
 } // namespace facebook::cachelib::navy::tests
@@ -27,11 +27,17 @@
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/io/async/EventHandler.h>
 
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
 #include <chrono>
 #include <cstring>
 #include <numeric>
 
 #include "cachelib/navy/common/FdpNvme.h"
+#include "cachelib/navy/common/RequestTrace.h"
 #include "cachelib/navy/common/Utils.h"
 
 namespace facebook::cachelib::navy {
@@ -312,6 +318,8 @@ class FileDevice : public Device {
 
   void flushImpl() override;
 
+  bool discardImpl(uint64_t offset, uint64_t size) override;
+
   int allocatePlacementHandle() override;
 
   // File vector for devices or regular files
@@ -380,6 +388,13 @@ class MemoryDevice final : public Device {
     // Noop
   }
 
+  // Zero the range so that tests can tell it was discarded.
+  bool discardImpl(uint64_t offset, uint64_t size) override {
+    XDCHECK_LE(offset + size, getSize());
+    std::memset(buffer_.get() + offset, 0, size);
+    return true;
+  }
+
   std::unique_ptr<uint8_t[]> buffer_;
 };
 } // namespace
@@ -426,7 +441,11 @@ bool Device::writeInternal(uint64_t offset,
     XDCHECK_EQ(writeSize % ioAlignmentSize_, 0ul);
 
     auto timeBegin = getSteadyClock();
-    result = writeImpl(offset, writeSize, data, placeHandle);
+    {
+      RequestTraceTimer traceTimer{&RequestTrace::deviceNs,
+                                   &RequestTrace::numDeviceIos};
+      result = writeImpl(offset, writeSize, data, placeHandle);
+    }
     writeLatencyEstimator_.trackValue(
         toMicros((getSteadyClock() - timeBegin)).count());
 
@@ -466,7 +485,11 @@ bool Device::readInternal(uint64_t offset, uint32_t size, void* value) {
     XDCHECK_EQ(size % ioAlignmentSize_, 0ul);
 
     auto timeBegin = getSteadyClock();
-    result = readImpl(curOffset, readSize, data);
+    {
+      RequestTraceTimer traceTimer{&RequestTrace::deviceNs,
+                                   &RequestTrace::numDeviceIos};
+      result = readImpl(curOffset, readSize, data);
+    }
     readLatencyEstimator_.trackValue(
         toMicros(getSteadyClock() - timeBegin).count());
 
@@ -523,11 +546,30 @@ bool Device::read(uint64_t offset, uint32_t size, void* value) {
   return readInternal(offset, size, value);
 }
 
+bool Device::discard(uint64_t offset, uint64_t size) {
+  XDCHECK_EQ(offset % ioAlignmentSize_, 0ul);
+  XDCHECK_EQ(size % ioAlignmentSize_, 0ul);
+  XDCHECK_LE(offset + size, size_);
+  if (size == 0) {
+    return true;
+  }
+  if (!discardImpl(offset, size)) {
+    discardErrors_.inc();
+    return false;
+  }
+  bytesDiscarded_.add(size);
+  return true;
+}
+
 void Device::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_device_bytes_written", getBytesWritten(),
           CounterVisitor::CounterType::RATE);
   visitor("navy_device_bytes_read", getBytesRead(),
           CounterVisitor::CounterType::RATE);
+  visitor("navy_device_bytes_discarded", getBytesDiscarded(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_discard_errors", discardErrors_.get(),
+          CounterVisitor::CounterType::RATE);
   readLatencyEstimator_.visitQuantileEstimator(visitor,
                                                "navy_device_read_latency_us");
   writeLatencyEstimator_.visitQuantileEstimator(visitor,
@@ -540,6 +582,7 @@ void Device::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_device_decryption_errors", decryptionErrors_.get(),
           CounterVisitor::CounterType::RATE);
+  getCountersImpl(visitor);
 }
 
 namespace {
@@ -978,8 +1021,11 @@ FileDevice::FileDevice(std::vector<folly::File>&& fvec,
 }
 
 bool FileDevice::readImpl(uint64_t offset, uint32_t size, void* value) {
-  auto req =
-      getIoContext()->submitRead(fvec_, stripeSize_, offset, size, value);
+  std::shared_ptr<IOReq> req;
+  {
+    RequestTraceTimer traceTimer{&RequestTrace::deviceSubmitNs};
+    req = getIoContext()->submitRead(fvec_, stripeSize_, offset, size, value);
+  }
   return req->waitCompletion();
 }
 
@@ -987,8 +1033,12 @@ bool FileDevice::writeImpl(uint64_t offset,
                            uint32_t size,
                            const void* value,
                            int placeHandle) {
-  auto req = getIoContext()->submitWrite(fvec_, stripeSize_, offset, size,
-                                         value, placeHandle);
+  std::shared_ptr<IOReq> req;
+  {
+    RequestTraceTimer traceTimer{&RequestTrace::deviceSubmitNs};
+    req = getIoContext()->submitWrite(fvec_, stripeSize_, offset, size, value,
+                                      placeHandle);
+  }
   return req->waitCompletion();
 }
 
@@ -998,6 +1048,49 @@ void FileDevice::flushImpl() {
   }
 }
 
+// Drop [offset, offset + size) of a single file. Block devices get a
+// BLKDISCARD. Regular files get a hole punched so the feature works (and can
+// be tested) on any file system that supports it.
+bool discardFileRange(int fd, uint64_t offset, uint64_t size) {
+  struct stat fileStat;
+  if (::fstat(fd, &fileStat) < 0) {
+    return false;
+  }
+  if (S_ISBLK(fileStat.st_mode)) {
+    uint64_t range[2] = {offset, size};
+    return ::ioctl(fd, BLKDISCARD, &range) == 0;
+  }
+#ifndef MISSING_FALLOCATE
+  return ::fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset,
+                     size) == 0;
+#else
+  return false;
+#endif
+}
+
+bool FileDevice::discardImpl(uint64_t offset, uint64_t size) {
+  if (fvec_.size() == 1) {
+    return discardFileRange(fvec_[0].fd(), offset, size);
+  }
+
+  // For RAID devices, split the range the same way IOReq splits IOs.
+  while (size > 0) {
+    uint64_t stripe = offset / stripeSize_;
+    uint32_t fdIdx = stripe % fvec_.size();
+    uint64_t stripeStartOffset = (stripe / fvec_.size()) * stripeSize_;
+    uint32_t offsetInStripe = offset % stripeSize_;
+    uint64_t discardSize =
+        std::min<uint64_t>(size, stripeSize_ - offsetInStripe);
+    if (!discardFileRange(fvec_[fdIdx].fd(),
+                          stripeStartOffset + offsetInStripe, discardSize)) {
+      return false;
+    }
+    size -= discardSize;
+    offset += discardSize;
+  }
+  return true;
+}
+
 IoContext* FileDevice::getIoContext() {
   if (ioEngine_ == IoEngine::Sync) {
     return syncIoContext_.get();
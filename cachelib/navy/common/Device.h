@@ -167,6 +167,18 @@ class Device {
   // Everything should be on device after this call returns.
   void flush() { flushImpl(); }
 
+  // Tells the device that the data in [@offset, @offset + @size) is no
+  // longer needed, so an SSD doesn't have to preserve it during garbage
+  // collection. Reads from a discarded range return unspecified data until
+  // it is written again.
+  // @offset and @size must be ioAlignmentSize_ aligned
+  //
+  // @return false if the device does not support discard or it failed
+  bool discard(uint64_t offset, uint64_t size);
+
+  // Return bytes discarded since device start
+  uint64_t getBytesDiscarded() const { return bytesDiscarded_.get(); }
+
   // Return bytes written since device start
   uint64_t getBytesWritten() const { return bytesWritten_.get(); }
 
@@ -190,9 +202,20 @@ class Device {
   virtual bool readImpl(uint64_t offset, uint32_t size, void* value) = 0;
   virtual void flushImpl() = 0;
 
+  // Devices that can drop data, e.g. by TRIM or hole punching, override this.
+  virtual bool discardImpl(uint64_t /* offset */, uint64_t /* size */) {
+    return false;
+  }
+
+  // Export stats specific to the device implementation. Called at the end of
+  // getCounters.
+  virtual void getCountersImpl(const CounterVisitor& /* visitor */) const {}
+
  private:
   mutable AtomicCounter bytesWritten_;
   mutable AtomicCounter bytesRead_;
+  mutable AtomicCounter bytesDiscarded_;
+  mutable AtomicCounter discardErrors_;
   mutable AtomicCounter writeIOErrors_;
   mutable AtomicCounter readIOErrors_;
   mutable AtomicCounter encryptionErrors_;
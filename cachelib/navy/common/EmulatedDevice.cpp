@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/EmulatedDevice.h"
+
+#include <folly/Random.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/portability/Asm.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "cachelib/navy/common/RequestTrace.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+namespace {
+// Nanoseconds it takes to transfer one byte at @bandwidthMBps. 0 means
+// unlimited bandwidth.
+double nsPerByte(uint32_t bandwidthMBps) {
+  return bandwidthMBps == 0 ? 0.0 : 1e9 / (bandwidthMBps * 1024.0 * 1024.0);
+}
+} // namespace
+
+EmulatedDevice::EmulatedDevice(std::unique_ptr<Device> device,
+                               const DeviceEmulationConfig& config)
+    : Device{device->getSize(), nullptr /* encryptor */,
+             device->getIOAlignmentSize(), 0 /* max IO size */,
+             0 /* max device write size */},
+      device_{std::move(device)},
+      config_{config},
+      readNsPerByte_{nsPerByte(config.getReadBandwidthMBps())},
+      writeNsPerByte_{nsPerByte(config.getWriteBandwidthMBps())},
+      gcDebtPerByte_{config.getGcUnitSizeKB() > 0
+                         ? config.getWriteAmplification() - 1
+                         : 0.0},
+      queueBusyUntilNs_(config.getNumQueues()) {
+  XDCHECK_GT(config.getNumQueues(), 0u);
+}
+
+uint64_t EmulatedDevice::reserveInterval(std::atomic<uint64_t>& busyUntil,
+                                         uint64_t startNs,
+                                         uint64_t durationNs) {
+  uint64_t busy = busyUntil.load(std::memory_order_relaxed);
+  uint64_t start;
+  do {
+    start = std::max(busy, startNs);
+  } while (!busyUntil.compare_exchange_weak(busy, start + durationNs,
+                                            std::memory_order_relaxed));
+  return start;
+}
+
+uint64_t EmulatedDevice::reserve(bool isWrite, uint64_t size, uint64_t nowNs) {
+  // IOs are spread round robin over the queues. Each queue transfers one IO
+  // at a time at its bandwidth.
+  const auto transferNs = static_cast<uint64_t>(
+      static_cast<double>(size) * (isWrite ? writeNsPerByte_ : readNsPerByte_));
+  auto& queue = queueBusyUntilNs_[nextQueue_.fetch_add(
+                                      1, std::memory_order_relaxed) %
+                                  queueBusyUntilNs_.size()];
+  uint64_t startNs = reserveInterval(queue, nowNs, transferNs);
+
+  if (isWrite && gcDebtPerByte_ > 0) {
+    const uint64_t unit = config_.getGcUnitSizeKB() * 1024ULL;
+    auto debt =
+        static_cast<uint64_t>(static_cast<double>(size) * gcDebtPerByte_);
+    debt -= takeGcCredit(debt);
+    const uint64_t before = gcDebtBytes_.fetch_add(debt);
+    const uint64_t stalls = (before + debt) / unit - before / unit;
+    if (stalls > 0) {
+      const uint64_t stallUs = stalls * config_.getGcStallUs();
+      reserveInterval(gcBusyUntilNs_, nowNs, stallUs * 1000);
+      gcStalls_.add(stalls);
+      gcStallUs_.add(stallUs);
+    }
+  }
+  // GC blocks every queue of the device.
+  startNs = std::max(startNs, gcBusyUntilNs_.load(std::memory_order_relaxed));
+
+  double latencyNs =
+      (isWrite ? config_.getWriteLatencyUs() : config_.getReadLatencyUs()) *
+      1000.0;
+  if (config_.getLatencySigma() > 0) {
+    // lognormal with the configured latency as the median.
+    static thread_local std::normal_distribution<double> normal{0.0, 1.0};
+    folly::ThreadLocalPRNG rng;
+    latencyNs *= std::exp(config_.getLatencySigma() * normal(rng));
+  }
+  const uint64_t outstanding = inflight_.load(std::memory_order_relaxed);
+  if (outstanding > 1) {
+    latencyNs *=
+        1 + config_.getQueueDepthLatencyFactor() *
+                static_cast<double>(outstanding - 1);
+  }
+
+  return startNs - nowNs + transferNs + static_cast<uint64_t>(latencyNs);
+}
+
+uint64_t EmulatedDevice::takeGcCredit(uint64_t debt) {
+  uint64_t credit = gcCreditBytes_.load(std::memory_order_relaxed);
+  uint64_t taken;
+  do {
+    taken = std::min(credit, debt);
+  } while (taken > 0 &&
+           !gcCreditBytes_.compare_exchange_weak(credit, credit - taken,
+                                                 std::memory_order_relaxed));
+  return taken;
+}
+
+bool EmulatedDevice::discardImpl(uint64_t offset, uint64_t size) {
+  if (!device_->discard(offset, size)) {
+    return false;
+  }
+  if (gcDebtPerByte_ > 0) {
+    // The credit can not exceed the debt of rewriting the whole device.
+    const auto maxCredit = static_cast<uint64_t>(
+        static_cast<double>(getSize()) * gcDebtPerByte_);
+    const auto credit =
+        static_cast<uint64_t>(static_cast<double>(size) * gcDebtPerByte_);
+    uint64_t curr = gcCreditBytes_.load(std::memory_order_relaxed);
+    while (!gcCreditBytes_.compare_exchange_weak(
+        curr, std::min(maxCredit, curr + credit), std::memory_order_relaxed)) {
+    }
+  }
+  return true;
+}
+
+bool EmulatedDevice::writeImpl(uint64_t offset,
+                               uint32_t size,
+                               const void* value,
+                               int placeHandle) {
+  const auto startNs = nowNs();
+  inflight_.fetch_add(1, std::memory_order_relaxed);
+  const auto delayNs = reserve(true /* isWrite */, size, startNs);
+  bool res;
+  {
+    // write() of this device traces the IO, including the emulated delay
+    RequestTraceSuspendScope untraced;
+    res = device_->write(
+        offset, BufferView{size, reinterpret_cast<const uint8_t*>(value)},
+        placeHandle);
+  }
+  waitUntil(startNs + delayNs);
+  inflight_.fetch_sub(1, std::memory_order_relaxed);
+  emulatedDelayUs_.add(delayNs / 1000);
+  return res;
+}
+
+bool EmulatedDevice::readImpl(uint64_t offset, uint32_t size, void* value) {
+  const auto startNs = nowNs();
+  inflight_.fetch_add(1, std::memory_order_relaxed);
+  const auto delayNs = reserve(false /* isWrite */, size, startNs);
+  bool res;
+  {
+    // read() of this device traces the IO, including the emulated delay
+    RequestTraceSuspendScope untraced;
+    res = device_->read(offset, size, value);
+  }
+  waitUntil(startNs + delayNs);
+  inflight_.fetch_sub(1, std::memory_order_relaxed);
+  emulatedDelayUs_.add(delayNs / 1000);
+  return res;
+}
+
+void EmulatedDevice::waitUntil(uint64_t deadlineNs) {
+  const auto now = nowNs();
+  if (deadlineNs <= now) {
+    return;
+  }
+  if (folly::fibers::onFiber()) {
+    // yield to other fibers of the IO thread while waiting
+    folly::fibers::Baton baton;
+    baton.try_wait_for(std::chrono::nanoseconds(deadlineNs - now));
+    return;
+  }
+
+  // thread sleeps overshoot by tens of microseconds, so sleep for the bulk of
+  // the wait and spin for the rest.
+  constexpr uint64_t kSpinNs = 50'000;
+  if (deadlineNs - now > kSpinNs) {
+    std::this_thread::sleep_for(
+        std::chrono::nanoseconds(deadlineNs - now - kSpinNs));
+  }
+  while (nowNs() < deadlineNs) {
+    folly::asm_volatile_pause();
+  }
+}
+
+void EmulatedDevice::getCountersImpl(const CounterVisitor& visitor) const {
+  visitor("navy_device_emulation_delay_us", emulatedDelayUs_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_emulation_gc_stalls", gcStalls_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_emulation_gc_stall_us", gcStallUs_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_emulation_write_amplification",
+          gcDebtPerByte_ + 1);
+}
+
+std::unique_ptr<Device> createEmulatedDevice(
+    std::unique_ptr<Device> device, const DeviceEmulationConfig& config) {
+  return std::make_unique<EmulatedDevice>(std::move(device), config);
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "cachelib/allocator/nvmcache/NavyConfig.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/navy/common/Device.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Device that emulates the timing of an SSD on top of another device.
+//
+// Data is stored in the wrapped device (usually a MemoryDevice). Every IO is
+// issued to the wrapped device and then held back until the completion time
+// computed by the model described in DeviceEmulationConfig:
+//
+//   completion = max(queue free, gc free) + transfer + latency
+//
+// where "queue free" is when the queue the IO is assigned to finishes its
+// previous transfers, "transfer" is size / per queue bandwidth, "latency" is
+// the base latency scaled by a lognormal jitter and by the number of
+// outstanding IOs, and "gc free" is when the emulated garbage collection
+// finishes. Writes accumulate GC debt of size * (WA - 1) bytes, and each
+// gcUnitSizeKB of debt stalls the whole device for gcStallUs. Discards are
+// forwarded to the wrapped device, and the debt the discarded bytes would
+// have caused is credited against later writes, since GC no longer has to
+// relocate them.
+//
+// Waits are done on the fiber baton when called from a fiber, so the async IO
+// paths keep their concurrency, and by sleeping the thread otherwise.
+class EmulatedDevice final : public Device {
+ public:
+  // @param device  device to store the data in
+  // @param config  emulation parameters
+  EmulatedDevice(std::unique_ptr<Device> device,
+                 const DeviceEmulationConfig& config);
+  EmulatedDevice(const EmulatedDevice&) = delete;
+  EmulatedDevice& operator=(const EmulatedDevice&) = delete;
+  ~EmulatedDevice() override = default;
+
+  // Number of GC stalls the model has injected so far.
+  uint64_t getGcStalls() const { return gcStalls_.get(); }
+
+  // Modelled delay of the IO in nanoseconds, excluding the time spent in the
+  // wrapped device. Exposed for testing; updates the queue and GC state as if
+  // an IO of @size bytes was issued at @nowNs.
+  uint64_t reserve(bool isWrite, uint64_t size, uint64_t nowNs);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  bool writeImpl(uint64_t offset,
+                 uint32_t size,
+                 const void* value,
+                 int placeHandle) override;
+
+  bool readImpl(uint64_t offset, uint32_t size, void* value) override;
+
+  int allocatePlacementHandle() override {
+    return device_->allocatePlacementHandle();
+  }
+
+  void flushImpl() override { device_->flush(); }
+
+  bool discardImpl(uint64_t offset, uint64_t size) override;
+
+  // Take up to @debt bytes from the GC credit earned by discards.
+  //
+  // @return the bytes taken
+  uint64_t takeGcCredit(uint64_t debt);
+
+  void getCountersImpl(const CounterVisitor& visitor) const override;
+
+  // Block the caller until @deadlineNs (in steady clock nanoseconds).
+  static void waitUntil(uint64_t deadlineNs);
+
+  static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Move @busyUntil to at least @startNs + @durationNs and return the time
+  // the reserved interval starts.
+  static uint64_t reserveInterval(std::atomic<uint64_t>& busyUntil,
+                                  uint64_t startNs,
+                                  uint64_t durationNs);
+
+  const std::unique_ptr<Device> device_;
+  const DeviceEmulationConfig config_;
+
+  // Nanoseconds per byte of transfer for each direction. 0 means unlimited.
+  const double readNsPerByte_;
+  const double writeNsPerByte_;
+  // Bytes of GC debt written per byte of host writes.
+  const double gcDebtPerByte_;
+
+  // Per queue time at which the queue finishes its outstanding transfers.
+  std::vector<std::atomic<uint64_t>> queueBusyUntilNs_;
+  std::atomic<uint64_t> nextQueue_{0};
+  // Number of IOs currently waiting for completion.
+  std::atomic<uint64_t> inflight_{0};
+
+  // Accumulated GC debt in bytes and time until which GC stalls the device.
+  std::atomic<uint64_t> gcDebtBytes_{0};
+  std::atomic<uint64_t> gcBusyUntilNs_{0};
+  // GC debt in bytes that discards saved and later writes have not used up.
+  std::atomic<uint64_t> gcCreditBytes_{0};
+
+  mutable AtomicCounter gcStalls_;
+  mutable AtomicCounter gcStallUs_;
+  mutable AtomicCounter emulatedDelayUs_;
+};
+
+// Wrap @device in an emulated SSD.
+//
+// @param device  device to store the data in
+// @param config  emulation parameters
+std::unique_ptr<Device> createEmulatedDevice(
+    std::unique_ptr<Device> device, const DeviceEmulationConfig& config);
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/RequestTrace.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+namespace {
+class RequestTraceData : public folly::RequestData {
+ public:
+  explicit RequestTraceData(RequestTrace* trace) : trace_{trace} {}
+
+  bool hasCallback() override { return false; }
+
+  RequestTrace* getTrace() const { return trace_; }
+
+ private:
+  RequestTrace* const trace_;
+};
+
+const folly::RequestToken& traceToken() {
+  static const folly::RequestToken token{"navy_request_trace"};
+  return token;
+}
+} // namespace
+
+folly::StringPiece getTraceStageName(TraceStage stage) {
+  switch (stage) {
+  case TraceStage::Enqueued:
+    return "enqueued";
+  case TraceStage::Submitted:
+    return "submitted";
+  case TraceStage::Dispatched:
+    return "dispatched";
+  case TraceStage::Executing:
+    return "executing";
+  case TraceStage::Callback:
+    return "callback";
+  case TraceStage::Completed:
+    return "completed";
+  case TraceStage::NumStages:
+    break;
+  }
+  XDCHECK(false);
+  return "invalid";
+}
+
+RequestTrace* RequestTrace::current() {
+  // untraced requests normally run without a request context
+  auto* ctx = folly::RequestContext::try_get();
+  if (!ctx) {
+    return nullptr;
+  }
+  auto* data = ctx->getContextData(traceToken());
+  return data ? static_cast<RequestTraceData*>(data)->getTrace() : nullptr;
+}
+
+std::string RequestTrace::toString() const {
+  auto us = [](uint64_t ns) { return ns / 1000; };
+  return folly::sformat(
+      "[{}] key {} total {}us: spool {}us dispatch_queue {}us fiber_start {}us "
+      "exec {}us (buffer_lock {}us device {}us submit {}us ios {} "
+      "reschedules {}) callback {}us",
+      name, key, us(totalNs()),
+      us(elapsedNs(TraceStage::Enqueued, TraceStage::Submitted)),
+      us(elapsedNs(TraceStage::Submitted, TraceStage::Dispatched)),
+      us(elapsedNs(TraceStage::Dispatched, TraceStage::Executing)),
+      us(elapsedNs(TraceStage::Executing, getStageNs(TraceStage::Callback)
+                                              ? TraceStage::Callback
+                                              : TraceStage::Completed)),
+      us(bufferLockNs), us(deviceNs), us(deviceSubmitNs), numDeviceIos,
+      numReschedules,
+      us(elapsedNs(TraceStage::Callback, TraceStage::Completed)));
+}
+
+RequestTraceScope::RequestTraceScope(RequestTrace* trace) {
+  if (trace) {
+    guard_.emplace(traceToken(), std::make_unique<RequestTraceData>(trace));
+  }
+}
+
+RequestTraceSuspendScope::RequestTraceSuspendScope() {
+  if (RequestTrace::current()) {
+    guard_.emplace(traceToken(), std::make_unique<RequestTraceData>(nullptr));
+  }
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
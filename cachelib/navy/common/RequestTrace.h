@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/async/Request.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "cachelib/common/Time.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Stages of a Navy request that are timestamped when the request is traced.
+enum class TraceStage : uint8_t {
+  // accepted by the job scheduler
+  Enqueued = 0,
+  // left the ordering spool and queued on a dispatcher
+  Submitted,
+  // picked by the dispatcher loop and handed to a fiber
+  Dispatched,
+  // the job started running
+  Executing,
+  // the job started running the completion callback
+  Callback,
+  // the job finished
+  Completed,
+  NumStages,
+};
+
+constexpr size_t kNumTraceStages = static_cast<size_t>(TraceStage::NumStages);
+
+folly::StringPiece getTraceStageName(TraceStage stage);
+
+// Lifecycle trace of a sampled Navy request. Stage timestamps are taken along
+// the scheduler path, while the time spent under the RegionManager buffer lock
+// and in device IOs is accumulated from inside the job through the current
+// trace (see RequestTrace::current()).
+//
+// A trace is only touched by one thread at a time: the enqueueing thread
+// before the hand off to the dispatcher, then the fiber running the job.
+struct RequestTrace {
+  // name of the job, e.g. "lookup" or "insert"
+  folly::StringPiece name;
+  // key hash of the request
+  uint64_t key{0};
+  // timestamp of each stage in ns, 0 if the stage was not reached
+  std::array<uint64_t, kNumTraceStages> stageNs{};
+  // time spent acquiring the RegionManager buffer lock
+  uint64_t bufferLockNs{0};
+  // time spent submitting device IOs
+  uint64_t deviceSubmitNs{0};
+  // time spent in device IOs (submission and completion)
+  uint64_t deviceNs{0};
+  // number of device IOs issued
+  uint32_t numDeviceIos{0};
+  // number of times the job asked to be rescheduled
+  uint32_t numReschedules{0};
+
+  void mark(TraceStage stage) {
+    stageNs[static_cast<size_t>(stage)] = util::getCurrentTimeNs();
+  }
+
+  uint64_t getStageNs(TraceStage stage) const {
+    return stageNs[static_cast<size_t>(stage)];
+  }
+
+  // @return ns elapsed between the two stages, 0 if either was not reached
+  uint64_t elapsedNs(TraceStage from, TraceStage to) const {
+    const auto fromNs = getStageNs(from);
+    const auto toNs = getStageNs(to);
+    return fromNs && toNs && toNs > fromNs ? toNs - fromNs : 0;
+  }
+
+  // @return ns from Enqueued to Completed
+  uint64_t totalNs() const {
+    return elapsedNs(TraceStage::Enqueued, TraceStage::Completed);
+  }
+
+  // One line human readable representation with per stage latencies.
+  std::string toString() const;
+
+  // @return the trace of the request running on the current fiber (or
+  //         thread), nullptr if the request is not traced.
+  static RequestTrace* current();
+
+  // Mark @stage on the current request if it is traced.
+  static void markCurrent(TraceStage stage) {
+    if (auto* trace = current()) {
+      trace->mark(stage);
+    }
+  }
+};
+
+// Makes @trace the current trace until the end of the scope. The trace is
+// kept in the folly::RequestContext, so it follows the fiber across yields.
+// Does nothing if @trace is nullptr.
+class RequestTraceScope {
+ public:
+  explicit RequestTraceScope(RequestTrace* trace);
+
+ private:
+  std::optional<folly::ShallowCopyRequestContextScopeGuard> guard_;
+};
+
+// Hides the current trace until the end of the scope, so that work already
+// timed by an enclosing RequestTraceTimer is not counted again.
+class RequestTraceSuspendScope {
+ public:
+  RequestTraceSuspendScope();
+
+ private:
+  std::optional<folly::ShallowCopyRequestContextScopeGuard> guard_;
+};
+
+// Adds the time until the end of the scope to @field of the current trace, and
+// increments @counter if given. The trace is captured at construction so that
+// the duration lands on the right trace even if the fiber yields.
+class RequestTraceTimer {
+ public:
+  explicit RequestTraceTimer(uint64_t RequestTrace::*field,
+                             uint32_t RequestTrace::*counter = nullptr)
+      : trace_{RequestTrace::current()},
+        field_{field},
+        beginNs_{trace_ ? util::getCurrentTimeNs() : 0} {
+    if (trace_ && counter) {
+      (trace_->*counter)++;
+    }
+  }
+  RequestTraceTimer(const RequestTraceTimer&) = delete;
+  RequestTraceTimer& operator=(const RequestTraceTimer&) = delete;
+
+  ~RequestTraceTimer() {
+    if (trace_) {
+      trace_->*field_ += util::getCurrentTimeNs() - beginNs_;
+    }
+  }
+
+ private:
+  RequestTrace* const trace_;
+  uint64_t RequestTrace::*const field_;
+  const uint64_t beginNs_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
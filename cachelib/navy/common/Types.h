@@ -65,6 +65,13 @@ using DestructorCallback =
 // Checking NvmItem expired
 using ExpiredCheck = std::function<bool(BufferView value)>;
 
+// Getting the absolute expiry time in seconds of NvmItem, 0 if none
+using ExpiryTimeGetter = std::function<uint32_t(BufferView value)>;
+
+// Visiting an item while walking the cache.
+// @key and @value are valid only during this callback invocation
+using ItemVisitor = std::function<void(HashedKey hk, BufferView value)>;
+
 // Get CounterVisitor into navy namespace.
 using CounterVisitor = util::CounterVisitor;
 
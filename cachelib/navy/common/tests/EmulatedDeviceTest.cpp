@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "cachelib/navy/common/EmulatedDevice.h"
+#include "cachelib/navy/common/RequestTrace.h"
+
+namespace facebook::cachelib::navy::tests {
+namespace {
+std::unique_ptr<EmulatedDevice> makeDevice(const DeviceEmulationConfig& c) {
+  return std::make_unique<EmulatedDevice>(
+      createMemoryDevice(1024 * 1024, nullptr /* encryptor */), c);
+}
+} // namespace
+
+TEST(EmulatedDevice, ReadWrite) {
+  auto device = makeDevice(DeviceEmulationConfig{}.setLatencyUs(10, 10));
+  Buffer wbuf{4096};
+  std::memset(wbuf.data(), 'x', wbuf.size());
+  EXPECT_TRUE(device->write(8192, wbuf.view()));
+  Buffer rbuf{4096};
+  EXPECT_TRUE(device->read(8192, 4096, rbuf.data()));
+  EXPECT_EQ(0, std::memcmp(wbuf.data(), rbuf.data(), 4096));
+}
+
+TEST(EmulatedDevice, RequestTrace) {
+  auto device = makeDevice(DeviceEmulationConfig{}.setLatencyUs(1000, 1000));
+  RequestTrace trace;
+  {
+    RequestTraceScope scope{&trace};
+    Buffer buf{4096};
+    EXPECT_TRUE(device->read(0, 4096, buf.data()));
+    EXPECT_TRUE(device->write(0, std::move(buf)));
+  }
+  // the wrapped device does not trace the IOs again
+  EXPECT_EQ(2, trace.numDeviceIos);
+  EXPECT_GE(trace.deviceNs, uint64_t{2'000'000});
+}
+
+TEST(EmulatedDevice, Latency) {
+  auto device = makeDevice(DeviceEmulationConfig{}.setLatencyUs(2000, 1000));
+  Buffer buf{4096};
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(device->read(0, 4096, buf.data()));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::microseconds(2000));
+
+  start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(device->write(0, std::move(buf)));
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::microseconds(1000));
+}
+
+TEST(EmulatedDevice, Bandwidth) {
+  // 1MB/s per queue: each 1KB transfer takes ~977us and serializes on the
+  // single queue.
+  auto device = makeDevice(
+      DeviceEmulationConfig{}.setLatencyUs(0, 0).setBandwidthMBps(1, 1));
+  const uint64_t now = 1'000'000'000;
+  EXPECT_EQ(976'562, device->reserve(false, 1024, now));
+  EXPECT_EQ(2 * 976'562, device->reserve(false, 1024, now));
+  // the queue drained by then
+  EXPECT_EQ(976'562, device->reserve(true, 1024, now + 10'000'000));
+
+  // with two queues, two IOs can transfer at the same time
+  device = makeDevice(DeviceEmulationConfig{}
+                          .setLatencyUs(0, 0)
+                          .setBandwidthMBps(1, 1)
+                          .setNumQueues(2));
+  EXPECT_EQ(976'562, device->reserve(false, 1024, now));
+  EXPECT_EQ(976'562, device->reserve(false, 1024, now));
+  EXPECT_EQ(2 * 976'562, device->reserve(false, 1024, now));
+}
+
+TEST(EmulatedDevice, GarbageCollection) {
+  // WA of 3 generates 2 bytes of GC debt per byte written, so every 32KB
+  // written triggers a 1ms stall with a 64KB GC unit.
+  auto device = makeDevice(DeviceEmulationConfig{}
+                               .setLatencyUs(0, 0)
+                               .setWriteAmplification(3)
+                               .setGcParams(64, 1000));
+  const uint64_t now = 1'000'000'000;
+  EXPECT_EQ(0, device->reserve(true, 16 * 1024, now));
+  EXPECT_EQ(0, device->getGcStalls());
+  EXPECT_EQ(1'000'000, device->reserve(true, 16 * 1024, now));
+  EXPECT_EQ(1, device->getGcStalls());
+  // reads are blocked by GC as well
+  EXPECT_EQ(1'000'000, device->reserve(false, 4096, now));
+  EXPECT_EQ(0, device->reserve(false, 4096, now + 1'000'000));
+
+  double wa = 0;
+  device->getCounters({[&wa](folly::StringPiece name, double value) {
+    if (name == "navy_device_emulation_write_amplification") {
+      wa = value;
+    }
+  }});
+  EXPECT_DOUBLE_EQ(3, wa);
+}
+
+TEST(EmulatedDevice, Discard) {
+  const auto config = DeviceEmulationConfig{}
+                          .setLatencyUs(0, 0)
+                          .setWriteAmplification(3)
+                          .setGcParams(64, 1000);
+  auto device = makeDevice(config);
+  Buffer wbuf{4096};
+  std::memset(wbuf.data(), 'x', wbuf.size());
+  EXPECT_TRUE(device->write(0, wbuf.view()));
+
+  // the discard reaches the wrapped device, which zeroes the range
+  EXPECT_TRUE(device->discard(0, 4096));
+  EXPECT_EQ(4096, device->getBytesDiscarded());
+  Buffer rbuf{4096};
+  EXPECT_TRUE(device->read(0, 4096, rbuf.data()));
+  EXPECT_EQ(0, rbuf.data()[0]);
+
+  // Every 16KB written adds 32KB of GC debt, and the 16KB discarded pays
+  // off the debt of the next 16KB written. The stall comes one write later.
+  device = makeDevice(config);
+  const uint64_t now = 1'000'000'000;
+  EXPECT_EQ(0, device->reserve(true, 16 * 1024, now));
+  EXPECT_TRUE(device->discard(0, 16 * 1024));
+  EXPECT_EQ(0, device->reserve(true, 16 * 1024, now));
+  EXPECT_EQ(0, device->getGcStalls());
+  EXPECT_EQ(1'000'000, device->reserve(true, 16 * 1024, now));
+  EXPECT_EQ(1, device->getGcStalls());
+}
+} // namespace facebook::cachelib::navy::tests
@@ -322,4 +322,16 @@ std::pair<Status, std::string> Driver::getRandomAlloc(Buffer& value) {
   size_t idx = getRandomAllocDist(getRandomAllocGen);
   return enginePairs_[idx].getRandomAlloc(value);
 }
+
+void Driver::forEachItem(uint32_t partition,
+                         uint32_t numPartitions,
+                         const ItemVisitor& visitor) {
+  if (numPartitions == 0 || partition >= numPartitions) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid partition {} of {}", partition, numPartitions));
+  }
+  for (auto& pair : enginePairs_) {
+    pair.forEachItem(partition, numPartitions, visitor);
+  }
+}
 } // namespace facebook::cachelib::navy
@@ -151,10 +151,20 @@ class Driver final : public AbstractCache {
   //         false if AdissionPolicy is not set or not DynamicRandom.
   bool updateMaxRateForDynamicRandomAP(uint64_t maxRate) override;
 
+  // returns the lifecycle traces of recent slow requests
+  std::string dumpSlowRequests() const override {
+    return scheduler_->dumpSlowRequests();
+  }
+
   // return a Buffer containing NvmItem randomly sampled in the backing store
   std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) override;
 
+  // walk the partition of every engine pair
+  void forEachItem(uint32_t partition,
+                   uint32_t numPartitions,
+                   const ItemVisitor& visitor) override;
+
  private:
   struct ValidConfigTag {};
 
@@ -123,6 +123,9 @@ class MockEngine : public Engine {
     (void)value;
     return std::make_pair(Status::NotFound, "");
   }
+  void forEachItem(uint32_t /* partition */,
+                   uint32_t /* numPartitions */,
+                   const ItemVisitor& /* visitor */) override {}
 
   uint64_t estimateWriteSize(HashedKey hk, BufferView value) const override {
     return defaultWriteSize_ == 0 ? hk.key().size() + value.size()
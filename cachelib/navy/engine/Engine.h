@@ -74,6 +74,14 @@ class Engine {
   // Get key and Buffer for a random sample
   virtual std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) = 0;
+
+  // Walks the items stored in partition @partition out of @numPartitions
+  // disjoint partitions of the engine and calls @visitor for each of them.
+  // Partitions can be walked concurrently. Items inserted or removed during
+  // the walk may or may not be visited.
+  virtual void forEachItem(uint32_t partition,
+                           uint32_t numPartitions,
+                           const ItemVisitor& visitor) = 0;
 };
 } // namespace navy
 } // namespace cachelib
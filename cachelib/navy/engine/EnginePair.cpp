@@ -16,6 +16,7 @@
 
 #include "cachelib/navy/engine/EnginePair.h"
 
+#include "cachelib/navy/common/RequestTrace.h"
 #include "cachelib/navy/engine/NoopEngine.h"
 
 namespace facebook::cachelib::navy {
@@ -120,6 +121,7 @@ void EnginePair::scheduleInsert(HashedKey hk,
         }
 
         if (cb) {
+          RequestTrace::markCurrent(TraceStage::Callback);
           cb(status, hk);
         }
 
@@ -172,6 +174,7 @@ void EnginePair::scheduleLookup(HashedKey hk, LookupCallback cb) {
           return JobExitCode::Reschedule;
         }
         if (cb) {
+          RequestTrace::markCurrent(TraceStage::Callback);
           cb(status, hk, std::move(value));
         }
 
@@ -226,6 +229,7 @@ void EnginePair::scheduleRemove(HashedKey hk, RemoveCallback cb) {
           return JobExitCode::Reschedule;
         }
         if (cb) {
+          RequestTrace::markCurrent(TraceStage::Callback);
           cb(status, hk);
         }
         return JobExitCode::Done;
@@ -303,6 +307,13 @@ std::pair<Status, std::string> EnginePair::getRandomAlloc(Buffer& value) {
   return smallItemCache_->getRandomAlloc(value);
 }
 
+void EnginePair::forEachItem(uint32_t partition,
+                             uint32_t numPartitions,
+                             const ItemVisitor& visitor) {
+  smallItemCache_->forEachItem(partition, numPartitions, visitor);
+  largeItemCache_->forEachItem(partition, numPartitions, visitor);
+}
+
 void EnginePair::validate() {
   if (smallItemCache_ != nullptr) {
     if (smallItemMaxSize_ == 0) {
@@ -103,6 +103,11 @@ class EnginePair {
 
   std::pair<Status, std::string> getRandomAlloc(Buffer& value);
 
+  // walk the partition of both engines, see Engine::forEachItem
+  void forEachItem(uint32_t partition,
+                   uint32_t numPartitions,
+                   const ItemVisitor& visitor);
+
   void validate();
 
  private:
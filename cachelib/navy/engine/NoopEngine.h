@@ -43,6 +43,7 @@ class NoopEngine final : public Engine {
   std::pair<Status, std::string> getRandomAlloc(Buffer&) override {
     return std::make_pair(Status::NotFound, "");
   }
+  void forEachItem(uint32_t, uint32_t, const ItemVisitor&) override {}
 };
 } // namespace navy
 } // namespace cachelib
@@ -19,6 +19,7 @@
 #include <folly/Function.h>
 
 #include <memory>
+#include <string>
 
 #include "cachelib/navy/common/CompilerUtils.h"
 #include "cachelib/navy/common/Types.h"
@@ -67,6 +68,10 @@ class JobScheduler {
 
   // visits each available counter for the visitor to take appropriate action.
   virtual void getCounters(const CounterVisitor& visitor) const = 0;
+
+  // Returns the traces of recent slow requests, one per line. Empty if the
+  // scheduler does not trace requests.
+  virtual std::string dumpSlowRequests() const { return {}; }
 };
 
 // Create a thread pool job scheduler that ensures ordering of requests by
@@ -84,13 +89,19 @@ std::unique_ptr<JobScheduler> createOrderedThreadPoolJobScheduler(
 // @param maxNumWrites        Max number of outstanding writes
 // @param stackSize           Size of fiber stack
 // @param reqOrderShardPower  The number of shards (in power of 2) for ordering
+// @param traceSampleRate     Trace one in every traceSampleRate requests.
+//                            0 disables request tracing
+// @param traceSlowThresholdUs  Traces slower than this are kept for
+//                              dumpSlowRequests()
 std::unique_ptr<JobScheduler> createNavyRequestScheduler(
     size_t numReaderThreads,
     size_t numWriterThreads_,
     size_t maxNumReads,
     size_t maxNumWrites,
     size_t stackSize,
-    size_t reqOrderShardPower);
+    size_t reqOrderShardPower,
+    uint32_t traceSampleRate = 0,
+    uint64_t traceSlowThresholdUs = 0);
 
 } // namespace navy
 } // namespace cachelib
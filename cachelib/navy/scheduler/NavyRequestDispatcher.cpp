@@ -25,8 +25,10 @@ namespace navy {
 NavyRequestDispatcher::NavyRequestDispatcher(JobScheduler& scheduler,
                                              folly::StringPiece name,
                                              size_t maxOutstanding,
-                                             size_t stackSize)
+                                             size_t stackSize,
+                                             RequestTracer* tracer)
     : scheduler_(scheduler),
+      tracer_(tracer),
       name_(name),
       maxOutstanding_(maxOutstanding),
       worker_{name_, NavyThread::Options(stackSize)} {
@@ -105,9 +107,26 @@ void NavyRequestDispatcher::processLoop() {
 void NavyRequestDispatcher::scheduleReq(std::unique_ptr<NavyRequest> req) {
   // Start a new fiber running the given request
   numOutstanding_.inc();
+  if (auto* trace = req->getTrace()) {
+    trace->mark(TraceStage::Dispatched);
+  }
   worker_.addTask([this, rq = std::move(req)]() mutable {
-    while (rq->execute() == JobExitCode::Reschedule) {
-      folly::fibers::yield();
+    if (auto* trace = rq->getTrace()) {
+      // Stages inside the job find the trace through the request context
+      RequestTraceScope traceScope{trace};
+      trace->mark(TraceStage::Executing);
+      while (rq->execute() == JobExitCode::Reschedule) {
+        trace->numReschedules++;
+        folly::fibers::yield();
+      }
+      trace->mark(TraceStage::Completed);
+      if (tracer_) {
+        tracer_->finishTrace(*trace);
+      }
+    } else {
+      while (rq->execute() == JobExitCode::Reschedule) {
+        folly::fibers::yield();
+      }
     }
 
     auto key = rq->getKey();
@@ -126,6 +145,9 @@ void NavyRequestDispatcher::scheduleReq(std::unique_ptr<NavyRequest> req) {
 void NavyRequestDispatcher::submitReq(std::unique_ptr<NavyRequest> navyReq) {
   XDCHECK(!!navyReq);
   numSubmitted_.inc();
+  if (auto* trace = navyReq->getTrace()) {
+    trace->mark(TraceStage::Submitted);
+  }
 
   auto* req = navyReq.release();
   NavyRequest* oldValue = nullptr;
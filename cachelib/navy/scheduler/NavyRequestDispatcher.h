@@ -22,7 +22,9 @@
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/Time.h"
 #include "cachelib/navy/common/NavyThread.h"
+#include "cachelib/navy/common/RequestTrace.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
+#include "cachelib/navy/scheduler/RequestTracer.h"
 
 namespace facebook {
 namespace cachelib {
@@ -52,6 +54,14 @@ class NavyRequest {
   // Main function to run the request
   JobExitCode execute() { return job_(); }
 
+  // Attach the lifecycle trace if the request is sampled for tracing
+  void setTrace(std::unique_ptr<RequestTrace> trace) {
+    trace_ = std::move(trace);
+  }
+
+  // Return the lifecycle trace, nullptr if the request is not traced
+  RequestTrace* getTrace() const { return trace_.get(); }
+
   // next_ is a hook used to implement the atomic singly linked list
   NavyRequest* next_ = nullptr;
 
@@ -67,6 +77,9 @@ class NavyRequest {
 
   // Time when the request was scheduled to track the timings
   uint64_t beginTime_;
+
+  // Lifecycle trace of a sampled request
+  std::unique_ptr<RequestTrace> trace_;
 };
 
 // NavyRequestDispatcher is a request dispatcher with MPSC atomic submission
@@ -98,10 +111,12 @@ class NavyRequestDispatcher {
   // notification
   // @param name            name of the dispatcher
   // @param maxOutstanding  maximum number of concurrently running requests
+  // @param tracer          tracer to report completed request traces to
   NavyRequestDispatcher(JobScheduler& scheduler,
                         folly::StringPiece name,
                         size_t maxOutstanding,
-                        size_t stackSize);
+                        size_t stackSize,
+                        RequestTracer* tracer = nullptr);
 
   folly::StringPiece getName() { return name_; }
 
@@ -125,6 +140,8 @@ class NavyRequestDispatcher {
 
   // The parent scheduler to get completion notification
   JobScheduler& scheduler_;
+  // Tracer of the parent scheduler. Can be nullptr
+  RequestTracer* tracer_;
   // Name of the dispatcher
   std::string name_;
   // The head of the custom implementation of atomic MPSC queue
@@ -28,13 +28,17 @@ std::unique_ptr<JobScheduler> createNavyRequestScheduler(
     size_t maxNumReads,
     size_t maxNumWrites,
     size_t stackSize,
-    size_t reqOrderShardPower) {
+    size_t reqOrderShardPower,
+    uint32_t traceSampleRate,
+    uint64_t traceSlowThresholdUs) {
   return std::make_unique<NavyRequestScheduler>(numReaderThreads,
                                                 numWriterThreads,
                                                 maxNumReads,
                                                 maxNumWrites,
                                                 stackSize,
-                                                reqOrderShardPower);
+                                                reqOrderShardPower,
+                                                traceSampleRate,
+                                                traceSlowThresholdUs);
 }
 
 NavyRequestScheduler::NavyRequestScheduler(size_t numReaderThreads,
@@ -42,10 +46,13 @@ NavyRequestScheduler::NavyRequestScheduler(size_t numReaderThreads,
                                            size_t maxNumReads,
                                            size_t maxNumWrites,
                                            size_t stackSize,
-                                           size_t numShardsPower)
+                                           size_t numShardsPower,
+                                           uint32_t traceSampleRate,
+                                           uint64_t traceSlowThresholdUs)
     : numReaderThreads_(numReaderThreads),
       numWriterThreads_(numWriterThreads),
       numShards_(1ULL << numShardsPower),
+      tracer_(traceSampleRate, traceSlowThresholdUs),
       mutexes_(numShards_),
       pendingReqs_(numShards_),
       shouldSpool_(numShards_, false) {
@@ -56,14 +63,14 @@ NavyRequestScheduler::NavyRequestScheduler(size_t numReaderThreads,
   for (size_t i = 0; i < numReaderThreads_; i++) {
     auto dispatcher = std::make_shared<NavyRequestDispatcher>(
         *this, fmt::format("navy_reader_{}", i),
-        maxNumReads / numReaderThreads_, stackSize);
+        maxNumReads / numReaderThreads_, stackSize, &tracer_);
     readerDispatchers_.emplace_back(std::move(dispatcher));
   }
 
   for (size_t i = 0; i < numWriterThreads_; i++) {
     auto dispatcher = std::make_shared<NavyRequestDispatcher>(
         *this, fmt::format("navy_writer_{}", i),
-        maxNumWrites / numWriterThreads_, stackSize);
+        maxNumWrites / numWriterThreads_, stackSize, &tracer_);
     writerDispatchers_.emplace_back(std::move(dispatcher));
   }
 
@@ -106,6 +113,9 @@ void NavyRequestScheduler::enqueueWithKey(Job job,
   }
 
   auto req = std::make_unique<NavyRequest>(std::move(job), name, type, key);
+  if (tracer_.isEnabled()) {
+    req->setTrace(tracer_.maybeStartTrace(name, key));
+  }
   // Allow one request can be outstanding per shard by spooling requests
   // if there is another request already running
   const auto shard = req->getKey() % numShards_;
@@ -178,6 +188,7 @@ void NavyRequestScheduler::getCounters(const CounterVisitor& visitor) const {
 
   visitor("navy_jobs.spooled.curr", currSpooled_.get());
   visitor("navy_jobs.spooled.total", numSpooled_.get());
+  tracer_.getCounters(visitor);
 }
 
 void NavyRequestScheduler::checkHealth(
@@ -24,6 +24,7 @@
 
 #include "cachelib/navy/scheduler/JobScheduler.h"
 #include "cachelib/navy/scheduler/NavyRequestDispatcher.h"
+#include "cachelib/navy/scheduler/RequestTracer.h"
 
 namespace facebook {
 namespace cachelib {
@@ -48,12 +49,18 @@ class NavyRequestScheduler : public JobScheduler {
   // @param writerThreads   number of threads for the write scheduler
   // @param numShardsPower  power of two specification for sharding internally
   //                        to avoid contention and queueing
+  // @param traceSampleRate trace one in every traceSampleRate requests.
+  //                        0 disables request tracing
+  // @param traceSlowThresholdUs  traces slower than this are kept for
+  //                              dumpSlowRequests()
   explicit NavyRequestScheduler(size_t numReaderThreads,
                                 size_t numWriterThreads,
                                 size_t maxNumReads,
                                 size_t maxNumWrites,
                                 size_t stackSize,
-                                size_t reqOrderShardPower);
+                                size_t reqOrderShardPower,
+                                uint32_t traceSampleRate = 0,
+                                uint64_t traceSlowThresholdUs = 0);
   NavyRequestScheduler(const NavyRequestScheduler&) = delete;
   NavyRequestScheduler& operator=(const NavyRequestScheduler&) = delete;
   ~NavyRequestScheduler() override;
@@ -74,6 +81,11 @@ class NavyRequestScheduler : public JobScheduler {
   // Exports the ordered scheduler stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const override;
 
+  // Returns the slowest recently traced requests, one per line
+  std::string dumpSlowRequests() const override {
+    return tracer_.dumpSlowRequests();
+  }
+
  private:
   void submitSpooledReq(size_t shard);
 
@@ -97,6 +109,10 @@ class NavyRequestScheduler : public JobScheduler {
 
   bool stopped_{false};
 
+  // Sampled lifecycle tracing of requests. Declared before the dispatchers
+  // which report completed traces to it.
+  RequestTracer tracer_;
+
   std::vector<std::shared_ptr<NavyRequestDispatcher>> readerDispatchers_;
   std::vector<std::shared_ptr<NavyRequestDispatcher>> writerDispatchers_;
 
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/scheduler/RequestTracer.h"
+
+#include <folly/Random.h>
+
+#include <algorithm>
+#include <mutex>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+RequestTracer::RequestTracer(uint32_t sampleRate, uint64_t slowThresholdUs)
+    : sampleRate_{sampleRate}, slowThresholdNs_{slowThresholdUs * 1000} {}
+
+std::unique_ptr<RequestTrace> RequestTracer::maybeStartTrace(
+    folly::StringPiece name, uint64_t key) {
+  if (sampleRate_ == 0 || !folly::Random::oneIn(sampleRate_)) {
+    return nullptr;
+  }
+  auto trace = std::make_unique<RequestTrace>();
+  trace->name = name;
+  trace->key = key;
+  trace->mark(TraceStage::Enqueued);
+  return trace;
+}
+
+void RequestTracer::finishTrace(const RequestTrace& trace) {
+  numTraced_.inc();
+  auto trackUs = [](util::PercentileStats& stats, uint64_t ns) {
+    stats.trackValue(static_cast<double>(ns / 1000));
+  };
+  trackUs(spoolLatency_,
+          trace.elapsedNs(TraceStage::Enqueued, TraceStage::Submitted));
+  trackUs(dispatchQueueLatency_,
+          trace.elapsedNs(TraceStage::Submitted, TraceStage::Dispatched));
+  trackUs(fiberStartLatency_,
+          trace.elapsedNs(TraceStage::Dispatched, TraceStage::Executing));
+  const bool hasCallback = trace.getStageNs(TraceStage::Callback) != 0;
+  trackUs(execLatency_,
+          trace.elapsedNs(TraceStage::Executing, hasCallback
+                                                     ? TraceStage::Callback
+                                                     : TraceStage::Completed));
+  trackUs(bufferLockLatency_, trace.bufferLockNs);
+  trackUs(deviceSubmitLatency_, trace.deviceSubmitNs);
+  trackUs(deviceLatency_, trace.deviceNs);
+  if (hasCallback) {
+    trackUs(callbackLatency_,
+            trace.elapsedNs(TraceStage::Callback, TraceStage::Completed));
+  }
+  trackUs(totalLatency_, trace.totalNs());
+
+  if (trace.totalNs() >= slowThresholdNs_) {
+    addSlowTrace(trace);
+  }
+}
+
+void RequestTracer::addSlowTrace(const RequestTrace& trace) {
+  numSlow_.inc();
+  auto& ring = *slowRings_;
+  auto& slot = ring.slots[ring.next++ % kSlowTracesPerThread];
+  std::lock_guard<folly::SpinLock> l{slot.lock};
+  slot.trace = trace;
+  slot.written = true;
+}
+
+std::vector<RequestTrace> RequestTracer::getSlowRequests() const {
+  std::vector<RequestTrace> traces;
+  for (const auto& ring : slowRings_.accessAllThreads()) {
+    for (const auto& slot : ring.slots) {
+      std::lock_guard<folly::SpinLock> l{slot.lock};
+      if (slot.written) {
+        traces.push_back(slot.trace);
+      }
+    }
+  }
+  std::sort(traces.begin(), traces.end(),
+            [](const RequestTrace& a, const RequestTrace& b) {
+              return a.totalNs() > b.totalNs();
+            });
+  return traces;
+}
+
+std::string RequestTracer::dumpSlowRequests() const {
+  std::string out;
+  for (const auto& trace : getSlowRequests()) {
+    out += trace.toString();
+    out += '\n';
+  }
+  return out;
+}
+
+void RequestTracer::getCounters(const CounterVisitor& visitor) const {
+  if (!isEnabled()) {
+    return;
+  }
+  visitor("navy_jobs.trace.sampled", numTraced_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_jobs.trace.slow", numSlow_.get(),
+          CounterVisitor::CounterType::RATE);
+  spoolLatency_.visitQuantileEstimator(visitor, "navy_jobs.trace.spool_us");
+  dispatchQueueLatency_.visitQuantileEstimator(
+      visitor, "navy_jobs.trace.dispatch_queue_us");
+  fiberStartLatency_.visitQuantileEstimator(visitor,
+                                            "navy_jobs.trace.fiber_start_us");
+  execLatency_.visitQuantileEstimator(visitor, "navy_jobs.trace.exec_us");
+  bufferLockLatency_.visitQuantileEstimator(visitor,
+                                            "navy_jobs.trace.buffer_lock_us");
+  deviceSubmitLatency_.visitQuantileEstimator(
+      visitor, "navy_jobs.trace.device_submit_us");
+  deviceLatency_.visitQuantileEstimator(visitor, "navy_jobs.trace.device_us");
+  callbackLatency_.visitQuantileEstimator(visitor,
+                                          "navy_jobs.trace.callback_us");
+  totalLatency_.visitQuantileEstimator(visitor, "navy_jobs.trace.total_us");
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/SpinLock.h>
+#include <folly/ThreadLocal.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PercentileStats.h"
+#include "cachelib/navy/common/RequestTrace.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// RequestTracer samples Navy requests for lifecycle tracing and aggregates the
+// completed traces.
+//
+// Per stage latencies of every completed trace go into quantile estimators
+// exported through getCounters. Traces slower than the threshold are kept in
+// per thread ring buffers that are written by the thread completing the
+// request. Each slot has its own spin lock, so the writer only contends with
+// a reader copying the same slot. dumpSlowRequests() returns the most recent
+// slow traces across all threads.
+class RequestTracer {
+ public:
+  // number of slow traces kept per thread
+  static constexpr size_t kSlowTracesPerThread = 64;
+
+  // @param sampleRate        trace one in every sampleRate requests.
+  //                          0 disables tracing
+  // @param slowThresholdUs   completed traces that took at least this long
+  //                          are kept for dumpSlowRequests()
+  RequestTracer(uint32_t sampleRate, uint64_t slowThresholdUs);
+  RequestTracer(const RequestTracer&) = delete;
+  RequestTracer& operator=(const RequestTracer&) = delete;
+
+  bool isEnabled() const { return sampleRate_ > 0; }
+
+  // @return a new trace with the Enqueued stage marked if the request is
+  //         sampled, nullptr otherwise.
+  std::unique_ptr<RequestTrace> maybeStartTrace(folly::StringPiece name,
+                                                uint64_t key);
+
+  // Record a completed trace.
+  void finishTrace(const RequestTrace& trace);
+
+  // @return the slow traces currently kept across all threads, slowest first
+  std::vector<RequestTrace> getSlowRequests() const;
+
+  // @return getSlowRequests() formatted one trace per line
+  std::string dumpSlowRequests() const;
+
+  // Exports the per stage latency estimates via CounterVisitor.
+  void getCounters(const CounterVisitor& visitor) const;
+
+ private:
+  // A slot of the ring buffer. trace is only valid once written is set.
+  struct Slot {
+    mutable folly::SpinLock lock;
+    bool written{false};
+    RequestTrace trace;
+  };
+
+  struct SlowRing {
+    std::array<Slot, kSlowTracesPerThread> slots;
+    // only accessed by the owning thread
+    uint64_t next{0};
+  };
+
+  class Tag;
+
+  void addSlowTrace(const RequestTrace& trace);
+
+  const uint32_t sampleRate_{0};
+  const uint64_t slowThresholdNs_{0};
+
+  AtomicCounter numTraced_{0};
+  AtomicCounter numSlow_{0};
+
+  mutable util::PercentileStats spoolLatency_;
+  mutable util::PercentileStats dispatchQueueLatency_;
+  mutable util::PercentileStats fiberStartLatency_;
+  mutable util::PercentileStats execLatency_;
+  mutable util::PercentileStats bufferLockLatency_;
+  mutable util::PercentileStats deviceSubmitLatency_;
+  mutable util::PercentileStats deviceLatency_;
+  mutable util::PercentileStats callbackLatency_;
+  mutable util::PercentileStats totalLatency_;
+
+  folly::ThreadLocal<SlowRing, Tag> slowRings_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
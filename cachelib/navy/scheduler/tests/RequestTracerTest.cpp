@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "cachelib/navy/scheduler/NavyRequestScheduler.h"
+#include "cachelib/navy/scheduler/RequestTracer.h"
+
+namespace facebook::cachelib::navy::tests {
+TEST(RequestTracer, Sampling) {
+  RequestTracer disabled{0, 0};
+  EXPECT_FALSE(disabled.isEnabled());
+  EXPECT_EQ(nullptr, disabled.maybeStartTrace("lookup", 1));
+
+  RequestTracer tracer{1, 0};
+  auto trace = tracer.maybeStartTrace("lookup", 42);
+  ASSERT_NE(nullptr, trace);
+  EXPECT_EQ("lookup", trace->name);
+  EXPECT_EQ(42, trace->key);
+  EXPECT_NE(0, trace->getStageNs(TraceStage::Enqueued));
+  EXPECT_EQ(0, trace->getStageNs(TraceStage::Completed));
+}
+
+TEST(RequestTracer, CurrentTrace) {
+  EXPECT_EQ(nullptr, RequestTrace::current());
+  RequestTrace trace;
+  {
+    RequestTraceScope scope{&trace};
+    EXPECT_EQ(&trace, RequestTrace::current());
+    RequestTrace::markCurrent(TraceStage::Callback);
+    {
+      RequestTraceTimer timer{&RequestTrace::deviceNs,
+                              &RequestTrace::numDeviceIos};
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  EXPECT_EQ(nullptr, RequestTrace::current());
+  EXPECT_NE(0, trace.getStageNs(TraceStage::Callback));
+  EXPECT_GE(trace.deviceNs, 1'000'000);
+  EXPECT_EQ(1, trace.numDeviceIos);
+
+  // timers without a current trace are no-ops
+  RequestTraceTimer timer{&RequestTrace::bufferLockNs};
+}
+
+TEST(RequestTracer, SlowRequests) {
+  RequestTracer tracer{1, 100 /* slowThresholdUs */};
+  auto makeTrace = [](uint64_t key, uint64_t totalUs) {
+    RequestTrace trace;
+    trace.name = "insert";
+    trace.key = key;
+    trace.stageNs[static_cast<size_t>(TraceStage::Enqueued)] = 1'000;
+    trace.stageNs[static_cast<size_t>(TraceStage::Completed)] =
+        1'000 + totalUs * 1000;
+    return trace;
+  };
+  tracer.finishTrace(makeTrace(1, 50));
+  tracer.finishTrace(makeTrace(2, 200));
+  // slow traces are kept per thread for as long as the thread lives
+  folly::Baton<> recorded;
+  folly::Baton<> release;
+  std::thread t{[&] {
+    tracer.finishTrace(makeTrace(3, 300));
+    recorded.post();
+    release.wait();
+  }};
+  recorded.wait();
+
+  auto slow = tracer.getSlowRequests();
+  ASSERT_EQ(2, slow.size());
+  EXPECT_EQ(3, slow[0].key);
+  EXPECT_EQ(2, slow[1].key);
+  EXPECT_NE(std::string::npos,
+            tracer.dumpSlowRequests().find("key 2 total 200us"));
+
+  // the ring keeps the most recent traces of each thread
+  for (size_t i = 0; i < RequestTracer::kSlowTracesPerThread; i++) {
+    tracer.finishTrace(makeTrace(100 + i, 150));
+  }
+  slow = tracer.getSlowRequests();
+  EXPECT_EQ(RequestTracer::kSlowTracesPerThread + 1, slow.size());
+  EXPECT_EQ(3, slow[0].key);
+
+  uint64_t sampled = 0;
+  tracer.getCounters({[&](folly::StringPiece name, double val) {
+    if (name == "navy_jobs.trace.sampled") {
+      sampled = static_cast<uint64_t>(val);
+    }
+  }});
+  EXPECT_EQ(3 + RequestTracer::kSlowTracesPerThread, sampled);
+
+  release.post();
+  t.join();
+}
+
+TEST(RequestTracer, NavyRequestScheduler) {
+  NavyRequestScheduler scheduler{1, 1, 4, 4, 0, 4, 1 /* trace all */,
+                                 0 /* keep all */};
+  folly::Baton<> done;
+  scheduler.enqueueWithKey(
+      []() {
+        RequestTrace::markCurrent(TraceStage::Callback);
+        return JobExitCode::Done;
+      },
+      "lookup", JobType::Read, 7);
+  scheduler.enqueueWithKey(
+      [&done]() {
+        done.post();
+        return JobExitCode::Done;
+      },
+      "lookup", JobType::Read, 7);
+  done.wait();
+
+  // traces are recorded after the job returns; wait for both of them
+  std::string dump = scheduler.dumpSlowRequests();
+  while (std::count(dump.begin(), dump.end(), '\n') < 2) {
+    std::this_thread::yield();
+    dump = scheduler.dumpSlowRequests();
+  }
+  EXPECT_NE(std::string::npos, dump.find("[lookup] key 7"));
+}
+} // namespace facebook::cachelib::navy::tests
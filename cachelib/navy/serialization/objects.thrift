@@ -22,6 +22,10 @@ struct IndexEntry {
   3: i16 sizeHint = 0;
   4: byte totalHits = 0;
   5: byte currentHits = 0;
+  // only set if the index keeps the corresponding metadata
+  6: optional i16 fingerprint;
+  // approximate expiry time, rounded up to the index granularity
+  7: optional i32 expiryTime;
 }
 
 struct IndexBucket {
@@ -36,6 +40,7 @@ struct Region {
   4: required i32 numItems = 0;
   5: required bool pinned = false;
   6: i32 priority = 0;
+  7: i32 band = 0;
 }
 
 struct RegionData {
@@ -91,4 +96,5 @@ struct BigHashPersistentData {
   6: required i64 numBuckets = 0;
   7: map<i64, i64> deprecated_sizeDist;
   8: i64 usedSizeBytes = 0;
+  9: i32 directorySize = 0;
 }